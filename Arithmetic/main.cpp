@@ -0,0 +1,131 @@
+/*
+
+    -----------------------
+    Overflow-safe Arithmetic
+    -----------------------
+    Checks every kernel of saturating.hpp, on every instruction set this CPU
+    supports, against a plain loop that does the arithmetic in int64_t.
+
+    Inputs are random values mixed with the edge cases (min, max, 0, -1, 1)
+    and odd sizes, so the scalar tails get exercised too.
+
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "saturating.hpp"
+#include "../Testing/self_check.hpp"
+
+namespace simd = ali::simd;
+
+using ali::check::report;
+
+template <typename T>
+static std::vector<T> randomSamples(std::size_t n, std::mt19937& rng)
+{
+    constexpr T lo = std::numeric_limits<T>::min();
+    constexpr T hi = std::numeric_limits<T>::max();
+    const T edges[] = { lo, T(lo + 1), T(-1), T(0), T(1), T(hi - 1), hi };
+
+    std::uniform_int_distribution<std::int64_t> value(lo, hi);
+    std::uniform_int_distribution<int> pick(0, 3);
+
+    std::vector<T> v(n);
+    for (auto& x : v)
+        x = pick(rng) == 0 ? edges[rng() % std::size(edges)] : T(value(rng));
+    return v;
+}
+
+template <typename T>
+static T clampTo(std::int64_t x)
+{
+    return T(std::clamp<std::int64_t>(x, std::numeric_limits<T>::min(), std::numeric_limits<T>::max()));
+}
+
+// reference results computed in int64_t, where nothing can overflow
+template <typename T>
+static bool checkBinary(std::mt19937& rng, std::size_t n)
+{
+    const auto a = randomSamples<T>(n, rng);
+    const auto b = randomSamples<T>(n, rng);
+    std::vector<T> out(n);
+    const std::span<const T> sa(a), sb(b);
+
+    auto same = [&](auto reference) {
+        for (std::size_t i = 0; i < n; ++i)
+            if (out[i] != reference(std::int64_t(a[i]), std::int64_t(b[i])))
+                return false;
+        return true;
+    };
+
+    bool ok = true;
+
+    ali::midpoint(sa, sb, std::span<T>(out));
+    ok &= same([](std::int64_t x, std::int64_t y) {
+        // round towards x
+        const std::int64_t s = x + y;
+        return T(x <= y ? (s >= 0 ? s / 2 : (s - 1) / 2) : (s >= 0 ? (s + 1) / 2 : s / 2));
+    });
+
+    ali::sat_add(sa, sb, std::span<T>(out));
+    ok &= same([](std::int64_t x, std::int64_t y) { return clampTo<T>(x + y); });
+
+    ali::sat_sub(sa, sb, std::span<T>(out));
+    ok &= same([](std::int64_t x, std::int64_t y) { return clampTo<T>(x - y); });
+
+    ali::sat_mul(sa, sb, std::span<T>(out));
+    ok &= same([](std::int64_t x, std::int64_t y) { return clampTo<T>(x * y); });
+
+    std::int64_t sum = 0;
+    for (auto x : a) sum += x;
+    ok &= ali::widening_sum(sa) == sum;
+
+    const auto checked = ali::checked_sum(sa);
+    ok &= checked ? *checked == sum : clampTo<T>(sum) != sum;
+
+    return ok;
+}
+
+int main()
+{
+    // the overflow from Threads/main.cpp
+    std::int32_t a = 1000000000;
+    std::int32_t b = 1500000000;
+    std::cout << "ali::midpoint(" << a << ", " << b << ") = " << ali::midpoint(a, b) << "\n";
+    std::cout << "ali::sat_add("  << a << ", " << b << ") = " << ali::sat_add(a, b) << "\n\n";
+
+    std::cout << "detected instruction set: " << simd::name(simd::detectIsa()) << "\n\n";
+
+    const std::size_t sizes[] = { 0, 1, 7, 15, 16, 33, 1000, 100003 };
+
+    for (auto isa : { simd::Isa::Scalar, simd::Isa::SSE42, simd::Isa::AVX2 }) {
+        if (!simd::supported(isa)) {
+            std::cout << "[SKIP] " << simd::name(isa) << "\n";
+            continue;
+        }
+        simd::setIsa(isa);
+
+        std::mt19937 rng(42);
+        bool ok16 = true, ok32 = true;
+        for (auto n : sizes) {
+            ok16 &= checkBinary<std::int16_t>(rng, n);
+            ok32 &= checkBinary<std::int32_t>(rng, n);
+        }
+        report(ok16, std::string(simd::name(isa)) + " int16");
+        report(ok32, std::string(simd::name(isa)) + " int32");
+    }
+
+    // sums that only fit into int64_t
+    simd::setIsa(simd::detectIsa());
+    std::vector<std::int16_t> loud(1 << 20, std::numeric_limits<std::int16_t>::max());
+    report(ali::widening_sum(std::span<const std::int16_t>(loud)) == std::int64_t(loud.size()) * 32767, "widening_sum of 2^20 x 32767");
+    report(!ali::checked_sum(std::span<const std::int16_t>(loud)), "checked_sum overflow detected");
+
+    return ali::check::finish();
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ALI_SATURATING_X86 1
+#endif
+
+/*
+    -----------------------
+    Overflow-safe Integer Arithmetic
+    -----------------------
+    Threads/main.cpp prints
+
+        int32_t a = 1000000000;
+        int32_t b = 1500000000;
+        (a+b)/2  =  -897483648
+
+    because a+b = 2.5e9 does not fit into an int32_t (max 2147483647).
+    Signed overflow is even undefined behaviour in C++, so the compiler is
+    free to do anything at all.
+
+    Scalar helpers (any integer type):
+        midpoint(a, b)      (a+b)/2 without overflow, rounded towards a
+                            (same as C++20 std::midpoint)
+        sat_add/sub/mul     clamp to [min, max] instead of wrapping around
+        checked_add(a,b,r)  false on overflow, like __builtin_add_overflow
+
+    Span kernels (int16_t and int32_t samples):
+        midpoint(a, b, out)         sat_add(a, b, out)
+        sat_sub(a, b, out)          sat_mul(a, b, out)
+        widening_sum(a)             exact sum as int64_t
+        checked_sum(a)              exact sum, std::nullopt if it does not fit
+                                    back into the sample type
+
+    out may alias a or b; all spans must have the same size.
+
+    The kernels exist three times: plain scalar, SSE4.2 and AVX2. The vector
+    versions are compiled from the same source (saturating_kernels.inl) with
+    "#pragma GCC target", so no -mavx2 is needed on the command line and the
+    binary still runs on older CPUs: the best version is picked once, at
+    run time, from what the CPU reports (see activeIsa()).
+*/
+
+namespace ali {
+
+//-----------------------------------------------------
+// Scalar
+//-----------------------------------------------------
+template <typename T>
+constexpr T midpoint(T a, T b) noexcept
+{
+    static_assert(std::is_integral_v<T>);
+    using U = std::make_unsigned_t<T>;
+    // (b - a) computed in unsigned arithmetic never overflows
+    if (a > b)
+        return T(a - T(U(U(a) - U(b)) / 2));
+    return T(a + T(U(U(b) - U(a)) / 2));
+}
+
+template <typename T>
+constexpr bool checked_add(T a, T b, T& result) noexcept { return !__builtin_add_overflow(a, b, &result); }
+
+template <typename T>
+constexpr bool checked_sub(T a, T b, T& result) noexcept { return !__builtin_sub_overflow(a, b, &result); }
+
+template <typename T>
+constexpr bool checked_mul(T a, T b, T& result) noexcept { return !__builtin_mul_overflow(a, b, &result); }
+
+template <typename T>
+constexpr T sat_add(T a, T b) noexcept
+{
+    T r{};
+    if (checked_add(a, b, r)) return r;
+    if constexpr (std::is_signed_v<T>)
+        return b < 0 ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+    else
+        return std::numeric_limits<T>::max();
+}
+
+template <typename T>
+constexpr T sat_sub(T a, T b) noexcept
+{
+    T r{};
+    if (checked_sub(a, b, r)) return r;
+    if constexpr (std::is_signed_v<T>)
+        return b < 0 ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+    else
+        return std::numeric_limits<T>::min();
+}
+
+template <typename T>
+constexpr T sat_mul(T a, T b) noexcept
+{
+    T r{};
+    if (checked_mul(a, b, r)) return r;
+    if constexpr (std::is_signed_v<T>)
+        return (a < 0) != (b < 0) ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+    else
+        return std::numeric_limits<T>::max();
+}
+
+namespace simd {
+
+enum class Isa { Scalar, SSE42, AVX2 };
+
+inline const char* name(Isa isa)
+{
+    switch (isa) {
+        case Isa::AVX2:  return "avx2";
+        case Isa::SSE42: return "sse4.2";
+        default:         return "scalar";
+    }
+}
+
+inline bool supported(Isa isa)
+{
+#ifdef ALI_SATURATING_X86
+    __builtin_cpu_init();
+    switch (isa) {
+        case Isa::AVX2:  return __builtin_cpu_supports("avx2");
+        case Isa::SSE42: return __builtin_cpu_supports("sse4.2");
+        default:         return true;
+    }
+#else
+    return isa == Isa::Scalar;
+#endif
+}
+
+// The fastest instruction set this CPU supports.
+inline Isa detectIsa()
+{
+    if (supported(Isa::AVX2))  return Isa::AVX2;
+    if (supported(Isa::SSE42)) return Isa::SSE42;
+    return Isa::Scalar;
+}
+
+//-----------------------------------------------------
+// Plain scalar loops (also the reference for the vector versions)
+//-----------------------------------------------------
+namespace scalar {
+
+// The next bigger type holds every sum, difference and product of two
+// samples: compute wide and clamp, which the compiler turns into
+// branch-free (and auto-vectorised) code
+template <typename T>
+using Wide = std::conditional_t<sizeof(T) == 2, std::int32_t, std::int64_t>;
+
+template <typename T>
+inline T clampWide(Wide<T> x)
+{
+    constexpr Wide<T> lo = std::numeric_limits<T>::min();
+    constexpr Wide<T> hi = std::numeric_limits<T>::max();
+    return T(x < lo ? lo : x > hi ? hi : x);
+}
+
+template <typename T, typename Op>
+inline void apply(const T* a, const T* b, T* out, std::size_t n, Op op)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = op(Wide<T>(a[i]), Wide<T>(b[i]));
+}
+
+// (a+b)/2 rounded towards a
+template <typename T>
+inline void midpoint(const T* a, const T* b, T* out, std::size_t n)
+{
+    apply(a, b, out, n, [](Wide<T> x, Wide<T> y) { return T(x + ((y - x) >> 1) + ((y - x) & (x > y))); });
+}
+
+template <typename T> inline void satAdd(const T* a, const T* b, T* out, std::size_t n) { apply(a, b, out, n, [](Wide<T> x, Wide<T> y) { return clampWide<T>(x + y); }); }
+template <typename T> inline void satSub(const T* a, const T* b, T* out, std::size_t n) { apply(a, b, out, n, [](Wide<T> x, Wide<T> y) { return clampWide<T>(x - y); }); }
+template <typename T> inline void satMul(const T* a, const T* b, T* out, std::size_t n) { apply(a, b, out, n, [](Wide<T> x, Wide<T> y) { return clampWide<T>(x * y); }); }
+
+inline void midpoint16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n) { midpoint(a, b, out, n); }
+inline void midpoint32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n) { midpoint(a, b, out, n); }
+inline void satAdd16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n)   { satAdd(a, b, out, n); }
+inline void satAdd32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n)   { satAdd(a, b, out, n); }
+inline void satSub16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n)   { satSub(a, b, out, n); }
+inline void satSub32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n)   { satSub(a, b, out, n); }
+inline void satMul16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n)   { satMul(a, b, out, n); }
+inline void satMul32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n)   { satMul(a, b, out, n); }
+
+inline std::int64_t widenSum16(const std::int16_t* a, std::size_t n)
+{
+    std::int64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += a[i];
+    return sum;
+}
+
+inline std::int64_t widenSum32(const std::int32_t* a, std::size_t n)
+{
+    std::int64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += a[i];
+    return sum;
+}
+
+} // namespace scalar
+
+#ifdef ALI_SATURATING_X86
+
+//-----------------------------------------------------
+// SSE4.2: 128-bit registers
+//-----------------------------------------------------
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+namespace sse42 {
+
+struct V
+{
+    using reg = __m128i;
+    static constexpr std::size_t kLanes16 = 8;
+    static constexpr std::size_t kLanes32 = 4;
+
+    static reg load(const void* p)              { return _mm_loadu_si128(static_cast<const reg*>(p)); }
+    static void store(void* p, reg v)           { _mm_storeu_si128(static_cast<reg*>(p), v); }
+    static reg zero()                           { return _mm_setzero_si128(); }
+    static reg set16(std::int16_t x)            { return _mm_set1_epi16(x); }
+    static reg set32(std::int32_t x)            { return _mm_set1_epi32(x); }
+    static reg set64(std::int64_t x)            { return _mm_set1_epi64x(x); }
+
+    static reg band(reg a, reg b)               { return _mm_and_si128(a, b); }
+    static reg bxor(reg a, reg b)               { return _mm_xor_si128(a, b); }
+    static reg select(reg mask, reg a, reg b)   { return _mm_blendv_epi8(b, a, mask); }    // mask ? a : b
+
+    static reg add16(reg a, reg b)              { return _mm_add_epi16(a, b); }
+    static reg add32(reg a, reg b)              { return _mm_add_epi32(a, b); }
+    static reg add64(reg a, reg b)              { return _mm_add_epi64(a, b); }
+    static reg sub32(reg a, reg b)              { return _mm_sub_epi32(a, b); }
+    static reg adds16(reg a, reg b)             { return _mm_adds_epi16(a, b); }
+    static reg subs16(reg a, reg b)             { return _mm_subs_epi16(a, b); }
+    static reg cmpgt16(reg a, reg b)            { return _mm_cmpgt_epi16(a, b); }
+    static reg cmpgt32(reg a, reg b)            { return _mm_cmpgt_epi32(a, b); }
+    static reg cmpgt64(reg a, reg b)            { return _mm_cmpgt_epi64(a, b); }
+    template <int S> static reg srai16(reg a)   { return _mm_srai_epi16(a, S); }
+    template <int S> static reg srai32(reg a)   { return _mm_srai_epi32(a, S); }
+    template <int S> static reg srli64(reg a)   { return _mm_srli_epi64(a, S); }
+    template <int S> static reg slli64(reg a)   { return _mm_slli_epi64(a, S); }
+
+    static reg mullo16(reg a, reg b)            { return _mm_mullo_epi16(a, b); }
+    static reg mulhi16(reg a, reg b)            { return _mm_mulhi_epi16(a, b); }
+    static reg mul32x64(reg a, reg b)           { return _mm_mul_epi32(a, b); }
+    static reg madd16(reg a, reg b)             { return _mm_madd_epi16(a, b); }
+    static reg unpacklo16(reg a, reg b)         { return _mm_unpacklo_epi16(a, b); }
+    static reg unpackhi16(reg a, reg b)         { return _mm_unpackhi_epi16(a, b); }
+    static reg packs32(reg a, reg b)            { return _mm_packs_epi32(a, b); }
+    static reg blendOdd32(reg even, reg odd)    { return _mm_blend_epi16(even, odd, 0xCC); }
+
+    static reg widenLo32(reg a)                 { return _mm_cvtepi32_epi64(a); }
+    static reg widenHi32(reg a)                 { return _mm_cvtepi32_epi64(_mm_srli_si128(a, 8)); }
+    static std::int64_t hsum64(reg a)           { return _mm_cvtsi128_si64(a) + _mm_extract_epi64(a, 1); }
+};
+
+#include "saturating_kernels.inl"
+
+} // namespace sse42
+#pragma GCC pop_options
+
+//-----------------------------------------------------
+// AVX2: 256-bit registers
+//-----------------------------------------------------
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace avx2 {
+
+struct V
+{
+    using reg = __m256i;
+    static constexpr std::size_t kLanes16 = 16;
+    static constexpr std::size_t kLanes32 = 8;
+
+    static reg load(const void* p)              { return _mm256_loadu_si256(static_cast<const reg*>(p)); }
+    static void store(void* p, reg v)           { _mm256_storeu_si256(static_cast<reg*>(p), v); }
+    static reg zero()                           { return _mm256_setzero_si256(); }
+    static reg set16(std::int16_t x)            { return _mm256_set1_epi16(x); }
+    static reg set32(std::int32_t x)            { return _mm256_set1_epi32(x); }
+    static reg set64(std::int64_t x)            { return _mm256_set1_epi64x(x); }
+
+    static reg band(reg a, reg b)               { return _mm256_and_si256(a, b); }
+    static reg bxor(reg a, reg b)               { return _mm256_xor_si256(a, b); }
+    static reg select(reg mask, reg a, reg b)   { return _mm256_blendv_epi8(b, a, mask); }
+
+    static reg add16(reg a, reg b)              { return _mm256_add_epi16(a, b); }
+    static reg add32(reg a, reg b)              { return _mm256_add_epi32(a, b); }
+    static reg add64(reg a, reg b)              { return _mm256_add_epi64(a, b); }
+    static reg sub32(reg a, reg b)              { return _mm256_sub_epi32(a, b); }
+    static reg adds16(reg a, reg b)             { return _mm256_adds_epi16(a, b); }
+    static reg subs16(reg a, reg b)             { return _mm256_subs_epi16(a, b); }
+    static reg cmpgt16(reg a, reg b)            { return _mm256_cmpgt_epi16(a, b); }
+    static reg cmpgt32(reg a, reg b)            { return _mm256_cmpgt_epi32(a, b); }
+    static reg cmpgt64(reg a, reg b)            { return _mm256_cmpgt_epi64(a, b); }
+    template <int S> static reg srai16(reg a)   { return _mm256_srai_epi16(a, S); }
+    template <int S> static reg srai32(reg a)   { return _mm256_srai_epi32(a, S); }
+    template <int S> static reg srli64(reg a)   { return _mm256_srli_epi64(a, S); }
+    template <int S> static reg slli64(reg a)   { return _mm256_slli_epi64(a, S); }
+
+    static reg mullo16(reg a, reg b)            { return _mm256_mullo_epi16(a, b); }
+    static reg mulhi16(reg a, reg b)            { return _mm256_mulhi_epi16(a, b); }
+    static reg mul32x64(reg a, reg b)           { return _mm256_mul_epi32(a, b); }
+    static reg madd16(reg a, reg b)             { return _mm256_madd_epi16(a, b); }
+    static reg unpacklo16(reg a, reg b)         { return _mm256_unpacklo_epi16(a, b); }
+    static reg unpackhi16(reg a, reg b)         { return _mm256_unpackhi_epi16(a, b); }
+    static reg packs32(reg a, reg b)            { return _mm256_packs_epi32(a, b); }
+    static reg blendOdd32(reg even, reg odd)    { return _mm256_blend_epi32(even, odd, 0xAA); }
+
+    static reg widenLo32(reg a)                 { return _mm256_cvtepi32_epi64(_mm256_castsi256_si128(a)); }
+    static reg widenHi32(reg a)                 { return _mm256_cvtepi32_epi64(_mm256_extracti128_si256(a, 1)); }
+    static std::int64_t hsum64(reg a)
+    {
+        const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+    }
+};
+
+#include "saturating_kernels.inl"
+
+} // namespace avx2
+#pragma GCC pop_options
+
+#endif // ALI_SATURATING_X86
+
+//-----------------------------------------------------
+// Runtime dispatch
+//-----------------------------------------------------
+struct Kernels
+{
+    void (*midpoint16)(const std::int16_t*, const std::int16_t*, std::int16_t*, std::size_t);
+    void (*midpoint32)(const std::int32_t*, const std::int32_t*, std::int32_t*, std::size_t);
+    void (*satAdd16)(const std::int16_t*, const std::int16_t*, std::int16_t*, std::size_t);
+    void (*satAdd32)(const std::int32_t*, const std::int32_t*, std::int32_t*, std::size_t);
+    void (*satSub16)(const std::int16_t*, const std::int16_t*, std::int16_t*, std::size_t);
+    void (*satSub32)(const std::int32_t*, const std::int32_t*, std::int32_t*, std::size_t);
+    void (*satMul16)(const std::int16_t*, const std::int16_t*, std::int16_t*, std::size_t);
+    void (*satMul32)(const std::int32_t*, const std::int32_t*, std::int32_t*, std::size_t);
+    std::int64_t (*widenSum16)(const std::int16_t*, std::size_t);
+    std::int64_t (*widenSum32)(const std::int32_t*, std::size_t);
+};
+
+#define ALI_SATURATING_KERNELS(ns) \
+    Kernels{ ns::midpoint16, ns::midpoint32, ns::satAdd16, ns::satAdd32, ns::satSub16, \
+             ns::satSub32, ns::satMul16, ns::satMul32, ns::widenSum16, ns::widenSum32 }
+
+// Kernels for the given instruction set, which the CPU must support.
+inline Kernels kernelsFor(Isa isa)
+{
+#ifdef ALI_SATURATING_X86
+    if (isa == Isa::AVX2)  return ALI_SATURATING_KERNELS(avx2);
+    if (isa == Isa::SSE42) return ALI_SATURATING_KERNELS(sse42);
+#endif
+    (void)isa;
+    return ALI_SATURATING_KERNELS(scalar);
+}
+
+#undef ALI_SATURATING_KERNELS
+
+// Set up on first use. Not thread-safe against concurrent use of the kernels:
+// call setIsa() (e.g. to compare instruction sets) before starting threads.
+inline Isa& activeIsaRef()
+{
+    static Isa isa = detectIsa();
+    return isa;
+}
+
+inline Kernels& activeKernels()
+{
+    static Kernels k = kernelsFor(activeIsaRef());
+    return k;
+}
+
+inline Isa activeIsa() { return activeIsaRef(); }
+
+inline void setIsa(Isa isa)
+{
+    assert(supported(isa));
+    activeIsaRef() = isa;
+    activeKernels() = kernelsFor(isa);
+}
+
+} // namespace simd
+
+//-----------------------------------------------------
+// Span API
+//-----------------------------------------------------
+#define ALI_SATURATING_BINARY(name, kernel, T)                                          \
+    inline void name(std::span<const T> a, std::span<const T> b, std::span<T> out)      \
+    {                                                                                   \
+        assert(a.size() == b.size() && a.size() == out.size());                         \
+        simd::activeKernels().kernel(a.data(), b.data(), out.data(), out.size());       \
+    }
+
+ALI_SATURATING_BINARY(midpoint, midpoint16, std::int16_t)
+ALI_SATURATING_BINARY(midpoint, midpoint32, std::int32_t)
+ALI_SATURATING_BINARY(sat_add,  satAdd16,   std::int16_t)
+ALI_SATURATING_BINARY(sat_add,  satAdd32,   std::int32_t)
+ALI_SATURATING_BINARY(sat_sub,  satSub16,   std::int16_t)
+ALI_SATURATING_BINARY(sat_sub,  satSub32,   std::int32_t)
+ALI_SATURATING_BINARY(sat_mul,  satMul16,   std::int16_t)
+ALI_SATURATING_BINARY(sat_mul,  satMul32,   std::int32_t)
+
+#undef ALI_SATURATING_BINARY
+
+inline std::int64_t widening_sum(std::span<const std::int16_t> a)
+{
+    return simd::activeKernels().widenSum16(a.data(), a.size());
+}
+
+// exact for up to 2^32 samples
+inline std::int64_t widening_sum(std::span<const std::int32_t> a)
+{
+    return simd::activeKernels().widenSum32(a.data(), a.size());
+}
+
+template <typename T>
+std::optional<T> checked_sum(std::span<const T> a)
+{
+    static_assert(std::is_same_v<T, std::int16_t> || std::is_same_v<T, std::int32_t>);
+    const std::int64_t sum = widening_sum(a);
+    if (sum < std::numeric_limits<T>::min() || sum > std::numeric_limits<T>::max())
+        return std::nullopt;
+    return static_cast<T>(sum);
+}
+
+} // namespace ali
@@ -0,0 +1,183 @@
+// Span kernels, written once against a small vector wrapper V and compiled
+// once per instruction set by saturating.hpp:
+//
+//     #pragma GCC target("avx2")      namespace avx2  { struct V {...};  #include this file }
+//     #pragma GCC target("sse4.2")    namespace sse42 { struct V {...};  #include this file }
+//
+// V::reg holds V::kLanes16 int16 lanes or V::kLanes32 int32 lanes.
+// Every kernel finishes the last (n % lanes) elements with the scalar code.
+//
+// No include guard on purpose.
+
+// round towards a, like std::midpoint:
+//   floor((a+b)/2) = (a & b) + ((a ^ b) >> 1)         never overflows
+//   + 1 when a > b and a+b is odd
+inline void midpoint16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n)
+{
+    const auto one = V::set16(1);
+    std::size_t i = 0;
+    for (; i + V::kLanes16 <= n; i += V::kLanes16) {
+        const auto va = V::load(a + i);
+        const auto vb = V::load(b + i);
+        const auto x = V::bxor(va, vb);
+        auto m = V::add16(V::band(va, vb), V::srai16<1>(x));
+        m = V::add16(m, V::band(V::cmpgt16(va, vb), V::band(x, one)));
+        V::store(out + i, m);
+    }
+    for (; i < n; ++i)
+        out[i] = ali::midpoint(a[i], b[i]);
+}
+
+inline void midpoint32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n)
+{
+    const auto one = V::set32(1);
+    std::size_t i = 0;
+    for (; i + V::kLanes32 <= n; i += V::kLanes32) {
+        const auto va = V::load(a + i);
+        const auto vb = V::load(b + i);
+        const auto x = V::bxor(va, vb);
+        auto m = V::add32(V::band(va, vb), V::srai32<1>(x));
+        m = V::add32(m, V::band(V::cmpgt32(va, vb), V::band(x, one)));
+        V::store(out + i, m);
+    }
+    for (; i < n; ++i)
+        out[i] = ali::midpoint(a[i], b[i]);
+}
+
+inline void satAdd16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + V::kLanes16 <= n; i += V::kLanes16)
+        V::store(out + i, V::adds16(V::load(a + i), V::load(b + i)));
+    for (; i < n; ++i)
+        out[i] = ali::sat_add(a[i], b[i]);
+}
+
+inline void satSub16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + V::kLanes16 <= n; i += V::kLanes16)
+        V::store(out + i, V::subs16(V::load(a + i), V::load(b + i)));
+    for (; i < n; ++i)
+        out[i] = ali::sat_sub(a[i], b[i]);
+}
+
+// There is no saturating 32-bit add instruction before AVX-512.
+// Overflow happened iff a and b have the same sign and the sum has the other:
+//     overflow = (a ^ sum) & (b ^ sum)         (sign bit)
+// and then the result is INT32_MAX if a >= 0, INT32_MIN otherwise:
+//     saturated = (a >> 31) ^ INT32_MAX
+inline void satAdd32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n)
+{
+    const auto max = V::set32(std::numeric_limits<std::int32_t>::max());
+    std::size_t i = 0;
+    for (; i + V::kLanes32 <= n; i += V::kLanes32) {
+        const auto va = V::load(a + i);
+        const auto vb = V::load(b + i);
+        const auto sum = V::add32(va, vb);
+        const auto overflow = V::srai32<31>(V::band(V::bxor(va, sum), V::bxor(vb, sum)));
+        const auto saturated = V::bxor(V::srai32<31>(va), max);
+        V::store(out + i, V::select(overflow, saturated, sum));
+    }
+    for (; i < n; ++i)
+        out[i] = ali::sat_add(a[i], b[i]);
+}
+
+// a - b overflows iff a and b have different signs and the difference has the sign of b
+inline void satSub32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n)
+{
+    const auto max = V::set32(std::numeric_limits<std::int32_t>::max());
+    std::size_t i = 0;
+    for (; i + V::kLanes32 <= n; i += V::kLanes32) {
+        const auto va = V::load(a + i);
+        const auto vb = V::load(b + i);
+        const auto diff = V::sub32(va, vb);
+        const auto overflow = V::srai32<31>(V::band(V::bxor(va, vb), V::bxor(va, diff)));
+        const auto saturated = V::bxor(V::srai32<31>(va), max);
+        V::store(out + i, V::select(overflow, saturated, diff));
+    }
+    for (; i < n; ++i)
+        out[i] = ali::sat_sub(a[i], b[i]);
+}
+
+// The full 32-bit products come from mullo/mulhi; packs_epi32 then narrows
+// them back to 16 bits *with* saturation. Both unpack and pack work per
+// 128-bit lane, so the element order is preserved.
+inline void satMul16(const std::int16_t* a, const std::int16_t* b, std::int16_t* out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + V::kLanes16 <= n; i += V::kLanes16) {
+        const auto va = V::load(a + i);
+        const auto vb = V::load(b + i);
+        const auto lo = V::mullo16(va, vb);
+        const auto hi = V::mulhi16(va, vb);
+        V::store(out + i, V::packs32(V::unpacklo16(lo, hi), V::unpackhi16(lo, hi)));
+    }
+    for (; i < n; ++i)
+        out[i] = ali::sat_mul(a[i], b[i]);
+}
+
+// 64-bit products of the even and of the odd lanes, clamped to the int32
+// range, then interleaved back together.
+inline void satMul32(const std::int32_t* a, const std::int32_t* b, std::int32_t* out, std::size_t n)
+{
+    const auto max = V::set64(std::numeric_limits<std::int32_t>::max());
+    const auto min = V::set64(std::numeric_limits<std::int32_t>::min());
+
+    auto clamp = [&](V::reg p) {
+        p = V::select(V::cmpgt64(p, max), max, p);
+        return V::select(V::cmpgt64(min, p), min, p);
+    };
+
+    std::size_t i = 0;
+    for (; i + V::kLanes32 <= n; i += V::kLanes32) {
+        const auto va = V::load(a + i);
+        const auto vb = V::load(b + i);
+        const auto even = clamp(V::mul32x64(va, vb));
+        const auto odd  = clamp(V::mul32x64(V::srli64<32>(va), V::srli64<32>(vb)));
+        V::store(out + i, V::blendOdd32(even, V::slli64<32>(odd)));
+    }
+    for (; i < n; ++i)
+        out[i] = ali::sat_mul(a[i], b[i]);
+}
+
+// madd(x, 1) adds neighbouring int16 pairs into int32 lanes, |pair| <= 2^16.
+// The int32 lanes are flushed into int64 every kFlush vectors, long before
+// they could overflow.
+inline std::int64_t widenSum16(const std::int16_t* a, std::size_t n)
+{
+    constexpr std::size_t kFlush = 1 << 14;
+    const auto ones = V::set16(1);
+
+    auto total = V::zero();
+    std::size_t i = 0;
+    while (i + V::kLanes16 <= n) {
+        auto acc32 = V::zero();
+        for (std::size_t k = 0; k < kFlush && i + V::kLanes16 <= n; ++k, i += V::kLanes16)
+            acc32 = V::add32(acc32, V::madd16(V::load(a + i), ones));
+        total = V::add64(total, V::widenLo32(acc32));
+        total = V::add64(total, V::widenHi32(acc32));
+    }
+
+    std::int64_t sum = V::hsum64(total);
+    for (; i < n; ++i)
+        sum += a[i];
+    return sum;
+}
+
+inline std::int64_t widenSum32(const std::int32_t* a, std::size_t n)
+{
+    auto acc0 = V::zero();
+    auto acc1 = V::zero();
+    std::size_t i = 0;
+    for (; i + V::kLanes32 <= n; i += V::kLanes32) {
+        const auto v = V::load(a + i);
+        acc0 = V::add64(acc0, V::widenLo32(v));
+        acc1 = V::add64(acc1, V::widenHi32(v));
+    }
+
+    std::int64_t sum = V::hsum64(V::add64(acc0, acc1));
+    for (; i < n; ++i)
+        sum += a[i];
+    return sum;
+}
@@ -0,0 +1,252 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <execution>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef ALI_HAVE_TBB
+#include <tbb/global_control.h>
+#endif
+
+#include "bench_main.hpp"
+#include "parallel_algorithms.hpp"
+
+// The seq/par comparison that main.cpp has commented out, as a matrix:
+//
+//   algorithms   for_each, transform, reduce, sort, inclusive_scan, find, count_if
+//   policies     std::execution::seq, unseq, par, par_unseq and ali::execution::par
+//                on our own pool (Threads/Parallel)
+//   parameters   elements (1K ... 16M uint64_t) and threads (1, 2, 4 ... cores)
+//
+// The std parallel policies need TBB with libstdc++. Without it CMake builds
+// them anyway and libstdc++ runs them sequentially ("no TBB" in the label).
+// The thread count is applied with tbb::global_control for std and with the
+// size of the pool for ali.
+//
+// sort copies the unsorted input first (same cost for every policy), find
+// looks for a value that is only at the very end.
+//
+// After the run a table shows the crossover per algorithm, policy and thread
+// count: the smallest size from which on the policy beats seq at every size.
+
+namespace {
+
+enum class Policy { Seq, Unseq, Par, ParUnseq, Pool };
+const char* const kPolicyNames[] = { "seq", "unseq", "par", "par_unseq", "pool" };
+
+using Value = std::uint64_t;
+
+const std::vector<Value>& input(std::size_t n)
+{
+  static std::map<std::size_t, std::vector<Value>> cache;
+  auto& v = cache[n];
+  if (v.size() != n) {
+    v.resize(n);
+    std::mt19937_64 rng(42);
+    for (auto& x : v)
+      x = rng() % 1000000;
+    v.back() = 1000000;                   // the value find() is looking for
+  }
+  return v;
+}
+
+// Runs fn(policy) with the execution policy object for p, on `threads` threads.
+template <class Fn>
+void withPolicy(Policy p, std::size_t threads, Fn fn)
+{
+  switch (p) {
+    case Policy::Seq:   fn(std::execution::seq);   break;
+    case Policy::Unseq: fn(std::execution::unseq); break;
+    case Policy::Par:
+    case Policy::ParUnseq: {
+#ifdef ALI_HAVE_TBB
+      tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+#endif
+      if (p == Policy::Par) fn(std::execution::par);
+      else                  fn(std::execution::par_unseq);
+      break;
+    }
+    case Policy::Pool: {
+      // the calling thread takes part, so threads - 1 workers
+      static std::map<std::size_t, std::unique_ptr<ali::ThreadPool>> pools;
+      auto& pool = pools[threads];
+      if (!pool)
+        pool = std::make_unique<ali::ThreadPool>(threads - 1);
+      fn(ali::execution::par.on(*pool));
+      break;
+    }
+  }
+}
+
+// std:: for the std policies, ali:: for ours
+template <class P> constexpr bool isAli = ali::execution::is_execution_policy_v<std::decay_t<P>>;
+
+#define ALI_DISPATCH(name)                                                          \
+  template <class P, class... Args>                                                 \
+  auto name(P&& policy, Args&&... args)                                             \
+  {                                                                                 \
+    if constexpr (isAli<P>)                                                         \
+      return ali::name(std::forward<P>(policy), std::forward<Args>(args)...);       \
+    else                                                                            \
+      return std::name(std::forward<P>(policy), std::forward<Args>(args)...);       \
+  }
+
+namespace dispatch {
+ALI_DISPATCH(for_each)
+ALI_DISPATCH(transform)
+ALI_DISPATCH(reduce)
+ALI_DISPATCH(sort)
+ALI_DISPATCH(inclusive_scan)
+ALI_DISPATCH(find)
+ALI_DISPATCH(count_if)
+}
+
+#undef ALI_DISPATCH
+
+//-----------------------------------------------------
+// The algorithms
+//-----------------------------------------------------
+struct Algorithm
+{
+  const char* name;
+  // one call on n elements; scratch has n elements
+  void (*run)(Policy, std::size_t threads, const std::vector<Value>& in, std::vector<Value>& scratch);
+};
+
+const Algorithm kAlgorithms[] = {
+  { "for_each", [](Policy p, std::size_t t, const std::vector<Value>&, std::vector<Value>& v) {
+      withPolicy(p, t, [&](auto&& policy) { dispatch::for_each(policy, v.begin(), v.end(), [](Value& x) { x = x * 3 + 1; }); });
+  } },
+  { "transform", [](Policy p, std::size_t t, const std::vector<Value>& in, std::vector<Value>& out) {
+      withPolicy(p, t, [&](auto&& policy) { dispatch::transform(policy, in.begin(), in.end(), out.begin(), [](Value x) { return x * x + 1; }); });
+  } },
+  { "reduce", [](Policy p, std::size_t t, const std::vector<Value>& in, std::vector<Value>&) {
+      withPolicy(p, t, [&](auto&& policy) { benchmark::DoNotOptimize(dispatch::reduce(policy, in.begin(), in.end(), Value(0))); });
+  } },
+  { "sort", [](Policy p, std::size_t t, const std::vector<Value>& in, std::vector<Value>& v) {
+      std::copy(in.begin(), in.end(), v.begin());
+      withPolicy(p, t, [&](auto&& policy) { dispatch::sort(policy, v.begin(), v.end()); });
+  } },
+  { "inclusive_scan", [](Policy p, std::size_t t, const std::vector<Value>& in, std::vector<Value>& out) {
+      withPolicy(p, t, [&](auto&& policy) { dispatch::inclusive_scan(policy, in.begin(), in.end(), out.begin()); });
+  } },
+  { "find", [](Policy p, std::size_t t, const std::vector<Value>& in, std::vector<Value>&) {
+      withPolicy(p, t, [&](auto&& policy) { benchmark::DoNotOptimize(dispatch::find(policy, in.begin(), in.end(), Value(1000000))); });
+  } },
+  { "count_if", [](Policy p, std::size_t t, const std::vector<Value>& in, std::vector<Value>&) {
+      withPolicy(p, t, [&](auto&& policy) { benchmark::DoNotOptimize(dispatch::count_if(policy, in.begin(), in.end(), [](Value x) { return x % 3 == 0; })); });
+  } },
+};
+
+void BM_Algorithm(benchmark::State& state, const Algorithm& algorithm, Policy policy)
+{
+  const std::size_t n = state.range(0);
+  const std::size_t threads = state.range(1);
+  const auto& in = input(n);
+  std::vector<Value> scratch(in);
+
+  for (auto _ : state) {
+    algorithm.run(policy, threads, in, scratch);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+#ifndef ALI_HAVE_TBB
+  if (policy == Policy::Par || policy == Policy::ParUnseq)
+    state.SetLabel("no TBB");
+#endif
+}
+
+void registerBenchmarks()
+{
+  std::vector<std::int64_t> threads;
+  const std::int64_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  for (std::int64_t t = 1; t < hardware; t *= 2)
+    threads.push_back(t);
+  threads.push_back(hardware);
+
+  for (const auto& algorithm : kAlgorithms) {
+    for (int p = 0; p < 5; ++p) {
+      const auto policy = Policy(p);
+      const bool parallel = policy == Policy::Par || policy == Policy::ParUnseq || policy == Policy::Pool;
+      auto* b = benchmark::RegisterBenchmark((std::string(algorithm.name) + "/" + kPolicyNames[p]).c_str(),
+                                             BM_Algorithm, algorithm, policy);
+      b->ArgNames({ "n", "threads" })->UseRealTime();
+      for (std::int64_t n = 1 << 10; n <= 1 << 24; n *= 4)
+        for (std::int64_t t : threads)
+          if (parallel || t == 1)
+            b->Args({ n, t });
+    }
+  }
+}
+
+//-----------------------------------------------------
+// Crossover table
+//-----------------------------------------------------
+// Console output as usual, plus the real time of every run for the table.
+class CrossoverReporter : public benchmark::ConsoleReporter
+{
+public:
+  void ReportRuns(const std::vector<Run>& runs) override
+  {
+    for (const auto& run : runs) {
+      if (run.run_type != Run::RT_Iteration || run.error_occurred)
+        continue;
+      // function_name "sort/pool", args "n:1024/threads:4"
+      const std::string& name = run.run_name.function_name;
+      std::size_t n = 0, threads = 0;
+      std::sscanf(run.run_name.args.c_str(), "n:%zu/threads:%zu", &n, &threads);
+      times_[name][threads][n] = run.GetAdjustedRealTime();
+    }
+    ConsoleReporter::ReportRuns(runs);
+  }
+
+  void printCrossover() const
+  {
+    std::cout << "\nCrossover: smallest size from which on the policy is faster than seq\n\n";
+    std::cout << std::left << std::setw(26) << "algorithm/policy" << std::setw(9) << "threads" << "crossover\n";
+    for (const auto& [name, perThreads] : times_) {
+      const std::string algorithm = name.substr(0, name.find('/'));
+      const auto seq = times_.find(algorithm + "/seq");
+      if (name == algorithm + "/seq" || seq == times_.end() || !seq->second.count(1))
+        continue;
+      const auto& seqTimes = seq->second.at(1);
+
+      for (const auto& [threads, perSize] : perThreads) {
+        // walk down from the largest size while the policy still wins
+        std::size_t crossover = 0;
+        for (auto it = perSize.rbegin(); it != perSize.rend(); ++it) {
+          const auto s = seqTimes.find(it->first);
+          if (s == seqTimes.end() || it->second >= s->second)
+            break;
+          crossover = it->first;
+        }
+        std::cout << std::setw(26) << name << std::setw(9) << threads
+                  << (crossover ? std::to_string(crossover) : std::string("never")) << "\n";
+      }
+    }
+  }
+
+private:
+  // name -> threads -> elements -> real time
+  std::map<std::string, std::map<std::size_t, std::map<std::size_t, double>>> times_;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  registerBenchmarks();
+  CrossoverReporter reporter;
+  const int result = ali::runBenchmarks(argc, argv, &reporter);
+  reporter.printCrossover();
+  return result;
+}
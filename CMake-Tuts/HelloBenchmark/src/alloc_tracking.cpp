@@ -0,0 +1,237 @@
+#include "alloc_tracking.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+
+// glibc's own entry points: the interposed malloc() below forwards to them
+extern "C" {
+void* __libc_malloc(std::size_t);
+void* __libc_calloc(std::size_t, std::size_t);
+void* __libc_realloc(void*, std::size_t);
+void* __libc_memalign(std::size_t, std::size_t);
+void  __libc_free(void*);
+}
+#endif
+
+// See alloc_tracking.hpp.
+//
+// Everything here may run before main(), after exit() and from inside the
+// allocator of another library, so it only touches constant-initialised
+// atomics: no locks, no allocation, no statics with constructors.
+
+namespace {
+
+std::atomic<bool>           active{false};
+std::atomic<std::uint64_t>  allocations{0};
+std::atomic<std::uint64_t>  frees{0};
+std::atomic<std::uint64_t>  bytes{0};
+std::atomic<std::int64_t>   live{0};
+std::atomic<std::int64_t>   peakLive{0};
+std::atomic<bool>           budgetExceeded{false};
+
+#ifdef __GLIBC__
+void* rawAlloc(std::size_t n)                       { return __libc_malloc(n); }
+void* rawAlignedAlloc(std::size_t a, std::size_t n) { return __libc_memalign(a, n); }
+void  rawFree(void* p)                              { __libc_free(p); }
+std::size_t usableSize(void* p)                     { return p ? malloc_usable_size(p) : 0; }
+#else
+void* rawAlloc(std::size_t n)                       { return std::malloc(n); }
+void* rawAlignedAlloc(std::size_t a, std::size_t n) { return std::aligned_alloc(a, (n + a - 1) / a * a); }
+void  rawFree(void* p)                              { std::free(p); }
+std::size_t usableSize(void*)                       { return 0; }
+#endif
+
+void onAlloc(void* p, std::size_t requested)
+{
+    if (!p || !active.load(std::memory_order_relaxed))
+        return;
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(requested, std::memory_order_relaxed);
+
+    const auto now = live.fetch_add(std::int64_t(usableSize(p)), std::memory_order_relaxed) + std::int64_t(usableSize(p));
+    auto peak = peakLive.load(std::memory_order_relaxed);
+    while (now > peak && !peakLive.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+}
+
+// before the memory goes back to the allocator
+void onFree(void* p)
+{
+    if (!p || !active.load(std::memory_order_relaxed))
+        return;
+    frees.fetch_add(1, std::memory_order_relaxed);
+    live.fetch_sub(std::int64_t(usableSize(p)), std::memory_order_relaxed);
+}
+
+void* countedAlloc(std::size_t n)
+{
+    void* p = rawAlloc(n);
+    onAlloc(p, n);
+    return p;
+}
+
+void* countedAlignedAlloc(std::size_t alignment, std::size_t n)
+{
+    void* p = rawAlignedAlloc(alignment, n);
+    onAlloc(p, n);
+    return p;
+}
+
+void countedFree(void* p)
+{
+    onFree(p);
+    rawFree(p);
+}
+
+void* newOrThrow(std::size_t n)
+{
+    if (n == 0) n = 1;
+    while (true) {
+        if (void* p = countedAlloc(n))
+            return p;
+        if (auto handler = std::get_new_handler())
+            handler();
+        else
+            throw std::bad_alloc();
+    }
+}
+
+void* alignedNewOrThrow(std::size_t n, std::align_val_t alignment)
+{
+    if (n == 0) n = 1;
+    while (true) {
+        if (void* p = countedAlignedAlloc(std::size_t(alignment), n))
+            return p;
+        if (auto handler = std::get_new_handler())
+            handler();
+        else
+            throw std::bad_alloc();
+    }
+}
+
+} // namespace
+
+//-----------------------------------------------------
+// ali::
+//-----------------------------------------------------
+namespace ali {
+
+namespace alloc {
+
+void start()
+{
+    allocations = 0;
+    frees = 0;
+    bytes = 0;
+    live = 0;
+    peakLive = 0;
+    active.store(true, std::memory_order_seq_cst);
+}
+
+AllocCounts stop()
+{
+    active.store(false, std::memory_order_seq_cst);
+    AllocCounts c;
+    c.allocations = allocations.load();
+    c.frees = frees.load();
+    c.bytes = bytes.load();
+    c.peakLive = peakLive.load();
+    return c;
+}
+
+bool tracksLiveBytes()
+{
+#ifdef __GLIBC__
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace alloc
+
+bool allocBudgetExceeded()      { return budgetExceeded.load(); }
+void markAllocBudgetExceeded()  { budgetExceeded.store(true); }
+
+} // namespace ali
+
+//-----------------------------------------------------
+// C allocation functions (glibc only)
+//-----------------------------------------------------
+#ifdef __GLIBC__
+extern "C" {
+
+void* malloc(std::size_t n) noexcept { return countedAlloc(n); }
+
+void free(void* p) noexcept { countedFree(p); }
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    void* p = __libc_calloc(count, size);
+    onAlloc(p, count * size);
+    return p;
+}
+
+// counted as one allocation of the new size and one free of the old block
+void* realloc(void* old, std::size_t n) noexcept
+{
+    if (!old)
+        return countedAlloc(n);
+    if (n == 0) {
+        countedFree(old);
+        return nullptr;
+    }
+    const std::size_t oldSize = usableSize(old);
+    void* p = __libc_realloc(old, n);
+    if (p && active.load(std::memory_order_relaxed)) {
+        frees.fetch_add(1, std::memory_order_relaxed);
+        live.fetch_sub(std::int64_t(oldSize), std::memory_order_relaxed);
+        onAlloc(p, n);
+    }
+    return p;
+}
+
+void* memalign(std::size_t alignment, std::size_t n) noexcept { return countedAlignedAlloc(alignment, n); }
+
+void* aligned_alloc(std::size_t alignment, std::size_t n) noexcept { return countedAlignedAlloc(alignment, n); }
+
+int posix_memalign(void** out, std::size_t alignment, std::size_t n) noexcept
+{
+    void* p = countedAlignedAlloc(alignment, n);
+    if (!p)
+        return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+} // extern "C"
+#endif
+
+//-----------------------------------------------------
+// Global operator new/delete
+//-----------------------------------------------------
+void* operator new(std::size_t n)                                               { return newOrThrow(n); }
+void* operator new[](std::size_t n)                                             { return newOrThrow(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept               { return countedAlloc(n ? n : 1); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept             { return countedAlloc(n ? n : 1); }
+void* operator new(std::size_t n, std::align_val_t a)                           { return alignedNewOrThrow(n, a); }
+void* operator new[](std::size_t n, std::align_val_t a)                         { return alignedNewOrThrow(n, a); }
+void* operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept   { return countedAlignedAlloc(std::size_t(a), n ? n : 1); }
+void* operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return countedAlignedAlloc(std::size_t(a), n ? n : 1); }
+
+void operator delete(void* p) noexcept                                          { countedFree(p); }
+void operator delete[](void* p) noexcept                                        { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept                             { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept                           { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept                   { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept                 { countedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept                        { countedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                      { countedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept           { countedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept         { countedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(p); }
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/*
+    -----------------------
+    Allocation Tracking
+    -----------------------
+    How many heap allocations does one iteration of a benchmark make? Wall
+    time hides it until the allocator becomes the bottleneck.
+
+    alloc_tracking.cpp replaces the global operator new/delete and, with
+    glibc, interposes malloc/calloc/realloc/free as well, so allocations made
+    inside the standard library or C code are seen too. Counting is off
+    unless an AllocScope is alive, so the benchmark library's own allocations
+    and the setup code are not counted:
+
+        static void BM_PushBack(benchmark::State& state)
+        {
+            ali::AllocScope allocs(state, 1);       // at most 1 allocation per iteration
+            for (auto _ : state) {
+                std::vector<S> v;
+                v.reserve(8);
+                ...
+            }
+        }
+
+    Reported as custom counters:
+
+        allocs/iter     allocations per iteration
+        bytes/iter      bytes requested per iteration
+        peak-live       highest number of bytes allocated and not yet freed,
+                        counted from the start of the scope
+
+    Budget:  with a maximum number of allocations per iteration, a benchmark
+    that goes over it is marked as failed (SkipWithError), and
+    ali::allocBudgetExceeded() turns true so main() can return non-zero:
+
+        int main(int argc, char** argv)
+        {
+            ...
+            benchmark::RunSpecifiedBenchmarks();
+            return ali::allocBudgetExceeded() ? 1 : 0;
+        }
+
+    Counting is process-wide (threads included) and the counters are global,
+    so only one AllocScope may be alive at a time. peak-live needs the size
+    of freed blocks, which only glibc tells us (malloc_usable_size); elsewhere
+    it is not reported.
+
+    Add alloc_tracking.cpp to the sources of the benchmark executable.
+*/
+
+namespace ali {
+
+struct AllocCounts
+{
+    std::uint64_t allocations = 0;
+    std::uint64_t frees = 0;
+    std::uint64_t bytes = 0;
+    std::int64_t  peakLive = 0;
+};
+
+namespace alloc {
+
+// start counting from zero / stop counting and return what was seen
+void start();
+AllocCounts stop();
+
+// whether peak-live can be measured on this platform
+bool tracksLiveBytes();
+
+} // namespace alloc
+
+bool allocBudgetExceeded();
+void markAllocBudgetExceeded();
+
+class AllocScope
+{
+public:
+    static constexpr double kNoBudget = std::numeric_limits<double>::infinity();
+
+    explicit AllocScope(benchmark::State& state, double maxAllocsPerIteration = kNoBudget)
+        : state_(state), budget_(maxAllocsPerIteration)
+    {
+        alloc::start();
+    }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+    ~AllocScope()
+    {
+        const AllocCounts counts = alloc::stop();
+        const double iterations = double(state_.iterations());
+        if (iterations == 0)
+            return;
+
+        using benchmark::Counter;
+        const double perIteration = double(counts.allocations) / iterations;
+        state_.counters["allocs/iter"] = perIteration;
+        state_.counters["bytes/iter"] = Counter(double(counts.bytes), Counter::kAvgIterations, Counter::kIs1024);
+        if (alloc::tracksLiveBytes())
+            state_.counters["peak-live"] = Counter(double(counts.peakLive), Counter::kDefaults, Counter::kIs1024);
+
+        if (perIteration > budget_) {
+            markAllocBudgetExceeded();
+            state_.SkipWithError("allocation budget exceeded");
+        }
+    }
+
+private:
+    benchmark::State&   state_;
+    const double        budget_;
+};
+
+} // namespace ali
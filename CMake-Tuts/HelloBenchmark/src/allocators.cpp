@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "memory_resources.hpp"
+#include "resource_allocator.hpp"
+
+// Containers/Allocators plugged into vector, map, unordered_map and list,
+// against std::allocator and the std::pmr resources. One iteration is one
+// "request": create the resource, build and churn the container, destroy
+// both.
+//
+//   vector          push_back n ints (reallocates as it grows)
+//   map             insert n random keys, then n/2 times erase one + insert one
+//   unordered_map   the same
+//   list            push_back n, then n/2 times pop_front + push_back
+//
+// Allocators (second part of the name):
+//
+//   std             std::allocator (malloc)
+//   pmr-newdelete   polymorphic_allocator on new_delete_resource: the cost of
+//                   the virtual call alone
+//   pmr-monotonic   std::pmr::monotonic_buffer_resource
+//   pmr-pool        std::pmr::unsynchronized_pool_resource
+//   arena, pool, tls        ali:: resources through polymorphic_allocator
+//   arena-direct, ...       the same through ali::ResourceAllocator<T, R>
+//
+// Counter "upstream": memory the ali:: resource took from upstream per
+// request (its footprint; the arena never reuses freed memory).
+
+struct WithStd {
+  template <typename T> auto get() { return std::allocator<T>(); }
+  double upstream() const { return -1; }
+};
+
+struct WithNewDelete {
+  template <typename T> auto get() { return std::pmr::polymorphic_allocator<T>(std::pmr::new_delete_resource()); }
+  double upstream() const { return -1; }
+};
+
+template <typename Resource>
+struct WithPmr {
+  Resource resource;
+  template <typename T> auto get() { return std::pmr::polymorphic_allocator<T>(&resource); }
+  double upstream() const {
+    if constexpr (requires { resource.stats(); })
+      return double(resource.stats().upstreamBytes);
+    else
+      return -1;
+  }
+};
+
+template <typename Resource>
+struct WithDirect {
+  Resource resource;
+  template <typename T> auto get() { return ali::ResourceAllocator<T, Resource>(&resource); }
+  double upstream() const { return double(resource.stats().upstreamBytes); }
+};
+
+template <typename With, typename T>
+using AllocatorOf = decltype(std::declval<With&>().template get<T>());
+
+static std::vector<int> randomKeys(std::size_t n) {
+  std::mt19937 rng(1);
+  std::vector<int> keys(n + n / 2);
+  for (auto& k : keys)
+    k = int(rng());
+  return keys;
+}
+
+// runs `work(with)` per iteration and reports the upstream footprint
+template <typename With, typename Work>
+static void run(benchmark::State& state, Work work) {
+  double upstream = 0;
+  for (auto _ : state) {
+    With with;
+    work(with);
+    upstream += with.upstream();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  if (upstream >= 0)
+    state.counters["upstream"] = benchmark::Counter(upstream, benchmark::Counter::kAvgIterations, benchmark::Counter::kIs1024);
+}
+
+template <typename With>
+static void BM_Vector(benchmark::State& state) {
+  const int n = int(state.range(0));
+  run<With>(state, [n](With& with) {
+    std::vector<int, AllocatorOf<With, int>> v(with.template get<int>());
+    for (int i = 0; i < n; ++i)
+      v.push_back(i);
+    benchmark::DoNotOptimize(v.data());
+  });
+}
+
+template <typename Map, typename With>
+static void churnMap(With& with, const std::vector<int>& keys, std::size_t n) {
+  Map m(with.template get<typename Map::value_type>());
+  for (std::size_t i = 0; i < n; ++i)
+    m.emplace(keys[i], int(i));
+  for (std::size_t i = 0; i < n / 2; ++i) {
+    m.erase(keys[i * 2]);
+    m.emplace(keys[n + i], int(i));
+  }
+  benchmark::DoNotOptimize(m.size());
+}
+
+template <typename With>
+static void BM_Map(benchmark::State& state) {
+  const auto keys = randomKeys(state.range(0));
+  using Map = std::map<int, int, std::less<int>, AllocatorOf<With, std::pair<const int, int>>>;
+  run<With>(state, [&](With& with) { churnMap<Map>(with, keys, state.range(0)); });
+}
+
+template <typename With>
+static void BM_UnorderedMap(benchmark::State& state) {
+  const auto keys = randomKeys(state.range(0));
+  using Map = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, AllocatorOf<With, std::pair<const int, int>>>;
+  run<With>(state, [&](With& with) { churnMap<Map>(with, keys, state.range(0)); });
+}
+
+template <typename With>
+static void BM_List(benchmark::State& state) {
+  const int n = int(state.range(0));
+  run<With>(state, [n](With& with) {
+    std::list<int, AllocatorOf<With, int>> l(with.template get<int>());
+    for (int i = 0; i < n; ++i)
+      l.push_back(i);
+    for (int i = 0; i < n / 2; ++i) {
+      l.pop_front();
+      l.push_back(i);
+    }
+    benchmark::DoNotOptimize(l.back());
+  });
+}
+
+#define ALLOCATOR_BENCHMARKS(With, label)                                                    \
+  BENCHMARK_TEMPLATE(BM_Vector, With)->Name("vector/" label)->Arg(1 << 10)->Arg(1 << 16);    \
+  BENCHMARK_TEMPLATE(BM_Map, With)->Name("map/" label)->Arg(1 << 10)->Arg(1 << 16);          \
+  BENCHMARK_TEMPLATE(BM_UnorderedMap, With)->Name("unordered_map/" label)->Arg(1 << 10)->Arg(1 << 16); \
+  BENCHMARK_TEMPLATE(BM_List, With)->Name("list/" label)->Arg(1 << 10)->Arg(1 << 16)
+
+using WithPmrMonotonic = WithPmr<std::pmr::monotonic_buffer_resource>;
+using WithPmrPool = WithPmr<std::pmr::unsynchronized_pool_resource>;
+using WithArena = WithPmr<ali::MonotonicArena>;
+using WithPool = WithPmr<ali::SizeClassPool>;
+using WithTls = WithPmr<ali::ThreadLocalFreeList>;
+using WithArenaDirect = WithDirect<ali::MonotonicArena>;
+using WithPoolDirect = WithDirect<ali::SizeClassPool>;
+using WithTlsDirect = WithDirect<ali::ThreadLocalFreeList>;
+
+ALLOCATOR_BENCHMARKS(WithStd, "std");
+ALLOCATOR_BENCHMARKS(WithNewDelete, "pmr-newdelete");
+ALLOCATOR_BENCHMARKS(WithPmrMonotonic, "pmr-monotonic");
+ALLOCATOR_BENCHMARKS(WithPmrPool, "pmr-pool");
+ALLOCATOR_BENCHMARKS(WithArena, "arena");
+ALLOCATOR_BENCHMARKS(WithPool, "pool");
+ALLOCATOR_BENCHMARKS(WithTls, "tls");
+ALLOCATOR_BENCHMARKS(WithArenaDirect, "arena-direct");
+ALLOCATOR_BENCHMARKS(WithPoolDirect, "pool-direct");
+ALLOCATOR_BENCHMARKS(WithTlsDirect, "tls-direct");
+
+ALI_BENCHMARK_MAIN();
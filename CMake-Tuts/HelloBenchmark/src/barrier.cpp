@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <barrier>
+#include <thread>
+#include <vector>
+
+#include "barrier.hpp"
+#include "bench_main.hpp"
+
+// Threads/Barrier against std::barrier: the cost of one phase
+// (arrive_and_wait with no work in between) on 2 ... 64 threads.
+// Every iteration runs kPhases phases on a fresh set of threads.
+
+constexpr int kPhases = 1000;
+
+template <class Barrier>
+static void arrive(Barrier& b, std::size_t id) { b.arrive_and_wait(id); }
+
+template <class Completion>
+static void arrive(std::barrier<Completion>& b, std::size_t) { b.arrive_and_wait(); }
+
+template <class Barrier>
+static void BM_Phase(benchmark::State& state)
+{
+  const std::size_t threads = state.range(0);
+  for (auto _ : state) {
+    Barrier barrier(threads);
+    auto run = [&](std::size_t id) {
+      for (int phase = 0; phase < kPhases; ++phase)
+        arrive(barrier, id);
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t id = 1; id < threads; ++id)
+      pool.emplace_back(run, id);
+    run(0);
+    for (auto& t : pool)
+      t.join();
+  }
+  state.SetItemsProcessed(state.iterations() * kPhases);
+  state.SetLabel("items = phases");
+}
+
+BENCHMARK(BM_Phase<ali::SenseBarrier<>>)->RangeMultiplier(2)->Range(2, 64)->UseRealTime();
+BENCHMARK(BM_Phase<ali::TreeBarrier<>>)->RangeMultiplier(2)->Range(2, 64)->UseRealTime();
+BENCHMARK(BM_Phase<std::barrier<>>)->RangeMultiplier(2)->Range(2, 64)->UseRealTime();
+
+ALI_BENCHMARK_MAIN();
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/utsname.h>
+#endif
+
+/*
+    -----------------------
+    Benchmark Results Store
+    -----------------------
+    BENCHMARK_MAIN() prints to the console and keeps nothing. ALI_BENCHMARK_MAIN()
+    runs the same way but also writes every run as JSON:
+
+        bench_results/<executable>-<YYYYmmdd-HHMMSS>.json
+
+    (the directory comes from ALI_BENCH_RESULTS, ALI_BENCH_RESULTS=off turns
+    the file off; an explicit --benchmark_out=... wins over both)
+
+    Next to what the benchmark library records anyway (host, CPUs, caches,
+    load) the "context" of the JSON gets a fingerprint of the machine and the
+    build, so that two result files are only compared when they are
+    comparable:
+
+        cpu_model           /proc/cpuinfo
+        cpu_governor        cpufreq scaling governor of CPU 0 ("performance" is
+                            what you want for benchmarking)
+        cpu_boost           turbo/boost on or off
+        kernel              uname -r
+        compiler            __VERSION__
+        compiler_flags      CMAKE_CXX_FLAGS + flags of the build type
+        build_type          Release, Debug, ...
+        git_commit          of the source tree at configure time
+
+    Compare two runs with tools/compare.py. Use repetitions so it has samples
+    for its statistical test:
+
+        ./build/HelloBenchmark --benchmark_repetitions=10
+        python3 tools/compare.py bench_results/old.json bench_results/new.json
+*/
+
+#ifndef ALI_BENCH_CXX_FLAGS
+#define ALI_BENCH_CXX_FLAGS "unknown"
+#endif
+#ifndef ALI_BENCH_BUILD_TYPE
+#define ALI_BENCH_BUILD_TYPE "unknown"
+#endif
+#ifndef ALI_BENCH_GIT_COMMIT
+#define ALI_BENCH_GIT_COMMIT "unknown"
+#endif
+
+namespace ali {
+
+namespace detail {
+
+// first line of a file, "" if it cannot be read
+inline std::string firstLine(const char* path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+inline std::string cpuModel()
+{
+    std::ifstream in("/proc/cpuinfo");
+    for (std::string line; std::getline(in, line);) {
+        // "model name" on x86, "Model" / "CPU part" on some ARM kernels
+        if (line.rfind("model name", 0) == 0 || line.rfind("Model", 0) == 0) {
+            const auto colon = line.find(':');
+            if (colon != std::string::npos)
+                return line.substr(line.find_first_not_of(" \t", colon + 1));
+        }
+    }
+    return "unknown";
+}
+
+inline std::string cpuBoost()
+{
+    // intel_pstate: no_turbo = 1 means off; acpi-cpufreq / amd: boost = 1 means on
+    const std::string noTurbo = firstLine("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    if (!noTurbo.empty())
+        return noTurbo == "1" ? "off" : "on";
+    const std::string boost = firstLine("/sys/devices/system/cpu/cpufreq/boost");
+    if (!boost.empty())
+        return boost == "1" ? "on" : "off";
+    return "unknown";
+}
+
+inline std::string orUnknown(std::string s) { return s.empty() ? "unknown" : s; }
+
+inline std::string resultFile(const char* argv0)
+{
+    const char* dir = std::getenv("ALI_BENCH_RESULTS");
+    if (dir && std::string(dir) == "off")
+        return {};
+
+    const std::filesystem::path directory = dir && *dir ? dir : "bench_results";
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+        return {};
+
+    const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+
+    const std::string name = std::filesystem::path(argv0).filename().string();
+    return (directory / (name + "-" + stamp + ".json")).string();
+}
+
+} // namespace detail
+
+inline void addMachineFingerprint()
+{
+    benchmark::AddCustomContext("cpu_model", detail::cpuModel());
+    benchmark::AddCustomContext("cpu_governor", detail::orUnknown(detail::firstLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor")));
+    benchmark::AddCustomContext("cpu_boost", detail::cpuBoost());
+#ifdef __linux__
+    utsname u;
+    benchmark::AddCustomContext("kernel", uname(&u) == 0 ? u.release : "unknown");
+#endif
+#ifdef __VERSION__
+    benchmark::AddCustomContext("compiler", __VERSION__);
+#endif
+    benchmark::AddCustomContext("compiler_flags", ALI_BENCH_CXX_FLAGS);
+    benchmark::AddCustomContext("build_type", ALI_BENCH_BUILD_TYPE);
+    benchmark::AddCustomContext("git_commit", ALI_BENCH_GIT_COMMIT);
+}
+
+// BENCHMARK_MAIN() plus the fingerprint and the JSON file; returns main()'s result.
+// display replaces the console reporter when given.
+inline int runBenchmarks(int argc, char** argv, benchmark::BenchmarkReporter* display = nullptr)
+{
+    std::vector<char*> args(argv, argv + argc);
+
+    bool hasOut = false;
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]).rfind("--benchmark_out=", 0) == 0)
+            hasOut = true;
+
+    std::string out, format = "--benchmark_out_format=json";
+    if (!hasOut) {
+        const std::string file = detail::resultFile(argv[0]);
+        if (!file.empty()) {
+            out = "--benchmark_out=" + file;
+            args.push_back(out.data());
+            args.push_back(format.data());
+        }
+    }
+    args.push_back(nullptr);
+
+    int count = int(args.size()) - 1;
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+        return 1;
+
+    addMachineFingerprint();
+    benchmark::RunSpecifiedBenchmarks(display);
+    benchmark::Shutdown();
+    return 0;
+}
+
+} // namespace ali
+
+#define ALI_BENCHMARK_MAIN()                        \
+    int main(int argc, char** argv)                 \
+    {                                               \
+        return ali::runBenchmarks(argc, argv);      \
+    }                                               \
+    int main(int, char**)
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "bit_vector.hpp"
+#include "rank_select.hpp"
+
+// Containers/BitVector against std::vector<bool> on filter-sized bitmaps
+// (64K ... 256M rows).
+//
+//   Count         number of ones: std::count over vector<bool>, bit_vector::count
+//   And           a &= b: element loop over vector<bool>, bit_vector::operator&=
+//   CountAnd      |a & b|: ali::count_and, nothing written
+//   ForEachSet    visit every set bit: index loop over vector<bool>,
+//                 bit_vector::for_each_set (tzcnt), density 1% and 50%
+//   Rank/Select   random rank1 / select1 queries on 256M bits; the rows
+//                 std::vector<bool> would have to scan are not attempted
+//
+// Bulk kernels run once per instruction set (arg 1: 0 = scalar, 1 = popcnt,
+// 2 = avx2); sets the CPU does not support are skipped.
+
+namespace bitops = ali::bitops;
+
+static std::vector<bool> randomBools(std::size_t n, double density, unsigned seed)
+{
+  std::mt19937_64 rng(seed);
+  std::bernoulli_distribution one(density);
+  std::vector<bool> v(n);
+  for (std::size_t i = 0; i < n; ++i)
+    v[i] = one(rng);
+  return v;
+}
+
+static ali::bit_vector randomBits(std::size_t n, double density, unsigned seed)
+{
+  const auto bools = randomBools(n, density, seed);
+  ali::bit_vector bits(n);
+  for (std::size_t i = 0; i < n; ++i)
+    if (bools[i])
+      bits.set(i);
+  return bits;
+}
+
+static bool selectIsa(benchmark::State& state)
+{
+  const auto isa = bitops::Isa(state.range(1));
+  if (!bitops::supported(isa)) {
+    state.SkipWithError("instruction set not supported");
+    return false;
+  }
+  bitops::setIsa(isa);
+  state.SetLabel(bitops::name(isa));
+  return true;
+}
+
+static void finish(benchmark::State& state)
+{
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) / 8);
+}
+
+//-----------------------------------------------------
+// Count
+//-----------------------------------------------------
+static void BM_CountVectorBool(benchmark::State& state)
+{
+  const auto bools = randomBools(state.range(0), 0.5, 1);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(std::count(bools.begin(), bools.end(), true));
+  finish(state);
+}
+
+static void BM_Count(benchmark::State& state)
+{
+  if (!selectIsa(state))
+    return;
+  const auto bits = randomBits(state.range(0), 0.5, 1);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(bits.count());
+  finish(state);
+}
+
+//-----------------------------------------------------
+// And
+//-----------------------------------------------------
+static void BM_AndVectorBool(benchmark::State& state)
+{
+  auto a = randomBools(state.range(0), 0.5, 1);
+  const auto b = randomBools(state.range(0), 0.99, 2);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < a.size(); ++i)
+      a[i] = a[i] && b[i];
+    benchmark::ClobberMemory();
+  }
+  finish(state);
+}
+
+static void BM_And(benchmark::State& state)
+{
+  if (!selectIsa(state))
+    return;
+  auto a = randomBits(state.range(0), 0.5, 1);
+  const auto b = randomBits(state.range(0), 0.99, 2);
+  for (auto _ : state) {
+    a &= b;
+    benchmark::DoNotOptimize(a.words().data());
+    benchmark::ClobberMemory();
+  }
+  finish(state);
+}
+
+static void BM_CountAnd(benchmark::State& state)
+{
+  if (!selectIsa(state))
+    return;
+  const auto a = randomBits(state.range(0), 0.5, 1);
+  const auto b = randomBits(state.range(0), 0.5, 2);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ali::count_and(a, b));
+  finish(state);
+}
+
+//-----------------------------------------------------
+// ForEachSet (arg 1: density in percent)
+//-----------------------------------------------------
+static void BM_ForEachSetVectorBool(benchmark::State& state)
+{
+  const auto bools = randomBools(state.range(0), double(state.range(1)) / 100, 1);
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < bools.size(); ++i)
+      if (bools[i])
+        sum += i;
+    benchmark::DoNotOptimize(sum);
+  }
+  finish(state);
+}
+
+static void BM_ForEachSet(benchmark::State& state)
+{
+  const auto bits = randomBits(state.range(0), double(state.range(1)) / 100, 1);
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    bits.for_each_set([&sum](std::size_t i) { sum += i; });
+    benchmark::DoNotOptimize(sum);
+  }
+  finish(state);
+}
+
+//-----------------------------------------------------
+// Rank / Select (items: queries)
+//-----------------------------------------------------
+static void BM_Rank(benchmark::State& state)
+{
+  const auto bits = randomBits(state.range(0), 0.5, 1);
+  const ali::rank_select index(bits);
+  std::mt19937_64 rng(3);
+  std::vector<std::size_t> queries(1 << 16);
+  for (auto& q : queries)
+    q = rng() % bits.size();
+  std::size_t i = 0, sum = 0;
+  for (auto _ : state) {
+    sum += index.rank1(queries[i++ & 0xffff]);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Select(benchmark::State& state)
+{
+  const auto bits = randomBits(state.range(0), double(state.range(1)) / 100, 1);
+  const ali::rank_select index(bits);
+  std::mt19937_64 rng(3);
+  std::vector<std::size_t> queries(1 << 16);
+  for (auto& q : queries)
+    q = rng() % index.ones();
+  std::size_t i = 0, sum = 0;
+  for (auto _ : state) {
+    sum += index.select1(queries[i++ & 0xffff]);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["index%"] = 100.0 * double(index.memory()) * 8 / double(bits.size());
+}
+
+static void BM_BuildRankSelect(benchmark::State& state)
+{
+  const auto bits = randomBits(state.range(0), 0.5, 1);
+  for (auto _ : state) {
+    ali::rank_select index(bits);
+    benchmark::DoNotOptimize(index.ones());
+  }
+  finish(state);
+}
+
+static void Sizes(benchmark::internal::Benchmark* b)
+{
+  for (long n : { 1 << 16, 1 << 22, 1 << 28 })
+    b->Args({ n, 0 });
+}
+
+static void SizesPerIsa(benchmark::internal::Benchmark* b)
+{
+  for (long n : { 1 << 16, 1 << 22, 1 << 28 })
+    for (long isa = 0; isa <= 2; ++isa)
+      b->Args({ n, isa });
+}
+
+static void SizesPerDensity(benchmark::internal::Benchmark* b)
+{
+  for (long n : { 1 << 16, 1 << 22, 1 << 28 })
+    for (long percent : { 1, 50 })
+      b->Args({ n, percent });
+}
+
+BENCHMARK(BM_CountVectorBool)->Apply(Sizes);
+BENCHMARK(BM_Count)->Apply(SizesPerIsa);
+BENCHMARK(BM_AndVectorBool)->Apply(Sizes);
+BENCHMARK(BM_And)->Apply(SizesPerIsa);
+BENCHMARK(BM_CountAnd)->Apply(SizesPerIsa);
+BENCHMARK(BM_ForEachSetVectorBool)->Apply(SizesPerDensity);
+BENCHMARK(BM_ForEachSet)->Apply(SizesPerDensity);
+BENCHMARK(BM_Rank)->Arg(1 << 28);
+BENCHMARK(BM_Select)->Args({ 1 << 28, 1 })->Args({ 1 << 28, 50 });
+BENCHMARK(BM_BuildRankSelect)->Arg(1 << 28);
+
+ALI_BENCHMARK_MAIN();
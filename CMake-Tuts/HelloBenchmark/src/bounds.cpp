@@ -0,0 +1,249 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "checked.hpp"
+
+// Containers/Checked: what a bounds check costs in a hot loop.
+//
+//   sum      s += x[i] for i < x.size(): the compiler can see that every
+//            index is in range and drop the check
+//   saxpy    y[i] += a * x[i] for i < n, n a parameter: one check per array
+//            and element, unless hoisted with x.first(n), y.first(n)
+//   gather   out[i] = x[idx[i]], random indices: the check cannot go
+//
+// Each kernel runs with bounds::unchecked, bounds::hardened on every access
+// and (where there is something to hoist) bounds::hardened with the range
+// checked once before the loop ("hardened-hoisted"). The sizes go from
+// L1 (4K floats) to DRAM (16M floats).
+//
+// After the run a table shows the time of the hardened variants relative to
+// unchecked, per kernel and size: the fastest of the repetitions (run with
+// --benchmark_repetitions), or their median when only the aggregates are
+// reported. Cells above the 2% target are marked with '!'.
+
+namespace {
+
+namespace bounds = ali::bounds;
+
+enum class Variant { Unchecked, Hardened, Hoisted };
+const char* const kVariantNames[] = { "unchecked", "hardened", "hardened-hoisted" };
+
+// the same buffers for every variant, so that they all see the same
+// alignment and pages
+std::vector<float>& floats(std::size_t n, unsigned seed)
+{
+  static std::map<std::pair<std::size_t, unsigned>, std::vector<float>> cache;
+  auto& v = cache[{ n, seed }];
+  if (v.size() != n) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> value(-1.f, 1.f);
+    v.resize(n);
+    for (auto& x : v)
+      x = value(rng);
+  }
+  return v;
+}
+
+const std::vector<std::uint32_t>& indices(std::size_t n)
+{
+  static std::map<std::size_t, std::vector<std::uint32_t>> cache;
+  auto& v = cache[n];
+  if (v.size() != n) {
+    std::mt19937 rng(3);
+    v.resize(n);
+    for (auto& i : v)
+      i = std::uint32_t(rng() % n);
+  }
+  return v;
+}
+
+//-----------------------------------------------------
+// Kernels (not inlined, so that every variant is compiled on its own)
+//-----------------------------------------------------
+template <typename Bounds>
+[[gnu::noinline]] float sum(ali::checked_span<const float, Bounds> x)
+{
+  float s = 0;
+  for (std::size_t i = 0; i < x.size(); ++i)
+    s += x[i];
+  return s;
+}
+
+template <typename Bounds>
+[[gnu::noinline]] void saxpy(std::size_t n, float a, ali::checked_span<const float, Bounds> x, ali::checked_span<float, Bounds> y)
+{
+  for (std::size_t i = 0; i < n; ++i)
+    y[i] += a * x[i];
+}
+
+// the same loop on plain spans, checked once
+template <typename Bounds>
+[[gnu::noinline]] void saxpyHoisted(std::size_t n, float a, ali::checked_span<const float, Bounds> x, ali::checked_span<float, Bounds> y)
+{
+  const auto xs = x.first(n);
+  const auto ys = y.first(n);
+  for (std::size_t i = 0; i < n; ++i)
+    ys[i] += a * xs[i];
+}
+
+template <typename Bounds>
+[[gnu::noinline]] void gather(ali::checked_span<const float, Bounds> x, std::span<const std::uint32_t> idx, std::span<float> out)
+{
+  for (std::size_t i = 0; i < idx.size(); ++i)
+    out[i] = x[idx[i]];
+}
+
+//-----------------------------------------------------
+// Benchmarks (arg: elements)
+//-----------------------------------------------------
+template <typename Bounds>
+void BM_Sum(benchmark::State& state)
+{
+  const auto& x = floats(state.range(0), 1);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(sum(ali::checked<Bounds>(x)));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Bounds, bool Hoist>
+void BM_Saxpy(benchmark::State& state)
+{
+  const std::size_t n = state.range(0);
+  const auto& x = floats(n, 1);
+  auto& y = floats(n, 2);
+  for (auto _ : state) {
+    if constexpr (Hoist)
+      saxpyHoisted(n, 0.5f, ali::checked<Bounds>(x), ali::checked<Bounds>(y));
+    else
+      saxpy(n, 0.5f, ali::checked<Bounds>(x), ali::checked<Bounds>(y));
+    benchmark::DoNotOptimize(y.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Bounds>
+void BM_Gather(benchmark::State& state)
+{
+  const std::size_t n = state.range(0);
+  const auto& x = floats(n, 1);
+  const auto& idx = indices(n);
+  auto& out = floats(n, 3);
+  for (auto _ : state) {
+    gather(ali::checked<Bounds>(x), idx, out);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+void registerBenchmarks()
+{
+  const auto add = [](const char* kernel, Variant v, void (*fn)(benchmark::State&)) {
+    auto* b = benchmark::RegisterBenchmark((std::string(kernel) + "/" + kVariantNames[int(v)]).c_str(), fn);
+    b->ArgName("n");
+    for (std::int64_t n = 1 << 12; n <= 1 << 24; n *= 16)
+      b->Arg(n);
+  };
+  add("sum", Variant::Unchecked, BM_Sum<bounds::unchecked>);
+  add("sum", Variant::Hardened, BM_Sum<bounds::hardened>);
+  add("saxpy", Variant::Unchecked, BM_Saxpy<bounds::unchecked, false>);
+  add("saxpy", Variant::Hardened, BM_Saxpy<bounds::hardened, false>);
+  add("saxpy", Variant::Hoisted, BM_Saxpy<bounds::hardened, true>);
+  add("gather", Variant::Unchecked, BM_Gather<bounds::unchecked>);
+  add("gather", Variant::Hardened, BM_Gather<bounds::hardened>);
+}
+
+//-----------------------------------------------------
+// Overhead table
+//-----------------------------------------------------
+// Console output as usual, plus the time of every run for the table.
+class OverheadReporter : public benchmark::ConsoleReporter
+{
+public:
+  static constexpr double kTarget = 2.0;        // percent
+
+  void ReportRuns(const std::vector<Run>& runs) override
+  {
+    for (const auto& run : runs) {
+      const bool iteration = run.run_type == Run::RT_Iteration;
+      // --benchmark_report_aggregates_only: no single repetitions, take the median
+      const bool median = run.run_type == Run::RT_Aggregate && run.aggregate_name == "median";
+      if (!(iteration || median) || run.error_occurred)
+        continue;
+      // function_name "saxpy/hardened", args "n:4096"
+      const std::string& name = run.run_name.function_name;
+      std::size_t n = 0;
+      std::sscanf(run.run_name.args.c_str(), "n:%zu", &n);
+      auto& time = times_[name.substr(0, name.find('/'))][n][name.substr(name.find('/') + 1)];
+      if (iteration)        // the fastest repetition: the least disturbed one
+        time.fastest = time.fastest == 0 ? run.GetAdjustedCPUTime() : std::min(time.fastest, run.GetAdjustedCPUTime());
+      else
+        time.median = run.GetAdjustedCPUTime();
+    }
+    ConsoleReporter::ReportRuns(runs);
+  }
+
+  void printOverhead() const
+  {
+    std::cout << "\nOverhead of the checks, relative to unchecked\n\n";
+    std::cout << std::left << std::setw(10) << "kernel" << std::setw(12) << "n"
+              << std::setw(12) << "hardened" << "hardened-hoisted\n";
+    bool above = false;
+    for (const auto& [kernel, perSize] : times_)
+      for (const auto& [n, perVariant] : perSize) {
+        const auto base = perVariant.find("unchecked");
+        if (base == perVariant.end())
+          continue;
+        std::cout << std::setw(10) << kernel << std::setw(12) << n;
+        for (const char* variant : { "hardened", "hardened-hoisted" }) {
+          const auto it = perVariant.find(variant);
+          std::ostringstream cell;
+          if (it != perVariant.end()) {
+            const double overhead = 100.0 * (it->second.value() / base->second.value() - 1);
+            cell << std::showpos << std::fixed << std::setprecision(1) << overhead << "%" << (overhead > kTarget ? " !" : "");
+            above = above || overhead > kTarget;
+          } else {
+            cell << "-";
+          }
+          std::cout << std::setw(12) << cell.str();
+        }
+        std::cout << "\n";
+      }
+    if (above)
+      std::cout << "\n! above the " << kTarget << "% target\n";
+  }
+
+private:
+  struct Time
+  {
+    double fastest = 0;
+    double median = 0;
+
+    double value() const { return fastest != 0 ? fastest : median; }
+  };
+
+  // kernel -> elements -> variant -> cpu time
+  std::map<std::string, std::map<std::size_t, std::map<std::string, Time>>> times_;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  registerBenchmarks();
+  OverheadReporter reporter;
+  const int result = ali::runBenchmarks(argc, argv, &reporter);
+  reporter.printOverhead();
+  return result;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+/*
+    -----------------------
+    Cache Hierarchy
+    -----------------------
+    The data and unified caches of CPU 0 as the kernel describes them in
+
+        /sys/devices/system/cpu/cpu0/cache/index<N>/{level,type,size,coherency_line_size,shared_cpu_list}
+
+    e.g.    L1 Data      48 KiB  64 B lines  private
+            L2 Unified    2 MiB  64 B lines  private
+            L3 Unified  105 MiB  64 B lines  shared by 32 CPUs
+
+    Without /sys (other systems, some containers) the sizes sysconf() knows
+    are used instead; without both the list is empty.
+
+    Use it to size blocks: e.g. a sort that works on blocks of half the L2
+    size, or a hash table partitioned to fit into L1:
+
+        auto caches = ali::detectCaches();
+        std::size_t block = ali::cacheSize(caches, 2) / 2;
+*/
+
+namespace ali {
+
+struct CacheLevel
+{
+    int         level = 0;
+    std::string type;               // "Data" or "Unified"
+    std::size_t size = 0;           // bytes
+    std::size_t lineSize = 64;      // bytes
+    int         sharedBy = 1;       // CPUs sharing this cache
+};
+
+namespace detail {
+
+inline std::string readSysFile(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string s;
+    std::getline(in, s);
+    return s;
+}
+
+// "48K", "2048K", "105M"
+inline std::size_t parseSize(const std::string& s)
+{
+    if (s.empty())
+        return 0;
+    std::size_t n = std::stoull(s);
+    switch (s.back()) {
+        case 'K': return n << 10;
+        case 'M': return n << 20;
+        case 'G': return n << 30;
+        default:  return n;
+    }
+}
+
+// "0-3,8-11" -> 8
+inline int countCpus(const std::string& list)
+{
+    int count = 0;
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        std::size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        const std::string range = list.substr(pos, end - pos);
+        const std::size_t dash = range.find('-');
+        count += dash == std::string::npos ? 1 : std::stoi(range.substr(dash + 1)) - std::stoi(range) + 1;
+        pos = end + 1;
+    }
+    return std::max(count, 1);
+}
+
+} // namespace detail
+
+// Data and unified caches, smallest (L1) first
+inline std::vector<CacheLevel> detectCaches()
+{
+    std::vector<CacheLevel> caches;
+
+    for (int index = 0;; ++index) {
+        const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        const std::string level = detail::readSysFile(dir + "level");
+        if (level.empty())
+            break;
+
+        CacheLevel c;
+        c.level = std::stoi(level);
+        c.type = detail::readSysFile(dir + "type");
+        if (c.type == "Instruction")
+            continue;
+        c.size = detail::parseSize(detail::readSysFile(dir + "size"));
+        const std::string line = detail::readSysFile(dir + "coherency_line_size");
+        if (!line.empty())
+            c.lineSize = std::stoul(line);
+        c.sharedBy = detail::countCpus(detail::readSysFile(dir + "shared_cpu_list"));
+        if (c.size)
+            caches.push_back(c);
+    }
+
+#if defined(__unix__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+    if (caches.empty()) {
+        const int names[] = { _SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE, _SC_LEVEL3_CACHE_SIZE };
+        for (int level = 1; level <= 3; ++level) {
+            const long size = sysconf(names[level - 1]);
+            if (size > 0)
+                caches.push_back({ level, level == 1 ? "Data" : "Unified", std::size_t(size), 64, 1 });
+        }
+    }
+#endif
+
+    std::sort(caches.begin(), caches.end(), [](const CacheLevel& a, const CacheLevel& b) { return a.level < b.level; });
+    return caches;
+}
+
+// size of the given level, 0 if there is none
+inline std::size_t cacheSize(const std::vector<CacheLevel>& caches, int level)
+{
+    for (const auto& c : caches)
+        if (c.level == level)
+            return c.size;
+    return 0;
+}
+
+// "L1", "L2", ... for the smallest cache a working set fits into, "DRAM" otherwise
+inline std::string fittingLevel(const std::vector<CacheLevel>& caches, std::size_t bytes)
+{
+    for (const auto& c : caches)
+        if (bytes <= c.size)
+            return std::string("L").append(std::to_string(c.level));
+    return "DRAM";
+}
+
+} // namespace ali
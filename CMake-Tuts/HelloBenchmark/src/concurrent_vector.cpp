@@ -0,0 +1,222 @@
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#ifdef ALI_HAVE_TBB
+#include <tbb/concurrent_vector.h>
+#endif
+
+#include "bench_main.hpp"
+#include "concurrent_vector.hpp"
+#include "parallel_algorithms.hpp"
+
+// Containers/ConcurrentVector against the usual alternatives.
+//
+//   Fill      1, 2, 4, 8 threads append kElements longs in total to a fresh
+//             container: std::vector under a std::mutex, concurrent_vector
+//             push_back (one fetch_add each), concurrent_vector grow_by(64)
+//             (one fetch_add per batch), tbb::concurrent_vector when TBB is
+//             found at configure time
+//   Sum       read 16M longs: std::vector, concurrent_vector by index
+//             (chunk lookup per element), by iterator (lookup per chunk),
+//             by segment span, and ali::reduce(par) over the iterators
+//
+// Every Fill iteration starts new threads, so the small sizes include the
+// thread start; compare the rows against each other, not with 0.
+
+constexpr long kElements = 1 << 20;
+constexpr long kBatch = 64;
+
+template <typename Append>
+static void runThreads(long threads, Append append)
+{
+  std::vector<std::thread> pool;
+  for (long t = 1; t < threads; ++t)
+    pool.emplace_back(append, t);
+  append(0);
+  for (auto& t : pool)
+    t.join();
+}
+
+//-----------------------------------------------------
+// Fill (arg: threads)
+//-----------------------------------------------------
+static void BM_FillStdMutex(benchmark::State& state)
+{
+  const long threads = state.range(0);
+  for (auto _ : state) {
+    std::vector<long> v;
+    std::mutex lock;
+    runThreads(threads, [&](long t) {
+      for (long i = t; i < kElements; i += threads) {
+        std::lock_guard guard(lock);
+        v.push_back(i);
+      }
+    });
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+
+static void BM_FillPushBack(benchmark::State& state)
+{
+  const long threads = state.range(0);
+  for (auto _ : state) {
+    ali::concurrent_vector<long> v;
+    runThreads(threads, [&](long t) {
+      for (long i = t; i < kElements; i += threads)
+        v.push_back(i);
+    });
+    benchmark::DoNotOptimize(&v[0]);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+
+static void BM_FillGrowBy(benchmark::State& state)
+{
+  const long threads = state.range(0);
+  for (auto _ : state) {
+    ali::concurrent_vector<long> v;
+    runThreads(threads, [&](long t) {
+      for (long i = t * kBatch; i < kElements; i += threads * kBatch) {
+        auto it = v.grow_by(kBatch);
+        for (long j = 0; j < kBatch; ++j, ++it)
+          *it = i + j;
+      }
+    });
+    benchmark::DoNotOptimize(&v[0]);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+
+#ifdef ALI_HAVE_TBB
+static void BM_FillTbb(benchmark::State& state)
+{
+  const long threads = state.range(0);
+  for (auto _ : state) {
+    tbb::concurrent_vector<long> v;
+    runThreads(threads, [&](long t) {
+      for (long i = t; i < kElements; i += threads)
+        v.push_back(i);
+    });
+    benchmark::DoNotOptimize(&v[0]);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+#endif
+
+//-----------------------------------------------------
+// Sum
+//-----------------------------------------------------
+constexpr long kSumElements = 1 << 24;
+
+static const ali::concurrent_vector<long>& sumInput()
+{
+  static const auto v = [] {
+    ali::concurrent_vector<long> v;
+    for (long i = 0; i < kSumElements; ++i)
+      v.push_back(i);
+    return v;
+  }();
+  return v;
+}
+
+static void finishSum(benchmark::State& state, long sum)
+{
+  if (sum != kSumElements * (kSumElements - 1) / 2)
+    state.SkipWithError("wrong sum");
+  state.SetItemsProcessed(state.iterations() * kSumElements);
+  state.SetBytesProcessed(state.iterations() * kSumElements * long(sizeof(long)));
+}
+
+static void BM_SumStdVector(benchmark::State& state)
+{
+  std::vector<long> v(kSumElements);
+  std::iota(v.begin(), v.end(), 0L);
+  long sum = 0;
+  for (auto _ : state) {
+    sum = std::accumulate(v.begin(), v.end(), 0L);
+    benchmark::DoNotOptimize(sum);
+  }
+  finishSum(state, sum);
+}
+
+static void BM_SumIndex(benchmark::State& state)
+{
+  const auto& v = sumInput();
+  long sum = 0;
+  for (auto _ : state) {
+    sum = 0;
+    for (std::size_t i = 0, n = v.size(); i < n; ++i)
+      sum += v[i];
+    benchmark::DoNotOptimize(sum);
+  }
+  finishSum(state, sum);
+}
+
+static void BM_SumIterator(benchmark::State& state)
+{
+  const auto& v = sumInput();
+  long sum = 0;
+  for (auto _ : state) {
+    sum = std::accumulate(v.begin(), v.end(), 0L);
+    benchmark::DoNotOptimize(sum);
+  }
+  finishSum(state, sum);
+}
+
+static void BM_SumSegments(benchmark::State& state)
+{
+  const auto& v = sumInput();
+  long sum = 0;
+  for (auto _ : state) {
+    sum = 0;
+    v.for_each_segment([&](std::span<const long> s) { sum = std::accumulate(s.begin(), s.end(), sum); });
+    benchmark::DoNotOptimize(sum);
+  }
+  finishSum(state, sum);
+}
+
+static void BM_SumReducePar(benchmark::State& state)
+{
+  const auto& v = sumInput();
+  long sum = 0;
+  for (auto _ : state) {
+    sum = ali::reduce(ali::execution::par, v.begin(), v.end(), 0L);
+    benchmark::DoNotOptimize(sum);
+  }
+  finishSum(state, sum);
+}
+
+#ifdef ALI_HAVE_TBB
+static void BM_SumTbb(benchmark::State& state)
+{
+  tbb::concurrent_vector<long> v(kSumElements);
+  std::iota(v.begin(), v.end(), 0L);
+  long sum = 0;
+  for (auto _ : state) {
+    sum = std::accumulate(v.begin(), v.end(), 0L);
+    benchmark::DoNotOptimize(sum);
+  }
+  finishSum(state, sum);
+}
+#endif
+
+BENCHMARK(BM_FillStdMutex)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(BM_FillPushBack)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(BM_FillGrowBy)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+#ifdef ALI_HAVE_TBB
+BENCHMARK(BM_FillTbb)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+#endif
+BENCHMARK(BM_SumStdVector);
+BENCHMARK(BM_SumIndex);
+BENCHMARK(BM_SumIterator);
+BENCHMARK(BM_SumSegments);
+BENCHMARK(BM_SumReducePar)->UseRealTime();
+#ifdef ALI_HAVE_TBB
+BENCHMARK(BM_SumTbb);
+#endif
+
+ALI_BENCHMARK_MAIN();
@@ -0,0 +1,262 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "concurrent_vector.hpp"
+#include "counted.hpp"
+#include "reloc_vector.hpp"
+#include "small_vector.hpp"
+#include "soa_vector.hpp"
+
+// What every container operation in Containers/ does to its elements:
+// constructions, copies, moves, assignments and destructions per element
+// (counters of ali::Counted, see counted.hpp), next to the time.
+//
+//   sequences     std::vector, ali::small_vector<T, 16>, ali::reloc_vector,
+//                 ali::concurrent_vector, ali::soa_vector<T>
+//                 push_back(lvalue), push_back(rvalue), emplace_back,
+//                 emplace_back after reserve(n), insert at the front, erase
+//                 at the front, copy and move of the whole container
+//   associative   std::map<T, int>, std::unordered_map<T, int>, std::set<T>
+//                 (Containers/map, Containers/set)
+//                 insert(lvalue), insert(rvalue), emplace(key), try_emplace
+//
+// Element types: Counted with 8 and 256 bytes of payload, with a noexcept
+// move ("nothrow") and without ("throwing"). The classic: a std::vector of
+// a type whose move constructor is not noexcept copies every element on
+// every growth step, see copies/elem of vector/emplace_back/throwing. The
+// reloc_vector rows declare Counted trivially relocatable: growth moves
+// bytes, no constructor runs at all.
+//
+// Operations a container does not have are not registered; soa_vector
+// requires a noexcept move and only runs with the nothrow types.
+//
+// Arg: elements (1024; insert/erase at the front: 256).
+
+template <std::size_t Payload, bool NoexceptMove>
+struct ali::is_trivially_relocatable<ali::Counted<Payload, NoexceptMove>> : std::true_type {};
+
+namespace {
+
+template <typename T> using Vector     = std::vector<T>;
+template <typename T> using Small      = ali::small_vector<T, 16>;
+template <typename T> using Reloc      = ali::reloc_vector<T>;
+template <typename T> using Concurrent = ali::concurrent_vector<T>;
+template <typename T> using SoA        = ali::soa_vector<T>;
+
+template <template <typename> class C, typename T>
+constexpr bool isSoA = std::is_same_v<C<T>, SoA<T>>;
+
+enum class Op { PushBackLValue, PushBackRValue, EmplaceBack, EmplaceReserved, InsertFront, EraseFront, Copy, Move };
+
+// soa_vector::push_back takes a tuple of the fields: emplace_back is its
+// push_back of a single T
+template <template <typename> class C, typename T, typename V>
+void pushBack(C<T>& c, V&& value)
+{
+  if constexpr (isSoA<C, T>)
+    c.emplace_back(std::forward<V>(value));
+  else
+    c.push_back(std::forward<V>(value));
+}
+
+template <template <typename> class C, typename T>
+C<T> filled(int n)
+{
+  C<T> c;
+  for (int i = 0; i < n; ++i)
+    c.emplace_back(i);
+  return c;
+}
+
+template <template <typename> class C, typename T, Op O>
+constexpr bool supported()
+{
+  if constexpr (isSoA<C, T> && !std::is_nothrow_move_constructible_v<T>)
+    return false;
+  else if constexpr (O == Op::EmplaceReserved)
+    return requires(C<T> c) { c.reserve(1); };
+  else if constexpr (O == Op::InsertFront)
+    return requires(C<T> c, T v) { c.insert(c.begin(), v); };
+  else if constexpr (O == Op::EraseFront)
+    return requires(C<T> c) { c.erase(c.begin()); };
+  else
+    return true;
+}
+
+template <template <typename> class C, typename T, Op O>
+void BM_Sequence(benchmark::State& state)
+{
+  const int n = int(state.range(0));
+  const T value(42);
+  const C<T> source = filled<C, T>(O == Op::EraseFront || O == Op::Copy || O == Op::Move ? n : 0);
+  {
+    ali::CountScope counts(state, n);
+    for (auto _ : state) {
+      if constexpr (O == Op::EraseFront || O == Op::Move) {
+        // the copy is not part of the operation: keep it out of the counts
+        state.PauseTiming();
+        const auto saved = ali::counted::counts;
+        C<T> c(source);
+        ali::counted::counts = saved;
+        state.ResumeTiming();
+        if constexpr (O == Op::EraseFront) {
+          for (int i = 0; i < n; ++i)
+            c.erase(c.begin());
+        } else {
+          C<T> moved(std::move(c));
+          benchmark::DoNotOptimize(&moved);
+        }
+        state.PauseTiming();                // not the destruction of the copy
+        c = C<T>();
+        state.ResumeTiming();
+      } else if constexpr (O == Op::Copy) {
+        C<T> c(source);
+        benchmark::DoNotOptimize(&c);
+      } else {
+        C<T> c;
+        if constexpr (O == Op::EmplaceReserved)
+          c.reserve(n);
+        for (int i = 0; i < n; ++i) {
+          if constexpr (O == Op::PushBackLValue)
+            pushBack<C, T>(c, value);
+          else if constexpr (O == Op::PushBackRValue)
+            pushBack<C, T>(c, T(i));
+          else if constexpr (O == Op::InsertFront)
+            c.insert(c.begin(), value);
+          else
+            c.emplace_back(i);
+        }
+        benchmark::DoNotOptimize(&c);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+//-----------------------------------------------------
+// Associative
+//-----------------------------------------------------
+enum class MapOp { InsertLValue, InsertRValue, Emplace, TryEmplace };
+
+template <typename C>
+constexpr bool isSet = requires { typename C::key_type; } && std::is_same_v<typename C::key_type, typename C::value_type>;
+
+template <typename C, MapOp O>
+void BM_Associative(benchmark::State& state)
+{
+  using Key = typename C::key_type;
+  const int n = int(state.range(0));
+  std::vector<typename C::value_type> values;
+  for (int i = 0; i < n; ++i) {
+    if constexpr (isSet<C>)
+      values.emplace_back(i);
+    else
+      values.emplace_back(Key(i), i);
+  }
+  {
+    ali::CountScope counts(state, n);
+    for (auto _ : state) {
+      C c;
+      for (int i = 0; i < n; ++i) {
+        if constexpr (O == MapOp::InsertLValue)
+          c.insert(values[std::size_t(i)]);
+        else if constexpr (O == MapOp::InsertRValue) {
+          if constexpr (isSet<C>)
+            c.insert(Key(i));
+          else
+            c.insert({ Key(i), i });
+        } else if constexpr (O == MapOp::Emplace) {
+          if constexpr (isSet<C>)
+            c.emplace(i);
+          else
+            c.emplace(i, i);
+        } else
+          c.try_emplace(i, i);
+      }
+      benchmark::DoNotOptimize(&c);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+//-----------------------------------------------------
+// Registration
+//-----------------------------------------------------
+const char* const kOpNames[] = { "push_back(lvalue)", "push_back(rvalue)", "emplace_back", "emplace_back+reserve",
+                                 "insert(front)", "erase(front)", "copy", "move" };
+const char* const kMapOpNames[] = { "insert(lvalue)", "insert(rvalue)", "emplace", "try_emplace" };
+
+template <typename T>
+std::string typeName()
+{
+  return std::string(T::noexcept_move ? "nothrow-" : "throwing-") + std::to_string(T::payload_size) + "B";
+}
+
+template <template <typename> class C, typename T, Op O>
+void addSequence(const char* container)
+{
+  if constexpr (supported<C, T, O>()) {
+    const std::string name = std::string(container) + "/" + kOpNames[int(O)] + "/" + typeName<T>();
+    benchmark::RegisterBenchmark(name.c_str(), BM_Sequence<C, T, O>)
+        ->Arg(O == Op::InsertFront || O == Op::EraseFront ? 256 : 1024);
+  }
+}
+
+template <template <typename> class C, typename T, Op... O>
+void addSequenceOps(const char* container)
+{
+  (addSequence<C, T, O>(container), ...);
+}
+
+template <typename C, MapOp... O>
+void addAssociativeOps(const char* container, const std::string& type)
+{
+  (benchmark::RegisterBenchmark((std::string(container) + "/" + kMapOpNames[int(O)] + "/" + type).c_str(),
+                                BM_Associative<C, O>)->Arg(1024), ...);
+}
+
+template <typename T>
+void addType()
+{
+  constexpr auto ops = [](auto add) {
+    add.template operator()<Op::PushBackLValue, Op::PushBackRValue, Op::EmplaceBack, Op::EmplaceReserved,
+                            Op::InsertFront, Op::EraseFront, Op::Copy, Op::Move>();
+  };
+  ops([]<Op... O>() {
+    addSequenceOps<Vector, T, O...>("vector");
+    addSequenceOps<Small, T, O...>("small_vector");
+    addSequenceOps<Reloc, T, O...>("reloc_vector");
+    addSequenceOps<Concurrent, T, O...>("concurrent_vector");
+    addSequenceOps<SoA, T, O...>("soa_vector");
+  });
+  addAssociativeOps<std::map<T, int>, MapOp::InsertLValue, MapOp::InsertRValue, MapOp::Emplace, MapOp::TryEmplace>(
+      "map", typeName<T>());
+  addAssociativeOps<std::unordered_map<T, int>, MapOp::InsertLValue, MapOp::InsertRValue, MapOp::Emplace, MapOp::TryEmplace>(
+      "unordered_map", typeName<T>());
+  addAssociativeOps<std::set<T>, MapOp::InsertLValue, MapOp::InsertRValue, MapOp::Emplace>("set", typeName<T>());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  // glibc gives blocks above 128K their own mmap() until the first such
+  // block is freed, then raises the threshold to its size. Do that now, or
+  // the first 256B rows (256K per container) pay page faults the later ones
+  // do not.
+  void* large = std::malloc(8 << 20);
+  benchmark::DoNotOptimize(large);
+  std::free(large);
+
+  addType<ali::Counted<8, true>>();
+  addType<ali::Counted<8, false>>();
+  addType<ali::Counted<256, true>>();
+  addType<ali::Counted<256, false>>();
+  return ali::runBenchmarks(argc, argv);
+}
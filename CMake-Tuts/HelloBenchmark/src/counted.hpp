@@ -0,0 +1,147 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/*
+    -----------------------
+    Copy / Move Counting
+    -----------------------
+    The struct S of Containers/Vector/main.cpp prints from every constructor
+    to show what push_back and emplace_back do. Printing is no use in a
+    benchmark: it is slower than the operation and nobody reads it.
+    Counted<Payload, NoexceptMove> counts instead, in thread-local counters:
+
+        value / default constructions, copy and move constructions,
+        copy and move assignments, destructions
+
+    Payload    bytes carried next to the int key, copied by every copy and
+               move: a copy of Counted<256> costs what a copy of a 256-byte
+               record costs
+    NoexceptMove
+               whether the move constructor and move assignment are
+               noexcept. std::vector (and small_vector) only move the
+               elements on reallocation when the move cannot throw
+               (std::move_if_noexcept); Counted<Payload, false> is the
+               classic missing noexcept, every growth step copies
+
+    Counted compares and hashes by key, so it can be a map/set key too.
+
+    A CountScope reports the counts of the benchmark's thread as custom
+    counters, per element (n elements per iteration):
+
+        static void BM_Fill(benchmark::State& state)
+        {
+            ali::CountScope counts(state, n);
+            for (auto _ : state) { ... }
+        }
+
+        ctors/elem  copies/elem  moves/elem  assigns/elem  dtors/elem
+
+    The counters are thread-local, so parallel benchmarks count per thread
+    and the benchmark library's threads do not disturb each other.
+*/
+
+namespace ali {
+
+struct CopyMoveCounts
+{
+    std::uint64_t constructions = 0;
+    std::uint64_t copies = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t copyAssignments = 0;
+    std::uint64_t moveAssignments = 0;
+    std::uint64_t destructions = 0;
+};
+
+namespace counted {
+
+inline thread_local CopyMoveCounts counts;
+
+inline void reset() noexcept { counts = {}; }
+
+} // namespace counted
+
+template <std::size_t Payload = 8, bool NoexceptMove = true>
+class Counted
+{
+public:
+    static constexpr std::size_t payload_size = Payload;
+    static constexpr bool noexcept_move = NoexceptMove;
+
+    Counted() noexcept { ++counted::counts.constructions; }
+    Counted(int key) noexcept : key_(key) { ++counted::counts.constructions; }
+
+    Counted(const Counted& other) noexcept : key_(other.key_), payload_(other.payload_) { ++counted::counts.copies; }
+    Counted(Counted&& other) noexcept(NoexceptMove) : key_(other.key_), payload_(other.payload_) { ++counted::counts.moves; }
+
+    Counted& operator=(const Counted& other) noexcept
+    {
+        key_ = other.key_;
+        payload_ = other.payload_;
+        ++counted::counts.copyAssignments;
+        return *this;
+    }
+
+    Counted& operator=(Counted&& other) noexcept(NoexceptMove)
+    {
+        key_ = other.key_;
+        payload_ = other.payload_;
+        ++counted::counts.moveAssignments;
+        return *this;
+    }
+
+    ~Counted() { ++counted::counts.destructions; }
+
+    int key() const noexcept { return key_; }
+
+    friend bool operator==(const Counted& a, const Counted& b) noexcept { return a.key_ == b.key_; }
+    friend auto operator<=>(const Counted& a, const Counted& b) noexcept { return a.key_ <=> b.key_; }
+
+private:
+    int                                 key_ = 0;
+    std::array<unsigned char, Payload>  payload_ {};
+};
+
+class CountScope
+{
+public:
+    explicit CountScope(benchmark::State& state, std::int64_t elementsPerIteration = 1)
+        : state_(state), elements_(elementsPerIteration)
+    {
+        counted::reset();
+    }
+
+    CountScope(const CountScope&) = delete;
+    CountScope& operator=(const CountScope&) = delete;
+
+    ~CountScope()
+    {
+        const CopyMoveCounts c = counted::counts;
+        const double per = double(state_.iterations()) * double(elements_);
+        if (per == 0)
+            return;
+        state_.counters["ctors/elem"] = double(c.constructions) / per;
+        state_.counters["copies/elem"] = double(c.copies) / per;
+        state_.counters["moves/elem"] = double(c.moves) / per;
+        state_.counters["assigns/elem"] = double(c.copyAssignments + c.moveAssignments) / per;
+        state_.counters["dtors/elem"] = double(c.destructions) / per;
+    }
+
+private:
+    benchmark::State&   state_;
+    const std::int64_t  elements_;
+};
+
+} // namespace ali
+
+template <std::size_t Payload, bool NoexceptMove>
+struct std::hash<ali::Counted<Payload, NoexceptMove>>
+{
+    std::size_t operator()(const ali::Counted<Payload, NoexceptMove>& c) const noexcept { return std::hash<int>()(c.key()); }
+};
@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "cuckoo_hash_map.hpp"
+#include "flat_hash_map.hpp"
+#include "latency_counters.hpp"
+
+// Containers/CuckooHashMap against the maps we have under a reader/writer
+// lock, shared by 1, 2, 4, 8 threads, uint64_t -> uint64_t.
+//
+//   cuckoo          ali::cuckoo_hash_map: lock-free lookups, writers lock
+//                   the stripes of two buckets
+//   flat+rwlock     ali::flat_hash_map (Containers/FlatHashMap) under a
+//                   std::shared_mutex
+//   unordered+rwlock
+//                   std::unordered_map under a std::shared_mutex
+//
+// Every map holds 90% of kSlots keys (the cuckoo table's load, where
+// inserts into full buckets need cuckoo paths). One iteration is one
+// operation on a random present key: a lookup, or with probability
+// writes / 1000 a write, which erases the key and inserts it again. Every
+// operation is timed (ali::LatencyCounters): p50 / p99 / p99.9 / max next to
+// the throughput. The tail is the point: under the rwlock a lookup waits
+// for every writer and for the cache line of the lock word; a cuckoo lookup
+// only for a writer inside one of its two buckets.
+//
+// Args: writes per mille (0, 10, 100); threads 1 ... 8.
+
+namespace {
+
+using Key = std::uint64_t;
+
+constexpr std::size_t kSlots = std::size_t(1) << 20;
+
+const std::vector<Key>& keys()
+{
+  static const std::vector<Key> k = [] {
+    std::vector<Key> v(kSlots * 9 / 10);
+    std::mt19937_64 rng(42);
+    for (Key& key : v)
+      key = rng();
+    return v;
+  }();
+  return k;
+}
+
+struct Cuckoo
+{
+  ali::cuckoo_hash_map<Key, Key> map { keys().size() };
+
+  bool find(Key key) const { return map.find(key).has_value(); }
+  void write(Key key)
+  {
+    map.erase(key);
+    map.insert(key, key);
+  }
+};
+
+template <typename Map>
+struct RwLocked
+{
+  Map map;
+  mutable std::shared_mutex lock;
+
+  RwLocked() { map.reserve(keys().size()); }
+
+  bool find(Key key) const
+  {
+    std::shared_lock guard(lock);
+    return map.find(key) != map.end();
+  }
+  void write(Key key)
+  {
+    std::unique_lock guard(lock);
+    map.erase(key);
+    map.emplace(key, key);
+  }
+};
+
+using FlatRwLocked = RwLocked<ali::flat_hash_map<Key, Key>>;
+using UnorderedRwLocked = RwLocked<std::unordered_map<Key, Key>>;
+
+template <typename Map>
+Map& shared()
+{
+  static Map& map = *[] {
+    auto* m = new Map;                  // lives until exit, like the keys
+    for (Key key : keys())
+      m->write(key);
+    return m;
+  }();
+  return map;
+}
+
+template <typename Map>
+void BM_Mixed(benchmark::State& state)
+{
+  const auto writes = std::uint64_t(state.range(0));
+  const auto& k = keys();
+  Map& map = shared<Map>();
+  std::mt19937_64 rng(std::uint64_t(state.thread_index()) + 1);
+  std::uint64_t found = 0;
+  {
+    ali::LatencyCounters latency(state);
+    for (auto _ : state) {
+      const std::uint64_t r = rng();
+      const Key key = k[r % k.size()];
+      ali::ScopedLatency timer(latency);
+      if ((r >> 40) % 1000 < writes)
+        map.write(key);
+      else
+        found += map.find(key);
+    }
+  }
+  benchmark::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations());
+}
+
+void registerMap(const char* name, benchmark::internal::Function* f)
+{
+  benchmark::RegisterBenchmark(name, f)
+      ->ArgsProduct({ { 0, 10, 100 } })->ArgNames({ "writes" })
+      ->ThreadRange(1, 8)->UseRealTime();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  registerMap("cuckoo", BM_Mixed<Cuckoo>);
+  registerMap("flat+rwlock", BM_Mixed<FlatRwLocked>);
+  registerMap("unordered+rwlock", BM_Mixed<UnorderedRwLocked>);
+  return ali::runBenchmarks(argc, argv);
+}
@@ -0,0 +1,228 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "perf_counters.hpp"
+
+// The dispatch styles the repo shows, measured against each other:
+//
+//   BM_Virtual         virtual member function through a base pointer
+//                      (Base::F2 in Inheritance/main.cpp)
+//   BM_Crtp            static_cast<Derived*>(this)->implementation()
+//                      (Base<Derived>::interface in Templates/main.cpp)
+//   BM_FunctionPtr     plain function pointer (cube1/cube2 in Function-Ptrs/main.cpp)
+//   BM_StdFunction     std::function (cube3 in Function-Ptrs/main.cpp)
+//   BM_Variant         std::variant of the concrete types and std::visit
+//
+// Every benchmark makes one call per element of an array of 4096 objects;
+// the argument is the number of different types at the call site:
+//
+//   ways:1   monomorphic: every call goes to the same function, the branch
+//            predictor (and sometimes the compiler) knows where it goes
+//   ways:2   the types alternate randomly between two
+//   ways:8   ... between eight: most indirect branches are mispredicted
+//
+// CRTP cannot put different types into one array, so BM_Crtp keeps one
+// array per type and walks them one after the other: the same calls, grouped
+// by type. That is what the pattern buys in practice.
+//
+// Reported per call: time/call and (with hardware counters, see
+// perf_counters.hpp) branch-miss/elem.
+
+namespace {
+
+constexpr int kKinds = 8;
+constexpr std::size_t kObjects = 4096;
+
+// The work behind every call: a few cycles, different for every type.
+template <int I>
+struct Kind
+{
+  std::uint64_t bias = I;
+  std::uint64_t apply(std::uint64_t x) const { return x * (2 * I + 3) + bias; }
+};
+
+// calls f(std::integral_constant<int, kind>{}) for a kind known only at run time
+template <class F, int... Is>
+void withKind(int kind, F&& f, std::integer_sequence<int, Is...>)
+{
+  ((kind == Is ? f(std::integral_constant<int, Is>{}) : void()), ...);
+}
+
+template <class F>
+void withKind(int kind, F&& f)
+{
+  withKind(kind, std::forward<F>(f), std::make_integer_sequence<int, kKinds>{});
+}
+
+// the type of every object: random among the first `ways` kinds
+std::vector<int> kinds(int ways)
+{
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> pick(0, ways - 1);
+  std::vector<int> k(kObjects);
+  for (auto& x : k)
+    x = pick(rng);
+  return k;
+}
+
+template <class Calls>
+void run(benchmark::State& state, Calls calls)
+{
+  ali::PerfScope perf(state, kObjects);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(calls());
+  state.counters["time/call"] = benchmark::Counter(double(state.iterations() * kObjects),
+                                                   benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  const int ways = int(state.range(0));
+  state.SetLabel(ways == 1 ? "monomorphic" : std::to_string(ways) + "-way");
+}
+
+//-----------------------------------------------------
+// virtual
+//-----------------------------------------------------
+struct Shape
+{
+  virtual ~Shape() = default;
+  virtual std::uint64_t apply(std::uint64_t x) const = 0;
+};
+
+template <int I>
+struct VirtualKind final : Shape
+{
+  Kind<I> kind;
+  std::uint64_t apply(std::uint64_t x) const override { return kind.apply(x); }
+};
+
+void BM_Virtual(benchmark::State& state)
+{
+  std::vector<std::unique_ptr<Shape>> objects;
+  for (int k : kinds(int(state.range(0))))
+    withKind(k, [&](auto I) { objects.push_back(std::make_unique<VirtualKind<I>>()); });
+
+  run(state, [&] {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+      sum += objects[i]->apply(i);
+    return sum;
+  });
+}
+
+//-----------------------------------------------------
+// CRTP
+//-----------------------------------------------------
+template <class Derived>
+struct CrtpBase
+{
+  std::uint64_t interface(std::uint64_t x) const { return static_cast<const Derived*>(this)->implementation(x); }
+};
+
+template <int I>
+struct CrtpKind : CrtpBase<CrtpKind<I>>
+{
+  Kind<I> kind;
+  std::uint64_t implementation(std::uint64_t x) const { return kind.apply(x); }
+};
+
+template <int... Is>
+using CrtpArrays = std::tuple<std::vector<CrtpKind<Is>>...>;
+
+template <int... Is>
+CrtpArrays<Is...> crtpArrays(std::integer_sequence<int, Is...>);
+
+void BM_Crtp(benchmark::State& state)
+{
+  decltype(crtpArrays(std::make_integer_sequence<int, kKinds>{})) arrays;
+  for (int k : kinds(int(state.range(0))))
+    withKind(k, [&](auto I) { std::get<I>(arrays).emplace_back(); });
+
+  run(state, [&] {
+    std::uint64_t sum = 0, i = 0;
+    std::apply([&](const auto&... array) {
+      ([&] { for (const auto& object : array) sum += object.interface(i++); }(), ...);
+    }, arrays);
+    return sum;
+  });
+}
+
+//-----------------------------------------------------
+// function pointer
+//-----------------------------------------------------
+template <int I>
+std::uint64_t applyKind(std::uint64_t x)
+{
+  return Kind<I>{}.apply(x);
+}
+
+void BM_FunctionPtr(benchmark::State& state)
+{
+  using Fn = std::uint64_t (*)(std::uint64_t);
+  std::vector<Fn> functions;
+  for (int k : kinds(int(state.range(0))))
+    withKind(k, [&](auto I) { functions.push_back(&applyKind<I>); });
+
+  run(state, [&] {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < functions.size(); ++i)
+      sum += functions[i](i);
+    return sum;
+  });
+}
+
+//-----------------------------------------------------
+// std::function
+//-----------------------------------------------------
+void BM_StdFunction(benchmark::State& state)
+{
+  std::vector<std::function<std::uint64_t(std::uint64_t)>> functions;
+  for (int k : kinds(int(state.range(0))))
+    withKind(k, [&](auto I) { functions.emplace_back([kind = Kind<I>{}](std::uint64_t x) { return kind.apply(x); }); });
+
+  run(state, [&] {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < functions.size(); ++i)
+      sum += functions[i](i);
+    return sum;
+  });
+}
+
+//-----------------------------------------------------
+// std::variant
+//-----------------------------------------------------
+template <int... Is>
+std::variant<Kind<Is>...> variantOf(std::integer_sequence<int, Is...>);
+
+using AnyKind = decltype(variantOf(std::make_integer_sequence<int, kKinds>{}));
+
+void BM_Variant(benchmark::State& state)
+{
+  std::vector<AnyKind> objects;
+  for (int k : kinds(int(state.range(0))))
+    withKind(k, [&](auto I) { objects.emplace_back(std::in_place_index<I>); });
+
+  run(state, [&] {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+      sum += std::visit([i](const auto& kind) { return kind.apply(i); }, objects[i]);
+    return sum;
+  });
+}
+
+} // namespace
+
+BENCHMARK(BM_Virtual)->ArgName("ways")->Arg(1)->Arg(2)->Arg(8);
+BENCHMARK(BM_Crtp)->ArgName("ways")->Arg(1)->Arg(2)->Arg(8);
+BENCHMARK(BM_FunctionPtr)->ArgName("ways")->Arg(1)->Arg(2)->Arg(8);
+BENCHMARK(BM_StdFunction)->ArgName("ways")->Arg(1)->Arg(2)->Arg(8);
+BENCHMARK(BM_Variant)->ArgName("ways")->Arg(1)->Arg(2)->Arg(8);
+
+ALI_BENCHMARK_MAIN();
@@ -0,0 +1,184 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "flat_hash_map.hpp"
+
+// Containers/FlatHashMap against std::unordered_map, uint64_t -> uint64_t,
+// at fixed load factors of the flat table.
+//
+//   Insert   n new keys into a map reserved for them (construction and
+//            destruction not timed)
+//   Hit      find() of present keys, random order
+//   Miss     find() of absent keys
+//   Erase    erase() of every key, random order (re-inserting not timed)
+//
+// Args: slots of the flat table (2^14: fits the L2 cache, 2^22: DRAM) and
+// its load factor in per mille (500, 625, 750, 875 = the maximum);
+// n = slots * load. unordered_map holds the same n keys with
+// max_load_factor 1 (its own load factor is in the "load" counter too).
+
+namespace {
+
+using Key = std::uint64_t;
+
+template <typename Map>
+constexpr bool isFlat = !std::is_same_v<Map, std::unordered_map<Key, Key>>;
+
+struct Keys
+{
+  std::vector<Key> present;     // inserted, in insertion order
+  std::vector<Key> lookups;     // the same, shuffled
+  std::vector<Key> absent;
+};
+
+// odd keys are inserted, even ones are never
+const Keys& keys(std::size_t n)
+{
+  static std::size_t cachedN = 0;
+  static Keys k;
+  if (cachedN != n) {
+    std::mt19937_64 rng(42);
+    k.present.resize(n);
+    k.absent.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      k.present[i] = rng() | 1;
+      k.absent[i] = rng() & ~Key(1);
+    }
+    k.lookups = k.present;
+    std::shuffle(k.lookups.begin(), k.lookups.end(), rng);
+    cachedN = n;
+  }
+  return k;
+}
+
+std::size_t elements(const benchmark::State& state)
+{
+  return (std::size_t(1) << state.range(0)) * std::size_t(state.range(1)) / 1000;
+}
+
+template <typename Map>
+void prepare(Map& map, std::size_t n)
+{
+  if constexpr (!isFlat<Map>)
+    map.max_load_factor(1.f);
+  map.reserve(n);
+}
+
+template <typename Map>
+Map filled(const Keys& k)
+{
+  Map map;
+  prepare(map, k.present.size());
+  for (Key key : k.present)
+    map.emplace(key, key);
+  return map;
+}
+
+template <typename Map>
+void finish(benchmark::State& state, const Map& map, std::size_t n)
+{
+  state.SetItemsProcessed(state.iterations() * std::int64_t(n));
+  state.counters["load"] = map.load_factor();
+  if constexpr (isFlat<Map>)
+    if (map.bucket_count() != std::size_t(1) << state.range(0))
+      state.SkipWithError("the flat table does not have the intended size");
+}
+
+//-----------------------------------------------------
+// Benchmarks
+//-----------------------------------------------------
+template <typename Map>
+void BM_Insert(benchmark::State& state)
+{
+  const std::size_t n = elements(state);
+  const auto& k = keys(n);
+  Map last;
+  for (auto _ : state) {
+    state.PauseTiming();
+    Map map;
+    prepare(map, n);
+    state.ResumeTiming();
+    for (Key key : k.present)
+      map.emplace(key, key);
+    state.PauseTiming();
+    last = std::move(map);
+    state.ResumeTiming();
+  }
+  finish(state, last, n);
+}
+
+template <typename Map>
+void BM_Hit(benchmark::State& state)
+{
+  const std::size_t n = elements(state);
+  const auto& k = keys(n);
+  const Map map = filled<Map>(k);
+  for (auto _ : state) {
+    Key sum = 0;
+    for (Key key : k.lookups)
+      sum += map.find(key)->second;
+    benchmark::DoNotOptimize(sum);
+  }
+  finish(state, map, n);
+}
+
+template <typename Map>
+void BM_Miss(benchmark::State& state)
+{
+  const std::size_t n = elements(state);
+  const auto& k = keys(n);
+  const Map map = filled<Map>(k);
+  for (auto _ : state) {
+    std::size_t found = 0;
+    for (Key key : k.absent)
+      found += map.find(key) != map.end();
+    benchmark::DoNotOptimize(found);
+  }
+  finish(state, map, n);
+}
+
+template <typename Map>
+void BM_Erase(benchmark::State& state)
+{
+  const std::size_t n = elements(state);
+  const auto& k = keys(n);
+  Map map = filled<Map>(k);
+  for (auto _ : state) {
+    for (Key key : k.lookups)
+      map.erase(key);
+    state.PauseTiming();
+    for (Key key : k.present)
+      map.emplace(key, key);
+    state.ResumeTiming();
+  }
+  finish(state, map, n);
+}
+
+void Loads(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "log2slots", "load" });
+  for (long slots : { 14, 22 })
+    for (long load : { 500, 625, 750, 875 })
+      b->Args({ slots, load });
+}
+
+using Flat = ali::flat_hash_map<Key, Key>;
+using Std = std::unordered_map<Key, Key>;
+
+} // namespace
+
+BENCHMARK(BM_Insert<Flat>)->Apply(Loads);
+BENCHMARK(BM_Insert<Std>)->Apply(Loads);
+BENCHMARK(BM_Hit<Flat>)->Apply(Loads);
+BENCHMARK(BM_Hit<Std>)->Apply(Loads);
+BENCHMARK(BM_Miss<Flat>)->Apply(Loads);
+BENCHMARK(BM_Miss<Std>)->Apply(Loads);
+BENCHMARK(BM_Erase<Flat>)->Apply(Loads);
+BENCHMARK(BM_Erase<Std>)->Apply(Loads);
+
+ALI_BENCHMARK_MAIN();
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "latency_histogram.hpp"
+
+/*
+    -----------------------
+    Latency Percentiles
+    -----------------------
+    Google Benchmark reports the mean time per iteration. When the single
+    operations inside an iteration are not all alike (a push_back that
+    reallocates, a lookup that misses the cache) the mean says nothing about
+    the slow ones. LatencyCounters collects every operation in a
+    LatencyHistogram (Profiling/Latency) and adds its percentiles as counters:
+
+        static void BM_Lookup(benchmark::State& state)
+        {
+            ali::LatencyCounters latency(state);
+            for (auto _ : state) {
+                ali::ScopedLatency timer(latency);
+                lookup();
+            }
+        }                                   // p50, p99, p99.9, max added here
+
+    The counters are in seconds, printed like 812n (812 ns) or 1.2m (1.2 ms).
+    In benchmarks with several threads each thread has its own histogram and
+    the reported values are averaged over the threads.
+*/
+
+namespace ali {
+
+class LatencyCounters
+{
+public:
+    explicit LatencyCounters(benchmark::State& state) : state_(state) {}
+    LatencyCounters(const LatencyCounters&) = delete;
+    LatencyCounters& operator=(const LatencyCounters&) = delete;
+
+    ~LatencyCounters()
+    {
+        if (histogram_.count() == 0)
+            return;
+        const auto s = histogram_.summary();
+        add("p50", s.p50);
+        add("p99", s.p99);
+        add("p99.9", s.p999);
+        add("max", s.max);
+    }
+
+    void record(std::uint64_t nanos) { histogram_.record(nanos); }
+
+    const LatencyHistogram& histogram() const { return histogram_; }
+
+private:
+    void add(const char* name, std::uint64_t nanos)
+    {
+        state_.counters[name] = benchmark::Counter(double(nanos) * 1e-9, benchmark::Counter::kAvgThreads);
+    }
+
+    benchmark::State& state_;
+    LatencyHistogram histogram_;
+};
+
+} // namespace ali
@@ -2,6 +2,14 @@
 #include <algorithm>
 #include <execution>
 #include <ctime>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "alloc_tracking.hpp"
+#include "bench_main.hpp"
+#include "latency_counters.hpp"
+#include "perf_counters.hpp"
 
 // create a vector of 500 elements
 // constexpr auto size = 1000000u;
@@ -40,6 +48,7 @@
 
 // Benchmark a function which creates empty strings
 static void BM_StringCreation(benchmark::State& state) {
+  ali::PerfScope perf(state);
   for (auto _ : state)
     std::string empty_string;
 }
@@ -47,9 +56,106 @@ BENCHMARK(BM_StringCreation);
 
 // Benchmark a function which copies strings
 static void BM_StringCopy(benchmark::State& state) {
+  ali::PerfScope perf(state);
+  ali::AllocScope allocs(state, 0);   // "hello" fits into the small string buffer
   for (auto _ : state)
     std::string copy("hello");
 }
 BENCHMARK(BM_StringCopy);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+// Same sum over the same elements, once in order and once in random order:
+// the counters show where the difference comes from (cache misses, IPC)
+static std::vector<int> data(std::size_t n) {
+  std::vector<int> v(n);
+  std::iota(v.begin(), v.end(), 0);
+  return v;
+}
+
+static void BM_SequentialSum(benchmark::State& state) {
+  const auto v = data(state.range(0));
+  ali::PerfScope perf(state, v.size());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(std::accumulate(v.begin(), v.end(), 0L));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SequentialSum)->Range(1 << 10, 1 << 24);
+
+static void BM_RandomSum(benchmark::State& state) {
+  const auto v = data(state.range(0));
+  auto index = data(state.range(0));
+  std::shuffle(index.begin(), index.end(), std::mt19937{42});
+  ali::PerfScope perf(state, v.size());
+  for (auto _ : state) {
+    long sum = 0;
+    for (int i : index)
+      sum += v[i];
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RandomSum)->Range(1 << 10, 1 << 24);
+
+// push_back vs emplace_back from Containers/Vector/main.cpp, without the printing.
+// Without reserve() the vector reallocates as it grows: allocs/iter shows how often.
+struct S {
+  int x, y;
+  S() : x(0), y(0) {}
+  S(int x, int y) : x(x), y(y) {}
+  S(const S& s) : x(s.x), y(s.y) {}
+  S(S&& s) noexcept : x(s.x), y(s.y) {}
+};
+
+static void BM_PushBack(benchmark::State& state) {
+  const bool reserve = state.range(1);
+  ali::AllocScope allocs(state, reserve ? 1 : ali::AllocScope::kNoBudget);
+  for (auto _ : state) {
+    std::vector<S> v;
+    if (reserve)
+      v.reserve(state.range(0));
+    for (int i = 0; i < state.range(0); ++i)
+      v.push_back(S(i, i));
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(BM_PushBack)->ArgsProduct({{8, 1024}, {0, 1}});
+
+static void BM_EmplaceBack(benchmark::State& state) {
+  const bool reserve = state.range(1);
+  ali::AllocScope allocs(state, reserve ? 1 : ali::AllocScope::kNoBudget);
+  for (auto _ : state) {
+    std::vector<S> v;
+    if (reserve)
+      v.reserve(state.range(0));
+    for (int i = 0; i < state.range(0); ++i)
+      v.emplace_back(i, i);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(BM_EmplaceBack)->ArgsProduct({{8, 1024}, {0, 1}});
+
+// One push_back per iteration: the mean looks cheap, the tail shows the
+// reallocations (copying the whole vector) that reserve() avoids.
+static void BM_PushBackLatency(benchmark::State& state) {
+  const bool reserve = state.range(0);
+  std::vector<S> v;
+  ali::LatencyCounters latency(state);
+  for (auto _ : state) {
+    if (v.size() == (1 << 20)) {
+      state.PauseTiming();
+      v = std::vector<S>();
+      if (reserve)
+        v.reserve(1 << 20);
+      state.ResumeTiming();
+    }
+    ali::ScopedLatency timer(latency);
+    v.push_back(S(1, 2));
+  }
+  benchmark::DoNotOptimize(v.data());
+}
+BENCHMARK(BM_PushBackLatency)->Arg(0)->Arg(1)->ArgName("reserve");
+
+// ALI_BENCHMARK_MAIN(), but failing when a benchmark allocated more than its budget
+int main(int argc, char** argv) {
+  const int result = ali::runBenchmarks(argc, argv);
+  return result ? result : ali::allocBudgetExceeded() ? 1 : 0;
+}
\ No newline at end of file
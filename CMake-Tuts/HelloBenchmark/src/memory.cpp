@@ -0,0 +1,236 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "cache_info.hpp"
+
+// Memory hierarchy sweep: how latency and bandwidth change as the working
+// set outgrows L1, L2, L3 and ends up in DRAM.
+//
+//   BM_Latency         pointer chasing through a random cyclic permutation of
+//                      cache lines: every load depends on the previous one and
+//                      the prefetcher cannot guess the next address
+//   BM_Read/BM_Write   sequential bandwidth
+//   BM_StridedRead     one 8 byte load every <stride> bytes: 64 = one per cache
+//                      line, 4096 = one per page (TLB misses)
+//   BM_ReadThreads     sequential read bandwidth of 1, 2, 4 ... threads, each
+//                      on its own part of the working set
+//
+// Working sets go from 4 KiB up to 4 GiB in powers of two, plus the exact
+// size of every cache level; each run is labelled with the level the working
+// set fits into. The upper end is capped at a quarter of the physical memory;
+// ALI_MEM_MAX=<bytes, K/M/G suffix allowed> overrides it (e.g. 64M for a
+// quick run).
+
+namespace {
+
+const std::vector<ali::CacheLevel> caches = ali::detectCaches();
+
+std::size_t maxBytes()
+{
+  if (const char* env = std::getenv("ALI_MEM_MAX"))
+    return ali::detail::parseSize(env);
+  std::size_t limit = std::size_t(4) << 30;
+#ifdef _SC_PHYS_PAGES
+  const long pages = sysconf(_SC_PHYS_PAGES), pageSize = sysconf(_SC_PAGESIZE);
+  if (pages > 0 && pageSize > 0)
+    limit = std::min(limit, std::size_t(pages) * std::size_t(pageSize) / 4);
+#endif
+  return limit;
+}
+
+std::vector<std::size_t> workingSets(std::size_t from, std::size_t step)
+{
+  const std::size_t max = maxBytes();
+  std::vector<std::size_t> sizes;
+  for (std::size_t s = from; s <= max; s *= step)
+    sizes.push_back(s);
+  for (const auto& c : caches)
+    if (c.size >= from && c.size <= max)
+      sizes.push_back(c.size);
+  std::sort(sizes.begin(), sizes.end());
+  sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+  return sizes;
+}
+
+void label(benchmark::State& state, std::size_t bytes)
+{
+  const char* unit = "B";
+  double size = double(bytes);
+  for (const char* u : { "KiB", "MiB", "GiB" })
+    if (size >= 1024) { size /= 1024; unit = u; }
+  state.SetLabel(std::to_string(int(size)) + unit + " " + ali::fittingLevel(caches, bytes));
+}
+
+// The buffers are kept between the runs of the same size: building a 4 GiB
+// permutation takes longer than measuring it.
+std::vector<std::uint64_t>& words(std::size_t bytes)
+{
+  static std::vector<std::uint64_t> buffer;
+  const std::size_t n = std::max<std::size_t>(bytes / sizeof(std::uint64_t), 1);
+  if (buffer.size() != n) {
+    buffer.clear();
+    buffer.shrink_to_fit();
+    buffer.assign(n, 1);                  // touch every page before timing
+  }
+  return buffer;
+}
+
+struct alignas(64) Node
+{
+  Node* next;
+};
+
+// one cycle through all nodes in random order (Sattolo's algorithm)
+Node* chain(std::size_t bytes)
+{
+  static std::vector<Node> nodes;
+  const std::size_t n = std::max<std::size_t>(bytes / sizeof(Node), 2);
+  if (nodes.size() != n) {
+    nodes.clear();
+    nodes.shrink_to_fit();
+    nodes.resize(n);
+
+    std::vector<std::uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937_64 rng(42);
+    for (std::size_t i = n - 1; i > 0; --i)
+      std::swap(order[i], order[std::uniform_int_distribution<std::size_t>(0, i - 1)(rng)]);
+    for (std::size_t i = 0; i < n; ++i)
+      nodes[i].next = &nodes[order[i]];
+  }
+  return &nodes[0];
+}
+
+//-----------------------------------------------------
+// Benchmarks
+//-----------------------------------------------------
+void BM_Latency(benchmark::State& state)
+{
+  constexpr std::size_t kLoads = 1 << 16;
+  const std::size_t bytes = state.range(0);
+  Node* p = chain(bytes);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < kLoads; i += 8) {
+      p = p->next; p = p->next; p = p->next; p = p->next;
+      p = p->next; p = p->next; p = p->next; p = p->next;
+    }
+    benchmark::DoNotOptimize(p);
+  }
+  // seconds per load: printed as e.g. 1.2n (nanoseconds)
+  state.counters["time/load"] = benchmark::Counter(double(state.iterations() * kLoads),
+                                                 benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  label(state, bytes);
+}
+
+void BM_Read(benchmark::State& state)
+{
+  const std::size_t bytes = state.range(0);
+  const auto& v = words(bytes);
+  for (auto _ : state) {
+    std::uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= v.size(); i += 4) {
+      s0 += v[i]; s1 += v[i + 1]; s2 += v[i + 2]; s3 += v[i + 3];
+    }
+    for (; i < v.size(); ++i)
+      s0 += v[i];
+    benchmark::DoNotOptimize(s0 + s1 + s2 + s3);
+  }
+  state.SetBytesProcessed(state.iterations() * v.size() * sizeof(std::uint64_t));
+  label(state, bytes);
+}
+
+void BM_Write(benchmark::State& state)
+{
+  const std::size_t bytes = state.range(0);
+  auto& v = words(bytes);
+  std::uint64_t value = 0;
+  for (auto _ : state) {
+    ++value;
+    for (auto& x : v)
+      x = value;
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * v.size() * sizeof(std::uint64_t));
+  label(state, bytes);
+}
+
+void BM_StridedRead(benchmark::State& state)
+{
+  const std::size_t bytes = state.range(0);
+  const std::size_t stride = state.range(1) / sizeof(std::uint64_t);
+  const auto& v = words(bytes);
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < v.size(); i += stride)
+      sum += v[i];
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::size_t accesses = (v.size() + stride - 1) / stride;
+  state.counters["time/access"] = benchmark::Counter(double(state.iterations() * accesses),
+                                                   benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  label(state, bytes);
+}
+
+// every thread allocates and reads its own share of the working set
+void BM_ReadThreads(benchmark::State& state)
+{
+  const std::size_t bytes = state.range(0);
+  const std::vector<std::uint64_t> v(std::max<std::size_t>(bytes / sizeof(std::uint64_t) / state.threads(), 1), 1);
+  for (auto _ : state) {
+    std::uint64_t s0 = 0, s1 = 0;
+    for (std::size_t i = 0; i + 2 <= v.size(); i += 2) {
+      s0 += v[i]; s1 += v[i + 1];
+    }
+    benchmark::DoNotOptimize(s0 + s1);
+  }
+  state.SetBytesProcessed(state.iterations() * v.size() * sizeof(std::uint64_t));
+  if (state.thread_index() == 0)
+    label(state, bytes);
+}
+
+void registerBenchmarks()
+{
+  for (auto bytes : workingSets(4 << 10, 2)) {
+    const auto n = std::int64_t(bytes);
+    benchmark::RegisterBenchmark("BM_Latency", BM_Latency)->Arg(n);
+    benchmark::RegisterBenchmark("BM_Read", BM_Read)->Arg(n);
+    benchmark::RegisterBenchmark("BM_Write", BM_Write)->Arg(n);
+  }
+  for (auto bytes : workingSets(16 << 10, 4))
+    for (std::int64_t stride : { 64, 256, 4096 })
+      benchmark::RegisterBenchmark("BM_StridedRead", BM_StridedRead)->Args({ std::int64_t(bytes), stride });
+
+  const int hardware = int(std::max(1u, std::thread::hardware_concurrency()));
+  for (auto bytes : workingSets(1 << 20, 8)) {
+    auto* b = benchmark::RegisterBenchmark("BM_ReadThreads", BM_ReadThreads)->Arg(std::int64_t(bytes))->UseRealTime();
+    for (int t = 1; t < hardware; t *= 2)
+      b->Threads(t);
+    b->Threads(hardware);
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::cout << "Caches (from /sys/devices/system/cpu/cpu0/cache):\n";
+  for (const auto& c : caches) {
+    std::cout << "  L" << c.level << " " << c.type << " " << (c.size >> 10) << " KiB, "
+              << c.lineSize << " B lines, shared by " << c.sharedBy << " CPU(s)\n";
+    benchmark::AddCustomContext("cache_L" + std::to_string(c.level) + "_" + c.type, std::to_string(c.size));
+  }
+  std::cout << "Working sets up to " << (maxBytes() >> 20) << " MiB\n\n";
+
+  registerBenchmarks();
+  return ali::runBenchmarks(argc, argv);
+}
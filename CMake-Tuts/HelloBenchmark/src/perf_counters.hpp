@@ -0,0 +1,215 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+    -----------------------
+    Hardware Performance Counters
+    -----------------------
+    Wall time alone says *that* something is slow, the CPU's counters say
+    *why*: few instructions per cycle, cache misses or mispredicted branches.
+
+    PerfScope opens Linux perf_event_open counters for the calling thread and
+    counts from its construction to its destruction, so put it right in front
+    of the benchmark loop:
+
+        static void BM_Sum(benchmark::State& state)
+        {
+            std::vector<int> v = ...;                       // not counted
+            ali::PerfScope perf(state, v.size());           // elements per iteration
+            for (auto _ : state)
+                benchmark::DoNotOptimize(std::accumulate(v.begin(), v.end(), 0));
+        }                                                   // counters added here
+
+    Reported as custom counters (per iteration, or per element):
+
+        cycles, instructions    per iteration
+        IPC                     instructions / cycles
+        cache-miss/elem         last level cache misses
+        branch-miss/elem        mispredicted branches
+        LLC-load/elem           loads that reached the last level cache
+
+    Only user space is counted (exclude_kernel), which perf_event_paranoid = 2
+    (the usual default) still allows. If the kernel has no perf support, the
+    counters are not permitted (containers, paranoid = 3) or the CPU does not
+    have a particular event (VMs), the affected counters are simply left out;
+    the benchmark itself runs as usual. A note is printed to stderr once.
+
+    Set ALI_PERF=0 to switch the counters off altogether.
+
+    When the kernel has to multiplex more events than the CPU has counters,
+    each count is scaled by time_enabled / time_running.
+
+    pause()/resume() go together with state.PauseTiming()/ResumeTiming().
+*/
+
+namespace ali {
+
+class PerfScope
+{
+public:
+    enum Event { Cycles, Instructions, CacheMisses, BranchMisses, LLCLoads, kEvents };
+
+    PerfScope(benchmark::State& state, double elementsPerIteration = 1.0)
+        : state_(state), elements_(elementsPerIteration)
+    {
+        fds_.fill(-1);
+        if (!enabled())
+            return;
+#ifdef __linux__
+        for (int e = 0; e < kEvents; ++e)
+            fds_[e] = open(Event(e));
+        if (!anyOpen())
+            warnOnce(errno);
+        resume();
+#endif
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+    ~PerfScope()
+    {
+        pause();
+        report();
+#ifdef __linux__
+        for (int fd : fds_)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    void pause()  { enableAll(false); }
+    void resume() { enableAll(true); }
+
+    // false when no counter could be opened
+    bool available() const { return anyOpen(); }
+
+    static bool enabled()
+    {
+        const char* env = std::getenv("ALI_PERF");
+        return !(env && std::strcmp(env, "0") == 0);
+    }
+
+private:
+    bool anyOpen() const
+    {
+        for (int fd : fds_)
+            if (fd >= 0) return true;
+        return false;
+    }
+
+#ifdef __linux__
+    static int open(Event e)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        switch (e) {
+            case Cycles:       attr.config = PERF_COUNT_HW_CPU_CYCLES;       break;
+            case Instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS;     break;
+            case CacheMisses:  attr.config = PERF_COUNT_HW_CACHE_MISSES;     break;
+            case BranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES;    break;
+            case LLCLoads:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL
+                            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                            | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+                break;
+            default: return -1;
+        }
+
+        // this thread, any CPU, no group
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    // the count scaled up for the time the event was not scheduled; < 0 if unknown
+    double read(Event e) const
+    {
+        if (fds_[e] < 0)
+            return -1;
+        std::uint64_t v[3] = {};    // value, time_enabled, time_running
+        if (::read(fds_[e], v, sizeof(v)) != sizeof(v) || v[2] == 0)
+            return -1;
+        return double(v[0]) * double(v[1]) / double(v[2]);
+    }
+
+    static void warnOnce(int error)
+    {
+        static bool warned = false;
+        if (warned)
+            return;
+        warned = true;
+        std::fprintf(stderr, "PerfScope: hardware counters unavailable (%s), reporting wall time only\n",
+                     std::strerror(error));
+    }
+#endif
+
+    void enableAll(bool enable)
+    {
+#ifdef __linux__
+        for (int fd : fds_)
+            if (fd >= 0)
+                ioctl(fd, enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+#else
+        (void)enable;
+#endif
+    }
+
+    void report()
+    {
+#ifdef __linux__
+        const double iterations = double(state_.iterations());
+        if (!anyOpen() || iterations == 0)
+            return;
+
+        using benchmark::Counter;
+        const double cycles = read(Cycles);
+        const double instructions = read(Instructions);
+        const double elements = iterations * elements_;
+
+        if (cycles >= 0)
+            state_.counters["cycles"] = Counter(cycles, Counter::kAvgIterations);
+        if (instructions >= 0)
+            state_.counters["instructions"] = Counter(instructions, Counter::kAvgIterations);
+        if (cycles > 0 && instructions >= 0)
+            state_.counters["IPC"] = instructions / cycles;
+
+        auto perElement = [&](Event e, const char* name) {
+            const double v = read(e);
+            if (v >= 0)
+                state_.counters[name] = v / elements;
+        };
+        perElement(CacheMisses,  "cache-miss/elem");
+        perElement(BranchMisses, "branch-miss/elem");
+        perElement(LLCLoads,     "LLC-load/elem");
+#endif
+    }
+
+    benchmark::State&       state_;
+    const double            elements_;
+    std::array<int, kEvents> fds_;
+};
+
+} // namespace ali
@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include <ratio>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "reloc_vector.hpp"
+
+// Containers/RelocVector against std::vector.
+//
+//   PushBack   fill a fresh vector with n elements, growth included
+//   Grow       one growth step of a full vector of n ints to 2n (the
+//              reserve() alone; filling and freeing are not timed): memcpy
+//              of the whole vector for std::vector, realloc()/mremap() for
+//              reloc_vector, an mprotect() inside a reservation
+//
+// Vectors (first template argument):
+//
+//   Std          std::vector
+//   Reloc        ali::reloc_vector, growth factor 2
+//   Reloc15      ali::reloc_vector, growth factor 1.5
+//   Reserved     ali::reloc_vector after reserve_address_space(4n)
+//
+// Arg: number of elements. From 1 MiB on reloc_vector is mapped, and Grow
+// should stop depending on n (page table updates instead of a copy). Grow
+// runs a fixed 20 iterations: the untimed fill of up to 512 MiB would
+// otherwise run thousands of times for the fast variants.
+
+struct Point2D {
+  float x, y;
+};
+
+template <typename T>
+using Std = std::vector<T>;
+
+template <typename T>
+using Reloc = ali::reloc_vector<T>;
+
+template <typename T>
+using Reloc15 = ali::reloc_vector<T, std::ratio<3, 2>>;
+
+template <typename T>
+struct Reserved : ali::reloc_vector<T> {};      // tag: reserve_address_space(4n) first
+
+template <typename V>
+constexpr bool isReserved = false;
+template <typename T>
+constexpr bool isReserved<Reserved<T>> = true;
+
+template <typename V>
+static void prepare(V& v, std::size_t n) {
+  if constexpr (isReserved<V>)
+    v.reserve_address_space(4 * n);
+}
+
+template <typename T>
+static T element(std::size_t i) {
+  if constexpr (std::is_same_v<T, int>)
+    return int(i);
+  else
+    return T{float(i), 1.f};
+}
+
+template <template <typename> class V, typename T>
+static void BM_PushBack(benchmark::State& state) {
+  const auto n = std::size_t(state.range(0));
+  for (auto _ : state) {
+    V<T> v;
+    prepare(v, n);
+    for (std::size_t i = 0; i < n; ++i)
+      v.push_back(element<T>(i));
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <template <typename> class V>
+static void BM_Grow(benchmark::State& state) {
+  const auto n = std::size_t(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    V<int> v;
+    prepare(v, n);
+    v.reserve(n);
+    v.resize(n, 1);             // touched: the pages are really there
+    state.ResumeTiming();
+
+    v.reserve(2 * n);
+    benchmark::DoNotOptimize(v.data());
+
+    state.PauseTiming();
+    V<int>().swap(v);
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations() * n * sizeof(int)));
+}
+
+#define PUSH_SIZES ->RangeMultiplier(8)->Range(1 << 10, 1 << 25)
+#define GROW_SIZES ->RangeMultiplier(8)->Range(1 << 15, 1 << 27)->Iterations(20)->Unit(benchmark::kMicrosecond)
+
+BENCHMARK_TEMPLATE(BM_PushBack, Std, int) PUSH_SIZES;
+BENCHMARK_TEMPLATE(BM_PushBack, Reloc, int) PUSH_SIZES;
+BENCHMARK_TEMPLATE(BM_PushBack, Reloc15, int) PUSH_SIZES;
+BENCHMARK_TEMPLATE(BM_PushBack, Reserved, int) PUSH_SIZES;
+BENCHMARK_TEMPLATE(BM_PushBack, Std, Point2D) PUSH_SIZES;
+BENCHMARK_TEMPLATE(BM_PushBack, Reloc, Point2D) PUSH_SIZES;
+BENCHMARK_TEMPLATE(BM_PushBack, Reserved, Point2D) PUSH_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Grow, Std) GROW_SIZES;
+BENCHMARK_TEMPLATE(BM_Grow, Reloc) GROW_SIZES;
+BENCHMARK_TEMPLATE(BM_Grow, Reserved) GROW_SIZES;
+
+ALI_BENCHMARK_MAIN();
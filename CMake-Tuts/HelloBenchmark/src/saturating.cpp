@@ -0,0 +1,176 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "saturating.hpp"
+
+// Arithmetic/saturating.hpp against the "naive" way of staying overflow-safe:
+// widen every sample to the next bigger type, compute, clamp back.
+//
+// Every kernel is run once per instruction set (arg 1: 0 = scalar,
+// 1 = sse4.2, 2 = avx2); sets the CPU does not support are skipped.
+
+namespace simd = ali::simd;
+
+template <typename T>
+static std::vector<T> samples(std::size_t n, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<std::int64_t> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+  std::vector<T> v(n);
+  for (auto& x : v)
+    x = T(dist(rng));
+  return v;
+}
+
+template <typename T>
+using Wide = std::conditional_t<sizeof(T) == 2, std::int32_t, std::int64_t>;
+
+template <typename T>
+static T clampTo(Wide<T> x)
+{
+  constexpr Wide<T> lo = std::numeric_limits<T>::min();
+  constexpr Wide<T> hi = std::numeric_limits<T>::max();
+  return T(x < lo ? lo : x > hi ? hi : x);
+}
+
+static bool selectIsa(benchmark::State& state)
+{
+  const auto isa = simd::Isa(state.range(1));
+  if (!simd::supported(isa)) {
+    state.SkipWithError("instruction set not supported");
+    return false;
+  }
+  simd::setIsa(isa);
+  state.SetLabel(simd::name(isa));
+  return true;
+}
+
+//-----------------------------------------------------
+// naive widened loops
+//-----------------------------------------------------
+template <typename T>
+static void BM_NaiveMidpoint(benchmark::State& state)
+{
+  const auto a = samples<T>(state.range(0), 1), b = samples<T>(state.range(0), 2);
+  std::vector<T> out(a.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < a.size(); ++i)
+      out[i] = T((Wide<T>(a[i]) + b[i]) / 2);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename T>
+static void BM_NaiveSatAdd(benchmark::State& state)
+{
+  const auto a = samples<T>(state.range(0), 1), b = samples<T>(state.range(0), 2);
+  std::vector<T> out(a.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < a.size(); ++i)
+      out[i] = clampTo<T>(Wide<T>(a[i]) + b[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename T>
+static void BM_NaiveSatMul(benchmark::State& state)
+{
+  const auto a = samples<T>(state.range(0), 1), b = samples<T>(state.range(0), 2);
+  std::vector<T> out(a.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < a.size(); ++i)
+      out[i] = clampTo<T>(Wide<T>(a[i]) * b[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename T>
+static void BM_NaiveSum(benchmark::State& state)
+{
+  const auto a = samples<T>(state.range(0), 1);
+  for (auto _ : state) {
+    std::int64_t sum = 0;
+    for (auto x : a)
+      sum += x;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+//-----------------------------------------------------
+// ali:: kernels
+//-----------------------------------------------------
+template <typename T>
+static void binaryKernel(benchmark::State& state, void (*kernel)(std::span<const T>, std::span<const T>, std::span<T>))
+{
+  if (!selectIsa(state))
+    return;
+  const auto a = samples<T>(state.range(0), 1), b = samples<T>(state.range(0), 2);
+  std::vector<T> out(a.size());
+  for (auto _ : state) {
+    kernel(a, b, out);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename T> static void BM_Midpoint(benchmark::State& state) { binaryKernel<T>(state, ali::midpoint); }
+template <typename T> static void BM_SatAdd(benchmark::State& state)   { binaryKernel<T>(state, ali::sat_add); }
+template <typename T> static void BM_SatMul(benchmark::State& state)   { binaryKernel<T>(state, ali::sat_mul); }
+
+template <typename T>
+static void BM_WideningSum(benchmark::State& state)
+{
+  if (!selectIsa(state))
+    return;
+  const auto a = samples<T>(state.range(0), 1);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ali::widening_sum(std::span<const T>(a)));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void Sizes(benchmark::internal::Benchmark* b)
+{
+  for (long n : { 1 << 10, 1 << 16, 1 << 22 })
+    b->Args({ n, 0 });
+}
+
+static void SizesPerIsa(benchmark::internal::Benchmark* b)
+{
+  for (long n : { 1 << 10, 1 << 16, 1 << 22 })
+    for (long isa = 0; isa <= 2; ++isa)
+      b->Args({ n, isa });
+}
+
+BENCHMARK(BM_NaiveMidpoint<std::int16_t>)->Apply(Sizes);
+BENCHMARK(BM_Midpoint<std::int16_t>)->Apply(SizesPerIsa);
+BENCHMARK(BM_NaiveMidpoint<std::int32_t>)->Apply(Sizes);
+BENCHMARK(BM_Midpoint<std::int32_t>)->Apply(SizesPerIsa);
+
+BENCHMARK(BM_NaiveSatAdd<std::int16_t>)->Apply(Sizes);
+BENCHMARK(BM_SatAdd<std::int16_t>)->Apply(SizesPerIsa);
+BENCHMARK(BM_NaiveSatAdd<std::int32_t>)->Apply(Sizes);
+BENCHMARK(BM_SatAdd<std::int32_t>)->Apply(SizesPerIsa);
+
+BENCHMARK(BM_NaiveSatMul<std::int16_t>)->Apply(Sizes);
+BENCHMARK(BM_SatMul<std::int16_t>)->Apply(SizesPerIsa);
+BENCHMARK(BM_NaiveSatMul<std::int32_t>)->Apply(Sizes);
+BENCHMARK(BM_SatMul<std::int32_t>)->Apply(SizesPerIsa);
+
+BENCHMARK(BM_NaiveSum<std::int16_t>)->Apply(Sizes);
+BENCHMARK(BM_WideningSum<std::int16_t>)->Apply(SizesPerIsa);
+BENCHMARK(BM_NaiveSum<std::int32_t>)->Apply(Sizes);
+BENCHMARK(BM_WideningSum<std::int32_t>)->Apply(SizesPerIsa);
+
+ALI_BENCHMARK_MAIN();
@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "alloc_tracking.hpp"
+#include "bench_main.hpp"
+#include "small_vector.hpp"
+
+// Containers/SmallVector against std::vector on the push_back / emplace_back
+// patterns of Containers/Vector/main.cpp: fill a fresh container with n
+// elements, n = 4 ... 64. small_vector<T, 16> does not allocate up to 16
+// elements and then grows like std::vector; std::vector with reserve() is
+// the best std::vector can do (always exactly one allocation).
+//
+// Arg: number of elements. Counters: allocs/iter (budget 0 for
+// small_vector up to 16 elements) and time per element.
+
+struct Point2D {
+  float x, y;
+};
+
+// S of Containers/Vector/main.cpp, without the printing
+struct S {
+  int x, y;
+  S() : x(0), y(0) {}
+  S(int x, int y) : x(x), y(y) {}
+  S(const S& s) : x(s.x), y(s.y) {}
+  S(S&& s) noexcept : x(s.x), y(s.y) {}
+};
+
+template <typename T>
+using Std = std::vector<T>;
+
+template <typename T>
+struct StdReserved : std::vector<T> {};     // tag: reserve(n) before filling
+
+template <typename T>
+using Small = ali::small_vector<T, 16>;
+
+// after the AllocScope is gone: adding a counter allocates
+static void timePerElement(benchmark::State& state, int n) {
+  state.counters["time/elem"] = benchmark::Counter(double(state.iterations()) * n,
+                                                   benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+enum class Pattern { PushBackLValue, PushBackRValue, EmplaceBack };
+
+template <template <typename> class C, typename T, Pattern P>
+static void BM_Fill(benchmark::State& state) {
+  const int n = int(state.range(0));
+  constexpr bool small = std::is_same_v<C<T>, Small<T>>;
+  const T value{1, 2};
+  {
+    ali::AllocScope allocs(state, small && n <= 16 ? 0 : ali::AllocScope::kNoBudget);
+    for (auto _ : state) {
+      C<T> v;
+      if constexpr (std::is_same_v<C<T>, StdReserved<T>>)
+        v.reserve(n);
+      for (int i = 0; i < n; ++i) {
+        if constexpr (P == Pattern::PushBackLValue)
+          v.push_back(value);
+        else if constexpr (P == Pattern::PushBackRValue)
+          v.push_back(T{decltype(T::x)(i), decltype(T::y)(i)});
+        else
+          v.emplace_back(T{decltype(T::x)(i), decltype(T::y)(i)});
+      }
+      benchmark::DoNotOptimize(v.data());
+      benchmark::ClobberMemory();
+    }
+  }
+  timePerElement(state, n);
+}
+
+// emplace_back(x, y): constructs in place, needs a constructor (S only)
+template <template <typename> class C>
+static void BM_EmplaceArgs(benchmark::State& state) {
+  const int n = int(state.range(0));
+  constexpr bool small = std::is_same_v<C<S>, Small<S>>;
+  {
+    ali::AllocScope allocs(state, small && n <= 16 ? 0 : ali::AllocScope::kNoBudget);
+    for (auto _ : state) {
+      C<S> v;
+      if constexpr (std::is_same_v<C<S>, StdReserved<S>>)
+        v.reserve(n);
+      for (int i = 0; i < n; ++i)
+        v.emplace_back(i, i);
+      benchmark::DoNotOptimize(v.data());
+      benchmark::ClobberMemory();
+    }
+  }
+  timePerElement(state, n);
+}
+
+// std::vector<Point2D> points { {1,1}, {2,2}, {3,3}, {4,4} } of Containers/Vector/main.cpp
+template <template <typename> class C>
+static void BM_InitList4(benchmark::State& state) {
+  ali::AllocScope allocs(state, std::is_same_v<C<Point2D>, Small<Point2D>> ? 0 : ali::AllocScope::kNoBudget);
+  for (auto _ : state) {
+    C<Point2D> points{{1, 1}, {2, 2}, {3, 3}, {4, 4}};
+    benchmark::DoNotOptimize(points.data());
+    benchmark::ClobberMemory();
+  }
+}
+
+#define SIZES ->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(64)
+
+#define FILL(C, T, P) BENCHMARK_TEMPLATE(BM_Fill, C, T, Pattern::P)->Name(#P "/" #T "/" #C) SIZES
+
+FILL(Std, Point2D, PushBackLValue);
+FILL(StdReserved, Point2D, PushBackLValue);
+FILL(Small, Point2D, PushBackLValue);
+FILL(Std, Point2D, PushBackRValue);
+FILL(StdReserved, Point2D, PushBackRValue);
+FILL(Small, Point2D, PushBackRValue);
+FILL(Std, S, PushBackLValue);
+FILL(StdReserved, S, PushBackLValue);
+FILL(Small, S, PushBackLValue);
+FILL(Std, S, PushBackRValue);
+FILL(StdReserved, S, PushBackRValue);
+FILL(Small, S, PushBackRValue);
+FILL(Std, S, EmplaceBack);
+FILL(StdReserved, S, EmplaceBack);
+FILL(Small, S, EmplaceBack);
+
+BENCHMARK_TEMPLATE(BM_EmplaceArgs, Std)->Name("EmplaceBackArgs/S/Std") SIZES;
+BENCHMARK_TEMPLATE(BM_EmplaceArgs, StdReserved)->Name("EmplaceBackArgs/S/StdReserved") SIZES;
+BENCHMARK_TEMPLATE(BM_EmplaceArgs, Small)->Name("EmplaceBackArgs/S/Small") SIZES;
+
+BENCHMARK_TEMPLATE(BM_InitList4, Std)->Name("InitList4/Point2D/Std");
+BENCHMARK_TEMPLATE(BM_InitList4, Small)->Name("InitList4/Point2D/Small");
+
+// ALI_BENCHMARK_MAIN(), but failing when small_vector allocated below its inline capacity
+int main(int argc, char** argv) {
+  const int result = ali::runBenchmarks(argc, argv);
+  return result ? result : ali::allocBudgetExceeded() ? 1 : 0;
+}
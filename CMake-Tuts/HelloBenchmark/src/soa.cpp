@@ -0,0 +1,194 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+
+#include "bench_main.hpp"
+#include "perf_counters.hpp"
+#include "soa_vector.hpp"
+
+// Containers/SoA: the same kernels over std::vector<Point2D> (AoS) and over
+// ali::soa_vector<float, float> (SoA), once through the column spans and once
+// through the proxy references ("feels like vector<Point2D>").
+//
+//   Distance     d[i] = |p[i] - q|        reads x and y, writes d
+//   ScaleX       x[i] = a * x[i] + b      only x: AoS drags y through the cache
+//   Translate    p[i] += (dx, dy)         both fields, in place
+//
+// Arg: number of points, 1K (L1) ... 16M (DRAM). Bytes/s counts the bytes
+// the kernel has to move: for ScaleX that is 8 per point with AoS and 4
+// with SoA, the point of the exercise.
+
+struct Point2D {
+  float x, y;
+};
+
+using Points = ali::soa_vector<float, float>;
+
+static std::vector<Point2D> aosPoints(std::size_t n) {
+  std::vector<Point2D> v(n);
+  for (std::size_t i = 0; i < n; ++i)
+    v[i] = {float(i % 1000), float(i % 777)};
+  return v;
+}
+
+static Points soaPoints(std::size_t n) {
+  Points v;
+  v.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    v.emplace_back(float(i % 1000), float(i % 777));
+  return v;
+}
+
+static void finish(benchmark::State& state, double bytesPerPoint) {
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(int64_t(double(state.iterations()) * double(state.range(0)) * bytesPerPoint));
+}
+
+//-----------------------------------------------------
+// Distance
+//-----------------------------------------------------
+static void BM_DistanceAoS(benchmark::State& state) {
+  const auto points = aosPoints(state.range(0));
+  std::vector<float> d(points.size());
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      const float dx = points[i].x - 3.f, dy = points[i].y - 4.f;
+      d[i] = std::sqrt(dx * dx + dy * dy);
+    }
+    benchmark::DoNotOptimize(d.data());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 12);
+}
+
+static void BM_DistanceSoA(benchmark::State& state) {
+  const auto points = soaPoints(state.range(0));
+  std::vector<float> d(points.size());
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    const float* xs = points.data<0>();
+    const float* ys = points.data<1>();
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      const float dx = xs[i] - 3.f, dy = ys[i] - 4.f;
+      d[i] = std::sqrt(dx * dx + dy * dy);
+    }
+    benchmark::DoNotOptimize(d.data());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 12);
+}
+
+static void BM_DistanceSoAProxy(benchmark::State& state) {
+  const auto points = soaPoints(state.range(0));
+  std::vector<float> d(points.size());
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    float* out = d.data();
+    for (auto [x, y] : points) {
+      const float dx = x - 3.f, dy = y - 4.f;
+      *out++ = std::sqrt(dx * dx + dy * dy);
+    }
+    benchmark::DoNotOptimize(d.data());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 12);
+}
+
+//-----------------------------------------------------
+// ScaleX
+//-----------------------------------------------------
+static void BM_ScaleXAoS(benchmark::State& state) {
+  auto points = aosPoints(state.range(0));
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    for (auto& p : points)
+      p.x = 0.5f * p.x + 1.f;
+    benchmark::DoNotOptimize(points.data());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 16);    // read + write of whole lines
+}
+
+static void BM_ScaleXSoA(benchmark::State& state) {
+  auto points = soaPoints(state.range(0));
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    for (float& x : points.column<0>())
+      x = 0.5f * x + 1.f;
+    benchmark::DoNotOptimize(points.data<0>());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 8);
+}
+
+static void BM_ScaleXSoAProxy(benchmark::State& state) {
+  auto points = soaPoints(state.range(0));
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    for (auto p : points)
+      p.get<0>() = 0.5f * p.get<0>() + 1.f;
+    benchmark::DoNotOptimize(points.data<0>());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 8);
+}
+
+//-----------------------------------------------------
+// Translate
+//-----------------------------------------------------
+static void BM_TranslateAoS(benchmark::State& state) {
+  auto points = aosPoints(state.range(0));
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    for (auto& p : points) {
+      p.x += 1.f;
+      p.y -= 1.f;
+    }
+    benchmark::DoNotOptimize(points.data());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 16);
+}
+
+static void BM_TranslateSoA(benchmark::State& state) {
+  auto points = soaPoints(state.range(0));
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    for (float& x : points.column<0>())
+      x += 1.f;
+    for (float& y : points.column<1>())
+      y -= 1.f;
+    benchmark::DoNotOptimize(points.data<0>());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 16);
+}
+
+static void BM_TranslateSoAProxy(benchmark::State& state) {
+  auto points = soaPoints(state.range(0));
+  ali::PerfScope perf(state, points.size());
+  for (auto _ : state) {
+    for (auto [x, y] : points) {
+      x += 1.f;
+      y -= 1.f;
+    }
+    benchmark::DoNotOptimize(points.data<0>());
+    benchmark::ClobberMemory();
+  }
+  finish(state, 16);
+}
+
+#define SIZES ->RangeMultiplier(8)->Range(1 << 10, 1 << 24)
+
+BENCHMARK(BM_DistanceAoS) SIZES;
+BENCHMARK(BM_DistanceSoA) SIZES;
+BENCHMARK(BM_DistanceSoAProxy) SIZES;
+BENCHMARK(BM_ScaleXAoS) SIZES;
+BENCHMARK(BM_ScaleXSoA) SIZES;
+BENCHMARK(BM_ScaleXSoAProxy) SIZES;
+BENCHMARK(BM_TranslateAoS) SIZES;
+BENCHMARK(BM_TranslateSoA) SIZES;
+BENCHMARK(BM_TranslateSoAProxy) SIZES;
+
+ALI_BENCHMARK_MAIN();
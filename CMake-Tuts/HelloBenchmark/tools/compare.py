@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+-----------------------
+Benchmark Comparator
+-----------------------
+Compares two JSON result files written by the benchmarks (see
+src/bench_main.hpp) and flags regressions:
+
+    python3 tools/compare.py baseline.json contender.json
+    python3 tools/compare.py --threshold 3 --alpha 0.01 old.json new.json
+
+For every benchmark found in both files the repetitions of baseline and
+contender are compared with a two-sided Mann-Whitney U test. A benchmark is
+a REGRESSION when its median time got slower by more than --threshold
+percent *and* the test says the difference is not noise (p < --alpha), an
+IMPROVEMENT the other way round. Without repetitions (run the benchmarks
+with --benchmark_repetitions=N, N >= 5 is sensible) there is no test and
+only the threshold is applied, marked with '?'.
+
+Differences in the machine fingerprint (CPU model, governor, compiler flags,
+...) are printed first: comparing across them measures the machine, not the
+code.
+
+Exit code 1 if there is a regression or a benchmark failed in the contender
+(e.g. an allocation budget was exceeded), so a nightly job can fail on it.
+
+Only the Python standard library is needed.
+"""
+
+import argparse
+import json
+import math
+import sys
+from collections import OrderedDict
+
+TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+FINGERPRINT = ["cpu_model", "num_cpus", "mhz_per_cpu", "cpu_governor", "cpu_boost", "cpu_scaling_enabled",
+               "kernel", "compiler", "compiler_flags", "build_type", "library_build_type"]
+
+
+def load(path, metric):
+    """returns (context, {name: [times in ns]}, {name: error message})"""
+    with open(path) as f:
+        data = json.load(f)
+
+    times = OrderedDict()
+    errors = {}
+    for b in data.get("benchmarks", []):
+        if b.get("run_type") == "aggregate":
+            continue
+        name = b.get("run_name", b["name"])
+        if b.get("error_occurred"):
+            errors[name] = b.get("error_message", "error")
+            continue
+        times.setdefault(name, []).append(b[metric] * TO_NS.get(b.get("time_unit", "ns"), 1.0))
+    return data.get("context", {}), times, errors
+
+
+def median(xs):
+    s = sorted(xs)
+    n = len(s)
+    return s[n // 2] if n % 2 else 0.5 * (s[n // 2 - 1] + s[n // 2])
+
+
+def mann_whitney_u(xs, ys):
+    """two-sided p-value of the Mann-Whitney U test (normal approximation with
+    tie and continuity correction); None when there are too few samples"""
+    n1, n2 = len(xs), len(ys)
+    if n1 < 2 or n2 < 2:
+        return None
+
+    # ranks, ties get the average rank
+    pooled = sorted([(x, 0) for x in xs] + [(y, 1) for y in ys])
+    ranks = [0.0] * len(pooled)
+    ties = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1.0
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+
+    r1 = sum(r for r, (_, group) in zip(ranks, pooled) if group == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2.0
+    mu = n1 * n2 / 2.0
+    n = n1 + n2
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1))))
+    if sigma == 0:
+        return 1.0
+    z = (abs(u1 - mu) - 0.5) / sigma
+    return max(0.0, min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2.0))))
+
+
+def format_time(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.3g %s" % (ns / scale, unit)
+    return "%.3g ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark result files.")
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent change that counts (default 5)")
+    parser.add_argument("--alpha", type=float, default=0.05, help="significance level of the U test (default 0.05)")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"], default="real_time")
+    parser.add_argument("--filter", default="", help="only benchmarks whose name contains this")
+    args = parser.parse_args()
+
+    base_ctx, base, _ = load(args.baseline, args.metric)
+    new_ctx, new, new_errors = load(args.contender, args.metric)
+
+    differences = [(k, base_ctx.get(k), new_ctx.get(k)) for k in FINGERPRINT if base_ctx.get(k) != new_ctx.get(k)]
+    if differences:
+        print("warning: the runs come from different machines or builds")
+        for key, a, b in differences:
+            print("  %-20s %s  ->  %s" % (key, a, b))
+        print()
+
+    rows = []
+    regressions = 0
+    for name, xs in base.items():
+        if args.filter not in name or name not in new:
+            continue
+        ys = new[name]
+        m0, m1 = median(xs), median(ys)
+        change = (m1 - m0) / m0 * 100.0 if m0 else 0.0
+        p = mann_whitney_u(xs, ys)
+
+        significant = p is None or p < args.alpha
+        if abs(change) <= args.threshold or not significant:
+            verdict = ""
+        else:
+            verdict = "REGRESSION" if change > 0 else "improvement"
+            if p is None:
+                verdict += " ?"
+        if verdict.startswith("REGRESSION"):
+            regressions += 1
+        rows.append((name, m0, m1, change, p, len(xs), len(ys), verdict))
+
+    width = max([len(r[0]) for r in rows] + [9])
+    print("%-*s %12s %12s %9s %8s %7s  %s" % (width, "benchmark", "baseline", "contender", "change", "p", "n", ""))
+    print("-" * (width + 62))
+    for name, m0, m1, change, p, n0, n1, verdict in rows:
+        print("%-*s %12s %12s %+8.1f%% %8s %3d/%-3d  %s" % (
+            width, name, format_time(m0), format_time(m1), change,
+            "-" if p is None else "%.3f" % p, n0, n1, verdict))
+
+    only_base = [n for n in base if n not in new and args.filter in n]
+    only_new = [n for n in new if n not in base and args.filter in n]
+    if only_base:
+        print("\nonly in baseline:  " + ", ".join(only_base))
+    if only_new:
+        print("only in contender: " + ", ".join(only_new))
+
+    failed = {n: e for n, e in new_errors.items() if args.filter in n}
+    for name, message in failed.items():
+        print("FAILED  %s: %s" % (name, message))
+
+    print("\n%d benchmarks, %d regressions (threshold %.1f%%, alpha %.2f, %s)" % (
+        len(rows), regressions, args.threshold, args.alpha, args.metric))
+    return 1 if regressions or failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
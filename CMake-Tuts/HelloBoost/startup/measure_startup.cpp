@@ -0,0 +1,316 @@
+/*
+
+    -----------------------
+    Startup Benchmark
+    -----------------------
+    Runs each HelloBoost variant (see CMakeLists.txt) many times with
+    "--apples 1 --oranges 2" and prints what its link mode costs at startup
+
+        exec->main      from just before execve() to the first line of main()
+                        (startup_probe.cpp): kernel exec, dynamic loader,
+                        symbol lookup, relocations, static initialisers
+        exec->exit      the whole run, as seen by the parent after wait4()
+        minflt          minor page faults of the child (median)
+        RSS             peak resident set (KiB)
+        size, .text     file size and size of the .text section
+        relocs          entries in the SHT_RELA/REL sections of the binary:
+                        .rela.dyn + .rela.plt (static-pie binaries relocate
+                        themselves, a plain static one has only IRELATIVE)
+        ld.so           one run with LD_DEBUG=statistics: relocations the
+                        loader processed in all objects (symbol / relative)
+                        and its startup time in cycles
+
+    exec->main and exec->exit are percentiles over all runs; the variants
+    are run interleaved, so drift of the machine hits all of them alike.
+
+    Usage:
+        ./StartupBenchmark                      every HelloBoost_* next to this binary
+        ./StartupBenchmark ./HelloBoost_static ./HelloBoost_dynamic
+        ./StartupBenchmark --runs=1000
+
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const char* kArguments[] = { "--apples", "1", "--oranges", "2" };
+
+struct Run
+{
+    bool ok = false;
+    double toMainUs = 0, toExitUs = 0;
+    long minorFaults = 0, maxRssKiB = 0;
+};
+
+struct Variant
+{
+    explicit Variant(fs::path p) : path(std::move(p)) {}
+
+    fs::path path;
+    std::vector<Run> runs;
+
+    // static properties of the file
+    std::uintmax_t fileSize = 0, textSize = 0;
+    std::uint64_t relocations = 0, pltRelocations = 0;
+    bool dynamic = false;
+
+    // LD_DEBUG=statistics, -1: not reported
+    long loaderRelocations = -1, loaderRelative = -1, loaderCycles = -1;
+};
+
+static long long nowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//-----------------------------------------------------
+// ELF: size of .text and the relocation sections
+//-----------------------------------------------------
+static void readElf(Variant& v)
+{
+    v.fileSize = fs::file_size(v.path);
+    std::ifstream in(v.path, std::ios::binary);
+    const std::string image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (image.size() < sizeof(Elf64_Ehdr) || std::memcmp(image.data(), ELFMAG, SELFMAG) != 0 || image[EI_CLASS] != ELFCLASS64)
+        return;
+
+    Elf64_Ehdr header;
+    std::memcpy(&header, image.data(), sizeof header);
+    if (header.e_shoff == 0 || header.e_shoff + header.e_shnum * sizeof(Elf64_Shdr) > image.size())
+        return;
+
+    std::vector<Elf64_Shdr> sections(header.e_shnum);
+    std::memcpy(sections.data(), image.data() + header.e_shoff, header.e_shnum * sizeof(Elf64_Shdr));
+    const char* names = image.data() + sections[header.e_shstrndx].sh_offset;
+
+    for (const Elf64_Shdr& s : sections) {
+        const std::string name = names + s.sh_name;
+        if (name == ".text")
+            v.textSize = s.sh_size;
+        if (s.sh_type == SHT_DYNAMIC)
+            v.dynamic = true;
+        if ((s.sh_type == SHT_RELA || s.sh_type == SHT_REL) && s.sh_entsize) {
+            const std::uint64_t count = s.sh_size / s.sh_entsize;
+            v.relocations += count;
+            if (name == ".rela.plt" || name == ".rel.plt")
+                v.pltRelocations += count;
+        }
+    }
+}
+
+//-----------------------------------------------------
+// Running a variant
+//-----------------------------------------------------
+// fork + exec with stdout on /dev/null; `stderrFd` >= 0 receives stderr
+// the child writes its own t0 to `timing` right before execve(), the probe
+// in main() writes t1 to the same pipe (it is inherited through exec)
+static Run runOnce(const Variant& v, const std::vector<std::string>& extraEnvironment, int stderrFd = -1)
+{
+    int timing[2];
+    if (pipe(timing) != 0)
+        return {};
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(timing[0]);
+        const int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(stderrFd >= 0 ? stderrFd : devNull, STDERR_FILENO);
+
+        std::vector<std::string> environment = extraEnvironment;
+        environment.push_back("ALI_STARTUP_FD=" + std::to_string(timing[1]));
+        std::vector<char*> envp;
+        for (auto& e : environment)
+            envp.push_back(e.data());
+        envp.push_back(nullptr);
+
+        std::string program = v.path.string();
+        std::vector<char*> argv { program.data() };
+        for (const char* a : kArguments)
+            argv.push_back(const_cast<char*>(a));
+        argv.push_back(nullptr);
+
+        dprintf(timing[1], "%lld\n", nowNs());
+        execve(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+    close(timing[1]);
+
+    int status = 0;
+    rusage usage {};
+    wait4(pid, &status, 0, &usage);
+    const long long exited = nowNs();
+
+    std::string text;
+    char buffer[128];
+    for (ssize_t n; (n = read(timing[0], buffer, sizeof buffer)) > 0;)
+        text.append(buffer, n);
+    close(timing[0]);
+
+    long long start = 0, inMain = 0;
+    Run r;
+    r.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && std::sscanf(text.c_str(), "%lld %lld", &start, &inMain) == 2;
+    r.toMainUs = (inMain - start) / 1e3;
+    r.toExitUs = (exited - start) / 1e3;
+    r.minorFaults = usage.ru_minflt;
+    r.maxRssKiB = usage.ru_maxrss;
+    return r;
+}
+
+// "     1234:	                 number of relocations: 117"
+static long statistic(const std::string& report, const std::string& key)
+{
+    const auto at = report.find(key);
+    return at == std::string::npos ? -1 : std::atol(report.c_str() + at + key.size());
+}
+
+static void readLoaderStatistics(Variant& v)
+{
+    FILE* log = std::tmpfile();
+    if (!log)
+        return;
+    runOnce(v, { "LD_DEBUG=statistics" }, fileno(log));
+
+    std::rewind(log);
+    std::string report;
+    char buffer[4096];
+    for (std::size_t n; (n = std::fread(buffer, 1, sizeof buffer, log)) > 0;)
+        report.append(buffer, n);
+    std::fclose(log);
+
+    v.loaderRelocations = statistic(report, "number of relocations:");
+    v.loaderRelative = statistic(report, "number of relative relocations:");
+    v.loaderCycles = statistic(report, "total startup time in dynamic loader:");
+}
+
+//-----------------------------------------------------
+// Report
+//-----------------------------------------------------
+template <typename T, typename F>
+static double percentile(const std::vector<Run>& runs, double p, F field)
+{
+    std::vector<T> values;
+    for (const Run& r : runs)
+        if (r.ok)
+            values.push_back(field(r));
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    return double(values[std::min(values.size() - 1, std::size_t(p * values.size()))]);
+}
+
+static std::string kib(std::uintmax_t bytes)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(bytes < 10 * 1024 ? 1 : 0) << bytes / 1024.0 << "K";
+    return out.str();
+}
+
+static std::string loader(const Variant& v)
+{
+    if (!v.dynamic)
+        return "- (static)";
+    if (v.loaderRelocations < 0)
+        return "-";
+    std::ostringstream out;
+    out << v.loaderRelocations << " / " << v.loaderRelative;
+    if (v.loaderCycles >= 0)
+        out << ", " << v.loaderCycles / 1000 << "k cyc";
+    return out.str();
+}
+
+int main(int argc, char** argv)
+{
+    int runs = 200;
+    std::vector<Variant> variants;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--runs=", 0) == 0) {
+            runs = std::max(1, std::atoi(arg.c_str() + 7));
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "usage: " << argv[0] << " [--runs=<n>] [variant...]\n";
+            return 2;
+        } else {
+            variants.emplace_back(fs::absolute(arg));
+        }
+    }
+    if (variants.empty()) {
+        // every HelloBoost_* next to this binary
+        const fs::path here = fs::read_symlink("/proc/self/exe").parent_path();
+        for (const auto& entry : fs::directory_iterator(here))
+            if (entry.path().filename().string().rfind("HelloBoost_", 0) == 0 && entry.is_regular_file())
+                variants.emplace_back(entry.path());
+        std::sort(variants.begin(), variants.end(), [](const Variant& a, const Variant& b) { return a.path < b.path; });
+    }
+    if (variants.empty()) {
+        std::cerr << "no HelloBoost_* variants found\n";
+        return 1;
+    }
+
+    for (Variant& v : variants) {
+        readElf(v);
+        readLoaderStatistics(v);
+        runOnce(v, {});                         // warm the page cache
+    }
+    for (int i = 0; i < runs; ++i)
+        for (Variant& v : variants)
+            v.runs.push_back(runOnce(v, {}));
+
+    std::cout << runs << " runs of <variant>";
+    for (const char* a : kArguments)
+        std::cout << " " << a;
+    std::cout << "\n\n"
+              << std::left << std::setw(24) << "variant" << std::right
+              << std::setw(14) << "exec->main us" << std::setw(9) << "p90"
+              << std::setw(14) << "exec->exit us" << std::setw(8) << "minflt" << std::setw(8) << "RSS K"
+              << std::setw(9) << "size" << std::setw(9) << ".text" << std::setw(14) << "relocs (plt)"
+              << "   ld.so relocs / relative\n";
+
+    bool failed = false;
+    for (const Variant& v : variants) {
+        const auto ok = std::count_if(v.runs.begin(), v.runs.end(), [](const Run& r) { return r.ok; });
+        std::cout << std::left << std::setw(24) << v.path.filename().string() << std::right;
+        if (ok == 0) {
+            failed = true;
+            std::cout << "  every run failed\n";
+            continue;
+        }
+        std::ostringstream relocs;
+        relocs << v.relocations << " (" << v.pltRelocations << ")";
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(14) << percentile<double>(v.runs, 0.5, [](const Run& r) { return r.toMainUs; })
+                  << std::setw(9) << percentile<double>(v.runs, 0.9, [](const Run& r) { return r.toMainUs; })
+                  << std::setw(14) << percentile<double>(v.runs, 0.5, [](const Run& r) { return r.toExitUs; })
+                  << std::setprecision(0)
+                  << std::setw(8) << percentile<long>(v.runs, 0.5, [](const Run& r) { return r.minorFaults; })
+                  << std::setw(8) << percentile<long>(v.runs, 0.5, [](const Run& r) { return r.maxRssKiB; })
+                  << std::setw(9) << kib(v.fileSize) << std::setw(9) << kib(v.textSize)
+                  << std::setw(14) << relocs.str() << "   " << loader(v) << "\n" << std::defaultfloat;
+        if (ok != long(v.runs.size())) {
+            failed = true;
+            std::cout << "    " << v.runs.size() - ok << " of " << v.runs.size() << " runs failed\n";
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -12,6 +12,8 @@
 #include <limits> // Necessary for std::numeric_limits
 #include <algorithm> // Necessary for std::clamp
 
+#include "latency_histogram.hpp"
+
 
 static std::vector<char> readFile(const std::string& filename) 
 {
@@ -870,11 +872,27 @@ void HelloTriangleApplication::createSyncObjects()
     }
 }
 
+// Frame times go into a histogram; every 5 seconds its percentiles are printed
+// and it starts over. A steady p50 with a p99 far above it is visible jitter.
 void HelloTriangleApplication::mainLoop() 
 {
+    ali::LatencyHistogram frameTimes;
+    const std::uint64_t reportEvery = 5000000000ull;        // ns
+    std::uint64_t lastReport = ali::LatencyClock::monotonicRaw();
+
     while (!glfwWindowShouldClose(m_window)) {
-        glfwPollEvents();
-        drawFrame();
+        {
+            ali::ScopedLatency frameTimer(frameTimes);
+            glfwPollEvents();
+            drawFrame();
+        }
+
+        const std::uint64_t now = ali::LatencyClock::monotonicRaw();
+        if (now - lastReport >= reportEvery) {
+            std::cout << "frame time: " << frameTimes.summary() << std::endl;
+            frameTimes.reset();
+            lastReport = now;
+        }
     }
 }
 
@@ -0,0 +1,290 @@
+/*
+
+    -----------------------
+    Memory Resources
+    -----------------------
+    1.  Size classes: every size up to 4 KiB gets a class at least as big and
+        at most 25% bigger (above 128 bytes).
+    2.  MonotonicArena: alignment, chunk growth, the initial buffer,
+        release().
+    3.  SizeClassPool: a freed block is the next one handed out, big and
+        over-aligned requests go upstream, statistics.
+    4.  ThreadLocalFreeList: 4 threads allocate, 4 others free what they
+        allocated (cross-thread frees), contents stay intact.
+    5.  vector, map, unordered_map and list on every resource, through
+        std::pmr and through ali::ResourceAllocator, give the same result
+        as with std::allocator.
+    6.  Every resource gives all its memory back to upstream.
+
+    Usage:
+        ./main
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_resources.hpp"
+#include "resource_allocator.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+// upstream that counts what is outstanding
+class CountingResource final : public std::pmr::memory_resource
+{
+public:
+    std::atomic<std::int64_t> bytes { 0 }, blocks { 0 };
+
+private:
+    void* do_allocate(std::size_t n, std::size_t alignment) override
+    {
+        bytes += std::int64_t(n);
+        ++blocks;
+        return std::pmr::new_delete_resource()->allocate(n, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t n, std::size_t alignment) override
+    {
+        bytes -= std::int64_t(n);
+        --blocks;
+        std::pmr::new_delete_resource()->deallocate(p, n, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+static bool aligned(const void* p, std::size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkSizeClasses()
+{
+    using C = ali::detail::SizeClasses;
+    bool ok = true;
+    for (std::size_t bytes = 1; bytes <= C::kMaxBytes && ok; ++bytes) {
+        const std::size_t c = C::index(bytes), size = C::size(c);
+        ok = c > 0 && c < C::kCount && size >= bytes && size % C::kAlignment == 0
+          && (bytes <= 128 || double(size) <= 1.25 * double(bytes))
+          && C::index(size) == c;
+    }
+    report(ok, "size classes cover 1 ... 4096 bytes, at most 25% lost");
+}
+
+static void checkArena()
+{
+    CountingResource upstream;
+    {
+        ali::MonotonicArena arena(1024, &upstream);
+        bool ok = true;
+        for (std::size_t alignment : { 1, 2, 8, 16, 64, 256 }) {
+            void* p = arena.allocate(3, alignment);
+            ok = ok && aligned(p, alignment);
+        }
+        report(ok, "arena: alignments 1 ... 256");
+
+        for (int i = 0; i < 1000; ++i)
+            (void)arena.allocate(100, 8);
+        const auto s = arena.stats();
+        report(s.allocations == 1006 && s.bytesInUse == 100018 && upstream.blocks < 10 && s.upstreamBytes == std::uint64_t(upstream.bytes),
+               "arena: 100 KB in " + std::to_string(upstream.blocks) + " chunks (geometric growth)");
+
+        arena.release();
+        report(upstream.bytes == 0 && arena.stats().upstreamBytes == 0, "arena: release() gives everything back");
+
+        alignas(64) std::byte buffer[4096];
+        ali::MonotonicArena onStack(buffer, sizeof buffer, &upstream);
+        void* first = onStack.allocate(1000, 8);
+        (void)onStack.allocate(3000, 8);
+        report(first == buffer && upstream.blocks == 0, "arena: the initial buffer comes first");
+        (void)onStack.allocate(1000, 8);
+        report(upstream.blocks == 1, "arena: then upstream");
+    }
+    report(upstream.bytes == 0, "arena: nothing left upstream");
+}
+
+static void checkPool()
+{
+    CountingResource upstream;
+    {
+        ali::SizeClassPool pool(&upstream);
+        void* a = pool.allocate(40, 8);
+        void* b = pool.allocate(40, 8);
+        pool.deallocate(a, 40, 8);
+        void* c = pool.allocate(33, 8);           // same class (48)
+        report(c == a && b != a, "pool: a freed block is reused by its class");
+
+        const auto chunks = upstream.blocks.load();
+        void* big = pool.allocate(10000, 8);
+        void* overAligned = pool.allocate(64, 64);
+        report(upstream.blocks == chunks + 2 && aligned(overAligned, 64), "pool: big and over-aligned requests go upstream");
+        pool.deallocate(big, 10000, 8);
+        pool.deallocate(overAligned, 64, 64);
+
+        std::vector<std::pair<void*, std::size_t>> blocks;
+        std::mt19937 rng(1);
+        bool ok = true;
+        for (int i = 0; i < 20000; ++i) {
+            const std::size_t n = 1 + rng() % 4096;
+            void* p = pool.allocate(n, 8);
+            ok = ok && aligned(p, 16);
+            std::memset(p, 0xab, n);
+            blocks.emplace_back(p, n);
+        }
+        for (auto [p, n] : blocks)
+            pool.deallocate(p, n, 8);
+        pool.deallocate(b, 40, 8);
+        pool.deallocate(c, 33, 8);
+        const auto s = pool.stats();
+        report(ok && s.allocations == s.deallocations && s.bytesInUse == 0 && s.peakBytesInUse > 20000 * 2000,
+               "pool: 20000 random sizes, stats balance");
+    }
+    report(upstream.bytes == 0, "pool: nothing left upstream");
+}
+
+static void checkThreadLocal()
+{
+    CountingResource upstream;
+    {
+        ali::ThreadLocalFreeList resource(&upstream);
+
+        // producers allocate and fill blocks, consumers check and free them
+        struct Block { unsigned char* p; std::size_t n; };
+        std::mutex mutex;
+        std::queue<Block> queue;
+        std::atomic<int> producing { 4 };
+        std::atomic<bool> corrupt { false };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                for (int i = 0; i < 20000; ++i) {
+                    const std::size_t n = 1 + rng() % 600;
+                    auto* p = static_cast<unsigned char*>(resource.allocate(n, 8));
+                    std::memset(p, int(n & 0xff), n);
+                    if (i % 3 == 0) {                   // freed by the same thread
+                        resource.deallocate(p, n, 8);
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queue.push({ p, n });
+                }
+                --producing;
+            });
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&] {
+                while (true) {
+                    Block b {};
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (queue.empty()) {
+                            if (producing == 0)
+                                return;
+                            continue;
+                        }
+                        b = queue.front();
+                        queue.pop();
+                    }
+                    for (std::size_t i = 0; i < b.n; ++i)
+                        if (b.p[i] != (b.n & 0xff))
+                            corrupt = true;
+                    resource.deallocate(b.p, b.n, 8);
+                }
+            });
+        for (auto& t : threads)
+            t.join();
+
+        const auto s = resource.stats();
+        report(!corrupt && s.allocations == 80000 && s.deallocations == 80000 && s.bytesInUse == 0,
+               "thread-local: 4 threads allocate, 4 free, stats balance");
+
+        // a new thread adopts the cache of an exited one
+        std::thread([&] { resource.deallocate(resource.allocate(24, 8), 24, 8); }).join();
+        report(resource.stats().allocations == 80001, "thread-local: later threads");
+    }
+    report(upstream.bytes == 0, "thread-local: nothing left upstream");
+}
+
+//-----------------------------------------------------
+// Containers
+//-----------------------------------------------------
+// the same work with every allocator; the result must not depend on it
+template <typename Vector, typename Map, typename UnorderedMap, typename List, typename Make>
+static std::string work(Make make)
+{
+    Vector v(make);
+    Map m(make);
+    UnorderedMap u(make);
+    List l(make);
+    std::mt19937 rng(5);
+    for (int i = 0; i < 20000; ++i) {
+        const int k = int(rng() % 5000);
+        v.push_back(k);
+        m[k] += i;
+        u[k] ^= i;
+        l.push_back(k);
+        if (i % 3 == 0) {
+            m.erase(int(rng() % 5000));
+            u.erase(int(rng() % 5000));
+            l.pop_front();
+        }
+    }
+    std::uint64_t h = 0;
+    for (int x : v) h = h * 31 + std::uint64_t(x);
+    for (auto [k, x] : m) h = h * 31 + std::uint64_t(k) * 7 + std::uint64_t(x);
+    std::map<int, int> sorted(u.begin(), u.end());
+    for (auto [k, x] : sorted) h = h * 31 + std::uint64_t(k) * 5 + std::uint64_t(x);
+    for (int x : l) h = h * 31 + std::uint64_t(x);
+    return std::to_string(h);
+}
+
+template <typename Resource>
+static void checkContainers(const std::string& name, const std::string& expected)
+{
+    CountingResource upstream;
+    {
+        Resource resource(&upstream);
+        const std::string viaPmr = work<std::pmr::vector<int>, std::pmr::map<int, int>, std::pmr::unordered_map<int, int>,
+                                        std::pmr::list<int>>(std::pmr::polymorphic_allocator<int>(&resource));
+        const std::string viaAllocator = work<ali::resource_vector<int, Resource>, ali::resource_map<int, int, Resource>,
+                                              ali::resource_unordered_map<int, int, Resource>, ali::resource_list<int, Resource>>(
+                                              ali::ResourceAllocator<int, Resource>(&resource));
+        const auto s = resource.stats();
+        report(viaPmr == expected && viaAllocator == expected && s.allocations == s.deallocations,
+               name + ": vector, map, unordered_map, list (pmr and ResourceAllocator)");
+    }
+    report(upstream.bytes == 0, name + ": nothing left upstream");
+}
+
+int main()
+{
+    checkSizeClasses();
+    checkArena();
+    checkPool();
+    checkThreadLocal();
+
+    const std::string expected = work<std::vector<int>, std::map<int, int>, std::unordered_map<int, int>, std::list<int>>(
+        std::allocator<int>());
+    checkContainers<ali::MonotonicArena>("MonotonicArena", expected);
+    checkContainers<ali::SizeClassPool>("SizeClassPool", expected);
+    checkContainers<ali::ThreadLocalFreeList>("ThreadLocalFreeList", expected);
+
+    return ali::check::finish();
+}
@@ -0,0 +1,571 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+/*
+    -----------------------
+    Memory Resources
+    -----------------------
+    Every container takes an Allocator (std::map<Key, T, Compare,
+    std::allocator<std::pair<const Key, T>>>) and by default that is
+    std::allocator, i.e. operator new / malloc for every node. Three
+    replacements, all std::pmr::memory_resource, so they plug into the
+    std::pmr containers, and usable through ali::ResourceAllocator
+    (resource_allocator.hpp) with the plain std containers:
+
+    MonotonicArena          bump-pointer allocation out of chunks that grow
+                            geometrically; deallocate() does nothing, all
+                            memory is given back at once by release() or the
+                            destructor. The fastest there is, for memory
+                            whose lifetime ends together ("per request").
+                            Not thread-safe.
+
+    SizeClassPool           one free list per size class (16, 32 ... 128,
+                            then 4 classes per power of two up to 4 KiB):
+                            a freed block is reused by the next allocation
+                            of its class. Blocks are carved out of chunks
+                            from upstream, which are given back in release()
+                            / the destructor. Bigger or over-aligned requests
+                            go straight to upstream. Not thread-safe.
+
+    ThreadLocalFreeList     the size classes of SizeClassPool, but every
+                            thread has its own free lists, so allocate() and
+                            deallocate() take no lock. Lists that grow too
+                            long give a batch back to a shared list (one
+                            mutex), empty lists refill from it. A thread may
+                            free a block another thread allocated. Caches of
+                            exited threads are adopted by new ones.
+                            Thread-safe.
+
+    Statistics (stats()) for all three:
+
+        allocations, deallocations      calls
+        bytesRequested                  sum of the sizes asked for
+        bytesInUse, peakBytesInUse      allocated and not yet freed (peak:
+                                        not tracked by ThreadLocalFreeList)
+        upstreamBytes                   obtained from upstream and not yet
+                                        given back: the real footprint
+
+    Like std::pmr::monotonic_buffer_resource / unsynchronized_pool_resource,
+    do_is_equal() is identity: memory must go back to the resource it came
+    from.
+*/
+
+namespace ali {
+
+struct ResourceStats
+{
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytesRequested = 0;
+    std::uint64_t bytesInUse = 0;
+    std::uint64_t peakBytesInUse = 0;
+    std::uint64_t upstreamBytes = 0;
+};
+
+namespace detail {
+
+// single-threaded bookkeeping of MonotonicArena and SizeClassPool
+struct StatsCounter
+{
+    ResourceStats s;
+
+    void allocated(std::size_t bytes) noexcept
+    {
+        ++s.allocations;
+        s.bytesRequested += bytes;
+        s.bytesInUse += bytes;
+        s.peakBytesInUse = std::max(s.peakBytesInUse, s.bytesInUse);
+    }
+
+    void deallocated(std::size_t bytes) noexcept
+    {
+        ++s.deallocations;
+        s.bytesInUse -= bytes;
+    }
+};
+
+//-----------------------------------------------------
+// Size classes
+//-----------------------------------------------------
+// 16, 32, ... 128: every 16 bytes; then 4 classes per power of two:
+// 160, 192, 224, 256, 320, 384, 448, 512, ... 4096. At most 25% lost.
+struct SizeClasses
+{
+    static constexpr std::size_t kMaxBytes = 4096;
+    static constexpr std::size_t kAlignment = 16;          // every class is a multiple of it
+    static constexpr std::size_t kCount = 29;              // index 0 is unused
+
+    static constexpr std::size_t index(std::size_t bytes) noexcept
+    {
+        if (bytes <= 128)
+            return bytes == 0 ? 1 : (bytes + 15) >> 4;
+        const std::size_t p = std::size_t(std::bit_width(bytes - 1));   // 2^(p-1) < bytes <= 2^p
+        const std::size_t step = std::size_t(1) << (p - 3);
+        const std::size_t sub = (bytes - (std::size_t(1) << (p - 1)) + step - 1) / step;
+        return 8 + (p - 8) * 4 + sub;
+    }
+
+    static constexpr std::size_t size(std::size_t index) noexcept
+    {
+        if (index <= 8)
+            return index * 16;
+        const std::size_t p = (index - 9) / 4 + 8, sub = (index - 9) % 4 + 1;
+        return (std::size_t(1) << (p - 1)) + sub * (std::size_t(1) << (p - 3));
+    }
+
+    static constexpr bool pooled(std::size_t bytes, std::size_t alignment) noexcept
+    {
+        return bytes <= kMaxBytes && alignment <= kAlignment;
+    }
+};
+
+static_assert(SizeClasses::index(4096) == SizeClasses::kCount - 1 && SizeClasses::size(SizeClasses::kCount - 1) == 4096);
+static_assert(SizeClasses::size(SizeClasses::index(129)) == 160 && SizeClasses::size(SizeClasses::index(300)) == 320);
+
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+// chunks obtained from upstream, given back all at once
+class ChunkList
+{
+public:
+    explicit ChunkList(std::pmr::memory_resource* upstream) noexcept : upstream_(upstream) {}
+    ~ChunkList() { release(); }
+
+    ChunkList(const ChunkList&) = delete;
+    ChunkList& operator=(const ChunkList&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        chunks_.reserve(chunks_.size() + 1);           // no leak if push_back would throw
+        void* p = upstream_->allocate(bytes, alignment);
+        chunks_.push_back({ p, bytes, alignment });
+        bytes_ += bytes;
+        return p;
+    }
+
+    void release() noexcept
+    {
+        for (const Chunk& c : chunks_)
+            upstream_->deallocate(c.p, c.bytes, c.alignment);
+        chunks_.clear();
+        bytes_ = 0;
+    }
+
+    std::size_t bytes() const noexcept { return bytes_; }
+    std::pmr::memory_resource* upstream() const noexcept { return upstream_; }
+
+private:
+    struct Chunk { void* p; std::size_t bytes, alignment; };
+
+    std::pmr::memory_resource*  upstream_;
+    std::vector<Chunk>          chunks_;
+    std::size_t                 bytes_ = 0;
+};
+
+} // namespace detail
+
+//-----------------------------------------------------
+// MonotonicArena
+//-----------------------------------------------------
+class MonotonicArena final : public std::pmr::memory_resource
+{
+public:
+    explicit MonotonicArena(std::size_t firstChunk = 4096,
+                            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+        : chunks_(upstream), nextChunk_(std::max<std::size_t>(firstChunk, 64))
+    {
+    }
+
+    explicit MonotonicArena(std::pmr::memory_resource* upstream) noexcept : MonotonicArena(4096, upstream) {}
+
+    // starts with `buffer` (e.g. on the stack), goes upstream when it is full
+    MonotonicArena(void* buffer, std::size_t size,
+                   std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+        : chunks_(upstream), initial_(static_cast<std::byte*>(buffer)), initialSize_(size),
+          current_(initial_), end_(initial_ + size), nextChunk_(std::max<std::size_t>(size, 64) * 2)
+    {
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // everything allocated so far is gone; the initial buffer is used again
+    void release() noexcept
+    {
+        chunks_.release();
+        current_ = initial_;
+        end_ = initial_ + initialSize_;
+        stats_ = {};
+    }
+
+    ResourceStats stats() const noexcept
+    {
+        ResourceStats s = stats_.s;
+        s.upstreamBytes = chunks_.bytes();
+        return s;
+    }
+
+    std::pmr::memory_resource* upstream() const noexcept { return chunks_.upstream(); }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        std::byte* p = alignUp(current_, alignment);
+        if (!current_ || p + bytes > end_) {
+            // a new chunk, at least twice as big as the last one
+            const std::size_t size = std::max(nextChunk_, bytes + alignment);
+            current_ = static_cast<std::byte*>(chunks_.allocate(size, alignof(std::max_align_t)));
+            end_ = current_ + size;
+            nextChunk_ = size * 2;
+            p = alignUp(current_, alignment);
+        }
+        current_ = p + bytes;
+        stats_.allocated(bytes);
+        return p;
+    }
+
+    void do_deallocate(void*, std::size_t bytes, std::size_t) override
+    {
+        stats_.deallocated(bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    static std::byte* alignUp(std::byte* p, std::size_t alignment) noexcept
+    {
+        const auto address = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((alignment - address % alignment) % alignment);
+    }
+
+    detail::ChunkList   chunks_;
+    std::byte*          initial_ = nullptr;
+    std::size_t         initialSize_ = 0;
+    std::byte*          current_ = nullptr;
+    std::byte*          end_ = nullptr;
+    std::size_t         nextChunk_;
+    detail::StatsCounter stats_;
+};
+
+//-----------------------------------------------------
+// SizeClassPool
+//-----------------------------------------------------
+class SizeClassPool final : public std::pmr::memory_resource
+{
+    using Classes = detail::SizeClasses;
+
+public:
+    explicit SizeClassPool(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+        : chunks_(upstream)
+    {
+    }
+
+    ~SizeClassPool() override { release(); }
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    // gives all chunks back; blocks not yet deallocated are gone too
+    void release() noexcept
+    {
+        chunks_.release();
+        for (auto& b : bins_)
+            b = Bin {};
+        stats_ = {};
+        largeBytes_ = 0;
+    }
+
+    ResourceStats stats() const noexcept
+    {
+        ResourceStats s = stats_.s;
+        s.upstreamBytes = chunks_.bytes() + largeBytes_;
+        return s;
+    }
+
+    std::pmr::memory_resource* upstream() const noexcept { return chunks_.upstream(); }
+
+private:
+    struct Bin
+    {
+        detail::FreeBlock*  free = nullptr;
+        std::size_t         nextBlocks = 8;         // blocks in the next chunk, doubles up to 64 KiB chunks
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        stats_.allocated(bytes);
+        if (!Classes::pooled(bytes, alignment)) {
+            largeBytes_ += bytes;
+            return chunks_.upstream()->allocate(bytes, alignment);
+        }
+        Bin& bin = bins_[Classes::index(bytes)];
+        if (!bin.free)
+            refill(bin, Classes::size(Classes::index(bytes)));
+        detail::FreeBlock* block = bin.free;
+        bin.free = block->next;
+        return block;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        stats_.deallocated(bytes);
+        if (!Classes::pooled(bytes, alignment)) {
+            largeBytes_ -= bytes;
+            chunks_.upstream()->deallocate(p, bytes, alignment);
+            return;
+        }
+        Bin& bin = bins_[Classes::index(bytes)];
+        bin.free = ::new (p) detail::FreeBlock { bin.free };
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void refill(Bin& bin, std::size_t blockSize)
+    {
+        const std::size_t count = bin.nextBlocks;
+        auto* chunk = static_cast<std::byte*>(chunks_.allocate(count * blockSize, Classes::kAlignment));
+        for (std::size_t i = count; i-- > 0;)
+            bin.free = ::new (chunk + i * blockSize) detail::FreeBlock { bin.free };
+        bin.nextBlocks = std::min(count * 2, std::max<std::size_t>(65536 / blockSize, 8));
+    }
+
+    detail::ChunkList                       chunks_;
+    std::array<Bin, Classes::kCount>        bins_ {};
+    std::size_t                             largeBytes_ = 0;
+    detail::StatsCounter                    stats_;
+};
+
+//-----------------------------------------------------
+// ThreadLocalFreeList
+//-----------------------------------------------------
+class ThreadLocalFreeList final : public std::pmr::memory_resource
+{
+    using Classes = detail::SizeClasses;
+
+public:
+    // a thread keeps at most 2 * batch free blocks per class
+    static constexpr std::size_t kBatch = 32;
+
+    explicit ThreadLocalFreeList(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : id_(nextId().fetch_add(1, std::memory_order_relaxed)), chunks_(upstream)
+    {
+    }
+
+    // the threads drop their caches of this resource on their next lookup
+    ~ThreadLocalFreeList() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& cache : caches_)
+            cache->retired.store(true, std::memory_order_release);
+    }
+
+    ThreadLocalFreeList(const ThreadLocalFreeList&) = delete;
+    ThreadLocalFreeList& operator=(const ThreadLocalFreeList&) = delete;
+
+    // sum over all threads; a consistent snapshot only when no thread allocates
+    ResourceStats stats() const
+    {
+        ResourceStats s;
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::int64_t inUse = 0;
+        for (const auto& cache : caches_) {
+            s.allocations += cache->allocations.load(std::memory_order_relaxed);
+            s.deallocations += cache->deallocations.load(std::memory_order_relaxed);
+            s.bytesRequested += cache->bytesRequested.load(std::memory_order_relaxed);
+            inUse += cache->bytesInUse.load(std::memory_order_relaxed);
+        }
+        s.bytesInUse = std::uint64_t(std::max<std::int64_t>(inUse, 0));
+        s.upstreamBytes = chunks_.bytes() + largeBytes_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    std::pmr::memory_resource* upstream() const noexcept { return chunks_.upstream(); }
+
+private:
+    // one per thread; written by its thread only (relaxed load + store),
+    // read by stats()
+    struct Cache
+    {
+        std::array<detail::FreeBlock*, Classes::kCount>   free {};
+        std::array<std::size_t, Classes::kCount>          length {};
+
+        std::atomic<std::uint64_t>  allocations { 0 }, deallocations { 0 }, bytesRequested { 0 };
+        std::atomic<std::int64_t>   bytesInUse { 0 };      // may go negative: freed by another thread
+        std::atomic<bool>           orphaned { false };    // its thread has exited
+        std::atomic<bool>           retired { false };     // its resource is gone
+
+        template <typename T, typename U>
+        static void add(std::atomic<T>& counter, U value) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + T(value), std::memory_order_relaxed);
+        }
+    };
+
+    // the caches of the calling thread, one per resource; on thread exit
+    // they are marked orphaned for the next thread to adopt
+    struct ThreadCaches
+    {
+        std::vector<std::pair<std::uint64_t, std::shared_ptr<Cache>>> entries;
+
+        ~ThreadCaches()
+        {
+            for (auto& entry : entries)
+                entry.second->orphaned.store(true, std::memory_order_release);
+        }
+    };
+
+    static std::atomic<std::uint64_t>& nextId()
+    {
+        static std::atomic<std::uint64_t> id { 1 };
+        return id;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        Cache& cache = local();
+        Cache::add(cache.allocations, 1);
+        Cache::add(cache.bytesRequested, bytes);
+        Cache::add(cache.bytesInUse, bytes);
+        if (!Classes::pooled(bytes, alignment)) {
+            largeBytes_.fetch_add(bytes, std::memory_order_relaxed);
+            return chunks_.upstream()->allocate(bytes, alignment);
+        }
+        const std::size_t c = Classes::index(bytes);
+        if (!cache.free[c])
+            refill(cache, c);
+        detail::FreeBlock* block = cache.free[c];
+        cache.free[c] = block->next;
+        --cache.length[c];
+        return block;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        Cache& cache = local();
+        Cache::add(cache.deallocations, 1);
+        Cache::add(cache.bytesInUse, -std::int64_t(bytes));
+        if (!Classes::pooled(bytes, alignment)) {
+            largeBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+            chunks_.upstream()->deallocate(p, bytes, alignment);
+            return;
+        }
+        const std::size_t c = Classes::index(bytes);
+        cache.free[c] = ::new (p) detail::FreeBlock { cache.free[c] };
+        if (++cache.length[c] > 2 * kBatch)
+            flush(cache, c);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    Cache& local()
+    {
+        thread_local ThreadCaches mine;
+        auto& entries = mine.entries;
+        if (!entries.empty() && entries.back().first == id_)
+            return *entries.back().second;
+        std::erase_if(entries, [](const auto& entry) { return entry.second->retired.load(std::memory_order_acquire); });
+        for (auto& entry : entries)
+            if (entry.first == id_) {
+                std::swap(entry, entries.back());      // most recently used last
+                return *entries.back().second;
+            }
+
+        std::shared_ptr<Cache> cache;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& c : caches_) {
+                bool orphaned = true;
+                if (c->orphaned.compare_exchange_strong(orphaned, false, std::memory_order_acquire)) {
+                    cache = c;
+                    break;
+                }
+            }
+            if (!cache)
+                cache = caches_.emplace_back(std::make_shared<Cache>());
+        }
+        entries.emplace_back(id_, cache);
+        return *cache;
+    }
+
+    // up to kBatch blocks from the shared list, or a new chunk
+    void refill(Cache& cache, std::size_t c)
+    {
+        const std::size_t blockSize = Classes::size(c);
+        std::lock_guard<std::mutex> lock(mutex_);
+        Shared& shared = shared_[c];
+        if (shared.free) {
+            std::size_t n = 0;
+            detail::FreeBlock* last = shared.free;
+            while (++n < kBatch && last->next)
+                last = last->next;
+            cache.free[c] = shared.free;
+            shared.free = last->next;
+            last->next = nullptr;
+            cache.length[c] = n;
+            return;
+        }
+        // a chunk twice as big as the last one of this class (up to 64 KiB):
+        // the first kBatch blocks for the cache, the rest for the shared list
+        const std::size_t count = shared.nextBlocks;
+        shared.nextBlocks = std::min(count * 2, std::max(65536 / blockSize, kBatch));
+        auto* chunk = static_cast<std::byte*>(chunks_.allocate(count * blockSize, Classes::kAlignment));
+        for (std::size_t i = count; i-- > kBatch;)
+            shared.free = ::new (chunk + i * blockSize) detail::FreeBlock { shared.free };
+        for (std::size_t i = kBatch; i-- > 0;)
+            cache.free[c] = ::new (chunk + i * blockSize) detail::FreeBlock { cache.free[c] };
+        cache.length[c] = kBatch;
+    }
+
+    // kBatch blocks back to the shared list
+    void flush(Cache& cache, std::size_t c)
+    {
+        detail::FreeBlock* first = cache.free[c];
+        detail::FreeBlock* last = first;
+        for (std::size_t n = 1; n < kBatch; ++n)
+            last = last->next;
+        cache.free[c] = last->next;
+        cache.length[c] -= kBatch;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        last->next = shared_[c].free;
+        shared_[c].free = first;
+    }
+
+    struct Shared
+    {
+        detail::FreeBlock*  free = nullptr;
+        std::size_t         nextBlocks = kBatch;    // blocks in the next chunk
+    };
+
+    const std::uint64_t                     id_;
+    mutable std::mutex                      mutex_;             // caches_, shared_, chunks_
+    detail::ChunkList                       chunks_;
+    std::array<Shared, Classes::kCount>     shared_ {};
+    std::vector<std::shared_ptr<Cache>>     caches_;
+    std::atomic<std::size_t>                largeBytes_ { 0 };
+};
+
+} // namespace ali
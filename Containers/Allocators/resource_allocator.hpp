@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "memory_resources.hpp"
+
+/*
+    -----------------------
+    Resource Allocator
+    -----------------------
+    The std-style allocator over a memory resource, for the plain std
+    containers:
+
+        ali::SizeClassPool pool;
+        std::map<int, int, std::less<int>, ali::ResourceAllocator<std::pair<const int, int>, ali::SizeClassPool>>
+            m(ali::ResourceAllocator<std::pair<const int, int>, ali::SizeClassPool>(&pool));
+
+    or shorter with the aliases below:
+
+        ali::resource_map<int, int, ali::SizeClassPool> m(&pool);
+
+    The difference to std::pmr::polymorphic_allocator is the Resource
+    parameter: with a concrete (final) resource the compiler sees through
+    allocate() and calls do_allocate() directly, no virtual call; with
+    Resource = std::pmr::memory_resource it is polymorphic_allocator.
+
+    Unlike polymorphic_allocator it propagates on move assignment and swap,
+    so moving a container between two resources steals the nodes instead of
+    copying them; copies of a container use the same resource.
+*/
+
+namespace ali {
+
+template <typename T, typename Resource = std::pmr::memory_resource>
+class ResourceAllocator
+{
+    static_assert(std::is_base_of_v<std::pmr::memory_resource, Resource>);
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+    using is_always_equal                        = std::false_type;
+
+    ResourceAllocator(Resource* resource) noexcept : resource_(resource) {}
+
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U, Resource>& other) noexcept : resource_(other.resource()) {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n > std::size_t(-1) / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    Resource* resource() const noexcept { return resource_; }
+
+    template <typename U>
+    bool operator==(const ResourceAllocator<U, Resource>& other) const noexcept
+    {
+        return resource_ == other.resource() || resource_->is_equal(*other.resource());
+    }
+
+private:
+    Resource* resource_;
+};
+
+//-----------------------------------------------------
+// Containers on a resource
+//-----------------------------------------------------
+template <typename T, typename Resource>
+using resource_vector = std::vector<T, ResourceAllocator<T, Resource>>;
+
+template <typename Key, typename T, typename Resource, typename Compare = std::less<Key>>
+using resource_map = std::map<Key, T, Compare, ResourceAllocator<std::pair<const Key, T>, Resource>>;
+
+template <typename Key, typename T, typename Resource, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+using resource_unordered_map = std::unordered_map<Key, T, Hash, KeyEqual, ResourceAllocator<std::pair<const Key, T>, Resource>>;
+
+template <typename T, typename Resource>
+using resource_list = std::list<T, ResourceAllocator<T, Resource>>;
+
+} // namespace ali
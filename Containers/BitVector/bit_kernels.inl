@@ -0,0 +1,53 @@
+// Word kernels of bit_vector, written once against pop() (popcount of one
+// word) and compiled once per instruction set by bit_vector.hpp:
+//
+//     namespace scalar {                          pop() = SWAR      #include this file }
+//     #pragma GCC target("popcnt")   namespace popcnt { pop() = popcnt  #include this file }
+//     #pragma GCC target("avx2")     namespace avx2   { pop() = popcnt  #include this file }
+//
+// Under the avx2 target the compiler vectorises the logical loops with
+// 256-bit registers; the AVX2 popcount has its own kernel in bit_vector.hpp.
+//
+// No include guard on purpose.
+
+inline std::size_t popcount(const std::uint64_t* w, std::size_t n)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        count += std::size_t(pop(w[i]));
+    return count;
+}
+
+// popcount(a & b) without writing a & b anywhere
+inline std::size_t countAnd(const std::uint64_t* a, const std::uint64_t* b, std::size_t n)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        count += std::size_t(pop(a[i] & b[i]));
+    return count;
+}
+
+// dst may be src
+inline void andWords(std::uint64_t* dst, const std::uint64_t* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] &= src[i];
+}
+
+inline void orWords(std::uint64_t* dst, const std::uint64_t* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] |= src[i];
+}
+
+inline void xorWords(std::uint64_t* dst, const std::uint64_t* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] ^= src[i];
+}
+
+inline void andNotWords(std::uint64_t* dst, const std::uint64_t* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] &= ~src[i];
+}
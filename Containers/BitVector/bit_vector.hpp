@@ -0,0 +1,571 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ALI_BITOPS_X86 1
+#endif
+
+/*
+    -----------------------
+    Bit Vector
+    -----------------------
+    Containers/Vector/main.cpp says to avoid std::vector<bool>: it packs the
+    bits, but only hands them out one at a time through proxy objects, with
+    no way to get at the words. Counting the ones of 100 million rows, or
+    intersecting two filters, then goes bit by bit.
+
+    bit_vector stores the bits in 64-bit words and works on whole words:
+
+        ali::bit_vector a(n), b(n);
+        a.set(17);
+        a &= b;                     // and / or / xor / and_not: 64 rows per
+        a.count();                  //   instruction, 256 with AVX2
+        ali::count_and(a, b);       // |a & b| without building a & b
+        a.for_each_set([](std::size_t row) { ... });
+
+    -   Bulk kernels (count, count_and, &=, |=, ^=, and_not) exist three
+        times: portable, with the POPCNT instruction and with AVX2 (the
+        popcount is Mula's nibble lookup with vpshufb + vpsadbw, 256 bits
+        per step). They are compiled with "#pragma GCC target" and picked
+        once at run time from what the CPU reports, like
+        Arithmetic/saturating.hpp.
+
+    -   Iteration over the set bits jumps from one to the next with
+        count-trailing-zeros (tzcnt/bsf) and clears it with w & (w - 1):
+        the cost is per set bit, not per bit, so a sparse filter over 100
+        million rows is walked in microseconds.
+
+    -   There are no proxy references: test(i), set(i), reset(i), flip(i)
+        say what they do. Binary operations need equal sizes.
+
+    Single-word helpers (popcount64, select_in_word) use POPCNT/PDEP when
+    the whole program is compiled for them (-mpopcnt -mbmi2, or
+    -march=native) and portable broadword code otherwise.
+
+    For rank/select over a bit_vector see rank_select.hpp.
+*/
+
+namespace ali {
+
+namespace bitops {
+
+//-----------------------------------------------------
+// Single words
+//-----------------------------------------------------
+inline int popcount64(std::uint64_t w) noexcept
+{
+#ifdef __POPCNT__
+    return __builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ull);
+    w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+    w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return int((w * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// index of the lowest set bit, w != 0 (tzcnt, or bsf: same result then)
+inline int lowest_bit(std::uint64_t w) noexcept
+{
+    return __builtin_ctzll(w);
+}
+
+// index of the k-th (from 0) set bit of w, k < popcount64(w)
+inline int select_in_word(std::uint64_t w, unsigned k) noexcept
+{
+#if defined(__BMI2__) && defined(ALI_BITOPS_X86)
+    return __builtin_ctzll(_pdep_u64(std::uint64_t(1) << k, w));
+#else
+    // byte b of `sums` = number of ones in bytes 0 ... b
+    std::uint64_t s = w - ((w >> 1) & 0x5555555555555555ull);
+    s = (s & 0x3333333333333333ull) + ((s >> 2) & 0x3333333333333333ull);
+    s = (s + (s >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    const std::uint64_t sums = s * 0x0101010101010101ull;
+    unsigned byte = 0;
+    while (((sums >> (8 * byte)) & 0xff) <= k)
+        ++byte;
+    if (byte > 0)
+        k -= unsigned((sums >> (8 * (byte - 1))) & 0xff);
+    std::uint64_t bits = (w >> (8 * byte)) & 0xff;
+    for (; k > 0; --k)
+        bits &= bits - 1;
+    return int(8 * byte) + __builtin_ctzll(bits);
+#endif
+}
+
+//-----------------------------------------------------
+// Bulk kernels, one set per instruction set
+//-----------------------------------------------------
+enum class Isa { Scalar, Popcnt, AVX2 };
+
+inline const char* name(Isa isa)
+{
+    switch (isa) {
+        case Isa::AVX2:   return "avx2";
+        case Isa::Popcnt: return "popcnt";
+        default:          return "scalar";
+    }
+}
+
+inline bool supported(Isa isa)
+{
+#ifdef ALI_BITOPS_X86
+    __builtin_cpu_init();
+    switch (isa) {
+        case Isa::AVX2:   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+        case Isa::Popcnt: return __builtin_cpu_supports("popcnt");
+        default:          return true;
+    }
+#else
+    return isa == Isa::Scalar;
+#endif
+}
+
+// The fastest instruction set this CPU supports.
+inline Isa detectIsa()
+{
+    if (supported(Isa::AVX2))   return Isa::AVX2;
+    if (supported(Isa::Popcnt)) return Isa::Popcnt;
+    return Isa::Scalar;
+}
+
+namespace scalar {
+
+inline int pop(std::uint64_t w) { return popcount64(w); }
+
+#include "bit_kernels.inl"
+
+} // namespace scalar
+
+#ifdef ALI_BITOPS_X86
+
+//-----------------------------------------------------
+// POPCNT: one word per instruction
+//-----------------------------------------------------
+#pragma GCC push_options
+#pragma GCC target("popcnt")
+namespace popcnt {
+
+inline int pop(std::uint64_t w) { return __builtin_popcountll(w); }
+
+#include "bit_kernels.inl"
+
+} // namespace popcnt
+#pragma GCC pop_options
+
+//-----------------------------------------------------
+// AVX2: 256 bits per instruction
+//-----------------------------------------------------
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt")
+namespace avx2 {
+
+inline int pop(std::uint64_t w) { return __builtin_popcountll(w); }
+
+#include "bit_kernels.inl"
+
+// number of ones in every byte: two 4-bit table lookups with vpshufb
+inline __m256i popcountBytes(__m256i v)
+{
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(v, low);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(table, lo), _mm256_shuffle_epi8(table, hi));
+}
+
+inline std::size_t hsum64(__m256i v)
+{
+    const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return std::size_t(_mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1));
+}
+
+inline __m256i load(const std::uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+// Load(i) gives 4 words; 4 of them per step keep the byte counts <= 32,
+// then vpsadbw adds the bytes up into 4 64-bit lanes
+template <typename Load>
+inline std::size_t popcountBlocks(std::size_t n, Load load4)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i total = zero;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i bytes = popcountBytes(load4(i));
+        bytes = _mm256_add_epi8(bytes, popcountBytes(load4(i + 4)));
+        bytes = _mm256_add_epi8(bytes, popcountBytes(load4(i + 8)));
+        bytes = _mm256_add_epi8(bytes, popcountBytes(load4(i + 12)));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(bytes, zero));
+    }
+    for (; i + 4 <= n; i += 4)
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(popcountBytes(load4(i)), zero));
+    return hsum64(total);
+}
+
+inline std::size_t popcountVec(const std::uint64_t* w, std::size_t n)
+{
+    const std::size_t head = n & ~std::size_t(3);
+    return popcountBlocks(head, [w](std::size_t i) { return load(w + i); }) + popcount(w + head, n - head);
+}
+
+inline std::size_t countAndVec(const std::uint64_t* a, const std::uint64_t* b, std::size_t n)
+{
+    const std::size_t head = n & ~std::size_t(3);
+    return popcountBlocks(head, [a, b](std::size_t i) { return _mm256_and_si256(load(a + i), load(b + i)); })
+         + countAnd(a + head, b + head, n - head);
+}
+
+} // namespace avx2
+#pragma GCC pop_options
+
+#endif // ALI_BITOPS_X86
+
+//-----------------------------------------------------
+// Runtime dispatch
+//-----------------------------------------------------
+struct Kernels
+{
+    std::size_t (*popcount)(const std::uint64_t*, std::size_t);
+    std::size_t (*countAnd)(const std::uint64_t*, const std::uint64_t*, std::size_t);
+    void (*andWords)(std::uint64_t*, const std::uint64_t*, std::size_t);
+    void (*orWords)(std::uint64_t*, const std::uint64_t*, std::size_t);
+    void (*xorWords)(std::uint64_t*, const std::uint64_t*, std::size_t);
+    void (*andNotWords)(std::uint64_t*, const std::uint64_t*, std::size_t);
+};
+
+// Kernels for the given instruction set, which the CPU must support.
+inline Kernels kernelsFor(Isa isa)
+{
+#ifdef ALI_BITOPS_X86
+    if (isa == Isa::AVX2)
+        return Kernels{ avx2::popcountVec, avx2::countAndVec, avx2::andWords, avx2::orWords, avx2::xorWords, avx2::andNotWords };
+    if (isa == Isa::Popcnt)
+        return Kernels{ popcnt::popcount, popcnt::countAnd, popcnt::andWords, popcnt::orWords, popcnt::xorWords, popcnt::andNotWords };
+#endif
+    (void)isa;
+    return Kernels{ scalar::popcount, scalar::countAnd, scalar::andWords, scalar::orWords, scalar::xorWords, scalar::andNotWords };
+}
+
+// Set up on first use. Not thread-safe against concurrent use of the kernels:
+// call setIsa() (e.g. to compare instruction sets) before starting threads.
+inline Isa& activeIsaRef()
+{
+    static Isa isa = detectIsa();
+    return isa;
+}
+
+inline Kernels& activeKernels()
+{
+    static Kernels k = kernelsFor(activeIsaRef());
+    return k;
+}
+
+inline Isa activeIsa() { return activeIsaRef(); }
+
+inline void setIsa(Isa isa)
+{
+    assert(supported(isa));
+    activeIsaRef() = isa;
+    activeKernels() = kernelsFor(isa);
+}
+
+} // namespace bitops
+
+//-----------------------------------------------------
+// bit_vector
+//-----------------------------------------------------
+class bit_vector
+{
+public:
+    using word_type = std::uint64_t;
+    using size_type = std::size_t;
+
+    static constexpr size_type kWordBits = 64;
+    static constexpr size_type npos = size_type(-1);
+
+    bit_vector() = default;
+
+    explicit bit_vector(size_type count, bool value = false)
+        : words_(wordsFor(count), value ? ~word_type(0) : 0), size_(count)
+    {
+        trim();
+    }
+
+    //-----------------------------------------------------
+    // bits
+    //-----------------------------------------------------
+    bool test(size_type i) const noexcept
+    {
+        assert(i < size_);
+        return (words_[i / kWordBits] >> (i % kWordBits)) & 1;
+    }
+
+    bool operator[](size_type i) const noexcept { return test(i); }
+
+    void set(size_type i) noexcept
+    {
+        assert(i < size_);
+        words_[i / kWordBits] |= bit(i);
+    }
+
+    void set(size_type i, bool value) noexcept
+    {
+        assert(i < size_);
+        word_type& w = words_[i / kWordBits];
+        w = (w & ~bit(i)) | (word_type(value) << (i % kWordBits));
+    }
+
+    void reset(size_type i) noexcept
+    {
+        assert(i < size_);
+        words_[i / kWordBits] &= ~bit(i);
+    }
+
+    void flip(size_type i) noexcept
+    {
+        assert(i < size_);
+        words_[i / kWordBits] ^= bit(i);
+    }
+
+    // all bits at once
+    void set() noexcept   { std::fill(words_.begin(), words_.end(), ~word_type(0)); trim(); }
+    void reset() noexcept { std::fill(words_.begin(), words_.end(), word_type(0)); }
+    void flip() noexcept
+    {
+        for (auto& w : words_)
+            w = ~w;
+        trim();
+    }
+
+    //-----------------------------------------------------
+    // size
+    //-----------------------------------------------------
+    size_type size()  const noexcept { return size_; }
+    bool      empty() const noexcept { return size_ == 0; }
+
+    void push_back(bool value)
+    {
+        if (size_ % kWordBits == 0)
+            words_.push_back(0);
+        ++size_;
+        set(size_ - 1, value);
+    }
+
+    void resize(size_type count, bool value = false)
+    {
+        const size_type old = size_;
+        words_.resize(wordsFor(count), value ? ~word_type(0) : 0);
+        size_ = count;
+        if (value && count > old && old % kWordBits != 0)      // the rest of the old last word
+            words_[old / kWordBits] |= ~word_type(0) << (old % kWordBits);
+        trim();
+    }
+
+    void clear() noexcept
+    {
+        words_.clear();
+        size_ = 0;
+    }
+
+    void reserve(size_type count) { words_.reserve(wordsFor(count)); }
+
+    // the words; bits beyond size() in the last one are always 0
+    std::span<const word_type> words() const noexcept { return words_; }
+    std::span<word_type>       words()       noexcept { return words_; }
+
+    //-----------------------------------------------------
+    // counting
+    //-----------------------------------------------------
+    size_type count() const { return bitops::activeKernels().popcount(words_.data(), words_.size()); }
+
+    bool any() const noexcept
+    {
+        for (word_type w : words_)
+            if (w)
+                return true;
+        return false;
+    }
+
+    bool none() const noexcept { return !any(); }
+
+    //-----------------------------------------------------
+    // word-wise operations (equal sizes)
+    //-----------------------------------------------------
+    bit_vector& operator&=(const bit_vector& other)
+    {
+        assert(size_ == other.size_);
+        bitops::activeKernels().andWords(words_.data(), other.words_.data(), words_.size());
+        return *this;
+    }
+
+    bit_vector& operator|=(const bit_vector& other)
+    {
+        assert(size_ == other.size_);
+        bitops::activeKernels().orWords(words_.data(), other.words_.data(), words_.size());
+        return *this;
+    }
+
+    bit_vector& operator^=(const bit_vector& other)
+    {
+        assert(size_ == other.size_);
+        bitops::activeKernels().xorWords(words_.data(), other.words_.data(), words_.size());
+        return *this;
+    }
+
+    // *this &= ~other, without building ~other
+    bit_vector& and_not(const bit_vector& other)
+    {
+        assert(size_ == other.size_);
+        bitops::activeKernels().andNotWords(words_.data(), other.words_.data(), words_.size());
+        return *this;
+    }
+
+    //-----------------------------------------------------
+    // set bits
+    //-----------------------------------------------------
+    // first set bit at or after `from`, npos if there is none
+    size_type find_next(size_type from) const noexcept
+    {
+        if (from >= size_)
+            return npos;
+        size_type index = from / kWordBits;
+        word_type w = words_[index] & (~word_type(0) << (from % kWordBits));
+        while (w == 0) {
+            if (++index == words_.size())
+                return npos;
+            w = words_[index];
+        }
+        return index * kWordBits + size_type(bitops::lowest_bit(w));
+    }
+
+    size_type find_first() const noexcept { return find_next(0); }
+
+    // f(position) for every set bit, in increasing order
+    template <typename F>
+    void for_each_set(F&& f) const
+    {
+        const word_type* words = words_.data();
+        const size_type n = words_.size();
+        for (size_type index = 0; index < n; ++index)
+            for (word_type w = words[index]; w != 0; w &= w - 1)
+                f(index * kWordBits + size_type(bitops::lowest_bit(w)));
+    }
+
+    // the positions of the set bits as a range: for (std::size_t row : bits.ones())
+    class ones_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = size_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const size_type*;
+        using reference         = size_type;
+
+        ones_iterator() = default;
+        ones_iterator(const word_type* words, size_type count, size_type index) noexcept
+            : words_(words), count_(count), index_(index)
+        {
+            current_ = index_ < count_ ? words_[index_] : 0;
+            skipEmpty();
+        }
+
+        size_type operator*() const noexcept { return index_ * kWordBits + size_type(bitops::lowest_bit(current_)); }
+
+        ones_iterator& operator++() noexcept
+        {
+            current_ &= current_ - 1;
+            skipEmpty();
+            return *this;
+        }
+
+        ones_iterator operator++(int) noexcept
+        {
+            ones_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const ones_iterator& other) const noexcept
+        {
+            return index_ == other.index_ && current_ == other.current_;
+        }
+
+    private:
+        void skipEmpty() noexcept
+        {
+            while (current_ == 0 && index_ < count_)
+                current_ = ++index_ < count_ ? words_[index_] : 0;
+        }
+
+        const word_type* words_ = nullptr;
+        size_type        count_ = 0;
+        size_type        index_ = 0;
+        word_type        current_ = 0;
+    };
+
+    struct ones_range
+    {
+        ones_iterator first, last;
+        ones_iterator begin() const noexcept { return first; }
+        ones_iterator end()   const noexcept { return last; }
+    };
+
+    ones_range ones() const noexcept
+    {
+        return { ones_iterator(words_.data(), words_.size(), 0),
+                 ones_iterator(words_.data(), words_.size(), words_.size()) };
+    }
+
+    friend bool operator==(const bit_vector& a, const bit_vector& b) noexcept
+    {
+        return a.size_ == b.size_ && a.words_ == b.words_;
+    }
+
+private:
+    static size_type wordsFor(size_type bits) noexcept { return (bits + kWordBits - 1) / kWordBits; }
+    static word_type bit(size_type i) noexcept { return word_type(1) << (i % kWordBits); }
+
+    // keeps the bits beyond size_ at 0, so that whole-word operations
+    // (count, ==, iteration) can ignore size_
+    void trim() noexcept
+    {
+        if (size_ % kWordBits != 0)
+            words_.back() &= ~word_type(0) >> (kWordBits - size_ % kWordBits);
+    }
+
+    std::vector<word_type> words_;
+    size_type              size_ = 0;
+};
+
+//-----------------------------------------------------
+// free functions
+//-----------------------------------------------------
+inline bit_vector operator&(bit_vector a, const bit_vector& b) { return a &= b; }
+inline bit_vector operator|(bit_vector a, const bit_vector& b) { return a |= b; }
+inline bit_vector operator^(bit_vector a, const bit_vector& b) { return a ^= b; }
+
+inline bit_vector operator~(bit_vector a)
+{
+    a.flip();
+    return a;
+}
+
+inline bit_vector and_not(bit_vector a, const bit_vector& b) { return a.and_not(b); }
+
+// |a & b|, the size of an intersection, without building it
+inline std::size_t count_and(const bit_vector& a, const bit_vector& b)
+{
+    assert(a.size() == b.size());
+    return bitops::activeKernels().countAnd(a.words().data(), b.words().data(), a.words().size());
+}
+
+} // namespace ali
@@ -0,0 +1,231 @@
+/*
+
+    -----------------------
+    Bit Vector
+    -----------------------
+    1.  popcount64 and select_in_word against bit-by-bit loops.
+    2.  set / reset / flip / push_back / resize against std::vector<bool>;
+        the bits beyond size() stay 0.
+    3.  and, or, xor, and_not, count and count_and with every instruction
+        set the CPU supports, for sizes around the word and AVX2 block
+        boundaries.
+    4.  for_each_set, ones() and find_next visit exactly the set bits, in
+        order, for sparse and dense bitmaps.
+    5.  rank_select: rank1 at every position and select1 for every one,
+        empty, sparse, dense and full bitmaps, sizes on and off the 512-bit
+        blocks.
+
+    Usage:
+        ./main
+
+*/
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bit_vector.hpp"
+#include "rank_select.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+namespace bitops = ali::bitops;
+
+// a random bitmap with the given density of ones, and the same as vector<bool>
+static ali::bit_vector randomBits(std::size_t n, double density, unsigned seed, std::vector<bool>* copy = nullptr)
+{
+    std::mt19937_64 rng(seed);
+    std::bernoulli_distribution one(density);
+    ali::bit_vector bits(n);
+    if (copy)
+        copy->assign(n, false);
+    for (std::size_t i = 0; i < n; ++i)
+        if (one(rng)) {
+            bits.set(i);
+            if (copy)
+                (*copy)[i] = true;
+        }
+    return bits;
+}
+
+static bool sameBits(const ali::bit_vector& bits, const std::vector<bool>& expected)
+{
+    if (bits.size() != expected.size())
+        return false;
+    for (std::size_t i = 0; i < bits.size(); ++i)
+        if (bits[i] != expected[i])
+            return false;
+    // nothing set beyond size()
+    const auto words = bits.words();
+    return bits.size() % 64 == 0 || (words.back() >> (bits.size() % 64)) == 0;
+}
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkWords()
+{
+    std::mt19937_64 rng(1);
+    bool popOk = true, selectOk = true;
+    for (int i = 0; i < 20000; ++i) {
+        std::uint64_t w = rng();
+        if (i % 3 == 0) w &= rng();             // sparser words as well
+        if (i % 5 == 0) w |= rng();
+        int expected = 0;
+        for (int b = 0; b < 64; ++b)
+            if ((w >> b) & 1) {
+                selectOk = selectOk && bitops::select_in_word(w, unsigned(expected)) == b;
+                ++expected;
+            }
+        popOk = popOk && bitops::popcount64(w) == expected;
+    }
+    report(popOk && bitops::popcount64(~std::uint64_t(0)) == 64 && bitops::popcount64(0) == 0, "popcount64");
+    report(selectOk && bitops::select_in_word(std::uint64_t(1) << 63, 0) == 63, "select_in_word");
+}
+
+static void checkAgainstVectorBool()
+{
+    std::mt19937 rng(2);
+    ali::bit_vector bits;
+    std::vector<bool> expected;
+    bool ok = true;
+    for (int step = 0; step < 200000 && ok; ++step) {
+        const std::size_t i = expected.empty() ? 0 : rng() % expected.size();
+        switch (rng() % 8) {
+        case 0: case 1:
+            bits.push_back(step & 1);
+            expected.push_back(step & 1);
+            break;
+        case 2:
+            if (!expected.empty()) { bits.set(i); expected[i] = true; }
+            break;
+        case 3:
+            if (!expected.empty()) { bits.reset(i); expected[i] = false; }
+            break;
+        case 4:
+            if (!expected.empty()) { bits.flip(i); expected[i] = !expected[i]; }
+            break;
+        case 5:
+            if (!expected.empty()) { bits.set(i, step & 2); expected[i] = step & 2; }
+            break;
+        case 6:
+            if (rng() % 50 == 0) {
+                const std::size_t size = rng() % 3000;
+                const bool value = rng() & 1;
+                bits.resize(size, value);
+                expected.resize(size, value);
+            }
+            break;
+        case 7:
+            if (rng() % 500 == 0) {
+                bits.flip();
+                expected.flip();
+            }
+            break;
+        }
+        ok = step % 997 != 0 || sameBits(bits, expected);
+    }
+    report(ok && sameBits(bits, expected), "200000 random set / reset / flip / push_back / resize against vector<bool>");
+
+    ali::bit_vector all(130, true);
+    report(all.count() == 130 && (~all).none() && all.find_next(129) == 129 && all.find_next(130) == ali::bit_vector::npos,
+           "bit_vector(130, true): 130 ones, ~ is empty");
+}
+
+static void checkBulk()
+{
+    for (auto isa : { bitops::Isa::Scalar, bitops::Isa::Popcnt, bitops::Isa::AVX2 }) {
+        if (!bitops::supported(isa)) {
+            std::cout << "[SKIP] " << bitops::name(isa) << " not supported\n";
+            continue;
+        }
+        bitops::setIsa(isa);
+        bool ok = true;
+        for (std::size_t n : { 0, 1, 63, 64, 65, 255, 256, 257, 1023, 1024, 1088, 100003 }) {
+            std::vector<bool> va, vb;
+            const auto a = randomBits(n, 0.5, unsigned(n), &va);
+            const auto b = randomBits(n, 0.3, unsigned(n) + 1, &vb);
+            std::vector<bool> vand(n), vor(n), vxor(n), vandNot(n);
+            std::size_t countA = 0, countAnd = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                vand[i] = va[i] && vb[i];
+                vor[i] = va[i] || vb[i];
+                vxor[i] = va[i] != vb[i];
+                vandNot[i] = va[i] && !vb[i];
+                countA += va[i];
+                countAnd += vand[i];
+            }
+            ok = ok && sameBits(a & b, vand) && sameBits(a | b, vor) && sameBits(a ^ b, vxor)
+                    && sameBits(ali::and_not(a, b), vandNot)
+                    && a.count() == countA && ali::count_and(a, b) == countAnd
+                    && (a & a) == a && (a ^ a).none();
+        }
+        report(ok, std::string("and / or / xor / and_not / count / count_and (") + bitops::name(isa) + ")");
+    }
+    bitops::setIsa(bitops::detectIsa());
+}
+
+static void checkIteration()
+{
+    bool ok = true;
+    for (double density : { 0.0, 0.001, 0.05, 0.5, 1.0 }) {
+        std::vector<bool> expected;
+        const auto bits = randomBits(100000 + 37, density, 3, &expected);
+        std::vector<std::size_t> positions;
+        for (std::size_t i = 0; i < expected.size(); ++i)
+            if (expected[i])
+                positions.push_back(i);
+
+        std::vector<std::size_t> viaForEach, viaRange, viaFind;
+        bits.for_each_set([&](std::size_t i) { viaForEach.push_back(i); });
+        for (std::size_t i : bits.ones())
+            viaRange.push_back(i);
+        for (std::size_t i = bits.find_first(); i != ali::bit_vector::npos; i = bits.find_next(i + 1))
+            viaFind.push_back(i);
+        ok = ok && viaForEach == positions && viaRange == positions && viaFind == positions;
+    }
+    report(ok, "for_each_set / ones() / find_next visit the set bits in order");
+}
+
+static void checkRankSelect()
+{
+    bool ok = true;
+    std::size_t checkedRanks = 0, checkedSelects = 0;
+    for (std::size_t n : { 0, 1, 511, 512, 513, 4096, 100000, 1 << 20 })
+        for (double density : { 0.0, 0.0001, 0.01, 0.5, 0.99, 1.0 }) {
+            const auto bits = randomBits(n, density, unsigned(n * 10 + density * 100));
+            const ali::rank_select index(bits);
+            std::size_t rank = 0;
+            for (std::size_t i = 0; i <= n && ok; ++i) {
+                ok = index.rank1(i) == rank && index.rank0(i) == i - rank;
+                if (i < n && bits[i]) {
+                    ok = ok && index.select1(rank) == i;
+                    ++rank;
+                    ++checkedSelects;
+                }
+                ++checkedRanks;
+            }
+            ok = ok && index.ones() == rank && rank == bits.count();
+        }
+    report(ok, "rank1 at " + std::to_string(checkedRanks) + " positions, select1 of " + std::to_string(checkedSelects) + " ones");
+
+    const auto bits = randomBits(1 << 20, 0.5, 9);
+    const ali::rank_select index(bits);
+    report(index.memory() * 8 <= bits.size() * 3 / 8 + 1024,
+           "index size: " + std::to_string(100.0 * double(index.memory()) * 8 / double(bits.size())).substr(0, 4) + "% of the bits");
+}
+
+int main()
+{
+    std::cout << "bulk kernels: " << bitops::name(bitops::activeIsa()) << "\n\n";
+
+    checkWords();
+    checkAgainstVectorBool();
+    checkBulk();
+    checkIteration();
+    checkRankSelect();
+
+    return ali::check::finish();
+}
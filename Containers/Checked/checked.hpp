@@ -0,0 +1,269 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+/*
+    -----------------------
+    Checked Access
+    -----------------------
+    std::vector gives two ways to index (see Containers/Vector/main.cpp):
+
+        points[i]       no check: points[points.size() + 1] is undefined
+                        behaviour that usually "works" and reads garbage
+        points.at(i)    checks and throws std::out_of_range
+
+    and the Array<T, N> of Templates/main.cpp throws from operator[] on
+    every access. Neither fits a hot loop: the exception path makes the
+    function bigger and keeps values in memory, and nobody wants to catch an
+    out-of-range index anyway, it is a bug. What we want is to choose, at
+    compile time, what a bad index does:
+
+        bounds::unchecked   nothing, like operator[]            (release)
+        bounds::asserted    abort with a message, unless NDEBUG  (debug)
+        bounds::hardened    abort with a message, always         (production
+                            code that must not read out of bounds)
+
+    The failing branch is [[unlikely]] and calls a cold, noinline function,
+    so the hot path is a compare and a never-taken jump. The policy is a
+    template parameter of checked_span<T, Bounds> and checked_array<T, N,
+    Bounds>; default_bounds is the policy of the build:
+
+        ALI_BOUNDS_CHECK=0  unchecked
+        ALI_BOUNDS_CHECK=1  asserted       (the default)
+        ALI_BOUNDS_CHECK=2  hardened
+
+    Hoisting checks out of loops
+    ----------------------------
+    A check per element is cheap but not free: in a loop over an index array
+    the compiler cannot remove it, and the abort branch can stop the loop from
+    being vectorised. Range accessors check a whole range once and return a
+    plain std::span, whose operator[] checks nothing:
+
+        auto xs = ali::checked<ali::bounds::hardened>(points);
+        for (auto& p : xs.subspan(first, count))     // one check here
+            p.x *= 2;                                 // none in the loop
+
+        auto window = xs.first(n);                   // n <= size(), once
+        auto tail   = xs.last(n);
+        auto range  = xs.slice(begin, end);          // [begin, end)
+
+    at() keeps its std meaning (throws) for code that wants to recover.
+*/
+
+namespace ali {
+
+//-----------------------------------------------------
+// Policies
+//-----------------------------------------------------
+namespace bounds {
+
+// out of line, so that the check only costs a compare and a jump in the caller
+[[noreturn, gnu::cold, gnu::noinline]]
+inline void fail(std::size_t index, std::size_t size, const char* what) noexcept
+{
+    std::fprintf(stderr, "ali::bounds: %s %zu out of range (size %zu)\n", what, index, size);
+    std::abort();
+}
+
+struct unchecked
+{
+    static constexpr const char* name = "unchecked";
+    static constexpr void check(std::size_t, std::size_t, const char* = "index") noexcept {}
+};
+
+struct asserted
+{
+    static constexpr const char* name = "asserted";
+    static constexpr void check([[maybe_unused]] std::size_t index, [[maybe_unused]] std::size_t size,
+                                [[maybe_unused]] const char* what = "index") noexcept
+    {
+#ifndef NDEBUG
+        if (index >= size) [[unlikely]]
+            fail(index, size, what);
+#endif
+    }
+};
+
+struct hardened
+{
+    static constexpr const char* name = "hardened";
+    static constexpr void check(std::size_t index, std::size_t size, const char* what = "index") noexcept
+    {
+        if (index >= size) [[unlikely]]
+            fail(index, size, what);
+    }
+};
+
+template <typename P>
+concept policy = requires { { P::check(std::size_t(), std::size_t(), "") } noexcept; };
+
+} // namespace bounds
+
+#ifndef ALI_BOUNDS_CHECK
+#define ALI_BOUNDS_CHECK 1
+#endif
+
+#if ALI_BOUNDS_CHECK == 0
+using default_bounds = bounds::unchecked;
+#elif ALI_BOUNDS_CHECK == 1
+using default_bounds = bounds::asserted;
+#else
+using default_bounds = bounds::hardened;
+#endif
+
+//-----------------------------------------------------
+// checked_span: std::span with a checked operator[]
+//-----------------------------------------------------
+template <typename T, bounds::policy Bounds = default_bounds>
+class checked_span
+{
+public:
+    using element_type    = T;
+    using value_type      = std::remove_cv_t<T>;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using pointer         = T*;
+    using iterator        = typename std::span<T>::iterator;
+    using policy_type     = Bounds;
+
+    constexpr checked_span() noexcept = default;
+    constexpr checked_span(std::span<T> s) noexcept : s_(s) {}
+    constexpr checked_span(T* data, size_type size) noexcept : s_(data, size) {}
+
+    template <typename U, typename B>
+        requires std::is_convertible_v<U (*)[], T (*)[]>
+    constexpr checked_span(checked_span<U, B> other) noexcept : s_(other.unchecked()) {}
+
+    //-----------------------------------------------------
+    // element access (one check each)
+    //-----------------------------------------------------
+    constexpr reference operator[](size_type i) const noexcept
+    {
+        Bounds::check(i, s_.size());
+        return s_[i];
+    }
+
+    constexpr reference at(size_type i) const
+    {
+        if (i >= s_.size())
+            throw std::out_of_range("ali::checked_span::at");
+        return s_[i];
+    }
+
+    constexpr reference front() const noexcept { return (*this)[0]; }
+    constexpr reference back()  const noexcept { Bounds::check(0, s_.size()); return s_.back(); }
+
+    //-----------------------------------------------------
+    // range access (one check for the range, none inside)
+    //-----------------------------------------------------
+    constexpr std::span<T> first(size_type count) const noexcept
+    {
+        Bounds::check(count, s_.size() + 1, "count");
+        return s_.first(count);
+    }
+
+    constexpr std::span<T> last(size_type count) const noexcept
+    {
+        Bounds::check(count, s_.size() + 1, "count");
+        return s_.last(count);
+    }
+
+    constexpr std::span<T> subspan(size_type offset, size_type count) const noexcept
+    {
+        Bounds::check(offset, s_.size() + 1, "offset");
+        Bounds::check(count, s_.size() - offset + 1, "count");
+        return s_.subspan(offset, count);
+    }
+
+    // [begin, end)
+    constexpr std::span<T> slice(size_type begin, size_type end) const noexcept
+    {
+        Bounds::check(end, s_.size() + 1, "end");
+        Bounds::check(begin, end + 1, "begin");
+        return s_.subspan(begin, end - begin);
+    }
+
+    // the whole span without checks: for loops that already know their bounds
+    constexpr std::span<T> unchecked() const noexcept { return s_; }
+
+    constexpr T*        data()  const noexcept { return s_.data(); }
+    constexpr size_type size()  const noexcept { return s_.size(); }
+    constexpr bool      empty() const noexcept { return s_.empty(); }
+    constexpr iterator  begin() const noexcept { return s_.begin(); }
+    constexpr iterator  end()   const noexcept { return s_.end(); }
+
+private:
+    std::span<T> s_;
+};
+
+// a checked view of any contiguous range: ali::checked<bounds::hardened>(v)
+template <bounds::policy Bounds = default_bounds, typename Range>
+constexpr auto checked(Range&& r) noexcept
+{
+    using T = std::remove_reference_t<decltype(*std::data(r))>;
+    return checked_span<T, Bounds>(std::data(r), std::size(r));
+}
+
+//-----------------------------------------------------
+// checked_array: the Array<T, N> of Templates/main.cpp with a policy
+//-----------------------------------------------------
+template <typename T, std::size_t N, bounds::policy Bounds = default_bounds>
+struct checked_array
+{
+    using value_type  = T;
+    using size_type   = std::size_t;
+    using policy_type = Bounds;
+
+    // public, so that checked_array is an aggregate like std::array
+    T elems_[N > 0 ? N : 1];
+
+    constexpr T& operator[](size_type i) noexcept
+    {
+        Bounds::check(i, N);
+        return elems_[i];
+    }
+
+    constexpr const T& operator[](size_type i) const noexcept
+    {
+        Bounds::check(i, N);
+        return elems_[i];
+    }
+
+    constexpr T& at(size_type i)
+    {
+        if (i >= N)
+            throw std::out_of_range("ali::checked_array::at");
+        return elems_[i];
+    }
+
+    constexpr const T& at(size_type i) const
+    {
+        if (i >= N)
+            throw std::out_of_range("ali::checked_array::at");
+        return elems_[i];
+    }
+
+    constexpr checked_span<T, Bounds>       span() noexcept       { return { elems_, N }; }
+    constexpr checked_span<const T, Bounds> span() const noexcept { return { elems_, N }; }
+
+    constexpr std::span<T>       subspan(size_type offset, size_type count) noexcept       { return span().subspan(offset, count); }
+    constexpr std::span<const T> subspan(size_type offset, size_type count) const noexcept { return span().subspan(offset, count); }
+
+    constexpr T*       data()        noexcept { return elems_; }
+    constexpr const T* data()  const noexcept { return elems_; }
+    static constexpr size_type size() noexcept { return N; }
+    constexpr T*       begin()       noexcept { return elems_; }
+    constexpr const T* begin() const noexcept { return elems_; }
+    constexpr T*       end()         noexcept { return elems_ + N; }
+    constexpr const T* end()   const noexcept { return elems_ + N; }
+};
+
+} // namespace ali
@@ -0,0 +1,168 @@
+/*
+
+    -----------------------
+    Checked Access
+    -----------------------
+    1.  In-range access is the same under every policy; at() throws
+        std::out_of_range.
+    2.  hardened aborts on a bad index, a bad subspan / first / last / slice
+        and a bad checked_array index (each in a child process).
+    3.  asserted aborts like hardened without NDEBUG, and not with it; unchecked
+        reads on (here into memory that exists, past the span's end).
+    4.  Range accessors return the right elements, including the empty
+        ranges at the ends.
+    5.  checked_array works in constant expressions.
+
+    Usage:
+        ./main
+
+*/
+
+#include <csignal>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "checked.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+namespace bounds = ali::bounds;
+
+// runs f in a child process; true when the child died of SIGABRT
+template <typename F>
+static bool aborts(F f)
+{
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        // the message of bounds::fail() is expected, keep the output clean
+        std::freopen("/dev/null", "w", stderr);
+        f();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+struct Point2D
+{
+    float x, y;
+};
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+template <typename Bounds>
+static bool inRange()
+{
+    std::vector<int> v(100);
+    std::iota(v.begin(), v.end(), 0);
+    const auto s = ali::checked<Bounds>(v);
+    long sum = 0;
+    for (std::size_t i = 0; i < s.size(); ++i)
+        sum += s[i];
+    bool threw = false;
+    try {
+        s.at(s.size());
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    return sum == 4950 && s.front() == 0 && s.back() == 99 && threw;
+}
+
+static void checkInRange()
+{
+    report(inRange<bounds::unchecked>() && inRange<bounds::asserted>() && inRange<bounds::hardened>(),
+           "in-range access under unchecked / asserted / hardened, at() throws");
+}
+
+static void checkHardened()
+{
+    std::vector<Point2D> points { { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 } };
+    const auto s = ali::checked<bounds::hardened>(points);
+
+    // the read of Containers/Vector/main.cpp
+    report(aborts([&] { std::cout << s[points.size() + 1].x; }), "hardened: points[size() + 1] aborts");
+    report(aborts([&] { s.subspan(3, 2); }) && aborts([&] { s.subspan(5, 0); }), "hardened: subspan past the end aborts");
+    report(aborts([&] { s.first(5); }) && aborts([&] { s.last(5); }), "hardened: first / last longer than the span abort");
+    report(aborts([&] { s.slice(3, 2); }) && aborts([&] { s.slice(0, 5); }), "hardened: slice with begin > end or end > size aborts");
+    report(aborts([] { ali::checked_array<int, 2, bounds::hardened> a {}; a[2] = 1; }),
+           "hardened: checked_array<int, 2>[2] aborts");
+    report(!aborts([&] { s[3].x = 5; s.subspan(4, 0); s.slice(4, 4); }), "hardened: the last element and empty ranges at the end pass");
+}
+
+static void checkOtherPolicies()
+{
+    std::vector<int> v(8, 7);
+    const auto view = std::span<int>(v).first(4);
+#ifdef NDEBUG
+    report(!aborts([&] { ali::checked_span<int, bounds::asserted> { view }[5] = 1; }), "asserted is off with NDEBUG");
+#else
+    report(aborts([&] { ali::checked_span<int, bounds::asserted> { view }[5] = 1; }), "asserted aborts without NDEBUG");
+#endif
+    report(!aborts([&] { ali::checked_span<int, bounds::unchecked> { view }[5] = 1; }), "unchecked does not look");
+}
+
+static void checkRanges()
+{
+    std::vector<int> v(10);
+    std::iota(v.begin(), v.end(), 0);
+    const auto s = ali::checked<bounds::hardened>(v);
+
+    const auto sub = s.subspan(2, 3);
+    const auto first = s.first(4);
+    const auto last = s.last(3);
+    const auto slice = s.slice(5, 8);
+    const bool ok = sub.size() == 3 && sub[0] == 2 && sub[2] == 4
+                 && first.size() == 4 && first[3] == 3
+                 && last.size() == 3 && last[0] == 7
+                 && slice.size() == 3 && slice[0] == 5 && slice[2] == 7
+                 && s.subspan(10, 0).empty() && s.first(0).empty() && s.last(10).size() == 10
+                 && s.slice(0, 10).size() == 10 && s.unchecked().size() == 10;
+
+    // hoisted: one check for the range, plain std::span in the loop
+    long sum = 0;
+    for (int x : s.subspan(1, 9))
+        sum += x;
+
+    ali::checked_span<const int, bounds::hardened> readOnly = s;
+    report(ok && sum == 45 && readOnly[9] == 9, "subspan / first / last / slice / unchecked");
+}
+
+static constexpr int constexprSum()
+{
+    ali::checked_array<int, 4, bounds::hardened> a { 1, 2, 3, 4 };
+    int sum = 0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        sum += a[i];
+    for (int x : a.subspan(2, 2))
+        sum += x;
+    return sum;
+}
+
+static void checkConstexpr()
+{
+    static_assert(constexprSum() == 17);
+    report(true, "checked_array in a constant expression");
+}
+
+int main()
+{
+    std::cout << "default policy: " << ali::default_bounds::name << "\n\n";
+
+    checkInRange();
+    checkHardened();
+    checkOtherPolicies();
+    checkRanges();
+    checkConstexpr();
+
+    return ali::check::finish();
+}
@@ -0,0 +1,438 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+    -----------------------
+    Concurrent Vector
+    -----------------------
+    Containers.md compares std::vector (contiguous, but growth moves every
+    element and invalidates every reference) with std::deque and std::list
+    (stable addresses, but a pointer hop per element or per small block).
+    None of them can be appended to by several threads at once.
+
+    concurrent_vector<T> is a segmented array: a fixed table of chunks whose
+    sizes double, so growing adds a chunk and never moves anything.
+
+        chunk:     0          1              2                     3
+        size:      F          2F             4F                    8F
+        indices:   [0, F)     [F, 3F)        [3F, 7F)              [7F, 15F)  ...
+
+    -   References, pointers and iterators stay valid for the lifetime of the
+        vector (until clear()).
+
+    -   Element i lives in chunk  c = msb(i + F) - log2(F)  at offset
+        (i + F) - 2^msb(i + F): one count-leading-zeros instruction, a
+        subtraction and one load of the chunk pointer. operator[] is O(1).
+
+    -   push_back() / emplace_back() / grow_by() are lock-free and can be
+        called from any number of threads at once: a slot is reserved with
+        one fetch_add on the size counter, and the first thread that needs
+        a new chunk installs it with a compare-and-swap (a thread that loses
+        the race frees its chunk). grow_by(n) reserves n slots in one
+        atomic operation, for producers that append in batches.
+
+    -   The elements of a chunk are contiguous: segment(s) is a std::span,
+        for_each_segment() visits them in order, and the random-access
+        iterators make the parallel algorithms work on it:
+
+            ali::for_each(ali::execution::par, v.begin(), v.end(), f);
+            pool.parallel_for(v.segment_count(), [&](std::size_t s) { for (auto& x : v.segment(s)) ... });
+
+    What concurrency does NOT cover (the usual rules of tbb::concurrent_vector):
+
+    -   size() counts reserved slots, including elements another thread is
+        still constructing. Iterate after the producers are done (joined,
+        or after a barrier). An element whose push_back() has returned may
+        be read by any thread that learnt its index from the producer.
+
+    -   clear(), copy/move assignment and destruction need the vector to
+        themselves.
+
+    -   A slot cannot be given back: if T's constructor or the allocation of
+        a chunk throws inside a push_back(), the program terminates (the
+        append functions are noexcept), as for an exception escaping a
+        parallel std:: algorithm.
+*/
+
+namespace ali {
+
+template <typename T, std::size_t FirstChunk = 64>
+class concurrent_vector
+{
+    static_assert(FirstChunk > 0 && (FirstChunk & (FirstChunk - 1)) == 0, "FirstChunk must be a power of two");
+
+    static constexpr int kFirstLog2 = std::countr_zero(FirstChunk);
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+
+    // i + FirstChunk must fit into a size_type
+    static constexpr size_type kMaxChunks = 64 - kFirstLog2;
+
+    template <bool Const>
+    class basic_iterator;
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    //-----------------------------------------------------
+    // index -> (chunk, offset)
+    //-----------------------------------------------------
+    static size_type chunk_of(size_type i) noexcept
+    {
+        return size_type(std::bit_width(i + FirstChunk) - 1 - kFirstLog2);
+    }
+
+    static size_type chunk_begin(size_type chunk) noexcept { return (FirstChunk << chunk) - FirstChunk; }
+    static size_type chunk_size(size_type chunk) noexcept  { return FirstChunk << chunk; }
+
+    //-----------------------------------------------------
+    // construction
+    //-----------------------------------------------------
+    concurrent_vector() noexcept = default;
+
+    explicit concurrent_vector(size_type count) { grow_to(count); }
+
+    concurrent_vector(std::initializer_list<T> init)
+    {
+        reserve(init.size());
+        for (const T& x : init)
+            push_back(x);
+    }
+
+    concurrent_vector(const concurrent_vector& other)
+    {
+        reserve(other.size());
+        for (const T& x : other)
+            push_back(x);
+    }
+
+    concurrent_vector(concurrent_vector&& other) noexcept { swap(other); }
+
+    ~concurrent_vector()
+    {
+        clear();
+        for (auto& chunk : chunks_)
+            deallocate(chunk.load(std::memory_order_relaxed), size_type(&chunk - chunks_));
+    }
+
+    concurrent_vector& operator=(const concurrent_vector& other)
+    {
+        if (this != &other)
+            concurrent_vector(other).swap(*this);
+        return *this;
+    }
+
+    concurrent_vector& operator=(concurrent_vector&& other) noexcept
+    {
+        concurrent_vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    //-----------------------------------------------------
+    // appending (thread-safe)
+    //-----------------------------------------------------
+    template <typename... Args>
+    iterator emplace_back(Args&&... args) noexcept
+    {
+        const size_type i = size_.fetch_add(1, std::memory_order_relaxed);
+        ::new (static_cast<void*>(slot(i))) T(std::forward<Args>(args)...);
+        return iterator(this, i);
+    }
+
+    iterator push_back(const T& value) noexcept { return emplace_back(value); }
+    iterator push_back(T&& value) noexcept      { return emplace_back(std::move(value)); }
+
+    // appends `count` copies of value with one atomic operation; returns
+    // an iterator to the first of them
+    iterator grow_by(size_type count, const T& value = T()) noexcept
+    {
+        const size_type first = size_.fetch_add(count, std::memory_order_relaxed);
+        constructRange(first, first + count, value);
+        return iterator(this, first);
+    }
+
+    // grows (never shrinks) to at least `count` elements; returns an
+    // iterator to the first new one (end() if there was nothing to do)
+    iterator grow_to(size_type count, const T& value = T()) noexcept
+    {
+        size_type current = size_.load(std::memory_order_relaxed);
+        while (current < count)
+            if (size_.compare_exchange_weak(current, count, std::memory_order_relaxed)) {
+                constructRange(current, count, value);
+                return iterator(this, current);
+            }
+        return end();
+    }
+
+    // allocates the chunks for `count` elements up front (thread-safe)
+    void reserve(size_type count)
+    {
+        if (count > 0)
+            for (size_type c = 0, last = chunk_of(count - 1); c <= last; ++c)
+                chunk(c);
+    }
+
+    //-----------------------------------------------------
+    // element access (thread-safe for constructed elements)
+    //-----------------------------------------------------
+    reference operator[](size_type i) noexcept
+    {
+        const size_type c = chunk_of(i);
+        return chunks_[c].load(std::memory_order_acquire)[i - chunk_begin(c)];
+    }
+
+    const_reference operator[](size_type i) const noexcept
+    {
+        const size_type c = chunk_of(i);
+        return chunks_[c].load(std::memory_order_acquire)[i - chunk_begin(c)];
+    }
+
+    reference at(size_type i)
+    {
+        if (i >= size())
+            throw std::out_of_range("concurrent_vector::at");
+        return (*this)[i];
+    }
+
+    const_reference at(size_type i) const
+    {
+        if (i >= size())
+            throw std::out_of_range("concurrent_vector::at");
+        return (*this)[i];
+    }
+
+    reference       front()       noexcept { return (*this)[0]; }
+    const_reference front() const noexcept { return (*this)[0]; }
+    reference       back()        noexcept { return (*this)[size() - 1]; }
+    const_reference back()  const noexcept { return (*this)[size() - 1]; }
+
+    //-----------------------------------------------------
+    // size
+    //-----------------------------------------------------
+    // reserved slots; see above
+    size_type size()  const noexcept { return size_.load(std::memory_order_acquire); }
+    bool      empty() const noexcept { return size() == 0; }
+
+    size_type capacity() const noexcept
+    {
+        size_type c = 0;
+        while (c < kMaxChunks && chunks_[c].load(std::memory_order_acquire))
+            ++c;
+        return chunk_begin(c);
+    }
+
+    // destroys the elements, keeps the chunks (not thread-safe)
+    void clear() noexcept
+    {
+        for_each_segment([](std::span<T> s) { std::destroy(s.begin(), s.end()); });
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    void swap(concurrent_vector& other) noexcept
+    {
+        for (size_type c = 0; c < kMaxChunks; ++c) {
+            T* mine = chunks_[c].load(std::memory_order_relaxed);
+            chunks_[c].store(other.chunks_[c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.chunks_[c].store(mine, std::memory_order_relaxed);
+        }
+        const size_type mine = size_.load(std::memory_order_relaxed);
+        size_.store(other.size_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.size_.store(mine, std::memory_order_relaxed);
+    }
+
+    //-----------------------------------------------------
+    // segments: the contiguous pieces of [0, size())
+    //-----------------------------------------------------
+    size_type segment_count() const noexcept { return empty() ? 0 : chunk_of(size() - 1) + 1; }
+
+    std::span<T> segment(size_type s) noexcept
+    {
+        const size_type first = chunk_begin(s);
+        return { chunks_[s].load(std::memory_order_acquire), std::min(size(), first + chunk_size(s)) - first };
+    }
+
+    std::span<const T> segment(size_type s) const noexcept
+    {
+        const size_type first = chunk_begin(s);
+        return { chunks_[s].load(std::memory_order_acquire), std::min(size(), first + chunk_size(s)) - first };
+    }
+
+    template <typename F>
+    void for_each_segment(F&& f)
+    {
+        for (size_type s = 0, n = segment_count(); s < n; ++s)
+            f(segment(s));
+    }
+
+    template <typename F>
+    void for_each_segment(F&& f) const
+    {
+        for (size_type s = 0, n = segment_count(); s < n; ++s)
+            f(segment(s));
+    }
+
+    //-----------------------------------------------------
+    // iterators
+    //-----------------------------------------------------
+    iterator       begin()        noexcept { return iterator(this, 0); }
+    const_iterator begin()  const noexcept { return const_iterator(this, 0); }
+    const_iterator cbegin() const noexcept { return const_iterator(this, 0); }
+    iterator       end()          noexcept { return iterator(this, size()); }
+    const_iterator end()    const noexcept { return const_iterator(this, size()); }
+    const_iterator cend()   const noexcept { return const_iterator(this, size()); }
+
+    // random access; ++ stays inside the chunk and only looks the next chunk
+    // up when it crosses a boundary
+    template <bool Const>
+    class basic_iterator
+    {
+        using Vector = std::conditional_t<Const, const concurrent_vector, concurrent_vector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+
+        basic_iterator() = default;
+        basic_iterator(Vector* v, size_type i) noexcept : v_(v), i_(i) { locate(); }
+
+        // iterator -> const_iterator
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other) noexcept : basic_iterator(other.vector(), other.index()) {}
+
+        size_type index()  const noexcept { return i_; }
+        Vector*   vector() const noexcept { return v_; }
+
+        reference operator*()  const noexcept { return *p_; }
+        pointer   operator->() const noexcept { return p_; }
+        reference operator[](difference_type n) const noexcept { return (*v_)[size_type(difference_type(i_) + n)]; }
+
+        basic_iterator& operator++() noexcept
+        {
+            ++i_;
+            if (!p_ || ++p_ == chunkEnd_)
+                locate();
+            return *this;
+        }
+
+        basic_iterator& operator--() noexcept
+        {
+            --i_;
+            locate();
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept { basic_iterator old = *this; ++*this; return old; }
+        basic_iterator operator--(int) noexcept { basic_iterator old = *this; --*this; return old; }
+
+        basic_iterator& operator+=(difference_type n) noexcept
+        {
+            i_ = size_type(difference_type(i_) + n);
+            locate();
+            return *this;
+        }
+
+        basic_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+
+        friend basic_iterator operator+(basic_iterator it, difference_type n) noexcept { return it += n; }
+        friend basic_iterator operator+(difference_type n, basic_iterator it) noexcept { return it += n; }
+        friend basic_iterator operator-(basic_iterator it, difference_type n) noexcept { return it -= n; }
+        friend difference_type operator-(const basic_iterator& a, const basic_iterator& b) noexcept
+        {
+            return difference_type(a.i_) - difference_type(b.i_);
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ == b.i_; }
+        friend auto operator<=>(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ <=> b.i_; }
+
+    private:
+        // the chunk of i_; nullptr past the last allocated chunk (end())
+        void locate() noexcept
+        {
+            const size_type c = chunk_of(i_);
+            pointer chunk = c < kMaxChunks ? v_->chunks_[c].load(std::memory_order_acquire) : nullptr;
+            p_ = chunk ? chunk + (i_ - chunk_begin(c)) : nullptr;
+            chunkEnd_ = chunk ? chunk + chunk_size(c) : nullptr;
+        }
+
+        Vector*   v_ = nullptr;
+        size_type i_ = 0;
+        pointer   p_ = nullptr;
+        pointer   chunkEnd_ = nullptr;
+    };
+
+private:
+    // chunks hold at least a cache line, aligned to one
+    static constexpr std::size_t kAlignment = std::max<std::size_t>(alignof(T), 64);
+
+    static T* allocate(size_type c)
+    {
+        return static_cast<T*>(::operator new(chunk_size(c) * sizeof(T), std::align_val_t(kAlignment)));
+    }
+
+    static void deallocate(T* p, size_type c) noexcept
+    {
+        if (p)
+            ::operator delete(p, chunk_size(c) * sizeof(T), std::align_val_t(kAlignment));
+    }
+
+    // chunk c, allocated by whoever gets there first
+    T* chunk(size_type c)
+    {
+        T* p = chunks_[c].load(std::memory_order_acquire);
+        if (p)
+            return p;
+        T* fresh = allocate(c);
+        if (chunks_[c].compare_exchange_strong(p, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+            return fresh;
+        deallocate(fresh, c);               // another thread was faster; p is its chunk
+        return p;
+    }
+
+    T* slot(size_type i) { return chunk(chunk_of(i)) + (i - chunk_begin(chunk_of(i))); }
+
+    void constructRange(size_type first, size_type last, const T& value)
+    {
+        while (first < last) {
+            const size_type c = chunk_of(first);
+            const size_type end = std::min(last, chunk_begin(c) + chunk_size(c));
+            T* p = chunk(c) + (first - chunk_begin(c));
+            std::uninitialized_fill(p, p + (end - first), value);
+            first = end;
+        }
+    }
+
+    // the counter every producer hits gets a cache line of its own, away
+    // from the chunk table that every reader loads from
+    alignas(64) std::atomic<size_type> size_ { 0 };
+    alignas(64) std::atomic<T*>        chunks_[kMaxChunks] {};
+};
+
+template <typename T, std::size_t F>
+void swap(concurrent_vector<T, F>& a, concurrent_vector<T, F>& b) noexcept
+{
+    a.swap(b);
+}
+
+} // namespace ali
@@ -0,0 +1,174 @@
+/*
+
+    -----------------------
+    Concurrent Vector
+    -----------------------
+    1.  Index -> (chunk, offset) covers every index exactly once, for
+        first chunks of 1 and 64 elements.
+    2.  References stay valid while the vector grows by a million elements.
+    3.  8 threads push_back and grow_by at the same time: every element
+        arrives exactly once, and each thread's elements are in its order.
+    4.  Iteration: iterators, segments and ali::for_each(par) see the same
+        elements.
+    5.  Every element is destroyed exactly once (clear(), destruction,
+        copies and moves).
+
+    Usage:
+        ./main
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_vector.hpp"
+#include "../../Threads/Parallel/parallel_algorithms.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+// counts the live objects
+struct Tracked
+{
+    static inline std::atomic<int> live { 0 };
+    long value;
+
+    Tracked(long v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value) { ++live; }
+    ~Tracked() { --live; }
+};
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+template <std::size_t F>
+static bool mappingCovers(std::size_t n)
+{
+    using V = ali::concurrent_vector<int, F>;
+    std::size_t expectedChunk = 0, expectedOffset = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (expectedOffset == V::chunk_size(expectedChunk)) {
+            ++expectedChunk;
+            expectedOffset = 0;
+        }
+        const std::size_t c = V::chunk_of(i);
+        if (c != expectedChunk || i - V::chunk_begin(c) != expectedOffset)
+            return false;
+        ++expectedOffset;
+    }
+    // the last index still has a chunk
+    const std::size_t last = std::size_t(-1) - F;
+    return V::chunk_of(last) < V::kMaxChunks && last - V::chunk_begin(V::chunk_of(last)) < V::chunk_size(V::chunk_of(last));
+}
+
+static void checkMapping()
+{
+    report(mappingCovers<1>(1 << 20) && mappingCovers<64>(1 << 20), "chunk_of / chunk_begin: every index once, in order");
+}
+
+static void checkStableAddresses()
+{
+    ali::concurrent_vector<long> v;
+    std::vector<long*> addresses;
+    for (long i = 0; i < 1000; ++i)
+        addresses.push_back(&*v.push_back(i));
+    for (long i = 1000; i < 1000000; ++i)
+        v.push_back(i);
+    bool ok = v.size() == 1000000;
+    for (long i = 0; i < 1000; ++i)
+        ok = ok && addresses[std::size_t(i)] == &v[std::size_t(i)] && *addresses[std::size_t(i)] == i;
+    report(ok, "1M push_back: references to the first elements stay valid (" + std::to_string(v.segment_count()) + " chunks)");
+}
+
+static void checkConcurrentAppend()
+{
+    constexpr long kThreads = 8, kPerThread = 100000, kBatch = 100;
+    ali::concurrent_vector<long> v;
+    std::vector<std::thread> threads;
+    for (long t = 0; t < kThreads; ++t)
+        threads.emplace_back([&v, t] {
+            // even threads one by one, odd threads in batches
+            if (t % 2 == 0) {
+                for (long i = 0; i < kPerThread; ++i)
+                    v.push_back(t * kPerThread + i);
+            } else {
+                for (long i = 0; i < kPerThread; i += kBatch) {
+                    auto it = v.grow_by(kBatch);
+                    for (long j = 0; j < kBatch; ++j, ++it)
+                        *it = t * kPerThread + i + j;
+                }
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+
+    std::vector<long> seen(kThreads * kPerThread, 0);
+    std::vector<long> last(kThreads, -1);
+    bool ordered = true;
+    for (long x : v) {
+        ++seen[std::size_t(x)];
+        ordered = ordered && x > last[std::size_t(x / kPerThread)];
+        last[std::size_t(x / kPerThread)] = x;
+    }
+    const bool once = std::all_of(seen.begin(), seen.end(), [](long n) { return n == 1; });
+    report(v.size() == std::size_t(kThreads * kPerThread) && once && ordered,
+           "8 threads, push_back and grow_by(100): 800000 elements, each once, in per-thread order");
+}
+
+static void checkIteration()
+{
+    ali::concurrent_vector<long, 16> v;
+    for (long i = 0; i < 300000; ++i)
+        v.push_back(i);
+
+    const long expected = 300000L * 299999 / 2;
+    const long viaIterators = std::accumulate(v.begin(), v.end(), 0L);
+    long viaSegments = 0;
+    v.for_each_segment([&](std::span<long> s) { viaSegments = std::accumulate(s.begin(), s.end(), viaSegments); });
+    long viaIndex = 0;
+    for (std::size_t i = 0; i < v.size(); ++i)
+        viaIndex += v[i];
+
+    std::atomic<long> viaPar { 0 };
+    ali::for_each(ali::execution::par, v.begin(), v.end(), [&](long x) { viaPar.fetch_add(x, std::memory_order_relaxed); });
+    ali::for_each(ali::execution::par, v.begin(), v.end(), [](long& x) { x *= 2; });
+
+    const auto it = v.begin() + 100000;
+    report(viaIterators == expected && viaSegments == expected && viaIndex == expected && viaPar == expected
+           && v.back() == 2 * 299999 && *it == 200000 && it[-1] == 199998 && (v.end() - it) == 200000
+           && std::is_sorted(v.cbegin(), v.cend()),
+           "iterators, segments, operator[] and ali::for_each(par) agree");
+}
+
+static void checkLifetimes()
+{
+    {
+        ali::concurrent_vector<Tracked> v;
+        for (long i = 0; i < 5000; ++i)
+            v.emplace_back(i);
+        v.grow_by(3000, Tracked(7));
+        auto copy = v;
+        ali::concurrent_vector<Tracked> moved(std::move(copy));
+        moved.clear();
+        moved.grow_to(10);
+        report(Tracked::live == 8000 + 10 && v[4999].value == 4999 && v[7999].value == 7 && moved.size() == 10,
+               "copy, move, clear, grow_to");
+    }
+    report(Tracked::live == 0, "every element destroyed once");
+}
+
+int main()
+{
+    checkMapping();
+    checkStableAddresses();
+    checkConcurrentAppend();
+    checkIteration();
+    checkLifetimes();
+
+    return ali::check::finish();
+}
@@ -0,0 +1,670 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/*
+    -----------------------
+    Cuckoo Hash Map
+    -----------------------
+    Containers/map/main.cpp names cuckoo hashing as the third way to
+    resolve collisions. Every key gets exactly two places, its buckets
+
+        b1 = h & mask
+        b2 = (b1 ^ (h >> 32 | 1)) & mask        (never b1, and b1 from b2
+                                                 the same way)
+
+    where h is the key's mixed 64-bit hash and its two halves are the two
+    hash functions. A bucket has 4 slots ("bucketised" cuckoo hashing), so a
+    lookup, hit or miss, looks at no more than 8 slots at any load: O(1) in
+    the worst case, not only on average like probing (FlatHashMap) or
+    chaining (std::unordered_map). Next to each slot is a one-byte tag, 8
+    more bits of h (0 = empty): keys are only compared where the tag matches.
+
+    Insert puts the key into a free slot of b1 or b2. When both are full, a
+    breadth-first search from b1 and b2 looks for a cuckoo path: a chain of
+    elements, each of which can move to its other bucket, that ends at a free
+    slot,
+
+        b1 [a b c d]    a -> [e f g h]    e -> [i j _ k]
+
+    of at most kMaxPathLength moves (BFS finds the shortest one). The moves
+    run from the end, e into the free slot, then a into e's old slot, so an
+    element is in one of its buckets at all times; the key then takes the
+    slot freed in b1. 4-way buckets fill to 95% and more before no path
+    is found; then the table doubles.
+
+    Concurrency
+    -----------
+    The buckets share kStripes lock stripes (bucket & (kStripes - 1)). A
+    stripe is a version counter that is odd while a writer holds it:
+
+        writer   lock the stripes of the key's two buckets (CAS even -> odd,
+                 lower index first, so writers never wait in a circle),
+                 change the slots, unlock (+1: even again)
+        reader   read both versions (wait while odd), copy the slots, read
+                 the versions again: unchanged means the copy is consistent,
+                 else look again
+
+    Readers take no lock and write no shared memory, so lookups on many
+    cores do not bounce cache lines between them; a lookup only waits for a
+    writer that is changing one of its own two buckets. The only move that
+    could make a reader miss a present key is a move between that key's two
+    buckets, and the mover holds both of their stripes. Growing locks every
+    stripe. The old tables stay allocated until the map is destroyed (all
+    of them together are smaller than the current one), since a reader may
+    still be copying from one.
+
+    Before it is validated, a reader's copy may be torn (half old, half
+    new), and it is thrown away. Only types that are plain bytes can be
+    copied like that: Key and T must be trivially copyable. They are stored
+    as relaxed atomic words, the seqlock recipe of H. Boehm ("Can Seqlocks
+    Get Along With Programming Language Memory Models?", 2012), so the racy
+    copy is not a data race. Strings and other owners of memory go into the
+    map as an index or a pointer.
+
+    API, every function may run concurrently with every other:
+
+        find(key)                      std::optional<T>, a copy
+        contains(key)
+        insert(key, value)             false if the key was there (unchanged)
+        insert_or_assign(key, value)   true if inserted
+        update(key, f)                 f(T&) under the lock, false if absent
+        upsert(key, f, value)          f(T&) if present, else insert value
+        erase(key)
+        size / empty / capacity / load_factor / reserve / clear
+        for_each(f)                    f(key, value) for every element, with
+                                       every stripe locked
+
+    f runs while the stripes are held: keep it short and do not touch the
+    map from it. size() is exact only when no writer runs.
+*/
+
+namespace ali {
+
+namespace cuckoo {
+
+inline constexpr std::size_t kSlotsPerBucket = 4;
+inline constexpr std::size_t kStripes = 1024;
+inline constexpr std::size_t kMaxPathLength = 5;
+
+// std::hash of an integer is the integer: spread every bit over the word
+// (64 x 64 -> 128 bit multiply, fold), see FlatHashMap
+inline std::uint64_t mix(std::uint64_t h) noexcept
+{
+    __extension__ typedef unsigned __int128 u128;
+    const u128 m = u128(h) * 0x9E3779B97F4A7C15ull;
+    return std::uint64_t(m) ^ std::uint64_t(m >> 64);
+}
+
+// spin while the holder is about to finish, yield once it looks preempted
+inline void backoff(unsigned& spins) noexcept
+{
+    if (++spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#endif
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+// a trivially copyable value kept in relaxed atomic words: a copy taken
+// while a writer changes it is torn, but not a data race
+template <typename V>
+class AtomicWords
+{
+    static constexpr std::size_t kWords = (sizeof(V) + 7) / 8;
+
+public:
+    V load() const noexcept
+    {
+        std::uint64_t words[kWords];
+        for (std::size_t i = 0; i < kWords; ++i)
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        std::array<unsigned char, sizeof(V)> bytes;
+        std::memcpy(bytes.data(), words, sizeof(V));
+        return std::bit_cast<V>(bytes);
+    }
+
+    void store(const V& value) noexcept
+    {
+        std::uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(V));
+        for (std::size_t i = 0; i < kWords; ++i)
+            words_[i].store(words[i], std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> words_[kWords];
+};
+
+// version counter and spinlock in one: odd while a writer holds it
+struct alignas(64) Stripe
+{
+    std::atomic<std::uint64_t> version { 0 };
+
+    void lock() noexcept
+    {
+        unsigned spins = 0;
+        std::uint64_t v = version.load(std::memory_order_relaxed);
+        while ((v & 1) || !version.compare_exchange_weak(v, v + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            backoff(spins);
+            v = version.load(std::memory_order_relaxed);
+        }
+        // the odd version before any slot write: a reader that copies a new
+        // value then reads a changed version
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void unlock() noexcept { version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+};
+
+// the stripes of two buckets (maybe the same one), lower address first
+class StripePair
+{
+public:
+    StripePair(Stripe& a, Stripe& b) noexcept
+        : first_(&a < &b ? &a : &b), second_(&a == &b ? nullptr : &a < &b ? &b : &a)
+    {
+        first_->lock();
+        if (second_)
+            second_->lock();
+    }
+
+    StripePair(const StripePair&) = delete;
+    StripePair& operator=(const StripePair&) = delete;
+
+    ~StripePair()
+    {
+        if (second_)
+            second_->unlock();
+        first_->unlock();
+    }
+
+private:
+    Stripe* first_;
+    Stripe* second_;
+};
+
+} // namespace cuckoo
+
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class cuckoo_hash_map
+{
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<T>,
+                  "readers copy slots while writers change them: Key and T must be trivially copyable");
+
+    static constexpr std::size_t kSlots = cuckoo::kSlotsPerBucket;
+    static constexpr std::size_t kStripes = cuckoo::kStripes;
+
+    using Stripe = cuckoo::Stripe;
+    using StripePair = cuckoo::StripePair;
+
+public:
+    using key_type    = Key;
+    using mapped_type = T;
+    using size_type   = std::size_t;
+    using hasher      = Hash;
+    using key_equal   = KeyEqual;
+
+    static constexpr size_type slots_per_bucket = kSlots;
+
+    //-----------------------------------------------------
+    // construction
+    //-----------------------------------------------------
+    // room for about capacity elements before the first growth
+    explicit cuckoo_hash_map(size_type capacity = 0, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : hash_(hash), equal_(equal), stripes_(new Stripe[kStripes])
+    {
+        tables_.push_back(std::make_unique<Table>(bucketsFor(capacity)));
+        table_.store(tables_.back().get(), std::memory_order_release);
+    }
+
+    // shared between threads by reference: neither copyable nor movable
+    cuckoo_hash_map(const cuckoo_hash_map&) = delete;
+    cuckoo_hash_map& operator=(const cuckoo_hash_map&) = delete;
+
+    //-----------------------------------------------------
+    // lookup (lock-free)
+    //-----------------------------------------------------
+    std::optional<T> find(const Key& key) const
+    {
+        const std::uint64_t h = hashOf(key);
+        unsigned spins = 0;
+        for (;;) {
+            const Table* t = table_.load(std::memory_order_acquire);
+            const Position pos = position(h, t->mask);
+            const Stripe& s1 = stripe(pos.b1);
+            const Stripe& s2 = stripe(pos.b2);
+            const std::uint64_t v1 = s1.version.load(std::memory_order_acquire);
+            const std::uint64_t v2 = s2.version.load(std::memory_order_acquire);
+            if ((v1 | v2) & 1) {
+                cuckoo::backoff(spins);
+                continue;
+            }
+            // grown since t was loaded: the versions above are of the new table
+            if (table_.load(std::memory_order_acquire) != t)
+                continue;
+
+            std::optional<T> found = copyIn(t->buckets[pos.b1], key, pos.tag);
+            if (!found)
+                found = copyIn(t->buckets[pos.b2], key, pos.tag);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s1.version.load(std::memory_order_relaxed) == v1 && s2.version.load(std::memory_order_relaxed) == v2)
+                return found;
+        }
+    }
+
+    bool contains(const Key& key) const { return find(key).has_value(); }
+
+    //-----------------------------------------------------
+    // modifiers
+    //-----------------------------------------------------
+    bool insert(const Key& key, const T& value)
+    {
+        return insertOr(key, value, [](Bucket&, size_type) {});
+    }
+
+    bool insert_or_assign(const Key& key, const T& value)
+    {
+        return insertOr(key, value, [&](Bucket& b, size_type slot) { b.values[slot].store(value); });
+    }
+
+    // f(T&) on the value of key, if present
+    template <typename F>
+    bool update(const Key& key, F f)
+    {
+        const std::uint64_t h = hashOf(key);
+        std::optional<StripePair> lock;
+        Table* t = lockKey(h, lock);
+        const Position pos = position(h, t->mask);
+        for (const size_type b : { pos.b1, pos.b2 }) {
+            const size_type slot = slotOf(t->buckets[b], key, pos.tag);
+            if (slot != npos) {
+                modify(t->buckets[b], slot, f);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // f(T&) if key is present, else insert value; true if inserted
+    template <typename F>
+    bool upsert(const Key& key, F f, const T& value)
+    {
+        return insertOr(key, value, [&](Bucket& b, size_type slot) { modify(b, slot, f); });
+    }
+
+    bool erase(const Key& key)
+    {
+        const std::uint64_t h = hashOf(key);
+        std::optional<StripePair> lock;
+        Table* t = lockKey(h, lock);
+        const Position pos = position(h, t->mask);
+        for (const size_type b : { pos.b1, pos.b2 }) {
+            const size_type slot = slotOf(t->buckets[b], key, pos.tag);
+            if (slot != npos) {
+                t->buckets[b].tags[slot].store(0, std::memory_order_relaxed);
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear()
+    {
+        AllStripes lock(*this);
+        Table* t = table_.load(std::memory_order_relaxed);
+        for (size_type b = 0; b <= t->mask; ++b)
+            for (auto& tag : t->buckets[b].tags)
+                tag.store(0, std::memory_order_relaxed);
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    // grows now to hold about count elements
+    void reserve(size_type count)
+    {
+        AllStripes lock(*this);
+        const Table* t = table_.load(std::memory_order_relaxed);
+        if (bucketsFor(count) > t->mask + 1)
+            rehashLocked(bucketsFor(count));
+    }
+
+    //-----------------------------------------------------
+    // size
+    //-----------------------------------------------------
+    size_type size()     const noexcept { return size_.load(std::memory_order_relaxed); }
+    bool      empty()    const noexcept { return size() == 0; }
+    size_type capacity() const noexcept { return (table_.load(std::memory_order_acquire)->mask + 1) * kSlots; }
+    float     load_factor() const noexcept { return float(size()) / float(capacity()); }
+
+    //-----------------------------------------------------
+    // iteration (every stripe locked)
+    //-----------------------------------------------------
+    template <typename F>
+    void for_each(F f) const
+    {
+        AllStripes lock(*this);
+        const Table* t = table_.load(std::memory_order_relaxed);
+        for (size_type b = 0; b <= t->mask; ++b) {
+            const Bucket& bucket = t->buckets[b];
+            for (size_type slot = 0; slot < kSlots; ++slot)
+                if (bucket.tags[slot].load(std::memory_order_relaxed) != 0)
+                    f(bucket.keys[slot].load(), bucket.values[slot].load());
+        }
+    }
+
+    hasher    hash_function() const { return hash_; }
+    key_equal key_eq() const { return equal_; }
+
+private:
+    static constexpr size_type npos = size_type(-1);
+
+    struct Bucket
+    {
+        std::atomic<std::uint8_t>   tags[kSlots];           // 0: empty
+        cuckoo::AtomicWords<Key>    keys[kSlots];
+        cuckoo::AtomicWords<T>      values[kSlots];
+    };
+
+    struct Table
+    {
+        explicit Table(size_type bucketCount) : mask(bucketCount - 1), buckets(new Bucket[bucketCount]()) {}
+
+        size_type                   mask;                   // bucket count - 1
+        std::unique_ptr<Bucket[]>   buckets;
+    };
+
+    struct Position
+    {
+        size_type    b1, b2;
+        std::uint8_t tag;
+    };
+
+    // one step of a cuckoo path: the element in slot of the parent's bucket
+    // (key) can move to bucket
+    struct PathNode
+    {
+        size_type bucket;
+        int       parent;
+        unsigned  slot;
+        unsigned  depth;
+        Key       key;
+    };
+
+    // every stripe, in index order like the pairs: growing, clear, for_each
+    class AllStripes
+    {
+    public:
+        explicit AllStripes(const cuckoo_hash_map& map) noexcept : stripes_(map.stripes_.get())
+        {
+            for (size_type i = 0; i < kStripes; ++i)
+                stripes_[i].lock();
+        }
+
+        AllStripes(const AllStripes&) = delete;
+        AllStripes& operator=(const AllStripes&) = delete;
+
+        ~AllStripes()
+        {
+            for (size_type i = kStripes; i-- > 0;)
+                stripes_[i].unlock();
+        }
+
+    private:
+        Stripe* stripes_;
+    };
+
+    // 90% of the slots for count elements, at least 2 buckets (b2 != b1)
+    static size_type bucketsFor(size_type count) noexcept
+    {
+        return std::bit_ceil(std::max<size_type>(2, (count + count / 9 + kSlots - 1) / kSlots));
+    }
+
+    // the other bucket of a key with hash h in bucket b: b1 <-> b2
+    static size_type alternate(size_type b, std::uint64_t h, size_type mask) noexcept
+    {
+        return (b ^ (size_type(h >> 32) | 1)) & mask;
+    }
+
+    static Position position(std::uint64_t h, size_type mask) noexcept
+    {
+        const size_type b1 = size_type(h) & mask;
+        const auto tag = std::uint8_t(h >> 24);
+        return { b1, alternate(b1, h, mask), tag ? tag : std::uint8_t(1) };
+    }
+
+    std::uint64_t hashOf(const Key& key) const noexcept(noexcept(hash_(key)))
+    {
+        return cuckoo::mix(std::uint64_t(hash_(key)));
+    }
+
+    Stripe& stripe(size_type bucket) const noexcept { return stripes_[bucket & (kStripes - 1)]; }
+
+    // a reader's copy of key's value in b, if there (maybe torn until validated)
+    std::optional<T> copyIn(const Bucket& b, const Key& key, std::uint8_t tag) const
+    {
+        for (size_type slot = 0; slot < kSlots; ++slot)
+            if (b.tags[slot].load(std::memory_order_relaxed) == tag && equal_(b.keys[slot].load(), key))
+                return b.values[slot].load();
+        return std::nullopt;
+    }
+
+    size_type slotOf(const Bucket& b, const Key& key, std::uint8_t tag) const
+    {
+        for (size_type slot = 0; slot < kSlots; ++slot)
+            if (b.tags[slot].load(std::memory_order_relaxed) == tag && equal_(b.keys[slot].load(), key))
+                return slot;
+        return npos;
+    }
+
+    static size_type freeSlot(const Bucket& b) noexcept
+    {
+        for (size_type slot = 0; slot < kSlots; ++slot)
+            if (b.tags[slot].load(std::memory_order_relaxed) == 0)
+                return slot;
+        return npos;
+    }
+
+    static void put(Bucket& b, size_type slot, const Key& key, const T& value, std::uint8_t tag) noexcept
+    {
+        b.keys[slot].store(key);
+        b.values[slot].store(value);
+        b.tags[slot].store(tag, std::memory_order_relaxed);
+    }
+
+    template <typename F>
+    static void modify(Bucket& b, size_type slot, F& f)
+    {
+        T value = b.values[slot].load();
+        f(value);
+        b.values[slot].store(value);
+    }
+
+    // locks the two buckets of h in the current table; no growth while held
+    Table* lockKey(std::uint64_t h, std::optional<StripePair>& lock) const
+    {
+        for (;;) {
+            Table* t = table_.load(std::memory_order_acquire);
+            const Position pos = position(h, t->mask);
+            lock.emplace(stripe(pos.b1), stripe(pos.b2));
+            if (table_.load(std::memory_order_relaxed) == t)
+                return t;
+            lock.reset();
+        }
+    }
+
+    // insert, or onFound(bucket, slot) if the key is there; true if inserted
+    template <typename OnFound>
+    bool insertOr(const Key& key, const T& value, OnFound onFound)
+    {
+        const std::uint64_t h = hashOf(key);
+        for (;;) {
+            Table* t;
+            {
+                std::optional<StripePair> lock;
+                t = lockKey(h, lock);
+                const Position pos = position(h, t->mask);
+                Bucket& b1 = t->buckets[pos.b1];
+                Bucket& b2 = t->buckets[pos.b2];
+                for (Bucket* b : { &b1, &b2 }) {
+                    const size_type slot = slotOf(*b, key, pos.tag);
+                    if (slot != npos) {
+                        onFound(*b, slot);
+                        return false;
+                    }
+                }
+                for (Bucket* b : { &b1, &b2 }) {
+                    const size_type slot = freeSlot(*b);
+                    if (slot != npos) {
+                        put(*b, slot, key, value, pos.tag);
+                        size_.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+            }
+            // both buckets full: free a slot along a cuckoo path, or grow
+            if (!makeRoom<true>(*t, h))
+                grow(t);
+        }
+    }
+
+    // BFS from the buckets of h to a bucket with a free slot, then the moves
+    // back along the path. false: no path, the table must grow; true: a slot
+    // of b1 or b2 is free, or a concurrent writer changed the path (look again)
+    template <bool Concurrent>
+    bool makeRoom(Table& t, std::uint64_t h)
+    {
+        const Position pos = position(h, t.mask);
+        std::vector<PathNode> nodes { { pos.b1, -1, 0, 0, Key() }, { pos.b2, -1, 0, 0, Key() } };
+        for (size_type i = 0; i < nodes.size(); ++i) {
+            const PathNode node = nodes[i];
+            const Bucket& b = t.buckets[node.bucket];
+            if (const size_type slot = freeSlot(b); slot != npos)
+                return movePath<Concurrent>(t, nodes, i, slot);
+            if (node.depth == cuckoo::kMaxPathLength)
+                continue;
+            for (unsigned slot = 0; slot < kSlots; ++slot) {
+                const Key key = b.keys[slot].load();
+                nodes.push_back({ alternate(node.bucket, hashOf(key), t.mask), int(i), slot, node.depth + 1, key });
+            }
+        }
+        return false;
+    }
+
+    // node i has slot free: each element of the path moves into the slot
+    // its successor left, the last one first
+    template <bool Concurrent>
+    bool movePath(Table& t, const std::vector<PathNode>& nodes, size_type i, size_type freeSlot)
+    {
+        for (; nodes[i].parent >= 0; i = size_type(nodes[i].parent)) {
+            const PathNode& node = nodes[i];
+            const size_type from = nodes[size_type(node.parent)].bucket;
+            if constexpr (Concurrent) {
+                StripePair lock(stripe(from), stripe(node.bucket));
+                if (table_.load(std::memory_order_relaxed) != &t || !move(t, from, node.slot, node.bucket, freeSlot, node.key))
+                    return true;
+            } else {
+                move(t, from, node.slot, node.bucket, freeSlot, node.key);
+            }
+            freeSlot = node.slot;
+        }
+        return true;
+    }
+
+    // the element key from (from, fromSlot) into the free (to, toSlot), if
+    // both are still what the search saw
+    bool move(Table& t, size_type from, size_type fromSlot, size_type to, size_type toSlot, const Key& key) const
+    {
+        Bucket& src = t.buckets[from];
+        Bucket& dst = t.buckets[to];
+        const std::uint8_t tag = src.tags[fromSlot].load(std::memory_order_relaxed);
+        if (tag == 0 || dst.tags[toSlot].load(std::memory_order_relaxed) != 0 || !equal_(src.keys[fromSlot].load(), key))
+            return false;
+        put(dst, toSlot, src.keys[fromSlot].load(), src.values[fromSlot].load(), tag);
+        src.tags[fromSlot].store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    void grow(const Table* seen)
+    {
+        AllStripes lock(*this);
+        const Table* t = table_.load(std::memory_order_relaxed);
+        if (t == seen)                      // else another writer grew it
+            rehashLocked((t->mask + 1) * 2);
+    }
+
+    // every stripe held: copy into a new table of bucketCount (or more, if
+    // some key finds no cuckoo path) and publish it
+    void rehashLocked(size_type bucketCount)
+    {
+        const Table& old = *table_.load(std::memory_order_relaxed);
+        for (;; bucketCount *= 2) {
+            auto next = std::make_unique<Table>(bucketCount);
+            if (copyAll(old, *next)) {
+                table_.store(next.get(), std::memory_order_release);
+                tables_.push_back(std::move(next));
+                return;
+            }
+        }
+    }
+
+    // into a table no reader has seen yet: no locks
+    bool copyAll(const Table& from, Table& to)
+    {
+        for (size_type b = 0; b <= from.mask; ++b) {
+            const Bucket& bucket = from.buckets[b];
+            for (size_type slot = 0; slot < kSlots; ++slot) {
+                const std::uint8_t tag = bucket.tags[slot].load(std::memory_order_relaxed);
+                if (tag == 0)
+                    continue;
+                const Key key = bucket.keys[slot].load();
+                const std::uint64_t h = hashOf(key);
+                for (;;) {
+                    const Position pos = position(h, to.mask);
+                    const size_type s1 = freeSlot(to.buckets[pos.b1]);
+                    if (s1 != npos) {
+                        put(to.buckets[pos.b1], s1, key, bucket.values[slot].load(), tag);
+                        break;
+                    }
+                    const size_type s2 = freeSlot(to.buckets[pos.b2]);
+                    if (s2 != npos) {
+                        put(to.buckets[pos.b2], s2, key, bucket.values[slot].load(), tag);
+                        break;
+                    }
+                    if (!makeRoom<false>(to, h))
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    Hash                                hash_;
+    KeyEqual                            equal_;
+    std::unique_ptr<Stripe[]>           stripes_;
+    std::atomic<Table*>                 table_ { nullptr };
+    std::vector<std::unique_ptr<Table>> tables_;           // the current one last, the older ones for late readers
+    std::atomic<size_type>              size_ { 0 };
+};
+
+} // namespace ali
@@ -0,0 +1,210 @@
+/*
+
+    -----------------------
+    Cuckoo Hash Map
+    -----------------------
+    1.  Random inserts, assignments, updates, upserts and erases give the
+        same results as std::unordered_map; for_each visits the same
+        elements; clear empties the map.
+    2.  The table only grows once cuckoo paths run out: at more than 90%
+        load from 4K slots on. Every key is still found after each growth.
+    3.  Readers next to writers that insert, erase and assign from a tiny
+        initial table (cuckoo moves and growths all the time): keys that are
+        always present are always found, and no value is ever torn.
+    4.  Concurrent upserts of counters lose no increment.
+
+    Usage:
+        ./main
+
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cuckoo_hash_map.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+// two words: a reader that copies one old and one new word sees check != ~value
+struct Checked
+{
+    std::uint64_t value;
+    std::uint64_t check;
+};
+
+static Checked makeChecked(std::uint64_t value) { return { value, ~value }; }
+static bool    intact(const Checked& c) { return c.check == ~c.value; }
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkAgainstUnorderedMap()
+{
+    ali::cuckoo_hash_map<std::uint64_t, std::uint64_t> map;
+    std::unordered_map<std::uint64_t, std::uint64_t> reference;
+    std::mt19937_64 rng(1);
+    bool same = true;
+    for (int i = 0; i < 400000 && same; ++i) {
+        const std::uint64_t key = rng() % 20000;
+        const std::uint64_t value = rng();
+        switch (rng() % 6) {
+        case 0:
+            same = map.insert(key, value) == reference.insert({ key, value }).second;
+            break;
+        case 1:
+            same = map.insert_or_assign(key, value) == reference.insert_or_assign(key, value).second;
+            break;
+        case 2: {
+            const auto it = reference.find(key);
+            if (it != reference.end())
+                it->second += 3;
+            same = map.update(key, [](std::uint64_t& v) { v += 3; }) == (it != reference.end());
+            break;
+        }
+        case 3: {
+            const bool inserted = !reference.contains(key);
+            reference[key] = inserted ? value : reference[key] * 2;
+            same = map.upsert(key, [](std::uint64_t& v) { v *= 2; }, value) == inserted;
+            break;
+        }
+        case 4:
+            same = map.erase(key) == (reference.erase(key) == 1);
+            break;
+        default: {
+            const auto found = map.find(key);
+            const auto it = reference.find(key);
+            same = found.has_value() == (it != reference.end()) && (!found || *found == it->second);
+        }
+        }
+    }
+    std::size_t visited = 0;
+    map.for_each([&](std::uint64_t key, std::uint64_t value) {
+        ++visited;
+        const auto it = reference.find(key);
+        same = same && it != reference.end() && it->second == value;
+    });
+    same = same && visited == reference.size() && map.size() == reference.size();
+    report(same, "400000 random operations and for_each match std::unordered_map (" + std::to_string(map.size())
+                     + " elements, load " + std::to_string(map.load_factor()) + ")");
+
+    map.clear();
+    report(map.empty() && !map.contains(reference.begin()->first) && map.insert(1, 1), "clear");
+}
+
+static void checkLoad()
+{
+    ali::cuckoo_hash_map<std::uint64_t, std::uint64_t> map;
+    float lowest = 1;
+    bool allFound = true;
+    for (std::uint64_t key = 0; map.capacity() < (1u << 20); ++key) {
+        const std::size_t before = map.capacity();
+        map.insert(key * 7919, key);
+        if (map.capacity() != before) {
+            if (before >= 4096)
+                lowest = std::min(lowest, float(key) / float(before));
+            for (std::uint64_t k = 0; k <= key; k += 1 + k / 64)
+                allFound = allFound && map.find(k * 7919) == k;
+        }
+    }
+    report(lowest > 0.9f && allFound, "grows at " + std::to_string(lowest) + " load or more (4K ... 1M slots), every key found after it");
+}
+
+static void checkConcurrentReaders()
+{
+    constexpr std::uint64_t kStable = 2000;     // keys 0 ... kStable - 1, never erased
+    constexpr std::uint64_t kChurn = 20000;     // per writer
+    constexpr int kWriters = 2;
+    constexpr int kReaders = 2;
+
+    ali::cuckoo_hash_map<std::uint64_t, Checked> map(16);
+    for (std::uint64_t key = 0; key < kStable; ++key)
+        map.insert(key, makeChecked(key));
+
+    std::atomic<int> writersLeft = kWriters;
+    std::atomic<bool> missed = false;
+    std::atomic<bool> torn = false;
+    std::atomic<long> lookups = 0;
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&, w] {
+            const std::uint64_t first = kStable + std::uint64_t(w) * kChurn;
+            for (int round = 0; round < 3; ++round) {
+                for (std::uint64_t key = first; key < first + kChurn; ++key) {
+                    map.insert(key, makeChecked(key * 3));
+                    map.insert_or_assign(key % kStable, makeChecked(key));
+                }
+                for (std::uint64_t key = first; key < first + kChurn; key += 2)
+                    map.erase(key);
+            }
+            --writersLeft;
+        });
+    }
+    for (int r = 0; r < kReaders; ++r) {
+        threads.emplace_back([&, r] {
+            std::mt19937_64 rng(std::uint64_t(r) + 7);
+            long n = 0;
+            while (writersLeft > 0) {
+                const std::uint64_t key = rng() % (kStable + kWriters * kChurn);
+                const auto found = map.find(key);
+                if (found && !intact(*found))
+                    torn = true;
+                if (key < kStable && !found)
+                    missed = true;
+                ++n;
+            }
+            lookups += n;
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    bool stable = true;
+    for (std::uint64_t key = 0; key < kStable; ++key)
+        stable = stable && map.contains(key);
+    report(!missed && stable, "present keys always found during moves and growth (" + std::to_string(lookups.load()) + " lookups)");
+    report(!torn, "no torn values (two words, written as one)");
+}
+
+static void checkConcurrentUpserts()
+{
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 100000;
+    constexpr std::uint64_t kKeys = 1000;
+
+    ali::cuckoo_hash_map<std::uint64_t, std::uint64_t> map;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i)
+                map.upsert(std::uint64_t(i + t) % kKeys, [](std::uint64_t& n) { ++n; }, 1);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    std::uint64_t total = 0;
+    bool even = true;
+    map.for_each([&](std::uint64_t, std::uint64_t n) {
+        total += n;
+        even = even && n == kThreads * kPerThread / kKeys;
+    });
+    report(total == std::uint64_t(kThreads) * kPerThread && even && map.size() == kKeys,
+           "4 threads x 100000 upserts of 1000 counters: every increment counted");
+}
+
+int main()
+{
+    checkAgainstUnorderedMap();
+    checkLoad();
+    checkConcurrentReaders();
+    checkConcurrentUpserts();
+
+    return ali::check::finish();
+}
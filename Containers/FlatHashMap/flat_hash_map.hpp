@@ -0,0 +1,810 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) && !defined(ALI_FLAT_HASH_PORTABLE)
+#include <emmintrin.h>
+#define ALI_FLAT_HASH_SSE2 1
+#endif
+
+/*
+    -----------------------
+    Flat Hash Map
+    -----------------------
+    std::unordered_map chains: every element is its own heap node and every
+    lookup follows at least two pointers (bucket -> node -> next ...).
+    flat_hash_map keeps the elements in one array and resolves collisions
+    by probing (open addressing, "SwissTable", Abseil / M. Kulukundis,
+    CppCon 2017). Next to the slots sits one control byte per slot:
+
+        ctrl:   [ h2 | E | h2 | D | h2 | h2 | E | ... ][ S ]
+        slots:  [ kv |   | kv |   | kv | kv |   | ... ]
+
+        E  empty     1000 0000
+        D  deleted   1111 1110     (tombstone)
+        S  sentinel  1111 1111     end of the table, stops iteration
+        h2 full      0xxx xxxx     the low 7 bits of the slot's hash
+
+    The hash is split: H1 (the high bits) picks the first group of 16
+    slots, H2 (the low 7 bits) goes into the control byte. A lookup loads
+    the 16 control bytes of a group into one SSE2 register and compares all
+    of them with H2 at once:
+
+        match = movemask(cmpeq(set1(h2), ctrl))     16 bits, one per slot
+
+    and only compares keys for the bits that are set: with 7 bits of H2 a
+    false match costs a key compare in 1 of 128 slots. A group with an
+    empty byte ends the search (the key would have been put there); else
+    the next group follows (triangular probing: 1, 2, 3 ... groups further,
+    which visits every group of a power-of-two table).
+
+    Deletion without tombstones: groups are aligned, so a lookup that
+    reaches a group either finds its key in it or, if the group has an empty
+    slot, stops there. If the erased slot's group still has an empty slot,
+    no key was ever placed beyond it, and the slot can simply become empty
+    again. Only in a group without empty slots does it become a tombstone;
+    tombstones are dropped at the next rehash.
+
+    The table grows (x2) when 7/8 of the slots are used (full or deleted);
+    if many of them are tombstones it is rebuilt at the same size instead.
+
+    Heterogeneous lookup: with a transparent Hash and KeyEqual (both with
+    is_transparent), find / contains / count / at / erase take anything
+    they can hash and compare, e.g. a string_view into a map of strings
+    without building a std::string:
+
+        ali::flat_hash_map<std::string, int, ali::string_hash, std::equal_to<>> m;
+        m.find(std::string_view("key"));
+
+    API: the unordered_map subset without buckets, node handles, hints and
+    allocators. Differences:
+
+    -   insert / emplace / operator[] invalidate iterators and references
+        when they rehash (unordered_map keeps references valid); erase
+        invalidates nothing but the erased element.
+    -   max_load_factor is fixed at 0.875 (the setter is accepted and
+        ignored); bucket_count() is the number of slots.
+    -   moving the elements on rehash must not throw (it terminates): keep
+        the move constructors of Key and T noexcept.
+
+    Without SSE2 (or with -DALI_FLAT_HASH_PORTABLE) the group compares run
+    as a plain loop over the 16 bytes, with the same results.
+*/
+
+namespace ali {
+
+// transparent hash for std::string keys: lookups with string_view / const char*
+struct string_hash
+{
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>()(s); }
+};
+
+namespace swiss {
+
+using ctrl_t = std::int8_t;
+
+inline constexpr ctrl_t      kEmpty = -128;
+inline constexpr ctrl_t      kDeleted = -2;
+inline constexpr ctrl_t      kSentinel = -1;
+inline constexpr std::size_t kGroupWidth = 16;
+
+inline constexpr bool isFull(ctrl_t c) noexcept { return c >= 0; }
+
+// control bytes of a table without slots: lookups find an empty group and stop
+alignas(kGroupWidth) inline constexpr ctrl_t kEmptyGroup[kGroupWidth] = {
+    kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+    kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+};
+
+// std::hash of an integer is the integer: spread every bit over the word,
+// so that both H1 and H2 see all of them (64 x 64 -> 128 bit multiply, fold)
+inline std::uint64_t mix(std::uint64_t h) noexcept
+{
+    __extension__ typedef unsigned __int128 u128;      // __extension__: no -Wpedantic warning
+    const u128 m = u128(h) * 0x9E3779B97F4A7C15ull;
+    return std::uint64_t(m) ^ std::uint64_t(m >> 64);
+}
+
+inline std::size_t h1(std::uint64_t hash) noexcept { return std::size_t(hash >> 7); }
+inline ctrl_t      h2(std::uint64_t hash) noexcept { return ctrl_t(hash & 0x7f); }
+
+// bit i set: byte i of the group matched; iterates over the set bits
+class BitMask
+{
+public:
+    explicit BitMask(std::uint32_t bits) noexcept : bits_(bits) {}
+
+    explicit operator bool() const noexcept { return bits_ != 0; }
+    unsigned lowest() const noexcept { return unsigned(std::countr_zero(bits_)); }
+
+    unsigned operator*() const noexcept { return lowest(); }
+    BitMask& operator++() noexcept { bits_ &= bits_ - 1; return *this; }
+    BitMask  begin() const noexcept { return *this; }
+    BitMask  end() const noexcept { return BitMask(0); }
+    bool operator!=(const BitMask& other) const noexcept { return bits_ != other.bits_; }
+
+private:
+    std::uint32_t bits_;
+};
+
+// 16 control bytes, compared at once
+class Group
+{
+public:
+#ifdef ALI_FLAT_HASH_SSE2
+    explicit Group(const ctrl_t* p) noexcept : ctrl_(_mm_load_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+    BitMask match(ctrl_t h2) const noexcept { return mask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)); }
+    BitMask matchEmpty() const noexcept { return mask(_mm_cmpeq_epi8(_mm_set1_epi8(kEmpty), ctrl_)); }
+    // empty and deleted are the only values below the sentinel (signed compare)
+    BitMask matchEmptyOrDeleted() const noexcept { return mask(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl_)); }
+
+private:
+    static BitMask mask(__m128i bytes) noexcept { return BitMask(std::uint32_t(_mm_movemask_epi8(bytes))); }
+
+    __m128i ctrl_;
+#else
+    explicit Group(const ctrl_t* p) noexcept { std::memcpy(ctrl_, p, kGroupWidth); }
+
+    BitMask match(ctrl_t h2) const noexcept { return matchIf([h2](ctrl_t c) { return c == h2; }); }
+    BitMask matchEmpty() const noexcept { return matchIf([](ctrl_t c) { return c == kEmpty; }); }
+    BitMask matchEmptyOrDeleted() const noexcept { return matchIf([](ctrl_t c) { return c < kSentinel; }); }
+
+private:
+    template <typename Pred>
+    BitMask matchIf(Pred pred) const noexcept
+    {
+        std::uint32_t bits = 0;
+        for (std::size_t i = 0; i < kGroupWidth; ++i)
+            bits |= std::uint32_t(pred(ctrl_[i])) << i;
+        return BitMask(bits);
+    }
+
+    ctrl_t ctrl_[kGroupWidth];
+#endif
+};
+
+// group offsets 0, 1, 3, 6, 10 ... after the first one, modulo the group count
+class Probe
+{
+public:
+    Probe(std::size_t h1, std::size_t groupMask) noexcept : mask_(groupMask), group_(h1 & groupMask) {}
+
+    std::size_t group() const noexcept { return group_; }
+    void next() noexcept { group_ = (group_ + ++step_) & mask_; }
+
+private:
+    std::size_t mask_;
+    std::size_t group_;
+    std::size_t step_ = 0;
+};
+
+// find(K) with K other than the key type only when Hash and KeyEqual are transparent
+template <bool Transparent>
+struct KeyArg { template <typename K, typename Key> using type = Key; };
+
+template <>
+struct KeyArg<true> { template <typename K, typename Key> using type = K; };
+
+template <typename F>
+concept transparent = requires { typename F::is_transparent; };
+
+} // namespace swiss
+
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_hash_map
+{
+    static constexpr bool kTransparent = swiss::transparent<Hash> && swiss::transparent<KeyEqual>;
+
+    template <typename K>
+    using key_arg = typename swiss::KeyArg<kTransparent>::template type<K, Key>;
+
+    using ctrl_t = swiss::ctrl_t;
+    static constexpr std::size_t kGroupWidth = swiss::kGroupWidth;
+
+public:
+    using key_type        = Key;
+    using mapped_type     = T;
+    using value_type      = std::pair<const Key, T>;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher          = Hash;
+    using key_equal       = KeyEqual;
+    using reference       = value_type&;
+    using const_reference = const value_type&;
+    using pointer         = value_type*;
+    using const_pointer   = const value_type*;
+
+    template <bool Const>
+    class basic_iterator;
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    //-----------------------------------------------------
+    // construction
+    //-----------------------------------------------------
+    flat_hash_map() noexcept(std::is_nothrow_default_constructible_v<Hash> && std::is_nothrow_default_constructible_v<KeyEqual>) {}
+
+    explicit flat_hash_map(size_type bucketCount, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : hash_(hash), equal_(equal)
+    {
+        rehash(bucketCount);
+    }
+
+    template <typename InputIt>
+    flat_hash_map(InputIt first, InputIt last, size_type bucketCount = 0, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : flat_hash_map(bucketCount, hash, equal)
+    {
+        insert(first, last);
+    }
+
+    flat_hash_map(std::initializer_list<value_type> init, size_type bucketCount = 0, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : flat_hash_map(init.begin(), init.end(), bucketCount, hash, equal)
+    {
+    }
+
+    // delegating: if a copy throws, the destructor frees what was built
+    flat_hash_map(const flat_hash_map& other) : flat_hash_map(0, other.hash_, other.equal_)
+    {
+        reserve(other.size());
+        for (const auto& value : other)
+            emplaceNew(hashOf(value.first), value);
+    }
+
+    flat_hash_map(flat_hash_map&& other) noexcept
+        : ctrl_(std::exchange(other.ctrl_, emptyGroup())),
+          slots_(std::exchange(other.slots_, nullptr)),
+          capacity_(std::exchange(other.capacity_, 0)),
+          size_(std::exchange(other.size_, 0)),
+          growthLeft_(std::exchange(other.growthLeft_, 0)),
+          hash_(other.hash_), equal_(other.equal_)
+    {
+    }
+
+    ~flat_hash_map()
+    {
+        destroyAll();
+        deallocate();
+    }
+
+    flat_hash_map& operator=(const flat_hash_map& other)
+    {
+        if (this != &other) {
+            flat_hash_map copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    flat_hash_map& operator=(flat_hash_map&& other) noexcept
+    {
+        flat_hash_map moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    flat_hash_map& operator=(std::initializer_list<value_type> init)
+    {
+        clear();
+        insert(init);
+        return *this;
+    }
+
+    //-----------------------------------------------------
+    // iterators
+    //-----------------------------------------------------
+    iterator       begin()        noexcept { return size_ ? iterator(ctrl_, slots_) : end(); }
+    const_iterator begin()  const noexcept { return size_ ? const_iterator(ctrl_, slots_) : end(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator       end()          noexcept { return iterator(ctrl_ + capacity_, slots_ + capacity_, 0); }
+    const_iterator end()    const noexcept { return const_iterator(ctrl_ + capacity_, slots_ + capacity_, 0); }
+    const_iterator cend()   const noexcept { return end(); }
+
+    //-----------------------------------------------------
+    // size
+    //-----------------------------------------------------
+    bool      empty()    const noexcept { return size_ == 0; }
+    size_type size()     const noexcept { return size_; }
+    size_type max_size() const noexcept { return (std::numeric_limits<size_type>::max() / 2) / (sizeof(value_type) + 1); }
+
+    //-----------------------------------------------------
+    // modifiers
+    //-----------------------------------------------------
+    void clear() noexcept
+    {
+        destroyAll();
+        if (capacity_) {
+            resetCtrl();
+            growthLeft_ = growthFor(capacity_);
+        }
+        size_ = 0;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return tryEmplaceImpl(value.first, [&](value_type* slot) { ::new (static_cast<void*>(slot)) value_type(std::move(value)); });
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+    {
+        auto result = try_emplace(key, std::forward<M>(obj));
+        if (!result.second)
+            result.first->second = std::forward<M>(obj);
+        return result;
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+    {
+        auto result = try_emplace(std::move(key), std::forward<M>(obj));
+        if (!result.second)
+            result.first->second = std::forward<M>(obj);
+        return result;
+    }
+
+    // builds the element first (the key has to be known to look it up)
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type value(std::forward<Args>(args)...);
+        return insert(std::move(value));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        return tryEmplaceImpl(key, [&](value_type* slot) {
+            ::new (static_cast<void*>(slot)) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                                        std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        return tryEmplaceImpl(key, [&](value_type* slot) {
+            ::new (static_cast<void*>(slot)) value_type(std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                                        std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+    T& operator[](const key_type& key) { return try_emplace(key).first->second; }
+    T& operator[](key_type&& key)      { return try_emplace(std::move(key)).first->second; }
+
+    iterator erase(iterator pos)
+    {
+        eraseAt(size_type(pos.ctrl_ - ctrl_));
+        pos.skip();
+        return pos;
+    }
+
+    iterator erase(const_iterator pos) { return erase(iterator(pos.ctrl_, const_cast<value_type*>(pos.slot_), 0)); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        while (first != last)
+            first = erase(first);
+        return iterator(last.ctrl_, const_cast<value_type*>(last.slot_), 0);
+    }
+
+    template <typename K = key_type>
+    size_type erase(const key_arg<K>& key)
+    {
+        const size_type i = findIndex(key, hashOf(key));
+        if (i == npos)
+            return 0;
+        eraseAt(i);
+        return 1;
+    }
+
+    void swap(flat_hash_map& other) noexcept
+    {
+        using std::swap;
+        swap(ctrl_, other.ctrl_);
+        swap(slots_, other.slots_);
+        swap(capacity_, other.capacity_);
+        swap(size_, other.size_);
+        swap(growthLeft_, other.growthLeft_);
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+    }
+
+    //-----------------------------------------------------
+    // lookup
+    //-----------------------------------------------------
+    template <typename K = key_type>
+    iterator find(const key_arg<K>& key)
+    {
+        const size_type i = findIndex(key, hashOf(key));
+        return i == npos ? end() : iteratorAt(i);
+    }
+
+    template <typename K = key_type>
+    const_iterator find(const key_arg<K>& key) const
+    {
+        const size_type i = findIndex(key, hashOf(key));
+        return i == npos ? end() : const_iterator(ctrl_ + i, slots_ + i, 0);
+    }
+
+    template <typename K = key_type>
+    bool contains(const key_arg<K>& key) const { return findIndex(key, hashOf(key)) != npos; }
+
+    template <typename K = key_type>
+    size_type count(const key_arg<K>& key) const { return contains(key) ? 1 : 0; }
+
+    template <typename K = key_type>
+    T& at(const key_arg<K>& key)
+    {
+        const size_type i = findIndex(key, hashOf(key));
+        if (i == npos)
+            throw std::out_of_range("ali::flat_hash_map::at");
+        return slots_[i].second;
+    }
+
+    template <typename K = key_type>
+    const T& at(const key_arg<K>& key) const
+    {
+        return const_cast<flat_hash_map*>(this)->at(key);
+    }
+
+    //-----------------------------------------------------
+    // hash policy
+    //-----------------------------------------------------
+    size_type bucket_count() const noexcept { return capacity_; }
+    float     load_factor() const noexcept { return capacity_ ? float(size_) / float(capacity_) : 0.f; }
+    float     max_load_factor() const noexcept { return 0.875f; }
+    void      max_load_factor(float) noexcept {}
+
+    // at least count slots (and enough for size()); rehash(0) on an empty map frees the memory
+    void rehash(size_type count)
+    {
+        if (count == 0 && size_ == 0) {
+            destroyAll();
+            deallocate();
+            ctrl_ = emptyGroup();
+            slots_ = nullptr;
+            capacity_ = growthLeft_ = 0;
+            return;
+        }
+        const size_type capacity = std::max(capacityFor(size_), roundUpCapacity(count));
+        if (capacity != capacity_)
+            resize(capacity);
+    }
+
+    // room for count elements without rehashing
+    void reserve(size_type count)
+    {
+        if (count > size_ + growthLeft_)
+            resize(std::max(capacityFor(count), capacity_));
+    }
+
+    hasher    hash_function() const { return hash_; }
+    key_equal key_eq() const { return equal_; }
+
+    friend bool operator==(const flat_hash_map& a, const flat_hash_map& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (const auto& [key, value] : a) {
+            const auto it = b.find(key);
+            if (it == b.end() || !(it->second == value))
+                return false;
+        }
+        return true;
+    }
+
+    //-----------------------------------------------------
+    // iterator
+    //-----------------------------------------------------
+    template <bool Const>
+    class basic_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = typename flat_hash_map::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer           = std::conditional_t<Const, const value_type*, value_type*>;
+
+        basic_iterator() noexcept = default;
+
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other) noexcept : ctrl_(other.ctrl_), slot_(other.slot_) {}
+
+        reference operator*() const noexcept { return *slot_; }
+        pointer  operator->() const noexcept { return slot_; }
+
+        basic_iterator& operator++() noexcept
+        {
+            ++ctrl_;
+            ++slot_;
+            skip();
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept
+        {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept { return a.ctrl_ == b.ctrl_; }
+
+    private:
+        friend class flat_hash_map;
+
+        // at ctrl, or the next full slot after it
+        basic_iterator(const ctrl_t* ctrl, pointer slot) noexcept : ctrl_(ctrl), slot_(slot) { skip(); }
+        // exactly at ctrl
+        basic_iterator(const ctrl_t* ctrl, pointer slot, int) noexcept : ctrl_(ctrl), slot_(slot) {}
+
+        // over empty and deleted slots, up to a full one or the sentinel
+        void skip() noexcept
+        {
+            while (*ctrl_ < swiss::kSentinel) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const ctrl_t* ctrl_ = nullptr;
+        pointer       slot_ = nullptr;
+    };
+
+private:
+    static constexpr size_type npos = size_type(-1);
+
+    static ctrl_t* emptyGroup() noexcept { return const_cast<ctrl_t*>(swiss::kEmptyGroup); }
+
+    // 7/8 of the slots
+    static size_type growthFor(size_type capacity) noexcept { return capacity - capacity / 8; }
+
+    // groups are a power of two
+    static size_type roundUpCapacity(size_type slots) noexcept
+    {
+        return slots <= kGroupWidth ? kGroupWidth : std::bit_ceil(slots);
+    }
+
+    static size_type capacityFor(size_type count) noexcept
+    {
+        if (count == 0)
+            return 0;
+        size_type capacity = roundUpCapacity(count);
+        while (growthFor(capacity) < count)
+            capacity *= 2;
+        return capacity;
+    }
+
+    size_type groupMask() const noexcept { return capacity_ ? capacity_ / kGroupWidth - 1 : 0; }
+
+    template <typename K>
+    std::uint64_t hashOf(const K& key) const noexcept(noexcept(hash_(key)))
+    {
+        return swiss::mix(std::uint64_t(hash_(key)));
+    }
+
+    iterator iteratorAt(size_type i) noexcept { return iterator(ctrl_ + i, slots_ + i, 0); }
+
+    template <typename K>
+    size_type findIndex(const K& key, std::uint64_t hash) const
+    {
+        swiss::Probe probe(swiss::h1(hash), groupMask());
+        while (true) {
+            const size_type base = probe.group() * kGroupWidth;
+            const swiss::Group group(ctrl_ + base);
+            for (unsigned i : group.match(swiss::h2(hash)))
+                if (equal_(slots_[base + i].first, key)) [[likely]]
+                    return base + i;
+            if (group.matchEmpty())
+                return npos;
+            probe.next();
+        }
+    }
+
+    // the first empty or deleted slot on the key's probe sequence
+    size_type findFirstNonFull(std::uint64_t hash) const noexcept
+    {
+        swiss::Probe probe(swiss::h1(hash), groupMask());
+        while (true) {
+            const size_type base = probe.group() * kGroupWidth;
+            if (const auto free = swiss::Group(ctrl_ + base).matchEmptyOrDeleted())
+                return base + free.lowest();
+            probe.next();
+        }
+    }
+
+    // claims a slot for a new element with this hash, growing when needed
+    size_type prepareInsert(std::uint64_t hash)
+    {
+        size_type i = findFirstNonFull(hash);
+        if (growthLeft_ == 0 && ctrl_[i] != swiss::kDeleted) [[unlikely]] {
+            rehashForInsert();
+            i = findFirstNonFull(hash);
+        }
+        growthLeft_ -= ctrl_[i] == swiss::kEmpty;
+        ctrl_[i] = swiss::h2(hash);
+        ++size_;
+        return i;
+    }
+
+    template <typename Construct>
+    std::pair<iterator, bool> tryEmplaceImpl(const key_type& key, Construct construct)
+    {
+        const std::uint64_t hash = hashOf(key);
+        const size_type found = findIndex(key, hash);
+        if (found != npos)
+            return { iteratorAt(found), false };
+        const size_type i = prepareInsert(hash);
+        try {
+            construct(slots_ + i);
+        } catch (...) {
+            ctrl_[i] = swiss::kDeleted;
+            --size_;
+            throw;
+        }
+        return { iteratorAt(i), true };
+    }
+
+    // a key known not to be in the map (copies)
+    void emplaceNew(std::uint64_t hash, const value_type& value)
+    {
+        const size_type i = prepareInsert(hash);
+        try {
+            ::new (static_cast<void*>(slots_ + i)) value_type(value);
+        } catch (...) {
+            ctrl_[i] = swiss::kDeleted;
+            --size_;
+            throw;
+        }
+    }
+
+    void eraseAt(size_type i) noexcept
+    {
+        std::destroy_at(slots_ + i);
+        --size_;
+        // an empty slot in the group: no probe sequence ever went past it
+        if (swiss::Group(ctrl_ + (i & ~(kGroupWidth - 1))).matchEmpty()) {
+            ctrl_[i] = swiss::kEmpty;
+            ++growthLeft_;
+        } else {
+            ctrl_[i] = swiss::kDeleted;
+        }
+    }
+
+    // no room left: drop the tombstones if they are many, else double
+    void rehashForInsert()
+    {
+        if (capacity_ && size_ * 32 <= capacity_ * 25)
+            resize(capacity_);
+        else
+            resize(capacity_ ? capacity_ * 2 : kGroupWidth);
+    }
+
+    //-----------------------------------------------------
+    // storage: [ ctrl: capacity + 16 ][ slots: capacity ], one block
+    //-----------------------------------------------------
+    static constexpr size_type kAlignment = std::max(kGroupWidth, alignof(value_type));
+
+    static size_type slotOffset(size_type capacity) noexcept
+    {
+        return (capacity + kGroupWidth + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    void resetCtrl() noexcept
+    {
+        std::memset(ctrl_, static_cast<unsigned char>(swiss::kEmpty), capacity_ + kGroupWidth);
+        ctrl_[capacity_] = swiss::kSentinel;
+    }
+
+    void resize(size_type capacity)
+    {
+        ctrl_t* const       oldCtrl = ctrl_;
+        value_type* const   oldSlots = slots_;
+        const size_type     oldCapacity = capacity_;
+
+        auto* block = static_cast<unsigned char*>(::operator new(slotOffset(capacity) + capacity * sizeof(value_type),
+                                                                 std::align_val_t(kAlignment)));
+        ctrl_ = reinterpret_cast<ctrl_t*>(block);
+        slots_ = reinterpret_cast<value_type*>(block + slotOffset(capacity));
+        capacity_ = capacity;
+        resetCtrl();
+        growthLeft_ = growthFor(capacity) - size_;
+
+        transfer(oldCtrl, oldSlots, oldCapacity);
+        if (oldCapacity)
+            ::operator delete(oldCtrl, slotOffset(oldCapacity) + oldCapacity * sizeof(value_type), std::align_val_t(kAlignment));
+    }
+
+    // moves every element into the new table; a throwing move terminates
+    void transfer(const ctrl_t* oldCtrl, value_type* oldSlots, size_type oldCapacity) noexcept
+    {
+        for (size_type j = 0; j < oldCapacity; ++j) {
+            if (!swiss::isFull(oldCtrl[j]))
+                continue;
+            value_type& old = oldSlots[j];
+            const std::uint64_t hash = hashOf(old.first);
+            const size_type i = findFirstNonFull(hash);
+            ctrl_[i] = swiss::h2(hash);
+            // the key is const only for the user: the old element dies right after
+            ::new (static_cast<void*>(slots_ + i)) value_type(std::move(const_cast<key_type&>(old.first)), std::move(old.second));
+            std::destroy_at(&old);
+        }
+    }
+
+    void destroyAll() noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            if (size_ == 0)
+                return;
+            for (size_type i = 0; i < capacity_; ++i)
+                if (swiss::isFull(ctrl_[i]))
+                    std::destroy_at(slots_ + i);
+        }
+    }
+
+    void deallocate() noexcept
+    {
+        if (capacity_)
+            ::operator delete(ctrl_, slotOffset(capacity_) + capacity_ * sizeof(value_type), std::align_val_t(kAlignment));
+    }
+
+    ctrl_t*     ctrl_ = emptyGroup();
+    value_type* slots_ = nullptr;
+    size_type   capacity_ = 0;
+    size_type   size_ = 0;
+    size_type   growthLeft_ = 0;
+    [[no_unique_address]] Hash     hash_ {};
+    [[no_unique_address]] KeyEqual equal_ {};
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void swap(flat_hash_map<Key, T, Hash, KeyEqual>& a, flat_hash_map<Key, T, Hash, KeyEqual>& b) noexcept
+{
+    a.swap(b);
+}
+
+// erase_if(map, pred) like std::erase_if for unordered_map
+template <typename Key, typename T, typename Hash, typename KeyEqual, typename Pred>
+std::size_t erase_if(flat_hash_map<Key, T, Hash, KeyEqual>& map, Pred pred)
+{
+    const std::size_t before = map.size();
+    for (auto it = map.begin(); it != map.end();) {
+        if (pred(*it))
+            it = map.erase(it);
+        else
+            ++it;
+    }
+    return before - map.size();
+}
+
+} // namespace ali
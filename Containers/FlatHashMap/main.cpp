@@ -0,0 +1,252 @@
+/*
+
+    -----------------------
+    Flat Hash Map
+    -----------------------
+    1.  Group matching (SSE2 or the portable loop) against byte-by-byte
+        compares.
+    2.  200000 random insert / erase / find / operator[] / try_emplace /
+        insert_or_assign against std::unordered_map, with a good hash and
+        with a bad one (8 distinct hash values: long probe sequences,
+        tombstones).
+    3.  Erase in a table with empty slots leaves no tombstones: filling and
+        emptying a 16-slot table forever never grows it.
+    4.  Heterogeneous lookup: find / contains / at / erase with string_view
+        and const char* in a map of std::string.
+    5.  Iteration visits every element once; erase(it) during iteration.
+    6.  Every element is constructed and destroyed the same number of times
+        through rehashes, copies, moves, clear() and destruction, also when
+        a copy throws halfway through copying a map.
+
+    Usage:
+        ./main
+
+*/
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "flat_hash_map.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+namespace swiss = ali::swiss;
+
+// a hash with only 8 values: every key of a class collides
+struct BadHash
+{
+    std::size_t operator()(int key) const noexcept { return std::size_t(key & 7); }
+};
+
+// counts the live objects; the copy number copiesUntilThrow throws
+struct Tracked
+{
+    static inline long live = 0;
+    static inline int copiesUntilThrow = -1;
+    int value;
+
+    Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value)
+    {
+        if (copiesUntilThrow >= 0 && copiesUntilThrow-- == 0)
+            throw std::runtime_error("copy");
+        ++live;
+    }
+    Tracked(Tracked&& other) noexcept : value(other.value) { ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    ~Tracked() { --live; }
+
+    bool operator==(const Tracked& other) const { return value == other.value; }
+};
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkGroup()
+{
+    std::mt19937 rng(1);
+    bool ok = true;
+    alignas(16) swiss::ctrl_t ctrl[16];
+    for (int round = 0; round < 10000 && ok; ++round) {
+        for (auto& c : ctrl) {
+            const unsigned r = rng() % 4;
+            c = r == 0 ? swiss::kEmpty : r == 1 ? swiss::kDeleted : swiss::ctrl_t(rng() % 8);
+        }
+        const swiss::ctrl_t h2 = swiss::ctrl_t(rng() % 8);
+        const swiss::Group group(ctrl);
+        std::uint32_t match = 0, empty = 0, free = 0;
+        for (unsigned i = 0; i < 16; ++i) {
+            match |= std::uint32_t(ctrl[i] == h2) << i;
+            empty |= std::uint32_t(ctrl[i] == swiss::kEmpty) << i;
+            free |= std::uint32_t(ctrl[i] == swiss::kEmpty || ctrl[i] == swiss::kDeleted) << i;
+        }
+        std::uint32_t seen = 0;
+        for (unsigned i : group.match(h2))
+            seen |= 1u << i;
+        ok = seen == match && bool(group.matchEmpty()) == (empty != 0) && bool(group.matchEmptyOrDeleted()) == (free != 0)
+             && (!free || group.matchEmptyOrDeleted().lowest() == unsigned(std::countr_zero(free)));
+    }
+#ifdef ALI_FLAT_HASH_SSE2
+    report(ok, "group match / empty / empty-or-deleted (SSE2)");
+#else
+    report(ok, "group match / empty / empty-or-deleted (portable)");
+#endif
+}
+
+template <typename Hash>
+static bool againstUnorderedMap(int steps, int keyRange, unsigned seed)
+{
+    ali::flat_hash_map<int, long, Hash> map;
+    std::unordered_map<int, long> expected;
+    std::mt19937 rng(seed);
+    for (int step = 0; step < steps; ++step) {
+        const int key = int(rng() % unsigned(keyRange));
+        const long value = long(rng());
+        switch (rng() % 7) {
+        case 0: {
+            const bool a = map.insert({ key, value }).second;
+            const bool b = expected.insert({ key, value }).second;
+            if (a != b) return false;
+            break;
+        }
+        case 1:
+            if (map.erase(key) != expected.erase(key)) return false;
+            break;
+        case 2:
+            map[key] += value;
+            expected[key] += value;
+            break;
+        case 3:
+            if (map.try_emplace(key, value).second != expected.try_emplace(key, value).second) return false;
+            break;
+        case 4:
+            if (map.insert_or_assign(key, value).second != expected.insert_or_assign(key, value).second) return false;
+            break;
+        case 5: {
+            const auto it = map.find(key);
+            const auto e = expected.find(key);
+            if ((it == map.end()) != (e == expected.end()) || (it != map.end() && it->second != e->second)) return false;
+            break;
+        }
+        case 6:
+            if (rng() % 1000 == 0) {
+                map.clear();
+                expected.clear();
+            }
+            break;
+        }
+        if (map.size() != expected.size() || map.load_factor() > map.max_load_factor()) return false;
+    }
+    std::unordered_map<int, long> copy(map.begin(), map.end());
+    return copy == expected;
+}
+
+static void checkAgainstStd()
+{
+    report(againstUnorderedMap<std::hash<int>>(200000, 5000, 2), "200000 random operations against unordered_map");
+    report(againstUnorderedMap<BadHash>(50000, 300, 3), "50000 random operations with 8 hash values");
+}
+
+static void checkNoTombstones()
+{
+    ali::flat_hash_map<int, int> map;
+    map.reserve(8);
+    const std::size_t buckets = map.bucket_count();
+    for (int round = 0; round < 100000; ++round) {
+        for (int i = 0; i < 8; ++i)
+            map[round * 8 + i] = i;
+        for (int i = 0; i < 8; ++i)
+            map.erase(round * 8 + i);
+    }
+    report(buckets == 16 && map.bucket_count() == 16 && map.empty(), "fill and empty a 16-slot table 100000 times: it never grows");
+}
+
+static void checkHeterogeneous()
+{
+    ali::flat_hash_map<std::string, int, ali::string_hash, std::equal_to<>> map;
+    for (int i = 0; i < 1000; ++i)
+        map.emplace("key" + std::to_string(i), i);
+    const std::string_view view = "key123";
+    bool threw = false;
+    try {
+        map.at(std::string_view("nothing"));
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    const bool ok = map.find(view) != map.end() && map.find(view)->second == 123 && map.contains("key999")
+                    && !map.contains(std::string_view("key1000")) && map.at("key7") == 7 && map.count(view) == 1
+                    && map.erase(view) == 1 && !map.contains(view) && threw;
+    report(ok, "find / contains / at / erase with string_view and const char*");
+}
+
+static void checkIteration()
+{
+    ali::flat_hash_map<int, int> map;
+    for (int i = 0; i < 10000; ++i)
+        map.emplace(i, i * 2);
+    std::vector<int> seen(10000, 0);
+    for (const auto& [key, value] : map)
+        seen[std::size_t(key)] += value == key * 2;
+    bool ok = std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; });
+
+    // erase the odd keys while iterating; the even ones keep their addresses
+    const int* address = &map.find(42)->second;
+    for (auto it = map.begin(); it != map.end();)
+        it = it->first % 2 ? map.erase(it) : std::next(it);
+    ok = ok && map.size() == 5000 && &map.find(42)->second == address && !map.contains(43);
+    ok = ok && ali::erase_if(map, [](const auto& kv) { return kv.first >= 100; }) == 4950 && map.size() == 50;
+    report(ok, "iteration visits every element once; erase(it) while iterating; erase_if");
+}
+
+static void checkLifetimes()
+{
+    {
+        ali::flat_hash_map<int, Tracked> map;
+        for (int i = 0; i < 5000; ++i)
+            map.try_emplace(i, i);
+        for (int i = 0; i < 5000; i += 3)
+            map.erase(i);
+        auto copy = map;
+        ali::flat_hash_map<int, Tracked> moved(std::move(copy));
+        moved.insert_or_assign(1, Tracked(7));
+        copy = moved;
+        moved.clear();
+        moved.rehash(0);
+        const auto same = map;
+        report(Tracked::live == 3 * 3333 && copy.at(1).value == 7 && same == map && !(copy == map) && moved.bucket_count() == 0,
+               "rehash, copy, move, clear keep every element once");
+    }
+    {
+        ali::flat_hash_map<int, Tracked> map;
+        for (int i = 0; i < 100; ++i)
+            map.try_emplace(i, i);
+        Tracked::copiesUntilThrow = 49;
+        bool threw = false;
+        try {
+            auto copy = map;
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        Tracked::copiesUntilThrow = -1;
+        report(threw && Tracked::live == 100, "a copy constructor that throws at the 50th element leaks nothing");
+    }
+    report(Tracked::live == 0, "every element destroyed once");
+}
+
+int main()
+{
+    checkGroup();
+    checkAgainstStd();
+    checkNoTombstones();
+    checkHeterogeneous();
+    checkIteration();
+    checkLifetimes();
+
+    return ali::check::finish();
+}
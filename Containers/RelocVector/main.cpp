@@ -0,0 +1,264 @@
+/*
+
+    -----------------------
+    Relocating Vector
+    -----------------------
+    1.  Which types are trivially relocatable, and opting in a type that is
+        not trivially copyable (std::unique_ptr).
+    2.  Small buffers grow on the heap, from 1 MiB on the buffer is its own
+        mapping; the elements survive every step.
+    3.  reserve_address_space(): growth within the reservation never moves
+        the elements (data() stays the same), growth beyond it does and
+        keeps them.
+    4.  shrink_to_fit() on the heap, on a mapping and in a reservation.
+    5.  push_back / insert of an element of the vector itself, also when it
+        makes the vector grow.
+    6.  100000 random operations against std::vector, with growth factors
+        2 and 1.5, across the heap -> mapping threshold.
+    7.  Every unique_ptr is freed exactly once (run with -fsanitize=address
+        to see it).
+
+    Usage:
+        ./main
+
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "reloc_vector.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+struct Point2D
+{
+    float x,y;
+};
+
+// a unique_ptr is only a pointer: moving it with memcpy and forgetting the
+// source is fine, even though its move constructor is not trivial
+template <typename T>
+struct ali::is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+static_assert(ali::is_trivially_relocatable_v<int>);
+static_assert(ali::is_trivially_relocatable_v<Point2D>);
+static_assert(ali::is_trivially_relocatable_v<std::unique_ptr<int>>);
+static_assert(!ali::is_trivially_relocatable_v<std::string>);
+
+template <typename V>
+static bool isSequence(const V& v, std::size_t count, int first = 0)
+{
+    if (v.size() != count)
+        return false;
+    for (std::size_t i = 0; i < count; ++i)
+        if (v[i] != int(i) + first)
+            return false;
+    return true;
+}
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkHeapToMapping()
+{
+    ali::reloc_vector<int> v;
+    bool ok = true;
+    bool mapped = false;
+    std::size_t mappedAt = 0;
+    for (int i = 0; i < (1 << 22); ++i) {
+        v.push_back(i);
+        if (v.is_mapped() && !mapped) {
+            mapped = true;
+            mappedAt = v.capacity() * sizeof(int);
+        }
+        ok = ok && v.capacity() >= v.size();
+    }
+    report(ok && isSequence(v, 1 << 22) && mapped && mappedAt >= ali::detail::RelocStorage::kMapThreshold,
+           "4M push_back: heap, then a mapping from " + std::to_string(mappedAt >> 10) + " KiB on");
+    report(v.capacity() * sizeof(int) % ali::detail::RelocStorage::pageSize() == 0, "mapped capacity is whole pages");
+
+    ali::reloc_vector<Point2D, std::ratio<3, 2>> points;
+    std::size_t steps = 0;
+    for (int i = 0; i < 100000; ++i) {
+        if (points.size() == points.capacity())
+            ++steps;
+        points.push_back({ float(i), float(-i) });
+    }
+    report(points.back().x == 99999.f && points[12345].y == -12345.f && steps > 20,
+           "growth factor 1.5: " + std::to_string(steps) + " growth steps for 100000 points");
+}
+
+static void checkReservation()
+{
+    ali::reloc_vector<int> v;
+    v.push_back(-1);
+    v.reserve_address_space(std::size_t(1) << 28);         // 1 GiB of address space
+    const int* first = v.data();
+    bool stable = v[0] == -1;
+    v.pop_back();
+    for (int i = 0; i < (1 << 22); ++i) {
+        v.push_back(i);
+        stable = stable && v.data() == first;
+    }
+    report(stable && isSequence(v, 1 << 22) && v.reserved_capacity() == (std::size_t(1) << 28),
+           "reserved 1 GiB: 4M push_back, the elements never move");
+    report(v.capacity() < (std::size_t(1) << 24), "reserved: only what is used is committed (" +
+           std::to_string(v.capacity() * sizeof(int) >> 20) + " MiB)");
+
+    v.shrink_to_fit();
+    v.resize(100);
+    v.shrink_to_fit();
+    report(v.data() == first && isSequence(v, 100) && v.capacity() * sizeof(int) == ali::detail::RelocStorage::pageSize(),
+           "reserved: shrink_to_fit() decommits, keeps the reservation");
+
+    // beyond the reservation: one more move, then an ordinary mapping
+    ali::reloc_vector<int> small;
+    small.reserve_address_space(1000);
+    for (int i = 0; i < 1000000; ++i)
+        small.push_back(i);
+    report(isSequence(small, 1000000) && small.is_mapped() && small.reserved_capacity() == 0,
+           "beyond the reservation: the mapping grows on");
+}
+
+static void checkShrink()
+{
+    ali::reloc_vector<int> heap(1000);
+    heap.resize(10);
+    heap.shrink_to_fit();
+    report(heap.capacity() == 10 && !heap.is_mapped(), "heap: shrink_to_fit() is realloc()");
+
+    ali::reloc_vector<int> mapped;
+    for (int i = 0; i < (1 << 20); ++i)
+        mapped.push_back(i);
+    mapped.resize(5000);
+    mapped.shrink_to_fit();
+    report(isSequence(mapped, 5000) && mapped.capacity() * sizeof(int) == ali::detail::RelocStorage::roundToPages(5000 * sizeof(int)),
+           "mapping: shrink_to_fit() unmaps the tail");
+    mapped.clear();
+    mapped.shrink_to_fit();
+    report(mapped.capacity() == 0 && mapped.data() == nullptr, "shrink_to_fit() of an empty vector frees everything");
+}
+
+static void checkAliasing()
+{
+    ali::reloc_vector<int> v { 1, 2, 3, 4 };
+    v.shrink_to_fit();
+    v.push_back(v[0]);                      // grows, v[0] lives in the old buffer
+    v.insert(v.begin(), v.back());
+    v.insert(v.begin() + 2, v[3]);
+    v.resize(v.capacity());
+    v.resize(v.size() + 1, v[1]);
+    report(v[0] == 1 && v[1] == 1 && v[2] == 3 && v[5] == 4 && v[6] == 1 && v.back() == 1,
+           "push_back / insert / resize with an element of the vector itself");
+}
+
+template <typename Growth>
+static void checkAgainstStd(const std::string& name)
+{
+    std::mt19937 rng(7);
+    std::vector<int> expected;
+    ali::reloc_vector<int, Growth> v;
+    // positions in the last 4096 elements: memmove()s of megabytes are not what is tested
+    auto position = [&] { return expected.size() - rng() % (std::min<std::size_t>(expected.size(), 4096) + 1); };
+    bool ok = true;
+    for (int step = 0; step < 100000 && ok; ++step) {
+        const int value = int(rng());
+        switch (rng() % 10) {
+        case 0: case 1: case 2:
+            expected.push_back(value);
+            v.push_back(value);
+            break;
+        case 3:                     // a burst, to get across 1 MiB
+            for (int i = 0; i < 64; ++i) {
+                expected.push_back(value + i);
+                v.emplace_back(value + i);
+            }
+            break;
+        case 4:
+            if (!expected.empty()) {
+                expected.pop_back();
+                v.pop_back();
+            }
+            break;
+        case 5: {
+            const std::size_t at = position();
+            expected.insert(expected.begin() + at, value);
+            v.insert(v.begin() + at, value);
+            break;
+        }
+        case 6:
+            if (!expected.empty()) {
+                const std::size_t at = std::min(position(), expected.size() - 1);
+                const std::size_t count = std::min<std::size_t>(rng() % 8, expected.size() - at);
+                expected.erase(expected.begin() + at, expected.begin() + at + count);
+                v.erase(v.begin() + at, v.begin() + at + count);
+            }
+            break;
+        case 7: {
+            const std::size_t size = expected.size() + rng() % 16 - 8;
+            if (size < expected.size() + 8) {
+                expected.resize(size, value);
+                v.resize(size, value);
+            }
+            break;
+        }
+        case 8:
+            if (rng() % 100 == 0) {
+                expected.shrink_to_fit();
+                v.shrink_to_fit();
+            }
+            break;
+        case 9: {
+            const std::size_t at = position();
+            const int more[] = { value, value + 1, value + 2 };
+            expected.insert(expected.begin() + at, std::begin(more), std::end(more));
+            v.insert(v.begin() + at, std::begin(more), std::end(more));
+            break;
+        }
+        }
+        ok = expected.size() == v.size() && v.capacity() >= v.size()
+          && (step % 1000 != 0 || std::equal(expected.begin(), expected.end(), v.begin()));
+    }
+    ok = ok && std::equal(expected.begin(), expected.end(), v.begin());
+
+    ali::reloc_vector<int, Growth> copy(v), moved(std::move(copy));
+    ok = ok && moved == v && copy.empty();
+    report(ok && v.is_mapped(), "100000 random operations against std::vector (" + name + ", " +
+           std::to_string(v.size() * sizeof(int) >> 10) + " KiB at the end)");
+}
+
+static void checkUniquePtr()
+{
+    ali::reloc_vector<std::unique_ptr<int>> v;
+    for (int i = 0; i < 300000; ++i)
+        v.push_back(std::make_unique<int>(i));
+    v.erase(v.begin(), v.begin() + 1000);
+    v.insert(v.begin(), std::make_unique<int>(-1));
+    v.resize(v.size() - 5);
+    v.shrink_to_fit();
+    bool ok = *v[0] == -1 && *v[1] == 1000 && v.size() == 300000 - 1000 + 1 - 5;
+    for (std::size_t i = 1; i < v.size() && ok; ++i)
+        ok = *v[i] == int(i) + 999;
+
+    ali::reloc_vector<std::unique_ptr<int>> other(std::move(v));
+    swap(v, other);
+    report(ok && other.empty() && *v.back() == 300000 - 6, "opted-in std::unique_ptr: relocated by memcpy, freed once");
+}
+
+int main()
+{
+    checkHeapToMapping();
+    checkReservation();
+    checkShrink();
+    checkAliasing();
+    checkAgainstStd<std::ratio<2>>("growth 2");
+    checkAgainstStd<std::ratio<3, 2>>("growth 1.5");
+    checkUniquePtr();
+
+    return ali::check::finish();
+}
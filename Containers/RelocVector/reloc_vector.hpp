@@ -0,0 +1,641 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+    -----------------------
+    Relocating Vector
+    -----------------------
+    When std::vector runs out of capacity it allocates a new buffer, moves
+    (or copies) every element over one by one and frees the old buffer: for
+    a 4 GB vector that is 4 GB read and 4 GB written, just to append one
+    element.
+
+    Most types don't care where they live: an int, a Point2D, a
+    std::unique_ptr can be moved to another address with memcpy() and the
+    old bytes simply forgotten ("trivially relocatable"). For those the
+    buffer can grow where it is:
+
+    -   small buffers (< 1 MiB) live on the malloc() heap and grow with
+        realloc(), which extends the block in place when the memory behind
+        it is free and copies it otherwise.
+
+    -   big buffers are their own mmap()ing and grow with mremap(): the
+        kernel moves the page table entries to a bigger hole in the address
+        space, no byte of the elements is copied. Growing from 2 GB to 4 GB
+        costs microseconds instead of a second.
+
+    -   reserve_address_space(n) maps address space for n elements up front
+        without committing it (PROT_NONE): growth within it only mprotect()s
+        the next pages, so the elements never move at all and data() and
+        every pointer into the vector stay valid. The physical pages come
+        when they are first written. Reserving 64 GB of address space is
+        fine on a 64-bit machine; the kernel only charges what is committed.
+
+        std::vector (memcpy per growth, peak = old + new buffer):
+            [ e0 .. e9 ]  ->  [ e0 .. e9 | e10 ........ ]  (copy, free old)
+
+        reloc_vector, mapped (page table entries move):
+            [ e0 .. e9 ]  ->  [ e0 .. e9 | e10 ........ ]  (same pages, new address)
+
+        reloc_vector, reserved (nothing moves):
+            [ e0 .. e9 | committed .. | PROT_NONE ............................ ]
+
+    The growth factor is a template parameter, reloc_vector<T, std::ratio<3, 2>>
+    grows by 1.5 instead of 2: fewer wasted bytes, more (cheap) growth steps.
+
+    A type is trivially relocatable if ali::is_trivially_relocatable<T> says
+    so: all trivially copyable types are; others opt in by specialising it:
+
+        template <> struct ali::is_trivially_relocatable<MyType> : std::true_type {};
+
+    A type that keeps a pointer into itself (a std::string with SSO in
+    libstdc++, a std::list head) must NOT opt in.
+
+    Unlike std::vector, iterators stay valid over a growth inside the
+    reserved address space; elsewhere growth invalidates them as usual.
+    Linux only (mremap).
+*/
+
+namespace ali {
+
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace detail {
+
+//-----------------------------------------------------
+// RelocStorage: the bytes of a reloc_vector
+//-----------------------------------------------------
+// one buffer of `bytes()` usable bytes on the heap, in a private mapping or
+// in a reservation of which only the front is committed
+class RelocStorage
+{
+public:
+    enum class Kind : unsigned char { None, Heap, Mapped, Reserved };
+
+    // buffers at least this big get their own mapping
+    static constexpr std::size_t kMapThreshold = std::size_t(1) << 20;
+
+    RelocStorage() noexcept = default;
+    RelocStorage(RelocStorage&& other) noexcept { swap(other); }
+    RelocStorage& operator=(RelocStorage&& other) noexcept
+    {
+        RelocStorage(std::move(other)).swap(*this);
+        return *this;
+    }
+    ~RelocStorage() { release(); }
+
+    void*       data()     const noexcept { return data_; }
+    std::size_t bytes()    const noexcept { return bytes_; }
+    std::size_t reserved() const noexcept { return kind_ == Kind::Reserved ? mapped_ : 0; }
+    Kind        kind()     const noexcept { return kind_; }
+
+    void swap(RelocStorage& other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(mapped_, other.mapped_);
+        std::swap(kind_, other.kind_);
+    }
+
+    static std::size_t pageSize() noexcept
+    {
+        static const std::size_t size = std::size_t(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    static std::size_t roundToPages(std::size_t n) noexcept
+    {
+        return (n + pageSize() - 1) & ~(pageSize() - 1);
+    }
+
+    // makes bytes() >= n, keeping the first `used` bytes; throws
+    // std::bad_alloc and leaves everything as it was if there is no memory
+    void grow(std::size_t used, std::size_t n)
+    {
+        switch (kind_) {
+        case Kind::None:
+            if (n < kMapThreshold)
+                setHeap(allocateHeap(n), n);
+            else
+                setMapped(map(roundToPages(n), PROT_READ | PROT_WRITE), roundToPages(n));
+            return;
+
+        case Kind::Heap:
+            if (n < kMapThreshold) {
+                void* p = std::realloc(data_, n);
+                if (!p)
+                    throw std::bad_alloc();
+                setHeap(p, n);
+            } else {
+                // the last copy: from here on the pages move, not the bytes
+                void* p = map(roundToPages(n), PROT_READ | PROT_WRITE);
+                std::memcpy(p, data_, used);
+                std::free(data_);
+                setMapped(p, roundToPages(n));
+            }
+            return;
+
+        case Kind::Mapped:
+            setMapped(remap(roundToPages(n)), roundToPages(n));
+            return;
+
+        case Kind::Reserved:
+            if (n <= mapped_) {
+                const std::size_t commit = roundToPages(n);
+                protect(static_cast<char*>(data_) + bytes_, commit - bytes_, PROT_READ | PROT_WRITE);
+                bytes_ = commit;
+                return;
+            }
+            // out of address space: one read-write mapping again, then move it
+            protect(static_cast<char*>(data_) + bytes_, mapped_ - bytes_, PROT_READ | PROT_WRITE);
+            bytes_ = mapped_;
+            setMapped(remap(roundToPages(n)), roundToPages(n));
+            return;
+        }
+    }
+
+    // maps (but does not commit) `n` bytes, keeping the first `used` bytes;
+    // does nothing if at least that much is reserved already
+    void reserveAddressSpace(std::size_t used, std::size_t n)
+    {
+        n = roundToPages(n);
+        if (n <= reserved() || n <= bytes_)
+            return;
+        char* p = static_cast<char*>(map(n, PROT_NONE));
+        const std::size_t commit = roundToPages(used);
+        if (commit > 0 && ::mprotect(p, commit, PROT_READ | PROT_WRITE) != 0) {
+            ::munmap(p, n);
+            throw std::bad_alloc();
+        }
+        if (used > 0)
+            std::memcpy(p, data_, used);
+        release();
+        data_ = p;
+        bytes_ = commit;
+        mapped_ = n;
+        kind_ = Kind::Reserved;
+    }
+
+    // gives back what is beyond the first `used` bytes; never throws, at
+    // worst nothing is given back
+    void shrink(std::size_t used) noexcept
+    {
+        if (used == 0 && kind_ != Kind::Reserved) {
+            release();
+            return;
+        }
+        switch (kind_) {
+        case Kind::None:
+            return;
+        case Kind::Heap:
+            if (void* p = std::realloc(data_, used))
+                setHeap(p, used);
+            return;
+        case Kind::Mapped: {
+            const std::size_t keep = roundToPages(used);
+            if (keep < mapped_) {
+                ::munmap(static_cast<char*>(data_) + keep, mapped_ - keep);
+                setMapped(data_, keep);
+            }
+            return;
+        }
+        case Kind::Reserved: {
+            // decommit the tail, keep the reservation
+            const std::size_t keep = roundToPages(used);
+            if (keep < bytes_) {
+                char* tail = static_cast<char*>(data_) + keep;
+                ::madvise(tail, bytes_ - keep, MADV_DONTNEED);
+                ::mprotect(tail, bytes_ - keep, PROT_NONE);
+                bytes_ = keep;
+            }
+            return;
+        }
+        }
+    }
+
+    void release() noexcept
+    {
+        if (kind_ == Kind::Heap)
+            std::free(data_);
+        else if (kind_ != Kind::None)
+            ::munmap(data_, mapped_);
+        data_ = nullptr;
+        bytes_ = mapped_ = 0;
+        kind_ = Kind::None;
+    }
+
+private:
+    static void* allocateHeap(std::size_t n)
+    {
+        void* p = std::malloc(n);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    static void* map(std::size_t n, int protection)
+    {
+        // MAP_NORESERVE: no swap is accounted for pages that are never touched
+        void* p = ::mmap(nullptr, n, protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void* remap(std::size_t n) const
+    {
+        void* p = ::mremap(data_, mapped_, n, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    static void protect(void* p, std::size_t n, int protection)
+    {
+        if (n > 0 && ::mprotect(p, n, protection) != 0)
+            throw std::bad_alloc();
+    }
+
+    void setHeap(void* p, std::size_t n) noexcept
+    {
+        data_ = p;
+        bytes_ = mapped_ = n;
+        kind_ = Kind::Heap;
+    }
+
+    void setMapped(void* p, std::size_t n) noexcept
+    {
+        data_ = p;
+        bytes_ = mapped_ = n;
+        kind_ = Kind::Mapped;
+    }
+
+    void*       data_ = nullptr;
+    std::size_t bytes_ = 0;         // usable (committed)
+    std::size_t mapped_ = 0;        // allocated / mapped, >= bytes_
+    Kind        kind_ = Kind::None;
+};
+
+} // namespace detail
+
+//-----------------------------------------------------
+// reloc_vector
+//-----------------------------------------------------
+template <typename T, typename Growth = std::ratio<2>>
+class reloc_vector
+{
+    static_assert(is_trivially_relocatable_v<T>, "reloc_vector needs a trivially relocatable T (see ali::is_trivially_relocatable)");
+    static_assert(Growth::num > Growth::den, "the growth factor must be greater than 1");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "malloc() does not align T");
+
+public:
+    using value_type             = T;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = T*;
+    using const_iterator         = const T*;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using growth_factor          = Growth;
+
+    //-----------------------------------------------------
+    // construction
+    //-----------------------------------------------------
+    reloc_vector() noexcept = default;
+
+    explicit reloc_vector(size_type count) { resize(count); }
+
+    reloc_vector(size_type count, const T& value) { resize(count, value); }
+
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    reloc_vector(InputIt first, InputIt last)
+    {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>)
+            reserve(size_type(std::distance(first, last)));
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    reloc_vector(std::initializer_list<T> init) : reloc_vector(init.begin(), init.end()) {}
+
+    reloc_vector(const reloc_vector& other) : reloc_vector(other.begin(), other.end()) {}
+
+    reloc_vector(reloc_vector&& other) noexcept
+        : storage_(std::move(other.storage_)), size_(std::exchange(other.size_, 0)) {}
+
+    ~reloc_vector() { destroyAll(); }
+
+    reloc_vector& operator=(const reloc_vector& other)
+    {
+        if (this != &other)
+            reloc_vector(other).swap(*this);
+        return *this;
+    }
+
+    reloc_vector& operator=(reloc_vector&& other) noexcept
+    {
+        reloc_vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    reloc_vector& operator=(std::initializer_list<T> init)
+    {
+        reloc_vector(init).swap(*this);
+        return *this;
+    }
+
+    //-----------------------------------------------------
+    // element access
+    //-----------------------------------------------------
+    reference at(size_type i)
+    {
+        if (i >= size_)
+            throw std::out_of_range("reloc_vector::at");
+        return data()[i];
+    }
+
+    const_reference at(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("reloc_vector::at");
+        return data()[i];
+    }
+
+    reference       operator[](size_type i)       noexcept { return data()[i]; }
+    const_reference operator[](size_type i) const noexcept { return data()[i]; }
+
+    reference       front()       noexcept { return data()[0]; }
+    const_reference front() const noexcept { return data()[0]; }
+    reference       back()        noexcept { return data()[size_ - 1]; }
+    const_reference back()  const noexcept { return data()[size_ - 1]; }
+
+    T*       data()       noexcept { return static_cast<T*>(storage_.data()); }
+    const T* data() const noexcept { return static_cast<const T*>(storage_.data()); }
+
+    //-----------------------------------------------------
+    // iterators
+    //-----------------------------------------------------
+    iterator       begin()        noexcept { return data(); }
+    const_iterator begin()  const noexcept { return data(); }
+    const_iterator cbegin() const noexcept { return data(); }
+    iterator       end()          noexcept { return data() + size_; }
+    const_iterator end()    const noexcept { return data() + size_; }
+    const_iterator cend()   const noexcept { return data() + size_; }
+
+    reverse_iterator       rbegin()        noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin()  const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator       rend()          noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend()    const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend()   const noexcept { return const_reverse_iterator(begin()); }
+
+    //-----------------------------------------------------
+    // capacity
+    //-----------------------------------------------------
+    bool      empty()    const noexcept { return size_ == 0; }
+    size_type size()     const noexcept { return size_; }
+    size_type capacity() const noexcept { return storage_.bytes() / sizeof(T); }
+    size_type max_size() const noexcept { return std::numeric_limits<difference_type>::max() / sizeof(T); }
+
+    // true once the buffer is its own mapping (grows with mremap/mprotect)
+    bool is_mapped() const noexcept
+    {
+        return storage_.kind() == detail::RelocStorage::Kind::Mapped || storage_.kind() == detail::RelocStorage::Kind::Reserved;
+    }
+
+    // number of elements the vector can grow to without moving (0: no reservation)
+    size_type reserved_capacity() const noexcept { return storage_.reserved() / sizeof(T); }
+
+    void reserve(size_type newCapacity)
+    {
+        if (newCapacity > capacity())
+            storage_.grow(size_ * sizeof(T), bytesFor(newCapacity));
+    }
+
+    // maps address space for `count` elements without committing it: up to
+    // that size the elements never move
+    void reserve_address_space(size_type count)
+    {
+        storage_.reserveAddressSpace(size_ * sizeof(T), bytesFor(count));
+    }
+
+    // heap: realloc() to size(); mapped: unmap / decommit the unused pages
+    void shrink_to_fit() noexcept { storage_.shrink(size_ * sizeof(T)); }
+
+    //-----------------------------------------------------
+    // modifiers
+    //-----------------------------------------------------
+    void clear() noexcept
+    {
+        destroyAll();
+        size_ = 0;
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value)      { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (size_ == capacity())
+            return *growAndEmplace(size_, std::forward<Args>(args)...);
+        T* slot = ::new (static_cast<void*>(data() + size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void pop_back() noexcept
+    {
+        --size_;
+        std::destroy_at(data() + size_);
+    }
+
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value)      { return emplace(pos, std::move(value)); }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        const size_type index = size_type(pos - data());
+        if (size_ == capacity())
+            return growAndEmplace(index, std::forward<Args>(args)...);
+
+        // args may refer to an element of this vector: build the value first,
+        // then relocate it into the gap
+        alignas(T) unsigned char value[sizeof(T)];
+        ::new (static_cast<void*>(value)) T(std::forward<Args>(args)...);
+        T* slot = data() + index;
+        std::memmove(static_cast<void*>(slot + 1), slot, (size_ - index) * sizeof(T));
+        std::memcpy(static_cast<void*>(slot), value, sizeof(T));
+        ++size_;
+        return slot;
+    }
+
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        // append, then rotate the new elements into place
+        const size_type index = size_type(pos - data());
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>)
+            reserve(size_ + size_type(std::distance(first, last)));
+        const size_type oldSize = size_;
+        for (; first != last; ++first)
+            emplace_back(*first);
+        std::rotate(data() + index, data() + oldSize, data() + size_);
+        return data() + index;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> init)
+    {
+        return insert(pos, init.begin(), init.end());
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        T* from = data() + (first - data());
+        T* to = data() + (last - data());
+        if (from != to) {
+            std::destroy(from, to);
+            std::memmove(static_cast<void*>(from), to, size_type(end() - to) * sizeof(T));
+            size_ -= size_type(to - from);
+        }
+        return from;
+    }
+
+    void resize(size_type count)
+    {
+        if (count <= size_) {
+            std::destroy(data() + count, end());
+            size_ = count;
+            return;
+        }
+        reserveForGrowth(count);
+        std::uninitialized_value_construct(end(), data() + count);
+        size_ = count;
+    }
+
+    void resize(size_type count, const T& value)
+    {
+        if (count <= size_) {
+            std::destroy(data() + count, end());
+            size_ = count;
+            return;
+        }
+        if (count > capacity()) {
+            const T copy(value);            // value may be one of our elements
+            reserveForGrowth(count);
+            std::uninitialized_fill(end(), data() + count, copy);
+        } else {
+            std::uninitialized_fill(end(), data() + count, value);
+        }
+        size_ = count;
+    }
+
+    void swap(reloc_vector& other) noexcept
+    {
+        storage_.swap(other.storage_);
+        std::swap(size_, other.size_);
+    }
+
+private:
+    void destroyAll() noexcept { std::destroy(begin(), end()); }
+
+    size_type bytesFor(size_type count) const
+    {
+        if (count > max_size())
+            throw std::length_error("reloc_vector");
+        return count * sizeof(T);
+    }
+
+    size_type grownCapacity(size_type required) const
+    {
+        const size_type current = capacity();
+        const size_type grown = current > max_size() / Growth::num ? max_size() : current * Growth::num / Growth::den;
+        return std::max({ required, grown, current + 1 });
+    }
+
+    // geometric growth for resize(), so that resize(size() + 1) in a loop
+    // is amortised O(1) like push_back()
+    void reserveForGrowth(size_type count)
+    {
+        if (count > capacity())
+            reserve(grownCapacity(count));
+    }
+
+    // the new element is built before the buffer moves, so args may still
+    // refer to the old elements; then it is relocated into place
+    template <typename... Args>
+    T* growAndEmplace(size_type index, Args&&... args)
+    {
+        alignas(T) unsigned char value[sizeof(T)];
+        T* built = ::new (static_cast<void*>(value)) T(std::forward<Args>(args)...);
+        try {
+            reserve(grownCapacity(size_ + 1));
+        } catch (...) {
+            std::destroy_at(built);
+            throw;
+        }
+        T* slot = data() + index;
+        std::memmove(static_cast<void*>(slot + 1), slot, (size_ - index) * sizeof(T));
+        std::memcpy(static_cast<void*>(slot), value, sizeof(T));
+        ++size_;
+        return slot;
+    }
+
+    detail::RelocStorage storage_;
+    size_type            size_ = 0;
+};
+
+//-----------------------------------------------------
+// comparison
+//-----------------------------------------------------
+template <typename T, typename G>
+bool operator==(const reloc_vector<T, G>& a, const reloc_vector<T, G>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, typename G>
+bool operator!=(const reloc_vector<T, G>& a, const reloc_vector<T, G>& b) { return !(a == b); }
+
+template <typename T, typename G>
+bool operator<(const reloc_vector<T, G>& a, const reloc_vector<T, G>& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template <typename T, typename G>
+void swap(reloc_vector<T, G>& a, reloc_vector<T, G>& b) noexcept
+{
+    a.swap(b);
+}
+
+} // namespace ali
@@ -0,0 +1,277 @@
+/*
+
+    -----------------------
+    Small Vector
+    -----------------------
+    1.  Up to N elements stay inline, the (N+1)-th spills to the heap, and
+        shrink_to_fit() brings them back.
+    2.  Copy, move and swap for every combination of inline and heap
+        vectors; a heap buffer is stolen, inline elements are moved one by
+        one, the moved-from vector is empty.
+    3.  push_back / insert of an element of the vector itself, also when it
+        makes the vector grow.
+    4.  Strong exception guarantee: a copy that throws during growth leaves
+        the vector as it was.
+    5.  100000 random operations against std::vector.
+    6.  resize(size() + 1) and insert(end(), 1, x) in a loop grow the
+        capacity geometrically, like push_back (amortised O(1)).
+    7.  Every constructed element is destroyed (no leaks, no double
+        destruction).
+
+    Usage:
+        ./main
+
+*/
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "small_vector.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+struct Point2D
+{
+    float x,y;
+};
+
+// counts the live objects; the copy constructor throws on request and the
+// move constructor is not noexcept, so growth has to copy
+struct Tracked
+{
+    static inline int live = 0;
+    static inline int copiesUntilThrow = -1;        // -1: never
+
+    int value;
+
+    Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value)
+    {
+        if (copiesUntilThrow == 0)
+            throw std::runtime_error("copy");
+        if (copiesUntilThrow > 0)
+            --copiesUntilThrow;
+        ++live;
+    }
+    Tracked(Tracked&& other) : value(other.value) { other.value = -1; ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&& other) { value = other.value; other.value = -1; return *this; }
+    ~Tracked() { --live; }
+
+    bool operator==(const Tracked& other) const { return value == other.value; }
+};
+
+template <typename V>
+static std::vector<int> values(const V& v)
+{
+    std::vector<int> out;
+    for (const auto& x : v)
+        out.push_back(int(x.value));
+    return out;
+}
+
+template <std::size_t N>
+static ali::small_vector<Tracked, N> make(int count, int first = 0)
+{
+    ali::small_vector<Tracked, N> v;
+    for (int i = 0; i < count; ++i)
+        v.emplace_back(first + i);
+    return v;
+}
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkInlineAndSpill()
+{
+    ali::small_vector<Point2D, 4> points { {1,1}, {2,2}, {3,3}, {4,4} };
+    report(points.is_inline() && points.size() == 4 && points.capacity() == 4, "4 points stay inline");
+    report(sizeof(points) >= 4 * sizeof(Point2D), "the inline buffer is part of the object");
+
+    points.push_back({5,5});
+    bool ok = !points.is_inline() && points.size() == 5 && points.capacity() == 8;
+    for (int i = 0; i < 5; ++i)
+        ok = ok && points[i].x == float(i + 1);
+    report(ok, "the 5th point spills to the heap, capacity doubles");
+
+    points.pop_back();
+    points.shrink_to_fit();
+    report(points.is_inline() && points.size() == 4 && points.back().y == 4, "shrink_to_fit() moves back inline");
+
+    ali::small_vector<int, 8> v(3, 7);
+    v.resize(6);
+    v.insert(v.begin() + 1, { 1, 2 });
+    v.erase(v.begin() + 4, v.begin() + 6);
+    report((std::vector<int>(v.begin(), v.end()) == std::vector<int> { 7, 1, 2, 7, 0, 0 }), "resize, insert list, erase range");
+    report(v.at(0) == 7 && [&] { try { v.at(6); return false; } catch (const std::out_of_range&) { return true; } }(),
+           "at() throws out_of_range");
+}
+
+static void checkMoves()
+{
+    // heap -> steal
+    auto heap = make<4>(10);
+    const Tracked* buffer = heap.data();
+    ali::small_vector<Tracked, 4> stolen(std::move(heap));
+    report(stolen.data() == buffer && heap.empty() && heap.is_inline() && values(stolen) == values(make<4>(10)),
+           "move construct from heap steals the buffer");
+
+    // inline -> elementwise
+    auto small = make<4>(3);
+    ali::small_vector<Tracked, 4> moved(std::move(small));
+    report(moved.is_inline() && small.empty() && values(moved) == std::vector<int> { 0, 1, 2 },
+           "move construct from inline moves the elements");
+
+    // move assignment: all four combinations
+    bool ok = true;
+    for (int from : { 2, 9 })
+        for (int to : { 3, 12 }) {
+            auto a = make<4>(from, 100), b = make<4>(to, 200);
+            const Tracked* source = a.data();
+            b = std::move(a);
+            ok = ok && a.empty() && a.is_inline() && values(b) == values(make<4>(from, 100));
+            ok = ok && (from <= 4 || b.data() == source);
+        }
+    report(ok, "move assignment inline/heap x inline/heap");
+
+    ok = true;
+    for (int x : { 2, 9 })
+        for (int y : { 3, 12 }) {
+            auto a = make<4>(x, 100), b = make<4>(y, 200);
+            a.swap(b);
+            ok = ok && values(a) == values(make<4>(y, 200)) && values(b) == values(make<4>(x, 100));
+            swap(a, b);
+            ok = ok && values(a) == values(make<4>(x, 100)) && values(b) == values(make<4>(y, 200));
+        }
+    report(ok, "swap inline/heap x inline/heap");
+
+    auto original = make<4>(6);
+    ali::small_vector<Tracked, 4> copy(original), assigned = make<4>(2);
+    assigned = original;
+    report(copy == original && assigned == original && values(original) == values(make<4>(6)), "copy construct and assign");
+}
+
+static void checkAliasing()
+{
+    auto v = make<4>(4);                    // full: the next push_back grows
+    v.push_back(v[0]);
+    v.insert(v.begin(), v[2]);
+    v.emplace(v.begin() + 3, v.back());
+    report((values(v) == std::vector<int> { 2, 0, 1, 0, 2, 3, 0 }), "push_back / insert of own elements");
+
+    ali::small_vector<std::string, 2> s { "a", "b" };
+    s.insert(s.begin() + 1, 3, s[0]);
+    report((s == ali::small_vector<std::string, 2> { "a", "a", "a", "a", "b" }), "insert(count, own element)");
+}
+
+static void checkExceptions()
+{
+    auto v = make<4>(4);
+    const auto before = values(v);
+    const Tracked* buffer = v.data();
+    Tracked::copiesUntilThrow = 2;          // the 3rd copy of the growth throws
+    bool threw = false;
+    try {
+        v.push_back(Tracked(99));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    Tracked::copiesUntilThrow = -1;
+    report(threw && values(v) == before && v.data() == buffer && v.is_inline(), "push_back that throws leaves the vector unchanged");
+
+    auto w = make<4>(8);
+    Tracked::copiesUntilThrow = 0;
+    threw = false;
+    try {
+        w.assign(20, Tracked(5));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    Tracked::copiesUntilThrow = -1;
+    report(threw && values(w) == values(make<4>(8)), "assign that throws while growing leaves the vector unchanged");
+}
+
+static void checkAgainstStd()
+{
+    std::mt19937 rng(7);
+    ali::small_vector<Tracked, 8> ours;
+    std::vector<Tracked> theirs;
+    bool ok = true;
+    for (int i = 0; i < 100000 && ok; ++i) {
+        const int value = int(rng() % 1000);
+        const std::size_t at = theirs.empty() ? 0 : rng() % (theirs.size() + 1);
+        switch (rng() % 10) {
+        case 0: case 1: case 2:
+            ours.push_back(value); theirs.push_back(value); break;
+        case 3:
+            ours.insert(ours.begin() + at, value); theirs.insert(theirs.begin() + at, value); break;
+        case 4:
+            if (at < theirs.size()) { ours.erase(ours.begin() + at); theirs.erase(theirs.begin() + at); }
+            break;
+        case 5:
+            if (!theirs.empty()) { ours.pop_back(); theirs.pop_back(); }
+            break;
+        case 6:
+            ours.resize(at / 2); theirs.resize(at / 2); break;
+        case 7:
+            ours.shrink_to_fit(); break;
+        case 8: {
+            auto copy = ours;
+            ours = std::move(copy);
+            break;
+        }
+        default:
+            if (rng() % 50 == 0) { ours.clear(); theirs.clear(); }
+        }
+        ok = values(ours) == values(theirs);
+    }
+    report(ok, "100000 random operations give the same result as std::vector");
+}
+
+// capacity changes while growing one element at a time through f
+template <typename F>
+static int reallocations(F f)
+{
+    ali::small_vector<int, 8> v;
+    int count = 0;
+    for (int i = 0; i < 50000; ++i) {
+        const std::size_t before = v.capacity();
+        f(v);
+        count += v.capacity() != before;
+    }
+    return v.size() == 50000 ? count : -1;
+}
+
+static void checkGrowth()
+{
+    const int one[] = { 1 };
+    const int counts[] = {
+        reallocations([](auto& v) { v.resize(v.size() + 1); }),
+        reallocations([](auto& v) { v.resize(v.size() + 1, 2); }),
+        reallocations([](auto& v) { v.insert(v.end(), 1, 3); }),
+        reallocations([&](auto& v) { v.insert(v.end(), std::begin(one), std::end(one)); }),
+    };
+    bool ok = true;
+    for (int c : counts)
+        ok = ok && c >= 0 && c <= 16;           // 8 -> 16 -> ... -> 65536: 13
+    report(ok, "50000 x resize(size() + 1) / insert(end(), 1, x): " + std::to_string(counts[0]) + ", "
+                   + std::to_string(counts[1]) + ", " + std::to_string(counts[2]) + ", " + std::to_string(counts[3])
+                   + " reallocations");
+}
+
+int main()
+{
+    checkInlineAndSpill();
+    checkMoves();
+    checkAliasing();
+    checkExceptions();
+    checkAgainstStd();
+    checkGrowth();
+    report(Tracked::live == 0, "every element destroyed exactly once");
+
+    return ali::check::finish();
+}
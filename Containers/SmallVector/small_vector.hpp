@@ -0,0 +1,546 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+    -----------------------
+    Small Vector
+    -----------------------
+    std::vector always puts its elements on the heap: even
+
+        std::vector<Point2D> points { {1,1}, {2,2}, {3,3}, {4,4} };
+
+    costs a malloc() and a free(). small_vector<T, N> keeps the first N
+    elements inside the object itself and only goes to the heap ("spills")
+    when the (N+1)-th element is added:
+
+        small_vector<Point2D, 8> points;        // no allocation up to 8 points
+
+        inline:     [ data_ | size_ | capacity_ = N | e0 e1 e2 .. eN-1 ]
+                      |_______________________________^
+
+        on heap:    [ data_ | size_ | capacity_     | (unused)         ]
+                      |________________________________________ -> [ e0 e1 ... ]
+
+    Once on the heap it behaves exactly like std::vector (capacity doubles);
+    shrink_to_fit() moves the elements back inside when they fit again.
+
+    The API is the one of std::vector (without the allocator), so it can
+    replace it. The differences come from the inline buffer:
+
+    -   sizeof(small_vector<T, N>) is about N * sizeof(T) + 3 words: keep N
+        small, and don't put big ones on the stack in recursive code.
+
+    -   move construction / move assignment / swap from an inline vector
+        cannot steal a pointer: the elements are moved one by one, O(size()),
+        and iterators into the source are invalidated. From a heap vector the
+        buffer is stolen in O(1), like std::vector. A moved-from vector is
+        always empty (and inline).
+
+    -   push_back()/insert() keep the strong exception guarantee: on growth
+        the elements are moved when T's move constructor is noexcept and
+        copied otherwise (std::move_if_noexcept), like std::vector.
+*/
+
+namespace ali {
+
+template <typename T, std::size_t N>
+class small_vector
+{
+    static_assert(N > 0, "small_vector<T, 0> is a std::vector");
+
+public:
+    using value_type             = T;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = T*;
+    using const_iterator         = const T*;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr size_type inline_capacity() noexcept { return N; }
+
+    //-----------------------------------------------------
+    // construction
+    //-----------------------------------------------------
+    small_vector() noexcept : data_(inlineData()) {}
+
+    explicit small_vector(size_type count) : small_vector()
+    {
+        resize(count);
+    }
+
+    small_vector(size_type count, const T& value) : small_vector()
+    {
+        assign(count, value);
+    }
+
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    small_vector(InputIt first, InputIt last) : small_vector()
+    {
+        assign(first, last);
+    }
+
+    small_vector(std::initializer_list<T> init) : small_vector()
+    {
+        assign(init.begin(), init.end());
+    }
+
+    small_vector(const small_vector& other) : small_vector()
+    {
+        assign(other.begin(), other.end());
+    }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : small_vector()
+    {
+        takeFrom(other);
+    }
+
+    ~small_vector()
+    {
+        destroyAll();
+        release();
+    }
+
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this != &other) {
+            clear();
+            if (!other.isInline()) {
+                // our own heap buffer would only be kept for nothing
+                release();
+                data_ = inlineData();
+                capacity_ = N;
+            }
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<T> init)
+    {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& value)
+    {
+        if (count > capacity_) {
+            small_vector fresh;
+            fresh.reallocate(count);
+            std::uninitialized_fill_n(fresh.data_, count, value);
+            fresh.size_ = count;
+            swap(fresh);
+            return;
+        }
+        std::fill_n(data_, std::min(count, size_), value);
+        if (count > size_)
+            std::uninitialized_fill_n(data_ + size_, count - size_, value);
+        else
+            std::destroy(data_ + count, data_ + size_);
+        size_ = count;
+    }
+
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    void assign(InputIt first, InputIt last)
+    {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            const auto count = size_type(std::distance(first, last));
+            if (count > capacity_) {
+                small_vector fresh;
+                fresh.reallocate(count);
+                std::uninitialized_copy(first, last, fresh.data_);
+                fresh.size_ = count;
+                swap(fresh);
+                return;
+            }
+            // assign over the live elements, construct the rest
+            T* out = data_;
+            for (; out != data_ + size_ && first != last; ++out, ++first)
+                *out = *first;
+            if (first != last)
+                std::uninitialized_copy(first, last, out);
+            else
+                std::destroy(out, data_ + size_);
+            size_ = count;
+        } else {
+            clear();
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+    }
+
+    void assign(std::initializer_list<T> init) { assign(init.begin(), init.end()); }
+
+    //-----------------------------------------------------
+    // element access
+    //-----------------------------------------------------
+    reference at(size_type i)
+    {
+        if (i >= size_)
+            throw std::out_of_range("small_vector::at");
+        return data_[i];
+    }
+
+    const_reference at(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("small_vector::at");
+        return data_[i];
+    }
+
+    reference       operator[](size_type i)       noexcept { return data_[i]; }
+    const_reference operator[](size_type i) const noexcept { return data_[i]; }
+
+    reference       front()       noexcept { return data_[0]; }
+    const_reference front() const noexcept { return data_[0]; }
+    reference       back()        noexcept { return data_[size_ - 1]; }
+    const_reference back()  const noexcept { return data_[size_ - 1]; }
+
+    T*       data()       noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+
+    //-----------------------------------------------------
+    // iterators
+    //-----------------------------------------------------
+    iterator       begin()        noexcept { return data_; }
+    const_iterator begin()  const noexcept { return data_; }
+    const_iterator cbegin() const noexcept { return data_; }
+    iterator       end()          noexcept { return data_ + size_; }
+    const_iterator end()    const noexcept { return data_ + size_; }
+    const_iterator cend()   const noexcept { return data_ + size_; }
+
+    reverse_iterator       rbegin()        noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin()  const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator       rend()          noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend()    const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend()   const noexcept { return const_reverse_iterator(begin()); }
+
+    //-----------------------------------------------------
+    // capacity
+    //-----------------------------------------------------
+    bool      empty()    const noexcept { return size_ == 0; }
+    size_type size()     const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    size_type max_size() const noexcept { return std::numeric_limits<difference_type>::max() / sizeof(T); }
+
+    // true while the elements live inside the object
+    bool is_inline() const noexcept { return isInline(); }
+
+    void reserve(size_type newCapacity)
+    {
+        if (newCapacity > capacity_)
+            reallocate(newCapacity);
+    }
+
+    void shrink_to_fit()
+    {
+        if (!isInline() && size_ < capacity_)
+            reallocate(size_);
+    }
+
+    //-----------------------------------------------------
+    // modifiers
+    //-----------------------------------------------------
+    void clear() noexcept
+    {
+        destroyAll();
+        size_ = 0;
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value)      { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_)
+            return *growAndEmplace(size_, std::forward<Args>(args)...);
+        T* slot = ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void pop_back() noexcept
+    {
+        --size_;
+        std::destroy_at(data_ + size_);
+    }
+
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value)      { return emplace(pos, std::move(value)); }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        const size_type index = size_type(pos - data_);
+        if (index == size_) {
+            emplace_back(std::forward<Args>(args)...);
+            return data_ + index;
+        }
+        if (size_ == capacity_)
+            return growAndEmplace(index, std::forward<Args>(args)...);
+
+        // args may refer to an element of this vector: build the value first
+        T value(std::forward<Args>(args)...);
+        ::new (static_cast<void*>(data_ + size_)) T(std::move(data_[size_ - 1]));
+        ++size_;
+        std::move_backward(data_ + index, data_ + size_ - 2, data_ + size_ - 1);
+        data_[index] = std::move(value);
+        return data_ + index;
+    }
+
+    iterator insert(const_iterator pos, size_type count, const T& value)
+    {
+        const size_type index = size_type(pos - data_);
+        const T copy(value);                // value may be one of our elements
+        reserveForGrowth(size_ + count);
+        const size_type oldSize = size_;
+        for (size_type i = 0; i < count; ++i)
+            emplace_back(copy);
+        std::rotate(data_ + index, data_ + oldSize, data_ + size_);
+        return data_ + index;
+    }
+
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        // append, then rotate the new elements into place
+        const size_type index = size_type(pos - data_);
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>)
+            reserveForGrowth(size_ + size_type(std::distance(first, last)));
+        const size_type oldSize = size_;
+        for (; first != last; ++first)
+            emplace_back(*first);
+        std::rotate(data_ + index, data_ + oldSize, data_ + size_);
+        return data_ + index;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> init)
+    {
+        return insert(pos, init.begin(), init.end());
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        T* from = data_ + (first - data_);
+        if (first != last) {
+            T* newEnd = std::move(data_ + (last - data_), data_ + size_, from);
+            std::destroy(newEnd, data_ + size_);
+            size_ = size_type(newEnd - data_);
+        }
+        return from;
+    }
+
+    void resize(size_type count)
+    {
+        if (count < size_) {
+            std::destroy(data_ + count, data_ + size_);
+            size_ = count;
+            return;
+        }
+        reserveForGrowth(count);
+        std::uninitialized_value_construct(data_ + size_, data_ + count);
+        size_ = count;
+    }
+
+    void resize(size_type count, const T& value)
+    {
+        if (count < size_) {
+            std::destroy(data_ + count, data_ + size_);
+            size_ = count;
+            return;
+        }
+        insert(end(), count - size_, value);
+    }
+
+    void swap(small_vector& other) noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_swappable_v<T>)
+    {
+        if (this == &other)
+            return;
+        if (!isInline() && !other.isInline()) {
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+            return;
+        }
+        // at least one side is inline: elements have to move
+        small_vector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+private:
+    T*       inlineData()       noexcept { return std::launder(reinterpret_cast<T*>(inline_)); }
+    const T* inlineData() const noexcept { return std::launder(reinterpret_cast<const T*>(inline_)); }
+    bool     isInline()   const noexcept { return data_ == inlineData(); }
+
+    static T* allocate(size_type n)       { return std::allocator<T>().allocate(n); }
+    static void deallocate(T* p, size_type n) { std::allocator<T>().deallocate(p, n); }
+
+    void destroyAll() noexcept { std::destroy(data_, data_ + size_); }
+
+    // frees the heap buffer (if any); elements must be destroyed or moved out
+    void release() noexcept
+    {
+        if (!isInline())
+            deallocate(data_, capacity_);
+    }
+
+    size_type grownCapacity(size_type required) const
+    {
+        if (required > max_size())
+            throw std::length_error("small_vector");
+        return std::max(required, capacity_ > max_size() / 2 ? max_size() : 2 * capacity_);
+    }
+
+    // geometric growth for insert() and resize(), so that resize(size() + 1)
+    // in a loop is amortised O(1) like push_back()
+    void reserveForGrowth(size_type count)
+    {
+        if (count > capacity_)
+            reserve(grownCapacity(count));
+    }
+
+    // construct [from, from + count) moved (or copied, if moving may throw) into `to`
+    static void relocate(T* from, size_type count, T* to)
+    {
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+            std::uninitialized_move(from, from + count, to);
+        else
+            std::uninitialized_copy(from, from + count, to);
+    }
+
+    // moves the elements to a buffer of exactly `newCapacity` (>= size_):
+    // back inside if it fits, to the heap otherwise
+    void reallocate(size_type newCapacity)
+    {
+        const bool toInline = newCapacity <= N;
+        if (toInline && isInline())
+            return;
+        T* buffer = toInline ? inlineData() : allocate(newCapacity);
+        try {
+            relocate(data_, size_, buffer);
+        } catch (...) {
+            if (!toInline)
+                deallocate(buffer, newCapacity);
+            throw;
+        }
+        destroyAll();
+        release();
+        data_ = buffer;
+        capacity_ = toInline ? N : newCapacity;
+    }
+
+    // emplace at `index` into a new, bigger buffer: the new element is built
+    // first, so args may still refer to the old elements
+    template <typename... Args>
+    T* growAndEmplace(size_type index, Args&&... args)
+    {
+        const size_type newCapacity = grownCapacity(size_ + 1);
+        T* buffer = allocate(newCapacity);
+        T* slot = buffer + index;
+        size_type built = 0;            // 0: nothing, 1: new element, 2: + prefix
+        try {
+            ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+            built = 1;
+            relocate(data_, index, buffer);
+            built = 2;
+            relocate(data_ + index, size_ - index, slot + 1);
+        } catch (...) {
+            if (built >= 1) std::destroy_at(slot);
+            if (built >= 2) std::destroy(buffer, buffer + index);
+            deallocate(buffer, newCapacity);
+            throw;
+        }
+        destroyAll();
+        release();
+        data_ = buffer;
+        capacity_ = newCapacity;
+        ++size_;
+        return slot;
+    }
+
+    // `other` is empty afterwards; `this` must be empty with its buffer
+    // inline or big enough for an inline `other`
+    void takeFrom(small_vector& other)
+    {
+        if (!other.isInline()) {
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inlineData();
+            other.size_ = 0;
+            other.capacity_ = N;
+            return;
+        }
+        std::uninitialized_move(other.data_, other.data_ + other.size_, data_);
+        size_ = other.size_;
+        other.clear();
+    }
+
+    T*          data_;
+    size_type   size_ = 0;
+    size_type   capacity_ = N;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+};
+
+//-----------------------------------------------------
+// comparison
+//-----------------------------------------------------
+template <typename T, std::size_t N>
+bool operator==(const small_vector<T, N>& a, const small_vector<T, N>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, std::size_t N>
+bool operator!=(const small_vector<T, N>& a, const small_vector<T, N>& b) { return !(a == b); }
+
+template <typename T, std::size_t N>
+bool operator<(const small_vector<T, N>& a, const small_vector<T, N>& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template <typename T, std::size_t N>
+bool operator>(const small_vector<T, N>& a, const small_vector<T, N>& b) { return b < a; }
+
+template <typename T, std::size_t N>
+bool operator<=(const small_vector<T, N>& a, const small_vector<T, N>& b) { return !(b < a); }
+
+template <typename T, std::size_t N>
+bool operator>=(const small_vector<T, N>& a, const small_vector<T, N>& b) { return !(a < b); }
+
+template <typename T, std::size_t N>
+void swap(small_vector<T, N>& a, small_vector<T, N>& b) noexcept(noexcept(a.swap(b)))
+{
+    a.swap(b);
+}
+
+} // namespace ali
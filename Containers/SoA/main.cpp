@@ -0,0 +1,230 @@
+/*
+
+    -----------------------
+    Structure of Arrays
+    -----------------------
+    1.  push_back / emplace_back scatter the fields into the columns; every
+        column is 64-byte aligned and contiguous.
+    2.  The proxy reference: read, write, structured bindings, assignment
+        between records, conversion to std::tuple.
+    3.  The iterators with std::sort, std::find_if, std::reverse.
+    4.  A column kernel and the same kernel through the proxies agree with
+        std::vector<Point2D>.
+    5.  Growth, copy, move, erase, resize with a non-trivial field
+        (std::string), without leaks.
+    6.  Appending a record of the vector itself at full capacity: the new
+        record is built before the old columns are freed.
+    7.  pop_back down to empty destroys every field, the last one too.
+
+    Usage:
+        ./main
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "soa_vector.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+struct Point2D
+{
+    float x,y;
+};
+
+using Points = ali::soa_vector<float, float>;
+
+static bool aligned(const void* p)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % Points::alignment == 0;
+}
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkColumns()
+{
+    Points points;
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 2)
+            points.emplace_back(float(i), float(-i));
+        else
+            points.push_back({ float(i), float(-i) });
+    }
+    auto xs = points.column<0>();
+    auto ys = points.column<1>();
+    bool ok = xs.size() == 1000 && ys.size() == 1000;
+    for (int i = 0; i < 1000; ++i)
+        ok = ok && xs[i] == float(i) && ys[i] == float(-i);
+    report(ok, "push_back / emplace_back scatter into the columns");
+    report(aligned(points.data<0>()) && aligned(points.data<1>()), "columns are 64-byte aligned");
+}
+
+static void checkProxy()
+{
+    Points points { { 1.f, 2.f }, { 3.f, 4.f }, { 5.f, 6.f } };
+
+    auto [x, y] = points[1];
+    x = 30.f;
+    y += 10.f;
+    report(points.column<0>()[1] == 30.f && points.column<1>()[1] == 14.f, "structured bindings refer to the fields");
+
+    for (auto [px, py] : points)
+        px += py;
+    report(points[0].get<0>() == 3.f && points[2].get<0>() == 11.f, "range-for with structured bindings writes through");
+
+    points[0] = points[2];
+    report(points[0] == std::tuple<float, float>(11.f, 6.f), "assigning a record copies the fields, not the proxy");
+
+    std::tuple<float, float> copy = points[1];
+    points[1].get<0>() = 0.f;
+    report(std::get<0>(copy) == 44.f && points[1].get<0>() == 0.f, "converting to value_type copies the record");
+
+    const Points& constant = points;
+    auto [cx, cy] = constant.back();
+    static_assert(std::is_same_v<decltype(cx), const float&>);
+    report(cx == 11.f && cy == 6.f, "const proxies");
+
+    try {
+        points.at(3);
+        report(false, "at() throws out_of_range");
+    } catch (const std::out_of_range&) {
+        report(true, "at() throws out_of_range");
+    }
+}
+
+static void checkAlgorithms()
+{
+    std::mt19937 rng(3);
+    Points points;
+    std::vector<Point2D> reference;
+    for (int i = 0; i < 5000; ++i) {
+        const float x = float(rng() % 1000), y = float(i);
+        points.emplace_back(x, y);
+        reference.push_back({ x, y });
+    }
+
+    std::sort(points.begin(), points.end());
+    std::sort(reference.begin(), reference.end(), [](const Point2D& a, const Point2D& b) {
+        return std::tie(a.x, a.y) < std::tie(b.x, b.y);
+    });
+    bool ok = true;
+    for (std::size_t i = 0; i < reference.size(); ++i)
+        ok = ok && points[i] == std::tuple<float, float>(reference[i].x, reference[i].y);
+    report(ok, "std::sort over the proxies (y follows x)");
+
+    const auto found = std::find_if(points.begin(), points.end(), [](auto p) { return p.template get<1>() == 42.f; });
+    report(found != points.end() && (*found).get<1>() == 42.f, "std::find_if");
+
+    std::reverse(points.begin(), points.end());
+    report(points.front() == std::tuple<float, float>(reference.back().x, reference.back().y), "std::reverse");
+}
+
+static void checkKernels()
+{
+    Points points;
+    std::vector<Point2D> aos;
+    for (int i = 0; i < 4096; ++i) {
+        points.emplace_back(float(i % 17), float(i % 23));
+        aos.push_back({ float(i % 17), float(i % 23) });
+    }
+
+    // distance to the origin: columns, proxies, AoS
+    std::vector<float> bySpan(points.size()), byProxy(points.size()), byAos(aos.size());
+    const float* xs = points.data<0>();
+    const float* ys = points.data<1>();
+    for (std::size_t i = 0; i < points.size(); ++i)
+        bySpan[i] = std::sqrt(xs[i] * xs[i] + ys[i] * ys[i]);
+    std::size_t i = 0;
+    for (auto [x, y] : points)
+        byProxy[i++] = std::sqrt(x * x + y * y);
+    for (std::size_t k = 0; k < aos.size(); ++k)
+        byAos[k] = std::sqrt(aos[k].x * aos[k].x + aos[k].y * aos[k].y);
+    report(bySpan == byAos && byProxy == byAos, "distance kernel: columns = proxies = AoS");
+}
+
+static void checkLifetime()
+{
+    ali::soa_vector<int, std::string> v;
+    for (int i = 0; i < 100; ++i)
+        v.emplace_back(i, std::string(40, char('a' + i % 26)));          // not in the small string buffer
+    ali::soa_vector<int, std::string> copy = v;
+    v.erase(v.begin() + 10);
+    v.pop_back();
+    v.resize(50);
+    v.resize(60);
+    bool ok = v.size() == 60 && v[9].get<0>() == 9 && v[10].get<0>() == 11 && v[49].get<1>() == std::string(40, char('a' + 50 % 26))
+           && v[55].get<1>().empty() && copy.size() == 100 && copy[10].get<0>() == 10;
+    report(ok, "erase, pop_back, resize, copy with std::string fields");
+
+    ali::soa_vector<int, std::string> moved = std::move(copy);
+    report(copy.empty() && moved.size() == 100 && moved.back().get<1>().size() == 40, "move steals the columns");
+    v = moved;
+    v.push_back(moved[0]);
+    report(v.size() == 101 && v.back().get<1>() == moved.front().get<1>(), "copy assignment, push_back of a proxy");
+}
+
+static void checkSelfAppend()
+{
+    ali::soa_vector<int, std::string> v;
+    for (int i = 0; i < 16; ++i)
+        v.emplace_back(i, std::string(40, char('a' + i)));
+    const bool full = v.size() == v.capacity();
+    v.push_back(v[3]);                                  // proxy into the columns being replaced
+    v.emplace_back(v[4].get<0>(), v[4].get<1>());       // the fields themselves
+    v.push_back(v.back());
+    report(full && v.size() == 19 && v[16].get<0>() == 3 && v[16].get<1>() == std::string(40, 'd')
+               && v[17].get<1>() == std::string(40, 'e') && v[18].get<0>() == 4,
+           "push_back(v[3]) / emplace_back(v[4] fields) at full capacity");
+}
+
+// counts the live objects
+struct Counted
+{
+    static inline int live = 0;
+
+    Counted() { ++live; }
+    Counted(const Counted&) { ++live; }
+    Counted(Counted&&) noexcept { ++live; }
+    Counted& operator=(const Counted&) = default;
+    Counted& operator=(Counted&&) noexcept = default;
+    ~Counted() { --live; }
+};
+
+static void checkPopToEmpty()
+{
+    {
+        ali::soa_vector<int, Counted> v;
+        for (int i = 0; i < 5; ++i)
+            v.emplace_back(i, Counted());
+        const int afterPush = Counted::live;
+        while (!v.empty())
+            v.pop_back();
+        report(afterPush == 5 && Counted::live == 0, "pop_back down to empty destroys all 5 fields, the last one too");
+
+        v.emplace_back(1, Counted());
+        v.resize(0);
+        report(Counted::live == 0, "resize(0) of one record destroys it");
+    }
+    report(Counted::live == 0, "nothing left after the destructor");
+}
+
+int main()
+{
+    checkColumns();
+    checkProxy();
+    checkAlgorithms();
+    checkKernels();
+    checkLifetime();
+    checkSelfAppend();
+    checkPopToEmpty();
+
+    return ali::check::finish();
+}
@@ -0,0 +1,565 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/*
+    -----------------------
+    Structure of Arrays
+    -----------------------
+    std::vector<Point2D> stores the records one after the other ("array of
+    structures", AoS):
+
+        x0 y0 x1 y1 x2 y2 x3 y3 ...
+
+    A kernel that only reads x still loads every y: half of each cache line
+    is wasted, and the compiler needs shuffles to put 8 x's into one AVX
+    register. soa_vector<float, float> keeps every field in its own array
+    ("structure of arrays", SoA), each aligned to a cache line:
+
+        column<0>:  x0 x1 x2 x3 ...
+        column<1>:  y0 y1 y2 y3 ...
+
+    Three ways to use it:
+
+    -   like a vector of records: push_back / emplace_back scatter the
+        fields into the columns, and operator[] / iterators give a proxy
+        reference that can be read, assigned and decomposed:
+
+            ali::soa_vector<float, float> points;
+            points.emplace_back(1.f, 2.f);
+            for (auto [x, y] : points)          // x and y are float&
+                x += y;
+
+    -   column spans for vectorised kernels: std::span<float> over one
+        field, contiguous and 64-byte aligned:
+
+            auto xs = points.column<0>();
+            for (float& x : xs) x *= 2;         // vectorises like float[]
+
+    -   data<I>() for raw pointers (with std::assume_aligned).
+
+    value_type is std::tuple<Fields...>. The proxy (soa_vector::reference)
+    is not a real reference: `auto p = points[0]` copies the proxy, not the
+    record, so writing through p changes the vector, and `value_type v =
+    points[0]` copies the record. Iterators are random access and work with
+    std::sort, std::find_if etc.; they are not C++20 contiguous iterators
+    (use the column spans for that).
+*/
+
+namespace ali {
+
+template <typename... Fields>
+class soa_vector;
+
+//-----------------------------------------------------
+// Proxy reference: base pointers of all columns + index
+//-----------------------------------------------------
+template <bool Const, typename... Fields>
+class soa_ref
+{
+    template <typename T>
+    using Qualified = std::conditional_t<Const, const T, T>;
+
+public:
+    using value_type = std::tuple<Fields...>;
+
+    soa_ref(std::tuple<Qualified<Fields>*...> base, std::size_t index) noexcept : base_(base), index_(index) {}
+
+    // a mutable reference converts to a const one
+    operator soa_ref<true, Fields...>() const noexcept
+    {
+        return { std::apply([](auto*... p) { return std::tuple<const Fields*...>(p...); }, base_), index_ };
+    }
+
+    template <std::size_t I>
+    auto& get() const noexcept { return std::get<I>(base_)[index_]; }
+
+    operator value_type() const
+    {
+        return std::apply([this](auto*... p) { return value_type(p[index_]...); }, base_);
+    }
+
+    // assignment writes the fields, it never rebinds the proxy
+    const soa_ref& operator=(const soa_ref& other) const requires (!Const)
+    {
+        assignFrom(other, std::index_sequence_for<Fields...>{});
+        return *this;
+    }
+
+    template <bool C>
+    const soa_ref& operator=(const soa_ref<C, Fields...>& other) const requires (!Const)
+    {
+        assignFrom(other, std::index_sequence_for<Fields...>{});
+        return *this;
+    }
+
+    const soa_ref& operator=(const value_type& value) const requires (!Const)
+    {
+        assignFrom(value, std::index_sequence_for<Fields...>{});
+        return *this;
+    }
+
+    const soa_ref& operator=(value_type&& value) const requires (!Const)
+    {
+        moveFrom(value, std::index_sequence_for<Fields...>{});
+        return *this;
+    }
+
+    friend void swap(const soa_ref& a, const soa_ref& b) requires (!Const)
+    {
+        swapWith(a, b, std::index_sequence_for<Fields...>{});
+    }
+
+    // compared like the tuples (std::sort, std::lower_bound ...)
+    friend bool operator==(const soa_ref& a, const soa_ref& b)    { return value_type(a) == value_type(b); }
+    friend bool operator==(const soa_ref& a, const value_type& b) { return value_type(a) == b; }
+    friend bool operator<(const soa_ref& a, const soa_ref& b)     { return value_type(a) < value_type(b); }
+    friend bool operator<(const soa_ref& a, const value_type& b)  { return value_type(a) < b; }
+    friend bool operator<(const value_type& a, const soa_ref& b)  { return a < value_type(b); }
+
+private:
+    // field I of a tuple or of another proxy
+    template <std::size_t I, typename Source>
+    static decltype(auto) field(const Source& source)
+    {
+        if constexpr (std::is_same_v<Source, value_type>)
+            return std::get<I>(source);
+        else
+            return source.template get<I>();
+    }
+
+    template <typename Source, std::size_t... I>
+    void assignFrom(const Source& source, std::index_sequence<I...>) const
+    {
+        ((get<I>() = field<I>(source)), ...);
+    }
+
+    template <std::size_t... I>
+    void moveFrom(value_type& source, std::index_sequence<I...>) const
+    {
+        ((get<I>() = std::move(std::get<I>(source))), ...);
+    }
+
+    template <std::size_t... I>
+    static void swapWith(const soa_ref& a, const soa_ref& b, std::index_sequence<I...>)
+    {
+        using std::swap;
+        (swap(a.template get<I>(), b.template get<I>()), ...);
+    }
+
+    std::tuple<Qualified<Fields>*...>   base_;
+    std::size_t                         index_;
+};
+
+//-----------------------------------------------------
+// Random access iterator over the proxies
+//-----------------------------------------------------
+template <bool Const, typename... Fields>
+class soa_iterator
+{
+    template <typename T>
+    using Qualified = std::conditional_t<Const, const T, T>;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = std::tuple<Fields...>;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = soa_ref<Const, Fields...>;
+    using pointer           = void;
+
+    soa_iterator() = default;
+    soa_iterator(std::tuple<Qualified<Fields>*...> base, difference_type index) noexcept : base_(base), index_(index) {}
+
+    operator soa_iterator<true, Fields...>() const noexcept
+    {
+        return { std::apply([](auto*... p) { return std::tuple<const Fields*...>(p...); }, base_), index_ };
+    }
+
+    reference operator*() const noexcept                     { return { base_, std::size_t(index_) }; }
+    reference operator[](difference_type n) const noexcept   { return { base_, std::size_t(index_ + n) }; }
+
+    soa_iterator& operator++() noexcept                  { ++index_; return *this; }
+    soa_iterator  operator++(int) noexcept               { auto old = *this; ++index_; return old; }
+    soa_iterator& operator--() noexcept                  { --index_; return *this; }
+    soa_iterator  operator--(int) noexcept               { auto old = *this; --index_; return old; }
+    soa_iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+    soa_iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+
+    friend soa_iterator operator+(soa_iterator it, difference_type n) noexcept    { return it += n; }
+    friend soa_iterator operator+(difference_type n, soa_iterator it) noexcept    { return it += n; }
+    friend soa_iterator operator-(soa_iterator it, difference_type n) noexcept    { return it -= n; }
+    friend difference_type operator-(const soa_iterator& a, const soa_iterator& b) noexcept { return a.index_ - b.index_; }
+
+    friend bool operator==(const soa_iterator& a, const soa_iterator& b) noexcept  { return a.index_ == b.index_; }
+    friend auto operator<=>(const soa_iterator& a, const soa_iterator& b) noexcept { return a.index_ <=> b.index_; }
+
+    difference_type index() const noexcept { return index_; }
+
+private:
+    std::tuple<Qualified<Fields>*...>   base_ {};
+    difference_type                     index_ = 0;
+};
+
+//-----------------------------------------------------
+// The container
+//-----------------------------------------------------
+template <typename... Fields>
+class soa_vector
+{
+    static_assert(sizeof...(Fields) > 0, "soa_vector needs at least one field");
+
+public:
+    using value_type      = std::tuple<Fields...>;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = soa_ref<false, Fields...>;
+    using const_reference = soa_ref<true, Fields...>;
+    using iterator        = soa_iterator<false, Fields...>;
+    using const_iterator  = soa_iterator<true, Fields...>;
+
+    template <std::size_t I>
+    using field_type = std::tuple_element_t<I, value_type>;
+
+    // every column starts on a cache line
+    static constexpr std::size_t alignment = 64;
+
+    soa_vector() = default;
+
+    explicit soa_vector(size_type count)
+    {
+        resize(count);
+    }
+
+    soa_vector(std::initializer_list<value_type> init)
+    {
+        reserve(init.size());
+        for (const auto& value : init)
+            push_back(value);
+    }
+
+    soa_vector(const soa_vector& other)
+    {
+        reserve(other.size_);
+        for (size_type i = 0; i < other.size_; ++i)
+            push_back(other[i]);
+    }
+
+    soa_vector(soa_vector&& other) noexcept
+        : columns_(std::exchange(other.columns_, {})),
+          size_(std::exchange(other.size_, 0)),
+          capacity_(std::exchange(other.capacity_, 0))
+    {
+    }
+
+    ~soa_vector()
+    {
+        clear();
+        deallocate(columns_);
+    }
+
+    soa_vector& operator=(const soa_vector& other)
+    {
+        if (this != &other) {
+            soa_vector copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    soa_vector& operator=(soa_vector&& other) noexcept
+    {
+        soa_vector moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    void swap(soa_vector& other) noexcept
+    {
+        std::swap(columns_, other.columns_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+    //-----------------------------------------------------
+    // columns
+    //-----------------------------------------------------
+    template <std::size_t I>
+    field_type<I>* data() noexcept { return std::assume_aligned<alignment>(std::get<I>(columns_)); }
+
+    template <std::size_t I>
+    const field_type<I>* data() const noexcept { return std::assume_aligned<alignment>(std::get<I>(columns_)); }
+
+    template <std::size_t I>
+    std::span<field_type<I>> column() noexcept { return { data<I>(), size_ }; }
+
+    template <std::size_t I>
+    std::span<const field_type<I>> column() const noexcept { return { data<I>(), size_ }; }
+
+    //-----------------------------------------------------
+    // records
+    //-----------------------------------------------------
+    reference       operator[](size_type i) noexcept       { return { columns_, i }; }
+    const_reference operator[](size_type i) const noexcept { return { constColumns(), i }; }
+
+    reference at(size_type i)
+    {
+        if (i >= size_)
+            throw std::out_of_range("soa_vector::at");
+        return (*this)[i];
+    }
+
+    const_reference at(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("soa_vector::at");
+        return (*this)[i];
+    }
+
+    reference       front() noexcept       { return (*this)[0]; }
+    const_reference front() const noexcept { return (*this)[0]; }
+    reference       back() noexcept        { return (*this)[size_ - 1]; }
+    const_reference back() const noexcept  { return (*this)[size_ - 1]; }
+
+    iterator       begin() noexcept        { return { columns_, 0 }; }
+    const_iterator begin() const noexcept  { return { constColumns(), 0 }; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator       end() noexcept          { return { columns_, difference_type(size_) }; }
+    const_iterator end() const noexcept    { return { constColumns(), difference_type(size_) }; }
+    const_iterator cend() const noexcept   { return end(); }
+
+    //-----------------------------------------------------
+    // capacity
+    //-----------------------------------------------------
+    bool      empty() const noexcept    { return size_ == 0; }
+    size_type size() const noexcept     { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+
+    void reserve(size_type newCapacity)
+    {
+        if (newCapacity > capacity_)
+            reallocate(newCapacity);
+    }
+
+    void shrink_to_fit()
+    {
+        if (size_ < capacity_)
+            reallocate(size_);
+    }
+
+    //-----------------------------------------------------
+    // modifiers
+    //-----------------------------------------------------
+    void clear() noexcept
+    {
+        destroyRange(0, size_, std::index_sequence_for<Fields...>{});
+        size_ = 0;
+    }
+
+    void push_back(const value_type& value)
+    {
+        std::apply([this](const auto&... f) { emplace_back(f...); }, value);
+    }
+
+    void push_back(value_type&& value)
+    {
+        std::apply([this](auto&... f) { emplace_back(std::move(f)...); }, value);
+    }
+
+    template <bool Const>
+    void push_back(const soa_ref<Const, Fields...>& value)
+    {
+        pushFrom(value, std::index_sequence_for<Fields...>{});
+    }
+
+    // one argument per field, scattered into the columns
+    template <typename... Args>
+        requires (sizeof...(Args) == sizeof...(Fields))
+    reference emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_)
+            growAndEmplace(std::forward<Args>(args)...);
+        else
+            constructAt(columns_, size_, std::index_sequence_for<Fields...>{}, std::forward<Args>(args)...);
+        return (*this)[size_++];
+    }
+
+    void pop_back() noexcept
+    {
+        --size_;
+        destroyRange(size_, size_ + 1, std::index_sequence_for<Fields...>{});
+    }
+
+    // the fields after pos are moved down, column by column
+    iterator erase(const_iterator pos)
+    {
+        const size_type i = size_type(pos.index());
+        eraseAt(i, std::index_sequence_for<Fields...>{});
+        --size_;
+        return { columns_, difference_type(i) };
+    }
+
+    void resize(size_type count)
+    {
+        if (count < size_) {
+            destroyRange(count, size_, std::index_sequence_for<Fields...>{});
+            size_ = count;
+            return;
+        }
+        reserve(count);
+        while (size_ < count)
+            emplace_back(Fields()...);
+    }
+
+private:
+    using Columns = std::tuple<Fields*...>;
+
+    std::tuple<const Fields*...> constColumns() const noexcept
+    {
+        return std::apply([](auto*... p) { return std::tuple<const Fields*...>(p...); }, columns_);
+    }
+
+    template <typename T>
+    static T* allocateColumn(size_type n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+    }
+
+    template <typename T>
+    static void deallocateColumn(T* p) noexcept
+    {
+        if (p)
+            ::operator delete(p, std::align_val_t(alignment));
+    }
+
+    static void deallocate(Columns& columns) noexcept
+    {
+        std::apply([](auto*... p) { (deallocateColumn(p), ...); }, columns);
+        columns = {};
+    }
+
+    // construct field I of record `at` from args[I]; on an exception the
+    // fields already built are destroyed again
+    template <std::size_t... I, typename... Args>
+    static void constructAt(Columns& columns, size_type at, std::index_sequence<I...>, Args&&... args)
+    {
+        std::size_t built = 0;
+        try {
+            ((::new (static_cast<void*>(std::get<I>(columns) + at)) Fields(std::forward<Args>(args)), ++built), ...);
+        } catch (...) {
+            ((I < built ? std::destroy_at(std::get<I>(columns) + at) : void()), ...);
+            throw;
+        }
+    }
+
+    // args may refer to our own fields (v.push_back(v[3])): build the new
+    // record in the new columns before the old ones are moved and freed
+    template <typename... Args>
+    void growAndEmplace(Args&&... args)
+    {
+        const size_type newCapacity = capacity_ ? 2 * capacity_ : 16;
+        Columns fresh = allocateAll(newCapacity);
+        try {
+            constructAt(fresh, size_, std::index_sequence_for<Fields...>{}, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(fresh);
+            throw;
+        }
+        adopt(fresh, newCapacity);
+    }
+
+    template <bool Const, std::size_t... I>
+    void pushFrom(const soa_ref<Const, Fields...>& value, std::index_sequence<I...>)
+    {
+        emplace_back(value.template get<I>()...);
+    }
+
+    template <std::size_t... I>
+    void destroyRange(size_type from, size_type to, std::index_sequence<I...>) noexcept
+    {
+        if (from == to)
+            return;                 // the columns may not be allocated yet
+        (std::destroy(std::get<I>(columns_) + from, std::get<I>(columns_) + to), ...);
+    }
+
+    template <std::size_t... I>
+    void eraseAt(size_type i, std::index_sequence<I...>)
+    {
+        ((std::move(std::get<I>(columns_) + i + 1, std::get<I>(columns_) + size_, std::get<I>(columns_) + i),
+          std::destroy_at(std::get<I>(columns_) + size_ - 1)), ...);
+    }
+
+    void reallocate(size_type newCapacity)
+    {
+        Columns fresh = allocateAll(newCapacity);
+        adopt(fresh, newCapacity);
+    }
+
+    static Columns allocateAll(size_type n)
+    {
+        Columns fresh {};
+        try {
+            allocateColumns(fresh, n, std::index_sequence_for<Fields...>{});
+        } catch (...) {
+            deallocate(fresh);
+            throw;
+        }
+        return fresh;
+    }
+
+    // moves the records into fresh and frees the old columns
+    void adopt(Columns& fresh, size_type newCapacity) noexcept
+    {
+        static_assert((std::is_nothrow_move_constructible_v<Fields> && ...),
+                      "soa_vector moves its fields when it grows: they must not throw");
+        moveColumns(fresh, std::index_sequence_for<Fields...>{});
+        deallocate(columns_);
+        columns_ = fresh;
+        capacity_ = newCapacity;
+    }
+
+    template <std::size_t... I>
+    static void allocateColumns(Columns& columns, size_type n, std::index_sequence<I...>)
+    {
+        ((std::get<I>(columns) = allocateColumn<Fields>(n)), ...);
+    }
+
+    template <std::size_t... I>
+    void moveColumns(Columns& to, std::index_sequence<I...>) noexcept
+    {
+        if (size_ == 0)
+            return;
+        ((std::uninitialized_move(std::get<I>(columns_), std::get<I>(columns_) + size_, std::get<I>(to)),
+          std::destroy(std::get<I>(columns_), std::get<I>(columns_) + size_)), ...);
+    }
+
+    Columns     columns_ {};
+    size_type   size_ = 0;
+    size_type   capacity_ = 0;
+};
+
+template <typename... Fields>
+void swap(soa_vector<Fields...>& a, soa_vector<Fields...>& b) noexcept
+{
+    a.swap(b);
+}
+
+} // namespace ali
+
+// structured bindings: auto [x, y] = points[i];
+template <bool Const, typename... Fields>
+struct std::tuple_size<ali::soa_ref<Const, Fields...>> : std::integral_constant<std::size_t, sizeof...(Fields)> {};
+
+template <std::size_t I, bool Const, typename... Fields>
+struct std::tuple_element<I, ali::soa_ref<Const, Fields...>>
+{
+    using type = std::conditional_t<Const, const std::tuple_element_t<I, std::tuple<Fields...>>,
+                                           std::tuple_element_t<I, std::tuple<Fields...>>>&;
+};
@@ -40,6 +40,11 @@
     at(i):              This is a safe way to access the elements as bounds checking will
                         be performed. This could throw an 'std::out_of_range' Exception.
 
+    A third way, for hot loops: Containers/Checked wraps the vector in a
+    checked_span whose operator[] aborts on a bad index (bounds::hardened),
+    checks only in debug builds (bounds::asserted) or not at all, chosen at
+    compile time; subspan()/first()/slice() check a whole range once.
+
 
 
     push_back vs emplace_back :   
@@ -125,6 +130,7 @@ int main(){
     */
 
     // we need to see how objects are copied or moved when using emplace_back vs push_back. 
+    // (CMake-Tuts/HelloBenchmark/src/counted.hpp is S for benchmarks: it counts instead of printing)
     struct S{
         // a simple class which does'nt have any "move-able data".
 
@@ -61,8 +61,10 @@ To resolve this problem we can use a no. of ways:
                                 In this method, instead of storing a single key in the hash table, 
                                 we'll store a linked list for each index. 
 
-2. Linear & Quadratic Probing: 
-3. Perfect Hashing – Cuckoo Hashing: 
+2. Linear & Quadratic Probing:    (open addressing, see Containers/FlatHashMap: a flat table
+                                probing 16 control bytes at once with SSE2)
+3. Perfect Hashing – Cuckoo Hashing: (see Containers/CuckooHashMap: two buckets of 4 slots per key,
+                                lookups in O(1) worst case and without locks)
 
 
 Complexity: 
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+/*
+    -----------------------
+    Latency Histograms
+    -----------------------
+    An average hides what users notice: the one frame in a hundred that takes
+    40 ms, the one request in a thousand that waits for a page fault. To see
+    those we keep every measurement, in a histogram with bounded error:
+
+        LatencyHistogram    plain histogram of nanosecond values, one thread
+        LatencyRecorder     the same, recorded from many threads at once
+        ScopedLatency       RAII timer: records the time from its construction
+                            to its destruction into either of the two
+        LatencyClock        the clock behind ScopedLatency
+
+    Usage:
+        ali::LatencyRecorder latency;               // shared by all threads
+        ...
+        {
+            ali::ScopedLatency timer(latency);
+            handleRequest();
+        }
+        ...
+        std::cout << latency.snapshot().summary() << "\n";
+        // n=120000 min=812ns p50=1.43us p90=2.1us p99=9.8us p99.9=212us max=3.1ms
+
+    Buckets are log-linear, like HdrHistogram: every power of two [2^k, 2^k+1)
+    is split into kSubBuckets = 128 equal buckets. Up to 256 ns every value has
+    its own bucket, above that a bucket is 1/128 of its power of two wide, so a
+    reported percentile is at most 0.8% above the recorded value, whether it
+    is 300 ns or 30 s. 7424 buckets cover the whole uint64_t range (58 KiB).
+
+    LatencyRecorder gives every recording thread its own shard of counters:
+    record() only ever touches the calling thread's shard (relaxed loads and
+    stores, no read-modify-write, no lock) and snapshot() adds the shards up.
+    A snapshot taken while threads are recording is not a single point in
+    time, but every count in it has been recorded. The first record() of a
+    thread registers its shard under a mutex.
+
+    LatencyClock reads the TSC (rdtsc, ~20 cycles) when the CPU says it ticks
+    at a constant rate in all power states (invariant TSC), and converts ticks
+    to nanoseconds with a factor calibrated once against CLOCK_MONOTONIC_RAW.
+    Without invariant TSC it reads CLOCK_MONOTONIC_RAW directly (~20-50 ns
+    through the vDSO).
+*/
+
+namespace ali {
+
+namespace detail {
+
+constexpr int kSubBucketBits = 7;
+constexpr std::uint64_t kSubBuckets = std::uint64_t(1) << kSubBucketBits;
+constexpr std::size_t kLatencyBuckets = (65 - kSubBucketBits) * kSubBuckets;
+
+inline int highestBit(std::uint64_t v)
+{
+    return 63 - __builtin_clzll(v | 1);
+}
+
+// bucket index: values below 2 * kSubBuckets map to themselves, above that
+// `shift` low bits are dropped and every power of two gets kSubBuckets slots
+inline std::size_t latencyBucket(std::uint64_t v)
+{
+    const int shift = std::max(0, highestBit(v) - kSubBucketBits);
+    return std::size_t(shift) * kSubBuckets + std::size_t(v >> shift);
+}
+
+inline std::uint64_t bucketLowest(std::size_t bucket)
+{
+    if (bucket < 2 * kSubBuckets)
+        return bucket;
+    const int shift = int(bucket / kSubBuckets) - 1;
+    return (bucket % kSubBuckets + kSubBuckets) << shift;
+}
+
+inline std::uint64_t bucketHighest(std::size_t bucket)
+{
+    const int shift = bucket < 2 * kSubBuckets ? 0 : int(bucket / kSubBuckets) - 1;
+    return bucketLowest(bucket) + ((std::uint64_t(1) << shift) - 1);
+}
+
+// 812ns, 1.43us, 16.7ms, 2.05s
+inline std::string formatNanos(double ns)
+{
+    std::ostringstream out;
+    out << std::setprecision(3);
+    if (ns < 1e3)      out << ns << "ns";
+    else if (ns < 1e6) out << ns / 1e3 << "us";
+    else if (ns < 1e9) out << ns / 1e6 << "ms";
+    else               out << ns / 1e9 << "s";
+    return out.str();
+}
+
+} // namespace detail
+
+//-----------------------------------------------------
+// LatencySummary
+//-----------------------------------------------------
+struct LatencySummary
+{
+    std::uint64_t count = 0;
+    std::uint64_t min = 0, p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0;     // ns
+    double mean = 0;                                                        // ns
+};
+
+inline std::ostream& operator<<(std::ostream& out, const LatencySummary& s)
+{
+    using detail::formatNanos;
+    return out << "n=" << s.count << " min=" << formatNanos(s.min) << " p50=" << formatNanos(s.p50)
+               << " p90=" << formatNanos(s.p90) << " p99=" << formatNanos(s.p99)
+               << " p99.9=" << formatNanos(s.p999) << " max=" << formatNanos(s.max);
+}
+
+//-----------------------------------------------------
+// LatencyHistogram
+//-----------------------------------------------------
+class LatencyHistogram
+{
+public:
+    static constexpr std::uint64_t kSubBuckets = detail::kSubBuckets;
+    static constexpr std::size_t kBuckets = detail::kLatencyBuckets;
+
+    void record(std::uint64_t nanos) { record(nanos, 1); }
+
+    void record(std::uint64_t nanos, std::uint64_t times)
+    {
+        counts_[detail::latencyBucket(nanos)] += times;
+        count_ += times;
+        sum_ += double(nanos) * double(times);
+        min_ = std::min(min_, nanos);
+        max_ = std::max(max_, nanos);
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (std::size_t b = 0; b < kBuckets; ++b)
+            counts_[b] += other.counts_[b];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t min() const { return count_ ? min_ : 0; }
+    std::uint64_t max() const { return max_; }
+    double mean() const { return count_ ? sum_ / double(count_) : 0.0; }
+
+    // smallest value that at least p percent of the recorded values are at or
+    // below (up to the bucket width); percentile(100) == max()
+    std::uint64_t percentile(double p) const
+    {
+        if (count_ == 0)
+            return 0;
+        const double wanted = std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * double(count_));
+        const std::uint64_t rank = std::max<std::uint64_t>(1, std::uint64_t(wanted));
+        std::uint64_t seen = 0;
+        for (std::size_t b = 0; b < kBuckets; ++b) {
+            seen += counts_[b];
+            if (seen >= rank)
+                return std::clamp(detail::bucketHighest(b), min(), max_);
+        }
+        return max_;
+    }
+
+    LatencySummary summary() const
+    {
+        return { count_, min(), percentile(50), percentile(90), percentile(99), percentile(99.9), max_, mean() };
+    }
+
+    // (lowest value, count) of every non-empty bucket, e.g. to plot or export
+    template <class Fn>
+    void forEachBucket(Fn fn) const
+    {
+        for (std::size_t b = 0; b < kBuckets; ++b)
+            if (counts_[b])
+                fn(detail::bucketLowest(b), counts_[b]);
+    }
+
+private:
+    friend class LatencyRecorder;
+
+    std::vector<std::uint64_t> counts_ = std::vector<std::uint64_t>(kBuckets, 0);
+    std::uint64_t count_ = 0;
+    double sum_ = 0;
+    std::uint64_t min_ = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t max_ = 0;
+};
+
+//-----------------------------------------------------
+// LatencyRecorder
+//-----------------------------------------------------
+class LatencyRecorder
+{
+public:
+    LatencyRecorder() : id_(nextId()) {}
+
+    // the threads drop their entries for this recorder on their next miss
+    ~LatencyRecorder()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& shard : shards_)
+            shard->retired.store(true, std::memory_order_release);
+    }
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    void record(std::uint64_t nanos) { shard().record(nanos); }
+
+    // all shards added up
+    LatencyHistogram snapshot() const
+    {
+        LatencyHistogram h;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shard : shards_)
+            shard->addTo(h);
+        return h;
+    }
+
+    LatencySummary summary() const { return snapshot().summary(); }
+
+    // number of threads that have recorded something
+    std::size_t threads() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return shards_.size();
+    }
+
+private:
+    // written by its own thread only, read by snapshot()
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<std::uint64_t>, LatencyHistogram::kBuckets> counts;
+        std::atomic<std::uint64_t> sum{0}, min{std::numeric_limits<std::uint64_t>::max()}, max{0};
+        std::atomic<bool> retired{false};       // its recorder is gone
+
+        Shard()
+        {
+            for (auto& c : counts)
+                c.store(0, std::memory_order_relaxed);
+        }
+
+        static void bump(std::atomic<std::uint64_t>& a, std::uint64_t by)
+        {
+            a.store(a.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+        }
+
+        void record(std::uint64_t nanos)
+        {
+            bump(counts[detail::latencyBucket(nanos)], 1);
+            bump(sum, nanos);
+            if (nanos < min.load(std::memory_order_relaxed)) min.store(nanos, std::memory_order_relaxed);
+            if (nanos > max.load(std::memory_order_relaxed)) max.store(nanos, std::memory_order_relaxed);
+        }
+
+        // the count is what the buckets hold, sum/min/max may be a record ahead or behind
+        void addTo(LatencyHistogram& h) const
+        {
+            std::uint64_t inBuckets = 0;
+            for (std::size_t b = 0; b < counts.size(); ++b) {
+                const std::uint64_t c = counts[b].load(std::memory_order_relaxed);
+                h.counts_[b] += c;
+                inBuckets += c;
+            }
+            h.count_ += inBuckets;
+            h.sum_ += double(sum.load(std::memory_order_relaxed));
+            h.min_ = std::min(h.min_, min.load(std::memory_order_relaxed));
+            h.max_ = std::max(h.max_, max.load(std::memory_order_relaxed));
+        }
+    };
+
+    static std::uint64_t nextId()
+    {
+        static std::atomic<std::uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The calling thread's shard. Recorder ids are never reused; entries of
+    // destroyed recorders are dropped on a miss, so the list only holds live
+    // recorders and a shard is freed by the last of its recorder and thread.
+    Shard& shard()
+    {
+        thread_local std::vector<std::pair<std::uint64_t, std::shared_ptr<Shard>>> mine;
+        if (!mine.empty() && mine.back().first == id_)
+            return *mine.back().second;
+        mine.erase(std::remove_if(mine.begin(), mine.end(),
+                                  [](const auto& entry) { return entry.second->retired.load(std::memory_order_acquire); }),
+                   mine.end());
+        for (auto& entry : mine)
+            if (entry.first == id_) {
+                std::swap(entry, mine.back());          // most recently used last
+                return *mine.back().second;
+            }
+
+        auto shard = std::make_shared<Shard>();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shards_.push_back(shard);
+        }
+        mine.emplace_back(id_, shard);
+        return *shard;
+    }
+
+    const std::uint64_t id_;
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<Shard>> shards_;
+};
+
+//-----------------------------------------------------
+// LatencyClock
+//-----------------------------------------------------
+class LatencyClock
+{
+public:
+    // ticks: TSC cycles or nanoseconds, see source()
+    static std::uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (calibration().tsc)
+            return __rdtsc();
+#endif
+        return monotonicRaw();
+    }
+
+    static std::uint64_t toNanos(std::uint64_t ticks)
+    {
+        return std::uint64_t(double(ticks) * calibration().nanosPerTick);
+    }
+
+    static double nanosPerTick() { return calibration().nanosPerTick; }
+    static const char* source() { return calibration().tsc ? "rdtsc" : "CLOCK_MONOTONIC_RAW"; }
+
+    static std::uint64_t monotonicRaw()
+    {
+#ifdef CLOCK_MONOTONIC_RAW
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return std::uint64_t(ts.tv_sec) * 1000000000u + std::uint64_t(ts.tv_nsec);
+#else
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+private:
+    struct Calibration
+    {
+        bool tsc = false;
+        double nanosPerTick = 1.0;
+    };
+
+    // once, on first use: ~10 ms with invariant TSC
+    static const Calibration& calibration()
+    {
+        static const Calibration c = calibrate();
+        return c;
+    }
+
+    static Calibration calibrate()
+    {
+        Calibration c;
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax, ebx, ecx, edx;
+        const bool invariant = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+        if (!invariant)
+            return c;
+
+        const std::uint64_t t0 = monotonicRaw(), c0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const std::uint64_t t1 = monotonicRaw(), c1 = __rdtsc();
+        if (c1 > c0 && t1 > t0) {
+            c.tsc = true;
+            c.nanosPerTick = double(t1 - t0) / double(c1 - c0);
+        }
+#endif
+        return c;
+    }
+};
+
+//-----------------------------------------------------
+// ScopedLatency
+//-----------------------------------------------------
+// Sink: anything with record(std::uint64_t nanos)
+template <class Sink>
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(Sink& sink) : sink_(sink), start_(LatencyClock::now()) {}
+    ~ScopedLatency() { sink_.record(LatencyClock::toNanos(LatencyClock::now() - start_)); }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    Sink& sink_;
+    std::uint64_t start_;
+};
+
+} // namespace ali
@@ -0,0 +1,207 @@
+/*
+
+    -----------------------
+    Latency Histograms
+    -----------------------
+    1.  Buckets: every value lies inside its bucket and the bucket is at most
+        1/128 of the value wide.
+    2.  Percentiles of 1 ... 100000 against the exact ones.
+    3.  LatencyRecorder: 4 threads record while a fifth takes snapshots; the
+        merged histogram equals a single-threaded one of the same values.
+    4.  Short-lived recorders: 50000 created and destroyed in turn on one
+        thread next to a long-lived one. Each keeps its own values, and the
+        first record into the last of them costs no more than into the first
+        (the thread drops the entries of destroyed recorders).
+    5.  ScopedLatency around a 2 ms sleep.
+    6.  Cost of record() and of a ScopedLatency.
+
+    Usage:
+        ./main
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+static bool near(std::uint64_t got, std::uint64_t want)
+{
+    // at most one bucket width above, never below
+    return got >= want && double(got - want) <= double(want) / 128.0 + 1.0;
+}
+
+//-----------------------------------------------------
+// Correctness
+//-----------------------------------------------------
+static void checkBuckets()
+{
+    std::mt19937_64 rng(1);
+    bool ok = true;
+    for (int i = 0; i < 1000000 && ok; ++i) {
+        const std::uint64_t v = rng() >> (rng() % 64);
+        const std::size_t b = ali::detail::latencyBucket(v);
+        const std::uint64_t lo = ali::detail::bucketLowest(b), hi = ali::detail::bucketHighest(b);
+        ok = b < ali::LatencyHistogram::kBuckets && lo <= v && v <= hi && double(hi - lo) <= double(v) / 128.0;
+        if (!ok)
+            std::cout << "  value " << v << " bucket " << b << " [" << lo << ", " << hi << "]\n";
+    }
+    ok = ok && ali::detail::latencyBucket(UINT64_MAX) == ali::LatencyHistogram::kBuckets - 1;
+    report(ok, "bucket bounds and width");
+}
+
+static void checkPercentiles()
+{
+    ali::LatencyHistogram h;
+    std::vector<std::uint64_t> values(100000);
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] = i + 1;
+    std::shuffle(values.begin(), values.end(), std::mt19937_64(2));
+    for (auto v : values)
+        h.record(v);
+
+    const auto s = h.summary();
+    std::cout << "  " << s << "\n";
+    report(s.count == 100000 && s.min == 1 && s.max == 100000, "count, min, max");
+    report(near(s.p50, 50000) && near(s.p90, 90000) && near(s.p99, 99000) && near(s.p999, 99900),
+           "p50, p90, p99, p99.9 within one bucket");
+    report(h.mean() == 50000.5, "mean");
+    report(h.percentile(100) == 100000 && h.percentile(0) == 1, "p0 = min, p100 = max");
+
+    ali::LatencyHistogram empty;
+    report(empty.percentile(99) == 0 && empty.min() == 0 && empty.max() == 0, "empty histogram");
+}
+
+static void checkRecorder()
+{
+    constexpr int kThreads = 4, kValues = 200000;
+    ali::LatencyRecorder recorder;
+    ali::LatencyHistogram expected;
+
+    std::vector<std::vector<std::uint64_t>> values(kThreads);
+    std::mt19937_64 rng(3);
+    for (auto& v : values) {
+        v.resize(kValues);
+        for (auto& x : v) {
+            x = rng() % 10000000;
+            expected.record(x);
+        }
+    }
+
+    std::atomic<bool> done{false};
+    std::uint64_t snapshots = 0;
+    bool monotonic = true;
+    std::thread reader([&] {
+        std::uint64_t last = 0;
+        while (!done.load()) {
+            const auto n = recorder.snapshot().count();
+            monotonic = monotonic && n >= last;
+            last = n;
+            ++snapshots;
+        }
+    });
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t)
+        writers.emplace_back([&, t] {
+            for (auto x : values[t])
+                recorder.record(x);
+        });
+    for (auto& w : writers)
+        w.join();
+    done = true;
+    reader.join();
+
+    const auto got = recorder.snapshot();
+    bool same = got.count() == expected.count() && got.min() == expected.min() && got.max() == expected.max();
+    for (double p : { 1.0, 50.0, 90.0, 99.0, 99.9, 99.99 })
+        same = same && got.percentile(p) == expected.percentile(p);
+    report(same, "4 threads merged == single-threaded histogram");
+    report(recorder.threads() == kThreads, "one shard per thread");
+    report(monotonic, "concurrent snapshots (" + std::to_string(snapshots) + ") never go backwards");
+}
+
+static void checkShortLived()
+{
+    constexpr int kRecorders = 50000, kSample = 5000;
+    ali::LatencyRecorder kept;
+    bool separate = true;
+    double firstNanos = 0, lastNanos = 0;
+    for (int i = 0; i < kRecorders; ++i) {
+        ali::LatencyRecorder r;
+        const auto t0 = std::chrono::steady_clock::now();
+        r.record(std::uint64_t(i));
+        const auto t1 = std::chrono::steady_clock::now();
+        kept.record(1);
+        r.record(std::uint64_t(i));
+        const double nanos = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        if (i < kSample)
+            firstNanos += nanos;
+        else if (i >= kRecorders - kSample)
+            lastNanos += nanos;
+        const auto h = r.snapshot();
+        separate = separate && h.count() == 2 && h.min() == std::uint64_t(i) && r.threads() == 1;
+    }
+    separate = separate && kept.snapshot().count() == kRecorders && kept.threads() == 1;
+    report(separate, "50000 short-lived recorders next to a long-lived one keep their own values");
+    report(lastNanos < 2 * firstNanos, "first record into the last of them: " + std::to_string(lastNanos / kSample)
+                                                 + " ns, into the first: " + std::to_string(firstNanos / kSample) + " ns");
+}
+
+static void checkScoped()
+{
+    ali::LatencyHistogram h;
+    {
+        ali::ScopedLatency timer(h);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::cout << "  clock: " << ali::LatencyClock::source() << ", " << ali::LatencyClock::nanosPerTick()
+              << " ns/tick; 2 ms sleep measured as " << ali::detail::formatNanos(double(h.max())) << "\n";
+    report(h.count() == 1 && h.max() >= 2000000 && h.max() < 200000000, "ScopedLatency around a 2 ms sleep");
+}
+
+//-----------------------------------------------------
+// Timings
+//-----------------------------------------------------
+template <class Fn>
+static double nanosPerCall(int calls, Fn fn)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i)
+        fn(i);
+    const auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+}
+
+static void timings()
+{
+    constexpr int kCalls = 10000000;
+    ali::LatencyHistogram h;
+    ali::LatencyRecorder r;
+    std::cout << "\nns per call\n";
+    std::cout << "  LatencyHistogram::record      " << nanosPerCall(kCalls, [&](int i) { h.record(std::uint64_t(i) * 37); }) << "\n";
+    std::cout << "  LatencyRecorder::record       " << nanosPerCall(kCalls, [&](int i) { r.record(std::uint64_t(i) * 37); }) << "\n";
+    std::cout << "  ScopedLatency<Histogram>      " << nanosPerCall(kCalls, [&](int) { ali::ScopedLatency timer(h); }) << "\n";
+    std::cout << "  ScopedLatency<Recorder>       " << nanosPerCall(kCalls, [&](int) { ali::ScopedLatency timer(r); }) << "\n";
+}
+
+int main()
+{
+    checkBuckets();
+    checkPercentiles();
+    checkRecorder();
+    checkShortLived();
+    checkScoped();
+    timings();
+
+    return ali::check::finish();
+}
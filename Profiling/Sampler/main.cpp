@@ -0,0 +1,193 @@
+/*
+
+    -----------------------
+    Sampling Profiler
+    -----------------------
+    1.  Process timer: two functions burn CPU in a 2:1 ratio; the profile has
+        to find both, in about that ratio, with readable names.
+    2.  Per-thread timers: two attached threads, each shows up under its name.
+    3.  Toggling with SIGUSR2 writes the profile file (into the temp
+        directory, removed again).
+
+    Usage:
+        ./main                          checks, nothing is left behind
+        ./main --folded=profile.folded  also keeps the profile of 1.
+        flamegraph.pl profile.folded > profile.svg
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "sampling_profiler.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+// some CPU work the compiler cannot drop
+static std::atomic<double> sink;
+
+// inlined, so that the samples land in heavyWork / lightWork themselves
+__attribute__((always_inline)) static inline void burnCpu(std::chrono::milliseconds duration)
+{
+    const auto end = std::chrono::steady_clock::now() + duration;
+    double x = 1.0;
+    while (std::chrono::steady_clock::now() < end)
+        for (int i = 0; i < 1000; ++i)
+            x = std::sqrt(x + i);
+    sink.store(x, std::memory_order_relaxed);
+}
+
+__attribute__((noinline)) static void heavyWork() { burnCpu(std::chrono::milliseconds(20)); }
+__attribute__((noinline)) static void lightWork() { burnCpu(std::chrono::milliseconds(10)); }
+
+static void workload(std::chrono::milliseconds total)
+{
+    const auto end = std::chrono::steady_clock::now() + total;
+    while (std::chrono::steady_clock::now() < end) {
+        heavyWork();
+        lightWork();
+    }
+}
+
+// samples whose stack contains `function` (and not `except`)
+static std::uint64_t samplesIn(const std::string& folded, const std::string& function, const std::string& except = "\n")
+{
+    std::istringstream in(folded);
+    std::uint64_t total = 0;
+    for (std::string line; std::getline(in, line);)
+        if (line.find(function) != std::string::npos && line.find(except) == std::string::npos)
+            total += std::stoull(line.substr(line.rfind(' ') + 1));
+    return total;
+}
+
+//-----------------------------------------------------
+// Checks
+//-----------------------------------------------------
+static void checkProcessTimer(const std::string& keep)
+{
+    auto& profiler = ali::SamplingProfiler::instance();
+    ali::ProfilerOptions options;
+    options.hz = 499;
+    report(profiler.start(options), "start (setitimer)");
+    report(!profiler.start(options), "second start is refused");
+    workload(std::chrono::milliseconds(1500));
+    profiler.stop();
+
+    std::ostringstream out;
+    profiler.writeFolded(out);
+    const std::string folded = out.str();
+    if (!keep.empty()) {
+        std::ofstream file(keep);
+        file << folded;
+    }
+
+    const auto heavy = samplesIn(folded, "heavyWork"), light = samplesIn(folded, "lightWork");
+    std::cout << "  " << profiler.samples() << " samples (" << profiler.dropped() << " dropped): heavyWork "
+              << heavy << ", lightWork " << light << "\n";
+    report(profiler.samples() > 100, "samples were taken");
+    report(heavy > 0 && light > 0, "both functions found by name");
+    report(light > 0 && double(heavy) / double(light) > 1.3 && double(heavy) / double(light) < 3.0,
+           "heavyWork : lightWork about 2 : 1");
+    report(folded.find("main;") != std::string::npos || folded.find(";main;") != std::string::npos,
+           "stacks go down to main");
+    profiler.clear();
+}
+
+static void checkPerThread()
+{
+    auto& profiler = ali::SamplingProfiler::instance();
+    auto worker = [&](const char* name, void (*work)()) {
+        pthread_setname_np(pthread_self(), name);
+        profiler.attachThread();
+        const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(600);
+        while (std::chrono::steady_clock::now() < end)
+            work();
+    };
+
+    ali::ProfilerOptions options;
+    options.hz = 499;
+    options.perThread = true;
+    report(profiler.start(options), "start (timer_create per thread)");
+    std::thread a(worker, "worker-heavy", &heavyWork), b(worker, "worker-light", &lightWork);
+    a.join();
+    b.join();
+    profiler.stop();
+
+    std::ostringstream out;
+    profiler.writeFolded(out);
+    const std::string folded = out.str();
+    const auto inA = samplesIn(folded, "worker-heavy;"), inB = samplesIn(folded, "worker-light;");
+    std::cout << "  worker-heavy " << inA << ", worker-light " << inB << " samples\n";
+    report(inA > 0 && inB > 0, "both attached threads sampled, under their names");
+    report(samplesIn(folded, "heavyWork", "worker-heavy;") == 0 && samplesIn(folded, "lightWork", "worker-light;") == 0,
+           "each thread's stacks are its own");
+    profiler.clear();
+}
+
+static void checkToggle()
+{
+    auto& profiler = ali::SamplingProfiler::instance();
+    ali::ProfilerOptions options;
+    options.hz = 499;
+    options.output = (std::filesystem::temp_directory_path() / ("profile-toggle-" + std::to_string(getpid()) + ".folded")).string();
+    std::remove(options.output.c_str());
+    profiler.toggleOnSignal(SIGUSR2, options);
+
+    auto waitFor = [&](bool running) {
+        for (int i = 0; i < 200 && profiler.running() != running; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return profiler.running() == running;
+    };
+
+    raise(SIGUSR2);
+    report(waitFor(true), "SIGUSR2 starts the profiler");
+    workload(std::chrono::milliseconds(300));
+    raise(SIGUSR2);
+    report(waitFor(false), "SIGUSR2 stops it");
+
+    std::ifstream in;
+    for (int i = 0; i < 2000 && !in.is_open(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        in.open(options.output);
+    }
+    std::stringstream content;
+    content << in.rdbuf();
+    report(samplesIn(content.str(), "Work") > 0, "stop wrote " + options.output);
+    in.close();
+    std::remove(options.output.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+    std::string keep;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--folded=", 0) == 0)
+            keep = arg.substr(9);
+        else {
+            std::cerr << "usage: " << argv[0] << " [--folded=<file>]\n";
+            return 2;
+        }
+    }
+
+    checkProcessTimer(keep);
+    checkPerThread();
+    checkToggle();
+
+    return ali::check::finish();
+}
@@ -0,0 +1,677 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <execinfo.h>
+#include <link.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/*
+    -----------------------
+    Sampling Profiler
+    -----------------------
+    A debugger (Foundational-Concepts/GDB.md) stops the program. A sampling
+    profiler lets it run and looks at it a hundred times a second instead:
+    a timer sends SIGPROF, the signal handler records the call stack of
+    whatever the thread was doing, and after a while the stacks that show up
+    most often are where the time goes. No perf, no root, no recompiling;
+    only the binary with its symbol table (don't strip it).
+
+    Usage:
+        auto& profiler = ali::SamplingProfiler::instance();
+        profiler.start();                           // 99 Hz, all threads
+        work();
+        profiler.stop();
+        profiler.writeFolded("profile.folded");
+
+        // or: start/stop with `kill -USR2 <pid>`, every stop writes the file
+        profiler.toggleOnSignal(SIGUSR2);
+
+        // or: ALI_PROFILE=profile.folded ./app, with this in main()
+        ali::profileFromEnvironment();
+
+    The output is one line per distinct stack, root first, and the number of
+    samples, which flamegraph.pl (github.com/brendangregg/FlameGraph) and
+    speedscope read as is:
+
+        worker;main;run;parse;std::getline 212
+
+    Timers
+        process (default)   setitimer(ITIMER_PROF): the kernel counts the CPU
+                            time of the whole process and signals a thread
+                            that is running. All threads, no registration.
+        perThread           timer_create() on the CPU-time clock of every
+                            thread that called attachThread(), delivered to
+                            that thread (SIGEV_THREAD_ID): exact per-thread
+                            sampling rates.
+
+    In the signal handler
+        backtrace() (the libgcc unwinder, called once in start() so it is
+        loaded before the first signal; with glibc >= 2.35 its lookups do not
+        take the loader lock) captures the stack into a preallocated ring of
+        samples. The ring is a bounded multi-producer queue of fixed-size
+        slots: one CAS to claim a slot, no allocation, no lock. When it is
+        full the sample is dropped and counted.
+
+    Outside the signal handler
+        a collector thread empties the ring every 50 ms and counts identical
+        stacks (as raw addresses). Symbol names are looked up only when the
+        profile is written: in the ELF symbol tables of the executable and
+        the loaded libraries (so static functions have names too), then
+        demangled.
+*/
+
+namespace ali {
+
+struct ProfilerOptions
+{
+    int hz = 99;                        // samples per second of CPU time
+    bool perThread = false;             // timer_create per attached thread
+    std::size_t capacity = 1 << 14;     // samples buffered between collections
+    bool threadNames = true;            // thread name as the root of every stack
+    std::string output = "profile.folded";  // written on every stop by toggleOnSignal()
+};
+
+namespace detail {
+
+constexpr int kMaxFrames = 64;
+
+inline pid_t currentTid() { return pid_t(syscall(SYS_gettid)); }
+
+//-----------------------------------------------------
+// SampleRing
+//-----------------------------------------------------
+// Bounded multi-producer / single-consumer queue (Vyukov): every slot has a
+// sequence number telling whether it is free for position p (seq == p) or
+// holds the sample of position p (seq == p + 1).
+class SampleRing
+{
+public:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> seq;
+        pid_t tid;
+        int depth;
+        void* frames[kMaxFrames];
+    };
+
+    explicit SampleRing(std::size_t capacity)
+    {
+        std::size_t n = 1;
+        while (n < capacity)
+            n *= 2;
+        slots_.reset(new Slot[n]);
+        mask_ = n - 1;
+        for (std::size_t i = 0; i < n; ++i)
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // async-signal-safe; false when full
+    bool push(pid_t tid, void* const* frames, int depth)
+    {
+        std::uint64_t pos = head_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            const std::uint64_t seq = slot->seq.load(std::memory_order_acquire);
+            const auto diff = std::int64_t(seq - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->tid = tid;
+        slot->depth = std::min(depth, kMaxFrames);
+        for (int i = 0; i < slot->depth; ++i)
+            slot->frames[i] = frames[i];
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // one consumer at a time
+    template <class Fn>
+    std::size_t drain(Fn fn)
+    {
+        std::size_t n = 0;
+        for (;; ++n, ++tail_) {
+            Slot& slot = slots_[tail_ & mask_];
+            if (slot.seq.load(std::memory_order_acquire) != tail_ + 1)
+                return n;
+            fn(const_cast<const Slot&>(slot));
+            slot.seq.store(tail_ + mask_ + 1, std::memory_order_release);
+        }
+    }
+
+private:
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::uint64_t tail_ = 0;
+};
+
+//-----------------------------------------------------
+// Symbolizer
+//-----------------------------------------------------
+// Function names for addresses, from the symbol tables (.symtab, else
+// .dynsym) of the loaded ELF files; dladdr() and "module+0x..." otherwise.
+class Symbolizer
+{
+public:
+    Symbolizer() { dl_iterate_phdr(&Symbolizer::addModule, this); }
+
+    std::string name(std::uintptr_t address)
+    {
+        for (auto& m : modules_) {
+            if (!m.contains(address))
+                continue;
+            if (!m.loaded)
+                m.load();
+            const std::uintptr_t offset = address - m.base;
+            auto it = std::upper_bound(m.symbols.begin(), m.symbols.end(), offset,
+                                       [](std::uintptr_t a, const Symbol& s) { return a < s.start; });
+            if (it != m.symbols.begin() && offset < std::prev(it)->end)
+                return demangle(std::prev(it)->name.c_str());
+
+            Dl_info info;
+            if (dladdr(reinterpret_cast<void*>(address), &info) && info.dli_sname)
+                return demangle(info.dli_sname);
+
+            const std::string file = m.path.substr(m.path.rfind('/') + 1);
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "+0x%zx", std::size_t(offset));
+            return "[" + file + buffer + "]";
+        }
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "[0x%zx]", std::size_t(address));
+        return buffer;
+    }
+
+private:
+    struct Symbol
+    {
+        std::uintptr_t start, end;
+        std::string name;
+    };
+
+    struct Module
+    {
+        std::string path;
+        std::uintptr_t base = 0;
+        std::vector<std::pair<std::uintptr_t, std::uintptr_t>> segments;
+        std::vector<Symbol> symbols;
+        bool loaded = false;
+
+        bool contains(std::uintptr_t a) const
+        {
+            for (const auto& s : segments)
+                if (a >= s.first && a < s.second)
+                    return true;
+            return false;
+        }
+
+        void load()
+        {
+            loaded = true;
+            std::ifstream in(path, std::ios::binary);
+            const std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (file.size() < sizeof(Elf64_Ehdr) || std::memcmp(file.data(), ELFMAG, SELFMAG) != 0 ||
+                file[EI_CLASS] != ELFCLASS64)
+                return;
+
+            Elf64_Ehdr header;
+            std::memcpy(&header, file.data(), sizeof(header));
+            if (header.e_shoff == 0 || header.e_shentsize != sizeof(Elf64_Shdr) ||
+                header.e_shoff + header.e_shnum * sizeof(Elf64_Shdr) > file.size())
+                return;
+            std::vector<Elf64_Shdr> sections(header.e_shnum);
+            std::memcpy(sections.data(), file.data() + header.e_shoff, header.e_shnum * sizeof(Elf64_Shdr));
+
+            for (const Elf32_Word type : { SHT_SYMTAB, SHT_DYNSYM }) {
+                for (const auto& section : sections) {
+                    if (section.sh_type != type || section.sh_link >= sections.size())
+                        continue;
+                    const auto& strings = sections[section.sh_link];
+                    if (section.sh_offset + section.sh_size > file.size() ||
+                        strings.sh_offset + strings.sh_size > file.size())
+                        continue;
+                    for (std::size_t i = 0; i < section.sh_size / sizeof(Elf64_Sym); ++i) {
+                        Elf64_Sym sym;
+                        std::memcpy(&sym, file.data() + section.sh_offset + i * sizeof(Elf64_Sym), sizeof(sym));
+                        if (ELF64_ST_TYPE(sym.st_info) != STT_FUNC || sym.st_value == 0 || sym.st_name >= strings.sh_size)
+                            continue;
+                        const char* name = file.data() + strings.sh_offset + sym.st_name;
+                        symbols.push_back({ sym.st_value, sym.st_value + std::max<std::uint64_t>(sym.st_size, 1), name });
+                    }
+                }
+                if (!symbols.empty())
+                    break;
+            }
+            std::sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) { return a.start < b.start; });
+        }
+    };
+
+    static int addModule(dl_phdr_info* info, std::size_t, void* self)
+    {
+        Module m;
+        m.path = info->dlpi_name && *info->dlpi_name ? info->dlpi_name : "/proc/self/exe";
+        m.base = info->dlpi_addr;
+        for (int i = 0; i < info->dlpi_phnum; ++i) {
+            const auto& ph = info->dlpi_phdr[i];
+            if (ph.p_type == PT_LOAD)
+                m.segments.emplace_back(m.base + ph.p_vaddr, m.base + ph.p_vaddr + ph.p_memsz);
+        }
+        static_cast<Symbolizer*>(self)->modules_.push_back(std::move(m));
+        return 0;
+    }
+
+    static std::string demangle(const char* name)
+    {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+        std::string result = status == 0 && demangled ? demangled : name;
+        std::free(demangled);
+        return result;
+    }
+
+    std::vector<Module> modules_;
+};
+
+inline std::uintptr_t interruptedPc(void* context)
+{
+    const auto* uc = static_cast<const ucontext_t*>(context);
+#if defined(__x86_64__)
+    return std::uintptr_t(uc->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+    return std::uintptr_t(uc->uc_mcontext.pc);
+#else
+    (void)uc;
+    return 0;
+#endif
+}
+
+} // namespace detail
+
+//-----------------------------------------------------
+// SamplingProfiler
+//-----------------------------------------------------
+// One per process (signal handlers are), hence instance(). It is never
+// destroyed: a late SIGPROF or the toggle thread may still use it during exit.
+class SamplingProfiler
+{
+public:
+    static SamplingProfiler& instance()
+    {
+        static SamplingProfiler* profiler = new SamplingProfiler;
+        return *profiler;
+    }
+
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    // false if already running or the timer could not be set up
+    bool start(const ProfilerOptions& options = {})
+    {
+        std::lock_guard<std::mutex> lock(control_);
+        if (active_.load())
+            return false;
+        options_ = options;
+
+        // load the unwinder now, not inside the first signal handler
+        void* warmUp[4];
+        backtrace(warmUp, 4);
+
+        if (!ring_ || ring_->capacity() < options.capacity)
+            ring_ = std::make_unique<detail::SampleRing>(options.capacity);
+
+        struct sigaction action {};
+        action.sa_sigaction = &SamplingProfiler::onSignal;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, &previous_) != 0)
+            return false;
+
+        active_.store(true);
+        stopCollector_ = false;
+        collector_ = std::thread([this] { collect(); });
+
+        bool armed;
+        if (options_.perThread) {
+            std::lock_guard<std::mutex> threads(threadsLock_);
+            const pid_t self = detail::currentTid();
+            if (std::find(threads_.begin(), threads_.end(), self) == threads_.end())
+                threads_.push_back(self);
+            for (pid_t tid : threads_)
+                addThreadTimer(tid);
+            armed = !timers_.empty();
+        } else {
+            armed = setitimer(ITIMER_PROF, &interval(), nullptr) == 0;
+        }
+        if (!armed) {
+            stopSampling();
+            return false;
+        }
+        return true;
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(control_);
+        if (active_.load())
+            stopSampling();
+    }
+
+    bool running() const { return active_.load(); }
+
+    // perThread mode: sample the calling thread too (call it from the thread)
+    void attachThread()
+    {
+        std::lock_guard<std::mutex> lock(threadsLock_);
+        const pid_t self = detail::currentTid();
+        if (std::find(threads_.begin(), threads_.end(), self) != threads_.end())
+            return;
+        threads_.push_back(self);
+        if (active_.load() && options_.perThread)
+            addThreadTimer(self);
+    }
+
+    std::uint64_t samples() const { return samples_.load(); }
+    std::uint64_t dropped() const { return dropped_.load(); }
+
+    // forget everything collected so far
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(stacksLock_);
+        stacks_.clear();
+        samples_ = 0;
+        dropped_ = 0;
+    }
+
+    // folded stacks: "root;...;leaf <samples>" per line
+    void writeFolded(std::ostream& out)
+    {
+        std::map<std::string, std::uint64_t> folded;
+        {
+            std::lock_guard<std::mutex> lock(stacksLock_);
+            drainRing();
+            detail::Symbolizer symbolizer;
+            std::map<std::uintptr_t, std::string> names;
+            auto nameOf = [&](std::uintptr_t a) -> const std::string& {
+                auto it = names.find(a);
+                if (it == names.end())
+                    it = names.emplace(a, symbolizer.name(a)).first;
+                return it->second;
+            };
+            for (const auto& [key, count] : stacks_) {
+                const auto& [tid, frames] = key;
+                std::string line;
+                if (options_.threadNames)
+                    line = threadName(tid);
+                // frames[0] is the interrupted instruction, the others are
+                // return addresses: look up the call instruction before them
+                for (std::size_t i = frames.size(); i-- > 0;) {
+                    if (!line.empty())
+                        line += ';';
+                    line += nameOf(frames[i] - (i > 0 ? 1 : 0));
+                }
+                folded[line] += count;
+            }
+        }
+        for (const auto& [stack, count] : folded)
+            out << stack << " " << count << "\n";
+    }
+
+    bool writeFolded(const std::string& path)
+    {
+        std::ofstream out(path);
+        writeFolded(out);
+        return bool(out);
+    }
+
+    // Every `signal` toggles: start with `options`, or stop and write
+    // options.output (then start over with an empty profile). The handler only
+    // posts a semaphore; a thread does the rest.
+    void toggleOnSignal(int signal = SIGUSR2, const ProfilerOptions& options = {})
+    {
+        std::lock_guard<std::mutex> lock(control_);
+        toggleOptions_ = options;
+        if (toggleSignal_ == 0) {
+            sem_init(&toggle_, 0, 0);
+            std::thread([this] { toggleLoop(); }).detach();
+        }
+        toggleSignal_ = signal;
+        struct sigaction action {};
+        action.sa_handler = [](int) { sem_post(&instance().toggle_); };
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(signal, &action, nullptr);
+    }
+
+private:
+    SamplingProfiler() = default;
+
+    static void onSignal(int, siginfo_t*, void* context)
+    {
+        const int savedErrno = errno;
+        SamplingProfiler& self = instance();
+        self.inHandler_.fetch_add(1);
+        if (self.active_.load()) {
+            void* frames[detail::kMaxFrames + 8];
+            const int n = backtrace(frames, detail::kMaxFrames + 8);
+            // skip the frames of this handler: start at the interrupted
+            // instruction (or after handler + signal trampoline)
+            const auto pc = reinterpret_cast<void*>(detail::interruptedPc(context));
+            int first = std::min(2, n);
+            for (int i = 0; i < n; ++i)
+                if (frames[i] == pc) {
+                    first = i;
+                    break;
+                }
+            if (self.ring_->push(detail::currentTid(), frames + first, n - first))
+                self.samples_.fetch_add(1, std::memory_order_relaxed);
+            else
+                self.dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        self.inHandler_.fetch_sub(1);
+        errno = savedErrno;
+    }
+
+    const itimerval& interval()
+    {
+        const long usec = std::max(1L, 1000000L / std::max(1, options_.hz));
+        interval_.it_interval = { usec / 1000000, usec % 1000000 };
+        interval_.it_value = interval_.it_interval;
+        return interval_;
+    }
+
+    // the CPU-time clock of thread `tid` (what pthread_getcpuclockid gives)
+    static clockid_t threadCpuClock(pid_t tid) { return clockid_t((~unsigned(tid) << 3) | 6); }
+
+    void addThreadTimer(pid_t tid)
+    {
+        sigevent event {};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event._sigev_un._tid = tid;
+        timer_t timer;
+        if (timer_create(threadCpuClock(tid), &event, &timer) != 0)
+            return;                                 // the thread is gone
+        const itimerval& i = interval();
+        itimerspec spec {};
+        spec.it_interval = { i.it_interval.tv_sec, i.it_interval.tv_usec * 1000 };
+        spec.it_value = spec.it_interval;
+        timer_settime(timer, 0, &spec, nullptr);
+        timers_.push_back(timer);
+    }
+
+    // with control_ held
+    void stopSampling()
+    {
+        if (options_.perThread) {
+            std::lock_guard<std::mutex> lock(threadsLock_);
+            for (timer_t t : timers_)
+                timer_delete(t);
+            timers_.clear();
+        } else {
+            itimerval off {};
+            setitimer(ITIMER_PROF, &off, nullptr);
+        }
+        active_.store(false);
+        while (inHandler_.load() != 0)
+            std::this_thread::yield();
+        sigaction(SIGPROF, &previous_, nullptr);
+
+        {
+            std::lock_guard<std::mutex> lock(stacksLock_);
+            stopCollector_ = true;
+        }
+        wakeCollector_.notify_all();
+        if (collector_.joinable())
+            collector_.join();
+        std::lock_guard<std::mutex> lock(stacksLock_);
+        drainRing();
+    }
+
+    // with stacksLock_ held
+    void drainRing()
+    {
+        if (!ring_)
+            return;
+        ring_->drain([this](const detail::SampleRing::Slot& s) {
+            std::vector<std::uintptr_t> frames(s.depth);
+            for (int i = 0; i < s.depth; ++i)
+                frames[i] = reinterpret_cast<std::uintptr_t>(s.frames[i]);
+            ++stacks_[{ s.tid, std::move(frames) }];
+            if (options_.threadNames && !names_.count(s.tid))
+                names_[s.tid] = readThreadName(s.tid);
+        });
+    }
+
+    void collect()
+    {
+        std::unique_lock<std::mutex> lock(stacksLock_);
+        while (!stopCollector_) {
+            wakeCollector_.wait_for(lock, std::chrono::milliseconds(50));
+            drainRing();
+        }
+    }
+
+    static std::string readThreadName(pid_t tid)
+    {
+        std::ifstream in("/proc/self/task/" + std::to_string(tid) + "/comm");
+        std::string name;
+        std::getline(in, name);
+        return name.empty() ? "thread-" + std::to_string(tid) : name;
+    }
+
+    std::string threadName(pid_t tid) const
+    {
+        const auto it = names_.find(tid);
+        return it != names_.end() ? it->second : "thread-" + std::to_string(tid);
+    }
+
+    void toggleLoop()
+    {
+        for (;;) {
+            while (sem_wait(&toggle_) != 0 && errno == EINTR) {}
+            ProfilerOptions options;
+            {
+                std::lock_guard<std::mutex> lock(control_);
+                options = toggleOptions_;
+            }
+            if (running()) {
+                stop();
+                // written next to it and renamed: the file appears complete or not at all
+                const std::string temporary = options.output + ".tmp";
+                const bool written = writeFolded(temporary) && std::rename(temporary.c_str(), options.output.c_str()) == 0;
+                std::fprintf(stderr, "profiler: stopped, %llu samples %s %s\n", (unsigned long long)samples(),
+                             written ? "written to" : "could not be written to", options.output.c_str());
+                clear();
+            } else {
+                const bool started = start(options);
+                std::fprintf(stderr, "profiler: %s at %d Hz\n", started ? "started" : "could not start", options.hz);
+            }
+        }
+    }
+
+    ProfilerOptions options_;
+    std::unique_ptr<detail::SampleRing> ring_;
+    std::atomic<bool> active_{false};
+    std::atomic<int> inHandler_{0};
+    std::atomic<std::uint64_t> samples_{0}, dropped_{0};
+    struct sigaction previous_ {};
+    itimerval interval_ {};
+
+    std::mutex control_;                    // start / stop
+    std::mutex threadsLock_;
+    std::vector<pid_t> threads_;            // attached (perThread)
+    std::vector<timer_t> timers_;
+
+    std::mutex stacksLock_;
+    std::map<std::pair<pid_t, std::vector<std::uintptr_t>>, std::uint64_t> stacks_;
+    std::map<pid_t, std::string> names_;
+    std::thread collector_;
+    std::condition_variable wakeCollector_;
+    bool stopCollector_ = false;
+
+    sem_t toggle_;
+    int toggleSignal_ = 0;
+    ProfilerOptions toggleOptions_;
+};
+
+// ALI_PROFILE=<file> [ALI_PROFILE_HZ=<hz>]: profile the whole run and write
+// the folded stacks to <file> at exit. Does nothing without ALI_PROFILE.
+inline bool profileFromEnvironment()
+{
+    const char* file = std::getenv("ALI_PROFILE");
+    if (!file || !*file)
+        return false;
+    static ProfilerOptions options;
+    options.output = file;
+    if (const char* hz = std::getenv("ALI_PROFILE_HZ"))
+        options.hz = std::max(1, std::atoi(hz));
+    if (!SamplingProfiler::instance().start(options))
+        return false;
+    std::atexit([] {
+        auto& profiler = SamplingProfiler::instance();
+        profiler.stop();
+        profiler.writeFolded(options.output);
+    });
+    return true;
+}
+
+} // namespace ali
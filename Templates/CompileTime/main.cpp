@@ -0,0 +1,259 @@
+/*
+
+    -----------------------
+    Compile-Time Benchmark
+    -----------------------
+    Runtime benchmarks don't show what templates cost: the time is spent in
+    the compiler. This driver writes one small translation unit per pattern,
+    variant and size (see variants.hpp), compiles each with -ftime-report and
+    prints
+
+        wall        best wall-clock time of the compiler over the repetitions
+        cpu         user + system time of that run
+        RSS         peak resident memory of the compiler (MiB)
+        inst        "template instantiation" from -ftime-report (GCC only)
+        x           wall / wall of the recursive variant (the one in
+                    Templates/main.cpp) of the same pattern and N
+
+    Factorial<N> for N = 10 ... 1000, sum() and Group<> for packs of 10 ...
+    500 types. The first line is the baseline: a unit that only includes
+    variants.hpp.
+
+    Usage:
+        ./main                          g++ (or $CXX), 3 repetitions, -fsyntax-only
+        ./main --compiler=clang++
+        ./main --repeat=5
+        ./main --codegen                compile to an object file (-O2), not just parse
+        ./main --keep                   leave the generated sources in ./compile_time/
+        ./main --sources=<dir>          where variants.hpp is (default: the directory
+                                        given by -DALI_SOURCE_DIR, else the one main is in)
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// variants.hpp lives next to this file; -DALI_SOURCE_DIR="\"$PWD\"" bakes that in
+static fs::path defaultSources()
+{
+#ifdef ALI_SOURCE_DIR
+    return ALI_SOURCE_DIR;
+#else
+    return fs::read_symlink("/proc/self/exe").parent_path();
+#endif
+}
+
+struct Case
+{
+    std::string pattern, variant;
+    int n;
+    std::string code;               // after #include "variants.hpp"
+};
+
+struct Result
+{
+    bool ok = false;
+    double wallMs = std::numeric_limits<double>::max();
+    double cpuMs = 0;
+    double rssMiB = 0;
+    double instantiationMs = -1;    // -1: not reported
+    std::string error;
+};
+
+//-----------------------------------------------------
+// The translation units
+//-----------------------------------------------------
+// f<I...>(): calls `expression` with I... = 0 ... n-1, used for the packs
+static std::string packCall(const std::string& expression, int n)
+{
+    return "template <int... I> int f(std::integer_sequence<int, I...>) { return " + expression + "; }\n"
+           "int r = f(std::make_integer_sequence<int, " + std::to_string(n) + ">{});\n";
+}
+
+static std::vector<Case> cases()
+{
+    std::vector<Case> all;
+    all.push_back({ "baseline", "-", 0, "" });
+
+    for (int n : { 10, 100, 250, 500, 1000 }) {
+        const std::string N = std::to_string(n);
+        all.push_back({ "Factorial", "recursive", n, "unsigned long long r = recursive::Factorial<" + N + ">::value;\n" });
+        all.push_back({ "Factorial", "constexpr", n, "constexpr unsigned long long r = constexpr_fn::factorial(" + N + ");\n" });
+        all.push_back({ "Factorial", "fold", n, "constexpr unsigned long long r = fold::Factorial<" + N + ">;\n" });
+    }
+    for (int n : { 10, 50, 100, 250, 500 }) {
+        all.push_back({ "sum", "recursive", n, packCall("recursive::sum(Value<I>{}...)", n) });
+        all.push_back({ "sum", "fold", n, packCall("fold::sum(Value<I>{}...)", n) });
+        all.push_back({ "sum", "constexpr", n, packCall("constexpr_fn::sum(Value<I>{}...)", n) });
+    }
+    for (int n : { 10, 50, 100, 250, 500 }) {
+        const std::string K = std::to_string(n / 2);
+        all.push_back({ "Group", "recursive", n, packCall("recursive::get<" + K + ">(recursive::makeGroup(Value<I>{}...))", n) });
+        all.push_back({ "Group", "flat", n, packCall("flat::get<" + K + ">(flat::makeGroup(Value<I>{}...))", n) });
+    }
+    return all;
+}
+
+//-----------------------------------------------------
+// Running the compiler
+//-----------------------------------------------------
+// "template instantiation : 0.50 ( 40%) 0.01 (...) 0.52 ( 41%) ..." -> wall column
+static double instantiationMs(const std::string& report)
+{
+    std::istringstream in(report);
+    for (std::string line; std::getline(in, line);) {
+        if (line.find("template instantiation") == std::string::npos || line.find(':') == std::string::npos)
+            continue;
+        std::istringstream columns(line.substr(line.find(':') + 1));
+        std::vector<double> numbers;
+        for (std::string word; columns >> word;)
+            if (word.front() != '(' && word.back() != ')' && word.back() != '%')
+                numbers.push_back(std::atof(word.c_str()));
+        if (numbers.size() >= 3)
+            return numbers[2] * 1000.0;
+    }
+    return -1;
+}
+
+static Result compileOnce(const std::vector<std::string>& args, const fs::path& log)
+{
+    Result r;
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, STDERR_FILENO);
+        dup2(fd, STDOUT_FILENO);
+        std::vector<char*> argv;
+        for (const auto& a : args)
+            argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execvp(argv[0], argv.data());
+        std::perror(argv[0]);
+        _exit(127);
+    }
+
+    int status = 0;
+    rusage usage {};
+    wait4(pid, &status, 0, &usage);
+    const auto end = std::chrono::steady_clock::now();
+
+    std::ifstream in(log);
+    const std::string output((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    r.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    r.wallMs = std::chrono::duration<double, std::milli>(end - start).count();
+    r.cpuMs = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+    r.rssMiB = usage.ru_maxrss / 1024.0;          // KiB on Linux
+    r.instantiationMs = instantiationMs(output);
+    if (!r.ok)
+        r.error = output.substr(0, 600);
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    std::string compiler = std::getenv("CXX") ? std::getenv("CXX") : "g++";
+    int repeat = 3;
+    bool codegen = false, keep = false;
+    fs::path sources = defaultSources();
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--compiler=", 0) == 0) compiler = arg.substr(11);
+        else if (arg.rfind("--repeat=", 0) == 0) repeat = std::max(1, std::atoi(arg.c_str() + 9));
+        else if (arg == "--codegen") codegen = true;
+        else if (arg == "--keep") keep = true;
+        else if (arg.rfind("--sources=", 0) == 0) sources = arg.substr(10);
+        else {
+            std::cerr << "usage: " << argv[0] << " [--compiler=<c++>] [--repeat=<n>] [--codegen] [--keep] [--sources=<dir>]\n";
+            return 2;
+        }
+    }
+
+    sources = fs::absolute(sources);
+    if (!fs::exists(sources / "variants.hpp")) {
+        std::cerr << "no variants.hpp in " << sources << ", pass --sources=<dir>\n";
+        return 2;
+    }
+    const fs::path work = keep ? fs::current_path() / "compile_time"
+                               : fs::temp_directory_path() / ("compile_time-" + std::to_string(getpid()));
+    fs::create_directories(work);
+
+    std::cout << compiler << (codegen ? " -c -O2" : " -fsyntax-only") << ", best of " << repeat << "\n\n";
+    std::cout << std::left << std::setw(11) << "pattern" << std::setw(11) << "variant" << std::right << std::setw(6) << "N"
+              << std::setw(11) << "wall ms" << std::setw(10) << "cpu ms" << std::setw(9) << "RSS MiB"
+              << std::setw(9) << "inst ms" << std::setw(8) << "x" << "\n";
+
+    const auto all = cases();
+    std::vector<Result> results(all.size());
+    bool failed = false;
+    for (std::size_t c = 0; c < all.size(); ++c) {
+        const Case& k = all[c];
+        const std::string name = k.pattern + "-" + k.variant + "-" + std::to_string(k.n);
+        const fs::path source = work / (name + ".cpp");
+        {
+            std::ofstream out(source);
+            out << "#include \"variants.hpp\"\nusing namespace ali::ct;\n" << k.code;
+        }
+
+        std::vector<std::string> args = { compiler, "-std=c++20", "-ftemplate-depth=2048", "-ftime-report",
+                                          "-I", sources.string(), source.string() };
+        if (codegen) {
+            args.insert(args.end(), { "-c", "-O2", "-o", (work / (name + ".o")).string() });
+        } else {
+            args.push_back("-fsyntax-only");
+        }
+
+        Result& best = results[c];
+        for (int i = 0; i < repeat; ++i) {
+            const Result r = compileOnce(args, work / (name + ".log"));
+            if (!r.ok) {
+                best = r;
+                break;
+            }
+            if (r.wallMs < best.wallMs)
+                best = r;
+        }
+
+        // the recursive variant of this pattern and N comes first
+        double recursive = best.wallMs;
+        for (std::size_t o = 0; o <= c; ++o)
+            if (all[o].pattern == k.pattern && all[o].n == k.n && all[o].variant == "recursive" && results[o].ok)
+                recursive = results[o].wallMs;
+
+        std::cout << std::left << std::setw(11) << k.pattern << std::setw(11) << k.variant << std::right << std::setw(6) << k.n;
+        if (!best.ok) {
+            failed = true;
+            std::cout << "  compile failed:\n" << best.error << "\n";
+            continue;
+        }
+        std::cout << std::fixed << std::setprecision(1) << std::setw(11) << best.wallMs << std::setw(10) << best.cpuMs
+                  << std::setw(9) << best.rssMiB;
+        if (best.instantiationMs >= 0) std::cout << std::setw(9) << best.instantiationMs;
+        else                           std::cout << std::setw(9) << "-";
+        std::cout << std::setw(7) << std::setprecision(2) << best.wallMs / recursive << "x\n" << std::defaultfloat;
+    }
+
+    if (!keep)
+        fs::remove_all(work);
+    else
+        std::cout << "\nsources and -ftime-report logs: " << work << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/*
+    -----------------------
+    Compile-Time Variants
+    -----------------------
+    The metaprogramming examples of Templates/main.cpp, each next to the
+    ways C++17/20 offers to write the same thing. main.cpp (the driver)
+    instantiates them with growing N and times the compiler.
+
+    Factorial<N>        recursive       Factorial<N> -> Factorial<N-1> -> ... -> Factorial<0>:
+                                        N class instantiations
+                        constexpr       a loop in a constexpr function: no instantiations,
+                                        just constant evaluation
+                        fold            (1 * ... * (I + 1)) over index_sequence<0..N-1>
+
+    sum(x...)           recursive       sum(x1, rest...) = x1 + sum(rest...): N function
+                                        templates, the k-th with a pack of N - k types,
+                                        so O(N^2) template arguments
+                        fold            (x + ...)
+                        constexpr       loop over { int(x)... }
+
+    Group<T...>         recursive       Group<T1, T...> : Group<T...>: a chain of N bases,
+                                        the k-th with a pack of N - k types
+                        flat            one class deriving from Leaf<I, T>... for all I at
+                                        once (index_sequence): N leaves of one type each
+
+    Every element of a pack has its own type (Value<I>), so nothing can be
+    shared between instantiations.
+*/
+
+namespace ali::ct {
+
+template <int I>
+struct Value : std::integral_constant<int, I> {};
+
+//-----------------------------------------------------
+// recursive (as in Templates/main.cpp)
+//-----------------------------------------------------
+namespace recursive {
+
+template <int N>
+struct Factorial
+{
+    static const unsigned long long value = N * Factorial<N - 1>::value;
+};
+
+template <>
+struct Factorial<0>
+{
+    static const unsigned long long value = 1;
+};
+
+template <typename T1>
+auto sum(const T1& x1) { return x1; }
+
+template <typename T1, typename... T>
+auto sum(const T1& x1, const T&... x) { return x1 + sum(x...); }
+
+template <typename... T>
+struct Group;
+
+template <typename T1>
+struct Group<T1>
+{
+    T1 t1_;
+    Group() = default;
+    explicit Group(const T1& t1) : t1_(t1) {}
+    explicit operator const T1&() const { return t1_; }
+};
+
+template <typename T1, typename... T>
+struct Group<T1, T...> : Group<T...>
+{
+    T1 t1_;
+    Group() = default;
+    explicit Group(const T1& t1, const T&... t) : Group<T...>(t...), t1_(t1) {}
+    explicit operator const T1&() const { return t1_; }
+};
+
+template <typename... T>
+auto makeGroup(const T&... t) { return Group<T...>(t...); }
+
+template <int K, typename G>
+const Value<K>& get(const G& g) { return static_cast<const Value<K>&>(g); }
+
+} // namespace recursive
+
+//-----------------------------------------------------
+// fold expressions
+//-----------------------------------------------------
+namespace fold {
+
+template <std::size_t... I>
+constexpr unsigned long long factorial(std::index_sequence<I...>) { return (1ull * ... * (I + 1)); }
+
+template <int N>
+constexpr unsigned long long Factorial = factorial(std::make_index_sequence<N>{});
+
+template <typename... T>
+auto sum(const T&... x) { return (0 + ... + x); }
+
+} // namespace fold
+
+//-----------------------------------------------------
+// constexpr functions
+//-----------------------------------------------------
+namespace constexpr_fn {
+
+constexpr unsigned long long factorial(int n)
+{
+    unsigned long long result = 1;
+    for (int i = 2; i <= n; ++i)
+        result *= unsigned(i);
+    return result;
+}
+
+template <typename... T>
+constexpr int sum(const T&... x)
+{
+    int total = 0;
+    for (int v : { int(x)... })
+        total += v;
+    return total;
+}
+
+} // namespace constexpr_fn
+
+//-----------------------------------------------------
+// flat (index_sequence)
+//-----------------------------------------------------
+namespace flat {
+
+template <std::size_t I, typename T>
+struct Leaf
+{
+    T value;
+};
+
+template <typename Indices, typename... T>
+struct GroupImpl;
+
+template <std::size_t... I, typename... T>
+struct GroupImpl<std::index_sequence<I...>, T...> : Leaf<I, T>...
+{
+    GroupImpl() = default;
+    explicit GroupImpl(const T&... t) : Leaf<I, T>{ t }... {}
+};
+
+template <typename... T>
+struct Group : GroupImpl<std::index_sequence_for<T...>, T...>
+{
+    using GroupImpl<std::index_sequence_for<T...>, T...>::GroupImpl;
+};
+
+template <typename... T>
+auto makeGroup(const T&... t) { return Group<T...>(t...); }
+
+// the base Leaf<K, T> is found by deduction, no recursion
+template <std::size_t K, typename T>
+const T& get(const Leaf<K, T>& leaf) { return leaf.value; }
+
+} // namespace flat
+
+} // namespace ali::ct
@@ -45,6 +45,8 @@ private:
    T data_[N];
 };
 
+// (throws on every access; Containers/Checked has checked_array<T, N, Bounds>
+//  with the check chosen at compile time: none, debug-only or abort)
 // Usage:
 // Array<int, 2> i;
 // i[0] = 1;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+/*
+    -----------------------
+    Self Checks
+    -----------------------
+    The main.cpp next to a header checks it: one line per check, then
+    PASSED, or FAILED and exit code 1, so that a script can run them all.
+
+        using ali::check::report;
+
+        int main()
+        {
+            report(v.size() == 3, "three elements");     // [ OK ] three elements
+            return ali::check::finish();                 // PASSED
+        }
+*/
+
+namespace ali::check {
+
+inline int failures = 0;
+
+inline void report(bool ok, const std::string& what)
+{
+    std::cout << (ok ? "[ OK ] " : "[FAIL] ") << what << "\n";
+    if (!ok) ++failures;
+}
+
+// the exit code of main
+inline int finish()
+{
+    std::cout << (failures ? "\nFAILED\n" : "\nPASSED\n");
+    return failures ? 1 : 0;
+}
+
+} // namespace ali::check
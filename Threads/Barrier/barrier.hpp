@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/*
+    -----------------------
+    Latch and Barriers
+    -----------------------
+    Threads/main.cpp starts all threads and joins all of them once. Iterative
+    jobs instead run many steps, and every thread has to finish step k before
+    anyone starts step k+1:
+
+        for (step = 0; step < n; ++step) {
+            work(step, myPart);
+            barrier.arrive_and_wait();
+        }
+
+    Re-creating the threads for every step would cost far more than the work.
+
+    Latch               single use: count_down() n times, then wait() returns
+                        (same as C++20 std::latch)
+    SenseBarrier        one shared counter; the last thread to arrive resets it
+                        and flips the phase everybody else is waiting on
+    TreeBarrier         combining tree: threads arrive in groups of kFanIn and
+                        only the last one of each group climbs one level up, so
+                        no cache line sees more than kFanIn writers per phase
+
+    Both barriers take an optional completion function, run by the last thread
+    to arrive before anybody is released (like std::barrier).
+
+    Waiting is spin-then-wait: a waiter first polls the flag for a short
+    while (cheap if the others are about to arrive, which is the common case
+    with balanced work), then falls back to std::atomic::wait() so a long
+    wait does not burn a core. With more threads than cores the spinning is
+    switched off, since the thread we are waiting for needs our core.
+*/
+
+namespace ali {
+
+namespace detail {
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// how many times to poll before blocking
+inline int defaultSpins()
+{
+    static const int spins = std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+    return spins;
+}
+
+// returns once flag != old
+template <class T>
+void spinThenWait(const std::atomic<T>& flag, T old, int spins)
+{
+    for (int i = 0; i < spins; ++i) {
+        if (flag.load(std::memory_order_acquire) != old)
+            return;
+        cpuRelax();
+    }
+    while (flag.load(std::memory_order_acquire) == old)
+        flag.wait(old, std::memory_order_acquire);
+}
+
+struct NoCompletion
+{
+    void operator()() noexcept {}
+};
+
+constexpr std::size_t kCacheLine = 64;
+
+} // namespace detail
+
+//-----------------------------------------------------
+// Latch
+//-----------------------------------------------------
+class Latch
+{
+public:
+    explicit Latch(std::ptrdiff_t count, int spins = detail::defaultSpins())
+        : count_(count), spins_(spins) {}
+
+    Latch(const Latch&) = delete;
+    Latch& operator=(const Latch&) = delete;
+
+    void count_down(std::ptrdiff_t n = 1)
+    {
+        if (count_.fetch_sub(n, std::memory_order_acq_rel) == n)
+            count_.notify_all();
+    }
+
+    bool try_wait() const noexcept { return count_.load(std::memory_order_acquire) == 0; }
+
+    void wait() const
+    {
+        for (auto c = count_.load(std::memory_order_acquire); c != 0; c = count_.load(std::memory_order_acquire))
+            detail::spinThenWait(count_, c, spins_);
+    }
+
+    void arrive_and_wait(std::ptrdiff_t n = 1)
+    {
+        count_down(n);
+        wait();
+    }
+
+private:
+    std::atomic<std::ptrdiff_t> count_;
+    const int                   spins_;
+};
+
+//-----------------------------------------------------
+// SenseBarrier
+//-----------------------------------------------------
+// "Sense reversal" with a phase counter instead of a boolean: a thread
+// remembers the phase it arrived in and waits for it to change, so there is
+// no per-thread sense variable to keep around.
+template <class Completion = detail::NoCompletion>
+class SenseBarrier
+{
+public:
+    explicit SenseBarrier(std::size_t threads, Completion completion = {}, int spins = detail::defaultSpins())
+        : threads_(threads), completion_(std::move(completion)), spins_(spins) {}
+
+    SenseBarrier(const SenseBarrier&) = delete;
+    SenseBarrier& operator=(const SenseBarrier&) = delete;
+
+    // the id is not needed, it only keeps the interface the same as TreeBarrier
+    void arrive_and_wait(std::size_t /*id*/ = 0)
+    {
+        const auto phase = phase_.load(std::memory_order_relaxed);
+        if (arrived_.fetch_add(1, std::memory_order_acq_rel) + 1 == threads_) {
+            arrived_.store(0, std::memory_order_relaxed);
+            completion_();
+            phase_.store(phase + 1, std::memory_order_release);
+            phase_.notify_all();
+        } else {
+            detail::spinThenWait(phase_, phase, spins_);
+        }
+    }
+
+    std::size_t size() const noexcept { return threads_; }
+
+private:
+    alignas(detail::kCacheLine) std::atomic<std::size_t>   arrived_{0};
+    alignas(detail::kCacheLine) std::atomic<std::uint32_t> phase_{0};
+    const std::size_t   threads_;
+    Completion          completion_;
+    const int           spins_;
+};
+
+//-----------------------------------------------------
+// TreeBarrier
+//-----------------------------------------------------
+// Thread id arrives at leaf id / kFanIn. Every node counts kFanIn arrivals
+// (fewer at the right edge); the last arrival resets the node and goes on to
+// the parent, everybody else waits for the phase to change. The thread that
+// completes the root runs the completion function and releases everyone.
+//
+// ids must be 0 ... threads-1, each used by exactly one thread per phase.
+template <class Completion = detail::NoCompletion>
+class TreeBarrier
+{
+public:
+    static constexpr std::size_t kFanIn = 4;
+
+    explicit TreeBarrier(std::size_t threads, Completion completion = {}, int spins = detail::defaultSpins())
+        : threads_(threads), completion_(std::move(completion)), spins_(spins)
+    {
+        // build the levels bottom up: level 0 are the leaves
+        std::size_t below = threads;
+        do {
+            const std::size_t count = (below + kFanIn - 1) / kFanIn;
+            const std::size_t first = nodes_.size();
+            nodes_.resize(first + count);
+            for (std::size_t i = 0; i < count; ++i) {
+                nodes_[first + i].expected = std::min(kFanIn, below - i * kFanIn);
+                nodes_[first + i].parent = first + count + i / kFanIn;
+            }
+            below = count;
+        } while (below > 1);
+        nodes_.back().parent = kRoot;
+    }
+
+    TreeBarrier(const TreeBarrier&) = delete;
+    TreeBarrier& operator=(const TreeBarrier&) = delete;
+
+    void arrive_and_wait(std::size_t id)
+    {
+        const auto phase = phase_.load(std::memory_order_relaxed);
+
+        std::size_t node = id / kFanIn;
+        while (true) {
+            Node& n = nodes_[node];
+            if (n.arrived.fetch_add(1, std::memory_order_acq_rel) + 1 != n.expected) {
+                detail::spinThenWait(phase_, phase, spins_);
+                return;
+            }
+            n.arrived.store(0, std::memory_order_relaxed);
+            if (n.parent == kRoot)
+                break;
+            node = n.parent;
+        }
+
+        completion_();
+        phase_.store(phase + 1, std::memory_order_release);
+        phase_.notify_all();
+    }
+
+    std::size_t size() const noexcept { return threads_; }
+
+private:
+    static constexpr std::size_t kRoot = std::size_t(-1);
+
+    struct alignas(detail::kCacheLine) Node
+    {
+        std::atomic<std::size_t>    arrived{0};
+        std::size_t                 expected = 0;
+        std::size_t                 parent = kRoot;
+
+        Node() = default;
+        Node(Node&& other) noexcept : expected(other.expected), parent(other.parent) {}
+    };
+
+    std::vector<Node>   nodes_;
+    alignas(detail::kCacheLine) std::atomic<std::uint32_t> phase_{0};
+    const std::size_t   threads_;
+    Completion          completion_;
+    const int           spins_;
+};
+
+} // namespace ali
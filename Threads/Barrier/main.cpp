@@ -0,0 +1,229 @@
+/*
+
+    -----------------------
+    Barriers
+    -----------------------
+    1.  Correctness: every thread writes its phase number into its own slot,
+        passes the barrier and checks that everybody else is in the same
+        phase. The completion function checks the same thing once per phase.
+    2.  Latch and PhasedPipeline, also with a stage that throws while another
+        thread is slow to leave the barrier.
+    3.  Cost of one phase (arrive_and_wait with no work in between) for
+        SenseBarrier, TreeBarrier and std::barrier on 2 ... 64 threads.
+
+    Usage:
+        ./main                  checks + timings up to 64 threads
+        ./main <phases>         use <phases> phases per timing
+
+*/
+
+#include <barrier>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "barrier.hpp"
+#include "pipeline.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+template <class Barrier>
+static void arrive(Barrier& b, std::size_t id) { b.arrive_and_wait(id); }
+
+template <class Completion>
+static void arrive(std::barrier<Completion>& b, std::size_t) { b.arrive_and_wait(); }
+
+// run fn(id) on `threads` threads, the calling thread being id 0
+template <class Fn>
+static void runThreads(std::size_t threads, Fn fn)
+{
+    std::vector<std::thread> pool;
+    for (std::size_t id = 1; id < threads; ++id)
+        pool.emplace_back(fn, id);
+    fn(0);
+    for (auto& t : pool)
+        t.join();
+}
+
+//-----------------------------------------------------
+// Correctness
+//-----------------------------------------------------
+template <template <class> class Barrier>
+static bool checkBarrier(std::size_t threads, std::size_t phases)
+{
+    std::vector<std::size_t> seen(threads, 0);
+    std::atomic<bool> ok{true};
+    std::size_t completions = 0;
+
+    auto onCompletion = [&]() noexcept {
+        for (auto s : seen)
+            if (s != completions / 2)
+                ok = false;
+        ++completions;
+    };
+    Barrier<decltype(onCompletion)> barrier(threads, onCompletion);
+
+    runThreads(threads, [&](std::size_t id) {
+        for (std::size_t phase = 0; phase < phases; ++phase) {
+            seen[id] = phase;
+            barrier.arrive_and_wait(id);
+            for (std::size_t other = 0; other < threads; ++other)
+                if (seen[other] != phase)
+                    ok = false;
+            barrier.arrive_and_wait(id);
+        }
+    });
+
+    return ok && completions == 2 * phases;
+}
+
+static bool checkLatch(std::size_t threads)
+{
+    ali::Latch ready{std::ptrdiff_t(threads)};
+    std::vector<int> started(threads, 0);
+    std::atomic<bool> ok{true};
+
+    runThreads(threads, [&](std::size_t id) {
+        started[id] = 1;
+        ready.arrive_and_wait();
+        for (auto s : started)
+            if (!s) ok = false;
+    });
+    return ok && ready.try_wait();
+}
+
+static bool checkPipeline()
+{
+    std::vector<long> results;
+    int next = 0;
+
+    ali::PhasedPipeline<long> pipeline(
+        [&](long& out) { out = next; return next++ < 1000; },
+        {
+            [](const long& in, long& out) { out = in + 1; },
+            [](const long& in, long& out) { out = in * 2; },
+            [](const long& in, long& out) { out = in - 3; },
+        },
+        [&](const long& in) { results.push_back(in); });
+
+    const std::size_t items = pipeline.run();
+
+    bool ok = items == 1000 && results.size() == 1000;
+    for (std::size_t i = 0; ok && i < results.size(); ++i)
+        ok = results[i] == (long(i) + 1) * 2 - 3;
+    return ok;
+}
+
+static bool checkPipelineException()
+{
+    int next = 0;
+    ali::PhasedPipeline<int> pipeline(
+        [&](int& out) { out = next++; return true; },                   // never ends on its own
+        { [](const int& in, int& out) { if (in == 42) throw std::runtime_error("42"); out = in; } },
+        [](const int&) {});
+
+    try {
+        pipeline.run();
+    } catch (const std::runtime_error& e) {
+        return std::string(e.what()) == "42";
+    }
+    return false;
+}
+
+// Thread 1 sleeps after every phase, so the stage after it is a phase ahead
+// when it throws: thread 1 must still arrive at that phase's barrier.
+struct SlowLeavingBarrier
+{
+    ali::SenseBarrier<> barrier;
+
+    explicit SlowLeavingBarrier(std::size_t threads) : barrier(threads) {}
+
+    void arrive_and_wait(std::size_t id)
+    {
+        barrier.arrive_and_wait(id);
+        if (id == 1)
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+};
+
+static bool checkPipelineExceptionSlowThread()
+{
+    // run() deadlocks if the threads disagree on the phase to stop in, so it
+    // runs on a thread of its own that owns everything it touches
+    using Pipeline = ali::PhasedPipeline<int, SlowLeavingBarrier>;
+    auto next = std::make_shared<int>(0);
+    auto pipeline = std::make_shared<Pipeline>(
+        [next](int& out) { out = (*next)++; return true; },
+        std::vector<Pipeline::Stage>{
+            [](const int& in, int& out) { out = in; },
+            [](const int& in, int& out) { if (in == 2) throw std::runtime_error("2"); out = in; },
+        },
+        [](const int&) {});
+
+    auto done = std::make_shared<std::promise<bool>>();
+    auto result = done->get_future();
+    std::thread([pipeline, done] {
+        try {
+            pipeline->run();
+            done->set_value(false);
+        } catch (const std::runtime_error& e) {
+            done->set_value(std::string(e.what()) == "2");
+        }
+    }).detach();
+    return result.wait_for(std::chrono::seconds(10)) == std::future_status::ready && result.get();
+}
+
+//-----------------------------------------------------
+// Timing
+//-----------------------------------------------------
+template <class Barrier>
+static double nsPerPhase(std::size_t threads, std::size_t phases)
+{
+    Barrier barrier(threads);
+    auto start = std::chrono::steady_clock::now();
+    runThreads(threads, [&](std::size_t id) {
+        for (std::size_t phase = 0; phase < phases; ++phase)
+            arrive(barrier, id);
+    });
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / phases;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t phases = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+
+    std::cout << "\n-----------------------";
+    std::cout << "\nCorrectness";
+    std::cout << "\n-----------------------\n";
+
+    for (std::size_t threads : { 1, 2, 3, 5, 8, 17 }) {
+        report(checkBarrier<ali::SenseBarrier>(threads, 200), "SenseBarrier " + std::to_string(threads) + " threads");
+        report(checkBarrier<ali::TreeBarrier>(threads, 200),  "TreeBarrier  " + std::to_string(threads) + " threads");
+        report(checkLatch(threads),                             "Latch        " + std::to_string(threads) + " threads");
+    }
+    report(checkPipeline(),          "PhasedPipeline 1000 items through 3 stages");
+    report(checkPipelineException(), "PhasedPipeline re-throws a stage's exception");
+    report(checkPipelineExceptionSlowThread(), "... also when the thread before it leaves each barrier late");
+
+    std::cout << "\n-----------------------";
+    std::cout << "\nns per phase (" << phases << " phases, " << std::thread::hardware_concurrency() << " hardware threads)";
+    std::cout << "\n-----------------------\n";
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "Sense" << std::setw(14) << "Tree" << std::setw(14) << "std::barrier" << "\n";
+
+    for (std::size_t threads : { 2, 4, 8, 16, 32, 64 }) {
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(0)
+                  << std::setw(14) << nsPerPhase<ali::SenseBarrier<>>(threads, phases)
+                  << std::setw(14) << nsPerPhase<ali::TreeBarrier<>>(threads, phases)
+                  << std::setw(14) << nsPerPhase<std::barrier<>>(threads, phases) << "\n";
+    }
+
+    return ali::check::finish();
+}
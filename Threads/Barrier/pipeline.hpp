@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "barrier.hpp"
+
+/*
+    -----------------------
+    PhasedPipeline
+    -----------------------
+    Runs a chain of stages, one thread per stage, in lock-step phases:
+
+        phase       0       1       2       3       4 ...
+        source      item0   item1   item2   item3   item4
+        stage 1             item0   item1   item2   item3
+        stage 2                     item0   item1   item2
+        sink                                item0   item1
+
+    In every phase each stage works on a different item, and a barrier ends
+    the phase. The hand-off between two stages is double buffered: stage s
+    writes item k into slot k % 2 of its output while stage s+1 reads item
+    k-1 from slot (k-1) % 2, so within a phase nobody reads what somebody
+    else writes, and no locks or queues are needed; the barrier is the only
+    synchronisation.
+
+    source(T& out)              fills in the next item, returns false when done
+    stage(const T& in, T& out)  one step of the computation
+    sink(const T& in)           consumes finished items, in order
+
+    The pipeline is as fast as its slowest stage (plus one barrier per item),
+    so it pays off when the stages are of similar, not too tiny, cost.
+    Exceptions thrown by a stage stop the pipeline after the current phase
+    and the first one is re-thrown by run().
+*/
+
+namespace ali {
+
+template <class T, class Barrier = SenseBarrier<>>
+class PhasedPipeline
+{
+public:
+    using Source = std::function<bool(T&)>;
+    using Stage  = std::function<void(const T&, T&)>;
+    using Sink   = std::function<void(const T&)>;
+
+    PhasedPipeline(Source source, std::vector<Stage> stages, Sink sink)
+        : source_(std::move(source)), stages_(std::move(stages)), sink_(std::move(sink)) {}
+
+    // returns the number of items that went through
+    std::size_t run()
+    {
+        // thread 0 is the source, threads 1..stages the stages, the last one the sink
+        const std::size_t threads = stages_.size() + 2;
+        const std::size_t lastStage = threads - 1;
+
+        std::vector<std::array<T, 2>> slots(threads - 1);       // output of thread s
+        Barrier barrier(threads);
+        std::atomic<std::size_t> items{kUnknown};
+        std::atomic<std::size_t> failedPhase{kUnknown};    // first phase with an exception
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        auto worker = [&](std::size_t s) {
+            for (std::size_t phase = 0;; ++phase) {
+                const std::size_t known = items.load(std::memory_order_relaxed);
+
+                // item that reaches this stage in this phase
+                if (phase >= s) {
+                    const std::size_t k = phase - s;
+                    try {
+                        if (s == 0) {
+                            if (known == kUnknown && !source_(slots[0][k % 2]))
+                                items.store(k, std::memory_order_relaxed);
+                        } else if (k < known) {
+                            if (s == lastStage)
+                                sink_(slots[s - 1][k % 2]);
+                            else
+                                stages_[s - 1](slots[s - 1][k % 2], slots[s][k % 2]);
+                        }
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!error)
+                            error = std::current_exception();
+                        if (phase < failedPhase.load(std::memory_order_relaxed))
+                            failedPhase.store(phase, std::memory_order_relaxed);
+                    }
+                }
+
+                barrier.arrive_and_wait(s);
+
+                // A faster thread may already be in the next phase and have set
+                // failedPhase or items there; those values only stop the
+                // pipeline in a later phase, so everyone stops in the same one.
+                if (failedPhase.load(std::memory_order_relaxed) <= phase)
+                    return;
+                const std::size_t n = items.load(std::memory_order_relaxed);
+                if (n != kUnknown && phase + 1 >= n + lastStage)
+                    return;
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (std::size_t s = 1; s < threads; ++s)
+            pool.emplace_back(worker, s);
+        worker(0);
+        for (auto& t : pool)
+            t.join();
+
+        if (error)
+            std::rethrow_exception(error);
+        return items.load();
+    }
+
+private:
+    static constexpr std::size_t kUnknown = std::numeric_limits<std::size_t>::max();
+
+    Source              source_;
+    std::vector<Stage>  stages_;
+    Sink                sink_;
+};
+
+} // namespace ali
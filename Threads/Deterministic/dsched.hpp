@@ -0,0 +1,797 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../Parallel/thread_pool.hpp"
+
+/*
+    -----------------------
+    Deterministic Scheduler
+    -----------------------
+    Running a racy program a thousand times
+
+        for i in {1..1000}; do ./main; done | sort | uniq -c
+
+    only finds a race if the OS happens to interleave the threads the wrong
+    way, and a failing run can never be reproduced.
+
+    dsched takes the OS out of the picture. Every logical thread still runs on
+    its own std::thread, but only one of them is allowed to run at any time.
+    At every synchronisation point (an atomic operation, a mutex lock, ...)
+    the running thread calls Scheduler::yield() and the scheduler decides,
+    from a seeded random number generator, who runs next.
+    Same seed => same interleaving => the bug shows up again, every time.
+
+    Strategy::PCT (Probabilistic Concurrency Testing, Burckhardt et al. 2010):
+        Every thread gets a random priority and the highest priority runnable
+        thread always runs. At d-1 random steps the running thread drops to
+        a low priority. A bug that needs d specific ordering constraints is
+        found with probability >= 1 / (n * k^(d-1)) per run, for n threads
+        and k steps, which in practice means within a few hundred runs.
+    Strategy::Random:
+        picks a random runnable thread at every step.
+
+    Instrumented replacements for the std types:
+
+        dsched::thread              dsched::mutex
+        dsched::atomic<T>           dsched::condition_variable
+        dsched::shared<T>           a plain variable whose loads & stores are
+                                    sync points, to expose data races such as
+                                    the lost update in Threads/main.cpp
+        dsched::ThreadPool          ali::BasicThreadPool on the types above
+
+    Outside of a Scheduler::run() they simply behave like the std types.
+
+    Usage:
+        auto test = [] {
+            dsched::atomic<int> x{0};
+            dsched::thread t([&] { x.store(x.load() + 1); });
+            x.store(x.load() + 1);
+            t.join();
+            dsched::check(x.load() == 2, "lost update");
+        };
+        auto found = dsched::explore(test, 1000);           // seeds 1 .. 1000
+        if (found.failure)
+            dsched::replay(test, *found.failure);           // same interleaving again
+
+    The scheduler explores sequentially consistent interleavings only:
+    memory_order arguments are accepted but ignored. Bugs that need a weaker
+    memory model to show up are the job of ThreadSanitizer.
+
+    A run fails on dsched::check(false, ...), on an uncaught exception, on a
+    deadlock (every thread blocked, e.g. a lost wake-up) and when it takes
+    more than Options::maxSteps steps (likely a livelock). After a deadlock
+    the blocked threads are unwound with dsched::Aborted; after the step
+    limit the remaining threads are let go to run freely so the run can end.
+*/
+
+namespace ali {
+namespace dsched {
+
+enum class Strategy { PCT, Random };
+
+struct Options
+{
+    std::uint64_t   seed = 1;
+    Strategy        strategy = Strategy::PCT;
+    unsigned        depth = 3;                  // PCT bug depth d
+    std::size_t     expectedSteps = 0;          // PCT change points fall in [1, expectedSteps];
+                                                // 0 = learn it from the previous run of explore()
+    std::size_t     maxSteps = 1000000;         // beyond that the run counts as a livelock
+};
+
+struct Result
+{
+    std::uint64_t       seed = 0;
+    std::size_t         expectedSteps = 0;      // needed, together with the seed, to replay a PCT run
+    bool                ok = true;
+    std::string         failure;
+    std::size_t         steps = 0;
+    std::vector<int>    schedule;               // id of the thread that ran each step
+};
+
+// Thrown out of blocking calls to unwind the threads of a dead-locked run.
+struct Aborted {};
+
+class Scheduler
+{
+    struct Task
+    {
+        int                     id = 0;
+        std::thread             os;
+        std::function<void()>   fn;
+        std::int64_t            priority = 0;
+        bool                    finished = false;
+        bool                    blocked = false;
+        const void*             waitingOn = nullptr;
+    };
+
+    struct Tls
+    {
+        Scheduler*  scheduler = nullptr;
+        Task*       task = nullptr;
+    };
+
+    static Tls& tls()
+    {
+        static thread_local Tls t;
+        return t;
+    }
+
+public:
+    explicit Scheduler(Options options) : options_(options), rng_(options.seed) {}
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // The scheduler of the calling thread, nullptr outside of run().
+    static Scheduler* current() { return tls().scheduler; }
+
+    // Runs test as logical thread 0 and returns once every thread has finished.
+    Result run(const std::function<void()>& test)
+    {
+        result_ = Result{};
+        result_.seed = options_.seed;
+        result_.expectedSteps = options_.expectedSteps ? options_.expectedSteps : kDefaultSteps;
+
+        if (options_.strategy == Strategy::PCT) {
+            std::uniform_int_distribution<std::size_t> dist(1, result_.expectedSteps);
+            for (unsigned i = 1; i < options_.depth; ++i)
+                changePoints_.push_back(dist(rng_));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            running_ = createTask(test);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_);
+            cv_.wait(lock, [this] { return allFinished(); });
+        }
+
+        // no more spawns once everybody is finished
+        for (auto& t : tasks_)
+            t->os.join();
+
+        result_.steps = steps_;
+        return result_;
+    }
+
+    //-------------------------------------------------
+    // called by the instrumented primitives
+    //-------------------------------------------------
+
+    // A sync point: lets the scheduler switch to another thread.
+    void yield()
+    {
+        std::unique_lock<std::mutex> lock(m_);
+        if (freeRun_)
+            return;
+
+        Task& me = self();
+        step(me);
+        if (freeRun_)
+            return;
+
+        const int next = pick();
+        if (next >= 0 && next != me.id) {
+            running_ = next;
+            cv_.notify_all();
+            waitTurn(lock, me);
+        }
+    }
+
+    // Like yield(), but first drop below every other thread, so that spin
+    // loops calling dsched::this_thread::yield() let the others make progress.
+    void yieldLowest()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            self().priority = --lowestPriority_;
+        }
+        yield();
+    }
+
+    int spawn(std::function<void()> fn)
+    {
+        int id;
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            id = createTask(std::move(fn));
+        }
+        yield();
+        return id;
+    }
+
+    void join(int id)
+    {
+        yield();
+        std::unique_lock<std::mutex> lock(m_);
+        Task& t = *tasks_[id];
+        while (!t.finished)
+            block(&t, lock, false);
+    }
+
+    void fail(const std::string& why)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        failLocked(why);
+    }
+
+    // Guards the scheduler *and* the state of every instrumented object.
+    std::unique_lock<std::mutex> guard() { return std::unique_lock<std::mutex>(m_); }
+
+    // Blocks the calling thread on `on` until unblock*(on) is called.
+    // lock must come from guard().
+    void block(const void* on, std::unique_lock<std::mutex>& lock, bool abortable = true)
+    {
+        Task& me = self();
+        me.blocked = true;
+        me.waitingOn = on;
+
+        if (!freeRun_) {
+            const int next = pick();
+            if (next >= 0) {
+                running_ = next;
+                cv_.notify_all();
+            }
+        }
+
+        cv_.wait(lock, [&] {
+            return (aborting_ && abortable) ||
+                   (freeRun_ ? !me.blocked : running_ == me.id && !me.blocked);
+        });
+
+        if (me.blocked) {
+            me.blocked = false;
+            me.waitingOn = nullptr;
+            throw Aborted{};
+        }
+    }
+
+    // lock must be held
+    void unblockAll(const void* on)
+    {
+        for (auto& t : tasks_)
+            if (t->blocked && t->waitingOn == on)
+                wake(*t);
+        if (freeRun_) cv_.notify_all();
+    }
+
+    // lock must be held; which waiter wakes up is also up to the seed
+    void unblockOne(const void* on)
+    {
+        std::vector<Task*> waiters;
+        for (auto& t : tasks_)
+            if (t->blocked && t->waitingOn == on)
+                waiters.push_back(t.get());
+        if (waiters.empty())
+            return;
+        wake(*waiters[rng_() % waiters.size()]);
+        if (freeRun_) cv_.notify_all();
+    }
+
+private:
+    Task& self() { return *tls().task; }
+
+    static void wake(Task& t)
+    {
+        t.blocked = false;
+        t.waitingOn = nullptr;
+    }
+
+    // lock must be held
+    int createTask(std::function<void()> fn)
+    {
+        auto task = std::make_unique<Task>();
+        task->id = static_cast<int>(tasks_.size());
+        task->fn = std::move(fn);
+        task->priority = static_cast<std::int64_t>(options_.depth + rng_() % (1u << 30));
+        Task* raw = task.get();
+        tasks_.push_back(std::move(task));
+        raw->os = std::thread([this, raw] { threadMain(*raw); });
+        return raw->id;
+    }
+
+    void threadMain(Task& t)
+    {
+        tls() = Tls{this, &t};
+        {
+            std::unique_lock<std::mutex> lock(m_);
+            waitTurn(lock, t);
+        }
+
+        try {
+            t.fn();
+        } catch (const Aborted&) {
+        } catch (const std::exception& e) {
+            fail(std::string("uncaught exception: ") + e.what());
+        } catch (...) {
+            fail("uncaught exception");
+        }
+
+        std::unique_lock<std::mutex> lock(m_);
+        t.finished = true;
+        unblockAll(&t);
+        if (allFinished()) {
+            cv_.notify_all();
+        } else if (!freeRun_) {
+            const int next = pick();
+            if (next >= 0) {
+                running_ = next;
+                cv_.notify_all();
+            }
+        }
+        tls() = Tls{};
+    }
+
+    void waitTurn(std::unique_lock<std::mutex>& lock, Task& me)
+    {
+        cv_.wait(lock, [&] { return freeRun_ || running_ == me.id; });
+    }
+
+    void step(Task& me)
+    {
+        ++steps_;
+        if (result_.schedule.size() < kMaxTrace)
+            result_.schedule.push_back(me.id);
+
+        for (std::size_t i = 0; i < changePoints_.size(); ++i)
+            if (changePoints_[i] == steps_)
+                me.priority = static_cast<std::int64_t>(options_.depth) - 1 - static_cast<std::int64_t>(i);
+
+        if (steps_ > options_.maxSteps) {
+            failLocked("step limit of " + std::to_string(options_.maxSteps) + " exceeded (livelock?)");
+            freeRun_ = true;
+            cv_.notify_all();
+        }
+    }
+
+    // Picks the next thread to run, -1 if nobody can run.
+    int pick()
+    {
+        std::vector<Task*> runnable;
+        for (auto& t : tasks_)
+            if (!t->finished && !t->blocked)
+                runnable.push_back(t.get());
+
+        if (runnable.empty()) {
+            if (!allFinished()) {
+                failLocked("deadlock: every thread is blocked");
+                aborting_ = true;
+                freeRun_ = true;
+                cv_.notify_all();
+            }
+            return -1;
+        }
+
+        if (options_.strategy == Strategy::Random)
+            return runnable[rng_() % runnable.size()]->id;
+
+        Task* best = runnable.front();
+        for (Task* t : runnable)
+            if (t->priority > best->priority)
+                best = t;
+        return best->id;
+    }
+
+    bool allFinished() const
+    {
+        return std::all_of(tasks_.begin(), tasks_.end(), [](const auto& t) { return t->finished; });
+    }
+
+    void failLocked(const std::string& why)
+    {
+        if (result_.ok) {
+            result_.ok = false;
+            result_.failure = why;
+        }
+    }
+
+    static constexpr std::size_t kMaxTrace = 100000;
+    static constexpr std::size_t kDefaultSteps = 1000;
+
+    Options                             options_;
+    std::mt19937_64                     rng_;
+    std::vector<std::size_t>            changePoints_;
+
+    std::mutex                          m_;
+    std::condition_variable             cv_;
+    std::vector<std::unique_ptr<Task>>  tasks_;
+    int                                 running_ = 0;
+    std::size_t                         steps_ = 0;
+    std::int64_t                        lowestPriority_ = 0;
+    bool                                freeRun_ = false;
+    bool                                aborting_ = false;
+    Result                              result_;
+};
+
+inline void syncPoint()
+{
+    if (Scheduler* s = Scheduler::current())
+        s->yield();
+}
+
+// Records a failure of the current run (or aborts outside of a run).
+inline void check(bool condition, const std::string& what)
+{
+    if (condition)
+        return;
+    if (Scheduler* s = Scheduler::current()) {
+        s->fail(what);
+    } else {
+        std::cerr << "dsched::check failed: " << what << std::endl;
+        std::abort();
+    }
+}
+
+namespace this_thread {
+inline void yield()
+{
+    if (Scheduler* s = Scheduler::current())
+        s->yieldLowest();
+    else
+        std::this_thread::yield();
+}
+} // namespace this_thread
+
+//-----------------------------------------------------
+// thread
+//-----------------------------------------------------
+class thread
+{
+public:
+    thread() = default;
+
+    template <class F, class... Args>
+    explicit thread(F&& f, Args&&... args)
+    {
+        auto call = std::make_shared<std::tuple<std::decay_t<F>, std::decay_t<Args>...>>(
+                        std::forward<F>(f), std::forward<Args>(args)...);
+        std::function<void()> fn = [call] {
+            std::apply([](auto& f, auto&... a) { std::invoke(f, a...); }, *call);
+        };
+
+        if ((scheduler_ = Scheduler::current()))
+            id_ = scheduler_->spawn(std::move(fn));
+        else
+            real_ = std::thread(std::move(fn));
+    }
+
+    thread(thread&& other) noexcept { *this = std::move(other); }
+
+    thread& operator=(thread&& other) noexcept
+    {
+        real_ = std::move(other.real_);
+        scheduler_ = std::exchange(other.scheduler_, nullptr);
+        id_ = std::exchange(other.id_, -1);
+        return *this;
+    }
+
+    bool joinable() const { return scheduler_ ? id_ >= 0 : real_.joinable(); }
+
+    void join()
+    {
+        if (scheduler_) {
+            scheduler_->join(id_);
+            id_ = -1;
+        } else {
+            real_.join();
+        }
+    }
+
+private:
+    std::thread     real_;
+    Scheduler*      scheduler_ = nullptr;
+    int             id_ = -1;
+};
+
+//-----------------------------------------------------
+// atomic<T>
+//-----------------------------------------------------
+template <class T>
+class atomic
+{
+public:
+    atomic() noexcept = default;
+    constexpr atomic(T desired) noexcept : value_(desired) {}
+
+    atomic(const atomic&) = delete;
+    atomic& operator=(const atomic&) = delete;
+
+    T load(std::memory_order = std::memory_order_seq_cst) const
+    {
+        syncPoint();
+        return value_.load();
+    }
+
+    void store(T desired, std::memory_order = std::memory_order_seq_cst)
+    {
+        syncPoint();
+        value_.store(desired);
+    }
+
+    T exchange(T desired, std::memory_order = std::memory_order_seq_cst)
+    {
+        syncPoint();
+        return value_.exchange(desired);
+    }
+
+    bool compare_exchange_strong(T& expected, T desired,
+                                 std::memory_order = std::memory_order_seq_cst,
+                                 std::memory_order = std::memory_order_seq_cst)
+    {
+        syncPoint();
+        return value_.compare_exchange_strong(expected, desired);
+    }
+
+    // never fails spuriously here: that would only add noise to the schedule
+    bool compare_exchange_weak(T& expected, T desired,
+                               std::memory_order = std::memory_order_seq_cst,
+                               std::memory_order = std::memory_order_seq_cst)
+    {
+        return compare_exchange_strong(expected, desired);
+    }
+
+    T fetch_add(T arg, std::memory_order = std::memory_order_seq_cst) { syncPoint(); return value_.fetch_add(arg); }
+    T fetch_sub(T arg, std::memory_order = std::memory_order_seq_cst) { syncPoint(); return value_.fetch_sub(arg); }
+    T fetch_and(T arg, std::memory_order = std::memory_order_seq_cst) { syncPoint(); return value_.fetch_and(arg); }
+    T fetch_or (T arg, std::memory_order = std::memory_order_seq_cst) { syncPoint(); return value_.fetch_or(arg); }
+    T fetch_xor(T arg, std::memory_order = std::memory_order_seq_cst) { syncPoint(); return value_.fetch_xor(arg); }
+
+    operator T() const          { return load(); }
+    T operator=(T desired)      { store(desired); return desired; }
+    T operator++()              { return fetch_add(1) + 1; }
+    T operator++(int)           { return fetch_add(1); }
+    T operator--()              { return fetch_sub(1) - 1; }
+    T operator--(int)           { return fetch_sub(1); }
+    T operator+=(T arg)         { return fetch_add(arg) + arg; }
+    T operator-=(T arg)         { return fetch_sub(arg) - arg; }
+
+private:
+    std::atomic<T> value_{};
+};
+
+//-----------------------------------------------------
+// shared<T>:  a plain (non-atomic) shared variable
+//-----------------------------------------------------
+template <class T>
+class shared
+{
+public:
+    shared() = default;
+    shared(T value) : value_(std::move(value)) {}
+
+    T load() const              { syncPoint(); return value_; }
+    void store(T value)         { syncPoint(); value_ = std::move(value); }
+
+    operator T() const          { return load(); }
+    shared& operator=(T value)  { store(std::move(value)); return *this; }
+
+private:
+    T value_{};
+};
+
+//-----------------------------------------------------
+// mutex
+//-----------------------------------------------------
+class condition_variable;
+
+class mutex
+{
+public:
+    mutex() = default;
+    mutex(const mutex&) = delete;
+    mutex& operator=(const mutex&) = delete;
+
+    void lock()
+    {
+        Scheduler* s = Scheduler::current();
+        if (!s) {
+            real_.lock();
+            return;
+        }
+        s->yield();
+        auto lock = s->guard();
+        while (locked_)
+            s->block(this, lock);
+        locked_ = true;
+    }
+
+    bool try_lock()
+    {
+        Scheduler* s = Scheduler::current();
+        if (!s)
+            return real_.try_lock();
+        s->yield();
+        auto lock = s->guard();
+        if (locked_)
+            return false;
+        locked_ = true;
+        return true;
+    }
+
+    // not a sync point: the next sync point of this thread is soon enough,
+    // and unlock() is mostly called from destructors, which must not throw
+    void unlock()
+    {
+        Scheduler* s = Scheduler::current();
+        if (!s) {
+            real_.unlock();
+            return;
+        }
+        auto lock = s->guard();
+        unlockLocked(s);
+    }
+
+private:
+    friend class condition_variable;
+
+    void unlockLocked(Scheduler* s)
+    {
+        locked_ = false;
+        s->unblockAll(this);
+    }
+
+    std::mutex  real_;
+    bool        locked_ = false;    // guarded by Scheduler::guard()
+};
+
+//-----------------------------------------------------
+// condition_variable
+//-----------------------------------------------------
+class condition_variable
+{
+public:
+    condition_variable() = default;
+    condition_variable(const condition_variable&) = delete;
+    condition_variable& operator=(const condition_variable&) = delete;
+
+    void notify_one()
+    {
+        if (Scheduler* s = Scheduler::current()) {
+            s->yield();
+            auto lock = s->guard();
+            s->unblockOne(this);
+        } else {
+            real_.notify_one();
+        }
+    }
+
+    void notify_all()
+    {
+        if (Scheduler* s = Scheduler::current()) {
+            s->yield();
+            auto lock = s->guard();
+            s->unblockAll(this);
+        } else {
+            real_.notify_all();
+        }
+    }
+
+    void wait(std::unique_lock<mutex>& userLock)
+    {
+        Scheduler* s = Scheduler::current();
+        if (!s) {
+            real_.wait(userLock);
+            return;
+        }
+        s->yield();
+        {
+            // releasing the mutex and starting to wait is one atomic step
+            auto lock = s->guard();
+            userLock.mutex()->unlockLocked(s);
+            s->block(this, lock);
+        }
+        userLock.mutex()->lock();
+    }
+
+    template <class Predicate>
+    void wait(std::unique_lock<mutex>& userLock, Predicate pred)
+    {
+        while (!pred())
+            wait(userLock);
+    }
+
+private:
+    std::condition_variable_any real_;
+};
+
+//-----------------------------------------------------
+// ThreadPool in deterministic mode
+//-----------------------------------------------------
+struct Backend
+{
+    using thread = dsched::thread;
+    using mutex = dsched::mutex;
+    using condition_variable = dsched::condition_variable;
+    template <class T> using atomic = dsched::atomic<T>;
+};
+
+using ThreadPool = BasicThreadPool<Backend>;
+
+//-----------------------------------------------------
+// explore / replay
+//-----------------------------------------------------
+inline Result runOnce(const std::function<void()>& test, const Options& options)
+{
+    Scheduler scheduler(options);
+    return scheduler.run(test);
+}
+
+struct Exploration
+{
+    std::size_t             runs = 0;
+    std::optional<Result>   failure;    // the first failing run, if any
+};
+
+// Runs test with seeds options.seed, options.seed + 1, ... until one fails.
+inline Exploration explore(const std::function<void()>& test, std::size_t iterations, Options options = {})
+{
+    Exploration exploration;
+    const std::uint64_t first = options.seed;
+    const bool learnSteps = options.expectedSteps == 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        options.seed = first + i;
+        Result r = runOnce(test, options);
+        ++exploration.runs;
+        if (learnSteps)
+            options.expectedSteps = std::max<std::size_t>(1, r.steps);
+        if (!r.ok) {
+            exploration.failure = std::move(r);
+            break;
+        }
+    }
+    return exploration;
+}
+
+inline Result replay(const std::function<void()>& test, std::uint64_t seed, std::size_t expectedSteps,
+                     Options options = {})
+{
+    options.seed = seed;
+    options.expectedSteps = expectedSteps;
+    return runOnce(test, options);
+}
+
+inline Result replay(const std::function<void()>& test, const Result& failed, Options options = {})
+{
+    return replay(test, failed.seed, failed.expectedSteps, options);
+}
+
+// Prints the schedule run-length encoded: "0x12 1x3 0x5" = thread 0 ran 12 steps, ...
+inline std::ostream& operator<<(std::ostream& os, const Result& r)
+{
+    os << "seed " << r.seed << " k " << r.expectedSteps << ": "
+       << (r.ok ? "ok" : r.failure) << " (" << r.steps << " steps)";
+    if (r.ok || r.schedule.empty())
+        return os;
+
+    os << "\n  schedule:";
+    std::size_t i = 0;
+    while (i < r.schedule.size()) {
+        std::size_t j = i;
+        while (j < r.schedule.size() && r.schedule[j] == r.schedule[i]) ++j;
+        os << ' ' << r.schedule[i] << 'x' << (j - i);
+        i = j;
+    }
+    return os;
+}
+
+} // namespace dsched
+} // namespace ali
@@ -0,0 +1,179 @@
+/*
+
+    -----------------------
+    Deterministic Scheduler
+    -----------------------
+    Instead of
+        for i in {1..1000}; do ./main; done | sort | uniq -c
+    this explores the interleavings of a handful of concurrent tests, one
+    seed per run, and replays the first failing seed to show that the
+    failure is reproducible.
+
+    Usage:
+        ./main                      explore every test
+        ./main <test> <seed> <k>    replay one test with the seed and step
+                                    estimate printed for a failing run
+
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dsched.hpp"
+
+namespace dsched = ali::dsched;
+
+// Example 1:
+// The square() from Threads/main.cpp: a read-modify-write of a plain int.
+// Two threads can read the same old value, one of the updates gets lost.
+void racySquare()
+{
+    dsched::shared<int> accum{0};
+
+    auto square = [&](int x) {
+        int temp = accum;
+        temp += x * x;
+        accum = temp;
+    };
+
+    std::vector<dsched::thread> threads;
+    for (int i = 1; i <= 3; i++)
+        threads.emplace_back(square, i);
+    for (auto& t : threads)
+        t.join();
+
+    dsched::check(accum == 1 + 4 + 9, "lost update: accum = " + std::to_string(accum));
+}
+
+// Example 2:
+// Same thing with a mutex around the update: no interleaving can fail.
+void lockedSquare()
+{
+    dsched::shared<int> accum{0};
+    dsched::mutex accumMutex;
+
+    auto square = [&](int x) {
+        std::lock_guard<dsched::mutex> lock(accumMutex);
+        int temp = accum;
+        temp += x * x;
+        accum = temp;
+    };
+
+    std::vector<dsched::thread> threads;
+    for (int i = 1; i <= 3; i++)
+        threads.emplace_back(square, i);
+    for (auto& t : threads)
+        t.join();
+
+    dsched::check(accum == 1 + 4 + 9, "lost update: accum = " + std::to_string(accum));
+}
+
+// Example 3:
+// The thread pool in deterministic mode. A load followed by a store on an
+// atomic is still not an atomic increment.
+void poolLoadStore()
+{
+    dsched::ThreadPool pool(2);
+    dsched::atomic<int> counter{0};
+
+    pool.parallel_for(4, [&](std::size_t) {
+        counter.store(counter.load() + 1);
+    });
+
+    dsched::check(counter.load() == 4, "lost increment: counter = " + std::to_string(counter.load()));
+}
+
+// Example 4:
+// ... while fetch_add() is.
+void poolFetchAdd()
+{
+    dsched::ThreadPool pool(2);
+    dsched::atomic<int> counter{0};
+
+    pool.parallel_for(4, [&](std::size_t) {
+        counter.fetch_add(1);
+    });
+
+    dsched::check(counter.load() == 4, "lost increment: counter = " + std::to_string(counter.load()));
+}
+
+// Example 5:
+// Two mutexes locked in opposite order: a deadlock the scheduler detects.
+void lockOrderInversion()
+{
+    dsched::mutex a, b;
+
+    dsched::thread t([&] {
+        std::lock_guard<dsched::mutex> la(a);
+        std::lock_guard<dsched::mutex> lb(b);
+    });
+    {
+        std::lock_guard<dsched::mutex> lb(b);
+        std::lock_guard<dsched::mutex> la(a);
+    }
+    t.join();
+}
+
+struct Test
+{
+    std::string             name;
+    std::function<void()>   fn;
+    bool                    expectFailure;
+};
+
+int main(int argc, char* argv[])
+{
+    const std::vector<Test> tests = {
+        {"racySquare",          racySquare,         true},
+        {"lockedSquare",        lockedSquare,       false},
+        {"poolLoadStore",       poolLoadStore,      true},
+        {"poolFetchAdd",        poolFetchAdd,       false},
+        {"lockOrderInversion",  lockOrderInversion, true},
+    };
+
+    if (argc > 3) {
+        for (const auto& t : tests)
+            if (t.name == argv[1])
+                std::cout << t.name << ": "
+                          << dsched::replay(t.fn, std::strtoull(argv[2], nullptr, 10),
+                                                  std::strtoull(argv[3], nullptr, 10)) << "\n";
+        return 0;
+    }
+
+    int unexpected = 0;
+    for (const auto& t : tests) {
+        auto start = std::chrono::steady_clock::now();
+        auto exploration = dsched::explore(t.fn, 1000);
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "\n-----------------------";
+        std::cout << "\n" << t.name << ": " << exploration.runs << " runs in " << ms << " ms";
+        std::cout << "\n-----------------------";
+
+        if (exploration.failure) {
+            std::cout << "\nFAILED  " << *exploration.failure;
+
+            // the same seed must fail the same way
+            auto again = dsched::replay(t.fn, *exploration.failure);
+            std::cout << "\nreplay  " << again;
+            if (again.schedule != exploration.failure->schedule) {
+                std::cout << "\n  replay diverged!";
+                ++unexpected;
+            }
+        } else {
+            std::cout << "\npassed every run";
+        }
+
+        if (bool(exploration.failure) != t.expectFailure) {
+            std::cout << "\n  unexpected!";
+            ++unexpected;
+        }
+        std::cout << "\n";
+    }
+
+    return unexpected ? 1 : 0;
+}
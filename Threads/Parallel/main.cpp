@@ -0,0 +1,182 @@
+/*
+
+    -----------------------
+    Parallel algorithms
+    -----------------------
+    Runs every algorithm in parallel_algorithms.hpp with ali::execution::seq and
+    ali::execution::par, checks that both give the same result and prints the
+    wall time of each. Last, a parallel partition whose element moves throw
+    must pass the exception on and leave no object behind.
+
+    No TBB needed, see Readme.txt for the compile line.
+
+    Usage:
+        ./main [elements] [threads]
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parallel_algorithms.hpp"
+#include "thread_pool.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+namespace exec = ali::execution;
+
+template <class F>
+double millis(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <class Seq, class Par>
+void compare(const std::string& name, Seq seq, Par par)
+{
+    decltype(seq()) a, b;
+    double ts = millis([&] { a = seq(); });
+    double tp = millis([&] { b = par(); });
+    std::ostringstream what;
+    what << name << "\tseq: " << ts << " ms\tpar: " << tp << " ms";
+    report(a == b, what.str());
+}
+
+// counts live objects; the move that finds movesUntilThrow at 0 throws
+struct Throwing
+{
+    static inline std::atomic<long> live{0};
+    static inline std::atomic<long> movesUntilThrow{-1};
+
+    std::int64_t value;
+
+    explicit Throwing(std::int64_t v) : value(v) { ++live; }
+    Throwing(const Throwing& other) : value(other.value) { ++live; }
+    Throwing(Throwing&& other) : value(other.value) { countMove(); ++live; }
+    Throwing& operator=(const Throwing&) = default;
+    Throwing& operator=(Throwing&& other) { countMove(); value = other.value; return *this; }
+    ~Throwing() { --live; }
+
+    static void countMove()
+    {
+        if (movesUntilThrow.fetch_sub(1) == 0)
+            throw std::runtime_error("move");
+    }
+};
+
+// a move into the scratch storage throws, then one on the way back
+template <class Policy>
+void partitionThrows(Policy par)
+{
+    constexpr std::size_t n = 100000;
+    for (long throwAt : { long(n / 3), long(n + n / 3) }) {
+        bool threw = false;
+        {
+            std::vector<Throwing> v;
+            v.reserve(n);
+            for (std::size_t i = 0; i < n; ++i)
+                v.emplace_back(std::int64_t(i));
+            Throwing::movesUntilThrow = throwAt;
+            try {
+                ali::partition(par, v.begin(), v.end(), [](const Throwing& x) { return x.value % 2 == 0; });
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            Throwing::movesUntilThrow = -1;
+        }
+        report(threw && Throwing::live == 0, std::string("partition: a throwing move ") +
+                   (throwAt < long(n) ? "into" : "out of") + " scratch storage leaves no object behind");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    const std::size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                         : std::max(1u, std::thread::hardware_concurrency());
+
+    ali::ThreadPool pool(threads);
+    const auto par = exec::par.on(pool);
+
+    std::vector<std::int64_t> input(n);
+    std::mt19937_64 rng(42);
+    for (auto& x : input) x = std::int64_t(rng() % 1000000);
+
+    std::cout << "elements: " << n << "  threads: " << pool.size() << "\n\n";
+
+    compare("for_each",
+        [&] { auto v = input; ali::for_each(exec::seq, v.begin(), v.end(), [](auto& x) { x = x * 3 + 1; }); return v; },
+        [&] { auto v = input; ali::for_each(par,       v.begin(), v.end(), [](auto& x) { x = x * 3 + 1; }); return v; });
+
+    compare("transform",
+        [&] { std::vector<std::int64_t> out(n); ali::transform(exec::seq, input.begin(), input.end(), out.begin(), [](auto x) { return x * x; }); return out; },
+        [&] { std::vector<std::int64_t> out(n); ali::transform(par,       input.begin(), input.end(), out.begin(), [](auto x) { return x * x; }); return out; });
+
+    compare("reduce",
+        [&] { return ali::reduce(exec::seq, input.begin(), input.end()); },
+        [&] { return ali::reduce(par,       input.begin(), input.end()); });
+
+    compare("transform_reduce",
+        [&] { return ali::transform_reduce(exec::seq, input.begin(), input.end(), input.begin(), std::int64_t(0)); },
+        [&] { return ali::transform_reduce(par,       input.begin(), input.end(), input.begin(), std::int64_t(0)); });
+
+    compare("inclusive_scan",
+        [&] { std::vector<std::int64_t> out(n); ali::inclusive_scan(exec::seq, input.begin(), input.end(), out.begin()); return out; },
+        [&] { std::vector<std::int64_t> out(n); ali::inclusive_scan(par,       input.begin(), input.end(), out.begin()); return out; });
+
+    compare("exclusive_scan",
+        [&] { std::vector<std::int64_t> out(n); ali::exclusive_scan(exec::seq, input.begin(), input.end(), out.begin(), std::int64_t(7)); return out; },
+        [&] { std::vector<std::int64_t> out(n); ali::exclusive_scan(par,       input.begin(), input.end(), out.begin(), std::int64_t(7)); return out; });
+
+    compare("inclusive_scan (in place)",
+        [&] { auto v = input; ali::inclusive_scan(exec::seq, v.begin(), v.end(), v.begin()); return v; },
+        [&] { auto v = input; ali::inclusive_scan(par,       v.begin(), v.end(), v.begin()); return v; });
+
+    // input holds values < 1000000: 1000000 is never found, input[n - 3] near the end
+    for (std::int64_t target : { input[n / 3], input[n - 3], std::int64_t(1000000) })
+        compare("find " + std::to_string(target),
+            [&] { return ali::find(exec::seq, input.begin(), input.end(), target) - input.begin(); },
+            [&] { return ali::find(par,       input.begin(), input.end(), target) - input.begin(); });
+
+    compare("count_if",
+        [&] { return ali::count_if(exec::seq, input.begin(), input.end(), [](auto x) { return x % 7 == 0; }); },
+        [&] { return ali::count_if(par,       input.begin(), input.end(), [](auto x) { return x % 7 == 0; }); });
+
+    compare("copy_if",
+        [&] { std::vector<std::int64_t> out(n); out.erase(ali::copy_if(exec::seq, input.begin(), input.end(), out.begin(), [](auto x) { return x % 3 == 0; }), out.end()); return out; },
+        [&] { std::vector<std::int64_t> out(n); out.erase(ali::copy_if(par,       input.begin(), input.end(), out.begin(), [](auto x) { return x % 3 == 0; }), out.end()); return out; });
+
+    // std::partition is not stable, so compare the partitioned halves as sorted sets
+    auto partitioned = [&](auto policy) {
+        auto v = input;
+        auto mid = ali::partition(policy, v.begin(), v.end(), [](auto x) { return x % 2 == 0; });
+        bool ok = std::all_of(v.begin(), mid, [](auto x) { return x % 2 == 0; }) &&
+                  std::none_of(mid, v.end(), [](auto x) { return x % 2 == 0; });
+        std::sort(v.begin(), mid);
+        std::sort(mid, v.end());
+        return ok ? v : std::vector<std::int64_t>{};
+    };
+    compare("partition",
+        [&] { return partitioned(exec::seq); },
+        [&] { return partitioned(par); });
+
+    compare("sort",
+        [&] { auto v = input; ali::sort(exec::seq, v.begin(), v.end()); return v; },
+        [&] { auto v = input; ali::sort(par,       v.begin(), v.end()); return v; });
+
+    std::cout << "\n";
+    partitionThrows(par);
+
+    return ali::check::finish();
+}
@@ -0,0 +1,623 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+/*
+    -----------------------
+    Parallel Algorithms
+    -----------------------
+    C++17 added execution-policy overloads to <algorithm> and <numeric>:
+
+        std::for_each(std::execution::par, v.begin(), v.end(), f);
+
+    With GCC, libstdc++ implements them on top of Intel TBB, so without TBB
+    installed (and -ltbb on the link line) the code does not even link.
+    See the commented-out parallel() in CMake-Tuts/HelloBenchmark/src/main.cpp.
+
+    This header provides the same overloads in namespace ali, running on
+    ali::ThreadPool instead of TBB. Switching is a matter of namespaces:
+
+        namespace exec = ali::execution;             // or std::execution
+        ali::for_each(exec::par, v.begin(), v.end(), f);
+
+    Policies:
+        seq, unseq              -> runs the plain sequential std algorithm
+        par, par_unseq          -> splits the range into blocks on the pool
+        par.on(pool)            -> same, but on a pool of your choice
+
+    Ranges smaller than 2 * kMinGrain elements, and ranges that are not
+    random-access, always run sequentially: below that size waking up the
+    workers costs more than the work itself.
+
+    Scans use the classic two-pass blocked algorithm:
+        pass 1:  reduce every block in parallel           -> one sum per block
+        carry:   exclusive scan of the block sums         (sequential, P values)
+        pass 2:  scan every block in parallel, seeded with its carry
+    copy_if() and partition() work the same way, with counts instead of sums.
+
+    find_if() searches the blocks in parallel and keeps the lowest hit so far
+    in an atomic: blocks behind it are skipped, and a block stops early as
+    soon as an earlier block has found something.
+
+    sort() sorts the blocks in parallel and then merges neighbours pairwise,
+    every merge round running its pairs in parallel.
+
+    Unlike std:: (which calls std::terminate), an exception thrown by a user
+    function is re-thrown in the calling thread.
+*/
+
+namespace ali {
+
+namespace execution {
+
+struct sequenced_policy {};
+struct unsequenced_policy {};
+
+struct parallel_policy
+{
+    ThreadPool* pool = nullptr;
+    parallel_policy on(ThreadPool& p) const { return parallel_policy{&p}; }
+};
+
+struct parallel_unsequenced_policy
+{
+    ThreadPool* pool = nullptr;
+    parallel_unsequenced_policy on(ThreadPool& p) const { return parallel_unsequenced_policy{&p}; }
+};
+
+inline constexpr sequenced_policy               seq{};
+inline constexpr unsequenced_policy             unseq{};
+inline constexpr parallel_policy                par{};
+inline constexpr parallel_unsequenced_policy    par_unseq{};
+
+template <class T> struct is_execution_policy : std::false_type {};
+template <> struct is_execution_policy<sequenced_policy>            : std::true_type {};
+template <> struct is_execution_policy<unsequenced_policy>          : std::true_type {};
+template <> struct is_execution_policy<parallel_policy>             : std::true_type {};
+template <> struct is_execution_policy<parallel_unsequenced_policy> : std::true_type {};
+
+template <class T>
+inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+} // namespace execution
+
+namespace detail {
+
+inline constexpr std::size_t kMinGrain = 4096;
+
+template <class P>
+using enable_if_policy = std::enable_if_t<execution::is_execution_policy_v<std::decay_t<P>>, int>;
+
+template <class P>
+inline constexpr bool is_parallel_policy_v =
+        std::is_same_v<std::decay_t<P>, execution::parallel_policy> ||
+        std::is_same_v<std::decay_t<P>, execution::parallel_unsequenced_policy>;
+
+template <class... It>
+inline constexpr bool all_random_access_v =
+        (std::is_base_of_v<std::random_access_iterator_tag,
+                           typename std::iterator_traits<It>::iterator_category> && ...);
+
+// Returns the pool to run on, or nullptr if the call should run sequentially.
+template <class P, class... It>
+ThreadPool* parallelPool(const P& policy, std::size_t n)
+{
+    if constexpr (is_parallel_policy_v<P> && all_random_access_v<It...>) {
+        if (n < 2 * kMinGrain)
+            return nullptr;
+        return policy.pool ? policy.pool : &ThreadPool::instance();
+    } else {
+        (void)policy; (void)n;
+        return nullptr;
+    }
+}
+
+// [0, n) split into `count` nearly equal, non-empty blocks
+struct Blocks
+{
+    std::size_t n;
+    std::size_t count;
+
+    Blocks(std::size_t n, std::size_t maxBlocks)
+        : n(n), count(std::max<std::size_t>(1, std::min(maxBlocks, n / kMinGrain))) {}
+
+    std::size_t begin(std::size_t b) const { return b * n / count; }
+    std::size_t end(std::size_t b) const   { return (b + 1) * n / count; }
+};
+
+// A few blocks per thread so that a slow block does not stall everybody.
+inline Blocks makeBlocks(std::size_t n, const ThreadPool& pool)
+{
+    return Blocks(n, 4 * (pool.size() + 1));
+}
+
+// Uninitialised scratch storage for n objects of T.
+template <class T>
+class Buffer
+{
+public:
+    explicit Buffer(std::size_t n)
+        : data_(static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))))) {}
+
+    ~Buffer() { ::operator delete(data_, std::align_val_t(alignof(T))); }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    T* data() { return data_; }
+
+private:
+    T* data_;
+};
+
+template <class RandomIt, class OutIt, class T, class BinaryOp>
+OutIt blockedScan(ThreadPool& pool, RandomIt first, std::size_t n, OutIt d_first,
+                  BinaryOp op, std::optional<T> init, bool inclusive)
+{
+    const Blocks blocks = makeBlocks(n, pool);
+
+    // pass 1: one partial sum per block
+    std::vector<std::optional<T>> sums(blocks.count);
+    pool.parallel_for(blocks.count, [&](std::size_t b) {
+        RandomIt it = first + blocks.begin(b);
+        RandomIt end = first + blocks.end(b);
+        T acc = *it;
+        for (++it; it != end; ++it)
+            acc = op(std::move(acc), *it);
+        sums[b] = std::move(acc);
+    });
+
+    // carry: exclusive scan over the block sums
+    std::vector<std::optional<T>> carries(blocks.count);
+    std::optional<T> carry = std::move(init);
+    for (std::size_t b = 0; b < blocks.count; ++b) {
+        carries[b] = carry;
+        carry = carry ? op(std::move(*carry), std::move(*sums[b])) : std::move(*sums[b]);
+    }
+
+    // pass 2: scan every block, starting from its carry
+    pool.parallel_for(blocks.count, [&](std::size_t b) {
+        RandomIt it = first + blocks.begin(b);
+        RandomIt end = first + blocks.end(b);
+        OutIt out = d_first + blocks.begin(b);
+        std::optional<T> acc = std::move(carries[b]);
+        for (; it != end; ++it, ++out) {
+            if (inclusive) {
+                acc = acc ? op(std::move(*acc), *it) : T(*it);
+                *out = *acc;
+            } else {
+                T value = *it;      // read before write, the scan may be in place
+                *out = *acc;
+                acc = op(std::move(*acc), std::move(value));
+            }
+        }
+    });
+
+    return d_first + n;
+}
+
+} // namespace detail
+
+//-----------------------------------------------------
+// for_each
+//-----------------------------------------------------
+template <class ExecutionPolicy, class ForwardIt, class UnaryFunction,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+void for_each(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, UnaryFunction f)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt>(policy, n);
+    if (!pool) {
+        std::for_each(first, last, f);
+        return;
+    }
+
+    const auto blocks = detail::makeBlocks(n, *pool);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        std::for_each(first + blocks.begin(b), first + blocks.end(b), f);
+    });
+}
+
+//-----------------------------------------------------
+// transform
+//-----------------------------------------------------
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class UnaryOperation,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt2 transform(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last,
+                     ForwardIt2 d_first, UnaryOperation op)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt1, ForwardIt2>(policy, n);
+    if (!pool)
+        return std::transform(first, last, d_first, op);
+
+    const auto blocks = detail::makeBlocks(n, *pool);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        std::transform(first + blocks.begin(b), first + blocks.end(b), d_first + blocks.begin(b), op);
+    });
+    return d_first + n;
+}
+
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class ForwardIt3, class BinaryOperation,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt3 transform(ExecutionPolicy&& policy, ForwardIt1 first1, ForwardIt1 last1,
+                     ForwardIt2 first2, ForwardIt3 d_first, BinaryOperation op)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first1, last1));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt1, ForwardIt2, ForwardIt3>(policy, n);
+    if (!pool)
+        return std::transform(first1, last1, first2, d_first, op);
+
+    const auto blocks = detail::makeBlocks(n, *pool);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        std::transform(first1 + blocks.begin(b), first1 + blocks.end(b),
+                       first2 + blocks.begin(b), d_first + blocks.begin(b), op);
+    });
+    return d_first + n;
+}
+
+//-----------------------------------------------------
+// reduce / transform_reduce
+//-----------------------------------------------------
+template <class ExecutionPolicy, class ForwardIt, class T, class BinaryReductionOp, class UnaryTransformOp,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+T transform_reduce(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, T init,
+                   BinaryReductionOp reduce, UnaryTransformOp transform)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt>(policy, n);
+    if (!pool)
+        return std::transform_reduce(first, last, std::move(init), reduce, transform);
+
+    const auto blocks = detail::makeBlocks(n, *pool);
+    std::vector<std::optional<T>> partials(blocks.count);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        auto it = first + blocks.begin(b);
+        auto end = first + blocks.end(b);
+        T acc = transform(*it);
+        for (++it; it != end; ++it)
+            acc = reduce(std::move(acc), transform(*it));
+        partials[b] = std::move(acc);
+    });
+
+    for (auto& p : partials)
+        init = reduce(std::move(init), std::move(*p));
+    return init;
+}
+
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class T,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+T transform_reduce(ExecutionPolicy&& policy, ForwardIt1 first1, ForwardIt1 last1, ForwardIt2 first2, T init)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first1, last1));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt1, ForwardIt2>(policy, n);
+    if (!pool)
+        return std::transform_reduce(first1, last1, first2, std::move(init));
+
+    const auto blocks = detail::makeBlocks(n, *pool);
+    std::vector<std::optional<T>> partials(blocks.count);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        partials[b] = std::transform_reduce(first1 + blocks.begin(b), first1 + blocks.end(b),
+                                            first2 + blocks.begin(b), T{});
+    });
+
+    for (auto& p : partials)
+        init = std::move(init) + std::move(*p);
+    return init;
+}
+
+template <class ExecutionPolicy, class ForwardIt, class T, class BinaryOp,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+T reduce(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, T init, BinaryOp op)
+{
+    using Ref = typename std::iterator_traits<ForwardIt>::reference;
+    return ali::transform_reduce(std::forward<ExecutionPolicy>(policy), first, last, std::move(init), op,
+                                 [](Ref x) -> Ref { return x; });
+}
+
+template <class ExecutionPolicy, class ForwardIt, class T,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+T reduce(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, T init)
+{
+    return ali::reduce(std::forward<ExecutionPolicy>(policy), first, last, std::move(init), std::plus<>());
+}
+
+template <class ExecutionPolicy, class ForwardIt,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+typename std::iterator_traits<ForwardIt>::value_type
+reduce(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last)
+{
+    using T = typename std::iterator_traits<ForwardIt>::value_type;
+    return ali::reduce(std::forward<ExecutionPolicy>(policy), first, last, T{}, std::plus<>());
+}
+
+//-----------------------------------------------------
+// inclusive_scan / exclusive_scan
+//-----------------------------------------------------
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class BinaryOp, class T,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt2 inclusive_scan(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last,
+                          ForwardIt2 d_first, BinaryOp op, T init)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt1, ForwardIt2>(policy, n);
+    if (!pool)
+        return std::inclusive_scan(first, last, d_first, op, std::move(init));
+
+    return detail::blockedScan<ForwardIt1, ForwardIt2, T>(*pool, first, n, d_first, op,
+                                                          std::optional<T>(std::move(init)), true);
+}
+
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class BinaryOp,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt2 inclusive_scan(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last,
+                          ForwardIt2 d_first, BinaryOp op)
+{
+    using T = typename std::iterator_traits<ForwardIt1>::value_type;
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt1, ForwardIt2>(policy, n);
+    if (!pool)
+        return std::inclusive_scan(first, last, d_first, op);
+
+    return detail::blockedScan<ForwardIt1, ForwardIt2, T>(*pool, first, n, d_first, op, std::nullopt, true);
+}
+
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt2 inclusive_scan(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last, ForwardIt2 d_first)
+{
+    return ali::inclusive_scan(std::forward<ExecutionPolicy>(policy), first, last, d_first, std::plus<>());
+}
+
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class T, class BinaryOp,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt2 exclusive_scan(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last,
+                          ForwardIt2 d_first, T init, BinaryOp op)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt1, ForwardIt2>(policy, n);
+    if (!pool)
+        return std::exclusive_scan(first, last, d_first, std::move(init), op);
+
+    return detail::blockedScan<ForwardIt1, ForwardIt2, T>(*pool, first, n, d_first, op,
+                                                          std::optional<T>(std::move(init)), false);
+}
+
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class T,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt2 exclusive_scan(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last,
+                          ForwardIt2 d_first, T init)
+{
+    return ali::exclusive_scan(std::forward<ExecutionPolicy>(policy), first, last, d_first,
+                               std::move(init), std::plus<>());
+}
+
+//-----------------------------------------------------
+// find / find_if / count / count_if
+//-----------------------------------------------------
+template <class ExecutionPolicy, class ForwardIt, class UnaryPredicate,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt find_if(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, UnaryPredicate pred)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt>(policy, n);
+    if (!pool)
+        return std::find_if(first, last, pred);
+
+    constexpr std::size_t kCheckEvery = 1024;
+    const auto blocks = detail::makeBlocks(n, *pool);
+    std::atomic<std::size_t> found{n};
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        const std::size_t begin = blocks.begin(b), end = blocks.end(b);
+        for (std::size_t chunk = begin; chunk < end; chunk += kCheckEvery) {
+            // an earlier block has a hit: nothing here can be the first one
+            if (found.load(std::memory_order_relaxed) < begin)
+                return;
+            const ForwardIt chunkLast = first + std::min(end, chunk + kCheckEvery);
+            const ForwardIt it = std::find_if(first + chunk, chunkLast, pred);
+            if (it != chunkLast) {
+                const auto i = static_cast<std::size_t>(it - first);
+                std::size_t current = found.load(std::memory_order_relaxed);
+                while (i < current && !found.compare_exchange_weak(current, i, std::memory_order_relaxed)) {}
+                return;
+            }
+        }
+    });
+    return first + found.load();
+}
+
+template <class ExecutionPolicy, class ForwardIt, class T,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt find(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, const T& value)
+{
+    return ali::find_if(std::forward<ExecutionPolicy>(policy), first, last,
+                        [&value](const auto& x) { return x == value; });
+}
+
+template <class ExecutionPolicy, class ForwardIt, class UnaryPredicate,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+typename std::iterator_traits<ForwardIt>::difference_type
+count_if(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, UnaryPredicate pred)
+{
+    using Diff = typename std::iterator_traits<ForwardIt>::difference_type;
+    return ali::transform_reduce(std::forward<ExecutionPolicy>(policy), first, last, Diff(0), std::plus<>(),
+                                 [&pred](const auto& x) -> Diff { return pred(x) ? 1 : 0; });
+}
+
+template <class ExecutionPolicy, class ForwardIt, class T,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+typename std::iterator_traits<ForwardIt>::difference_type
+count(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, const T& value)
+{
+    return ali::count_if(std::forward<ExecutionPolicy>(policy), first, last,
+                         [&value](const auto& x) { return x == value; });
+}
+
+//-----------------------------------------------------
+// copy_if / partition
+//-----------------------------------------------------
+template <class ExecutionPolicy, class ForwardIt1, class ForwardIt2, class UnaryPredicate,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt2 copy_if(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last,
+                   ForwardIt2 d_first, UnaryPredicate pred)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt1, ForwardIt2>(policy, n);
+    if (!pool)
+        return std::copy_if(first, last, d_first, pred);
+
+    // pass 1: evaluate pred once per element, count the hits per block
+    const auto blocks = detail::makeBlocks(n, *pool);
+    std::vector<unsigned char> keep(n);
+    std::vector<std::size_t> offsets(blocks.count + 1, 0);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        std::size_t count = 0;
+        for (std::size_t i = blocks.begin(b); i < blocks.end(b); ++i)
+            count += keep[i] = pred(first[i]) ? 1 : 0;
+        offsets[b + 1] = count;
+    });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    // pass 2: every block copies into its own slice of the output
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        auto out = d_first + offsets[b];
+        for (std::size_t i = blocks.begin(b); i < blocks.end(b); ++i)
+            if (keep[i]) *out++ = first[i];
+    });
+    return d_first + offsets.back();
+}
+
+// The parallel version is stable, like std::stable_partition.
+template <class ExecutionPolicy, class ForwardIt, class UnaryPredicate,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+ForwardIt partition(ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, UnaryPredicate pred)
+{
+    using T = typename std::iterator_traits<ForwardIt>::value_type;
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, ForwardIt>(policy, n);
+    if (!pool)
+        return std::partition(first, last, pred);
+
+    const auto blocks = detail::makeBlocks(n, *pool);
+    std::vector<unsigned char> isTrue(n);
+    std::vector<std::size_t> trueOffsets(blocks.count + 1, 0);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        std::size_t count = 0;
+        for (std::size_t i = blocks.begin(b); i < blocks.end(b); ++i)
+            count += isTrue[i] = pred(first[i]) ? 1 : 0;
+        trueOffsets[b + 1] = count;
+    });
+    std::partial_sum(trueOffsets.begin(), trueOffsets.end(), trueOffsets.begin());
+    const std::size_t totalTrue = trueOffsets.back();
+
+    // move everything into scratch storage at its final position ...
+    // done[b] counts the elements of block b moved so far, so that a move
+    // that throws leaves no object behind in the scratch storage
+    detail::Buffer<T> buffer(n);
+    T* scratch = buffer.data();
+    std::vector<std::size_t> done(blocks.count, 0);
+    auto forEachSlot = [&](std::size_t b, std::size_t count, auto fn) {
+        std::size_t t = trueOffsets[b];
+        std::size_t f = totalTrue + (blocks.begin(b) - trueOffsets[b]);
+        for (std::size_t i = blocks.begin(b); i < blocks.begin(b) + count; ++i)
+            fn(i, isTrue[i] ? t++ : f++);
+    };
+    try {
+        pool->parallel_for(blocks.count, [&](std::size_t b) {
+            std::size_t count = 0;
+            try {
+                forEachSlot(b, blocks.end(b) - blocks.begin(b), [&](std::size_t i, std::size_t to) {
+                    ::new (static_cast<void*>(scratch + to)) T(std::move(first[i]));
+                    ++count;
+                });
+            } catch (...) {
+                done[b] = count;
+                throw;
+            }
+            done[b] = count;
+        });
+    } catch (...) {
+        for (std::size_t b = 0; b < blocks.count; ++b)
+            forEachSlot(b, done[b], [&](std::size_t, std::size_t to) { scratch[to].~T(); });
+        throw;
+    }
+
+    // ... and back again
+    std::fill(done.begin(), done.end(), 0);
+    try {
+        pool->parallel_for(blocks.count, [&](std::size_t b) {
+            std::size_t i = blocks.begin(b);
+            try {
+                for (; i < blocks.end(b); ++i) {
+                    first[i] = std::move(scratch[i]);
+                    scratch[i].~T();
+                }
+            } catch (...) {
+                done[b] = i - blocks.begin(b);
+                throw;
+            }
+            done[b] = i - blocks.begin(b);
+        });
+    } catch (...) {
+        for (std::size_t b = 0; b < blocks.count; ++b)
+            for (std::size_t i = blocks.begin(b) + done[b]; i < blocks.end(b); ++i)
+                scratch[i].~T();
+        throw;
+    }
+    return first + totalTrue;
+}
+
+//-----------------------------------------------------
+// sort
+//-----------------------------------------------------
+template <class ExecutionPolicy, class RandomIt, class Compare,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+void sort(ExecutionPolicy&& policy, RandomIt first, RandomIt last, Compare comp)
+{
+    const auto n = static_cast<std::size_t>(std::distance(first, last));
+    ThreadPool* pool = detail::parallelPool<std::decay_t<ExecutionPolicy>, RandomIt>(policy, n);
+    if (!pool) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    // one block per thread: more blocks only add merge rounds
+    const detail::Blocks blocks(n, pool->size() + 1);
+    pool->parallel_for(blocks.count, [&](std::size_t b) {
+        std::sort(first + blocks.begin(b), first + blocks.end(b), comp);
+    });
+
+    for (std::size_t width = 1; width < blocks.count; width *= 2) {
+        const std::size_t pairs = (blocks.count + 2 * width - 1) / (2 * width);
+        pool->parallel_for(pairs, [&](std::size_t p) {
+            const std::size_t lo = p * 2 * width;
+            const std::size_t mid = lo + width;
+            const std::size_t hi = std::min(lo + 2 * width, blocks.count);
+            if (mid < hi)
+                std::inplace_merge(first + blocks.begin(lo), first + blocks.begin(mid),
+                                   first + blocks.end(hi - 1), comp);
+        });
+    }
+}
+
+template <class ExecutionPolicy, class RandomIt,
+          detail::enable_if_policy<ExecutionPolicy> = 0>
+void sort(ExecutionPolicy&& policy, RandomIt first, RandomIt last)
+{
+    ali::sort(std::forward<ExecutionPolicy>(policy), first, last, std::less<>());
+}
+
+} // namespace ali
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+    -----------------------
+    ThreadPool
+    -----------------------
+    A fixed set of worker threads pulling tasks from one shared queue.
+    Creating a std::thread per task (like Threads/main.cpp does) costs tens of
+    microseconds each time, a pool pays that price once.
+
+    Two ways to use it:
+
+    1.  submit(f):              fire a single task, get a std::future back.
+
+    2.  parallel_for(n, fn):    fork-join; runs fn(0) ... fn(n-1) and returns once
+                                all of them have finished. The calling thread
+                                takes part in the work, so parallel_for() can be
+                                nested (called from inside a task) without
+                                dead-locking the pool.
+                                The first exception thrown by fn is re-thrown
+                                in the caller.
+
+    ThreadPool::instance() is a process wide pool with one worker per
+    hardware thread, used by the parallel algorithms by default.
+
+    The pool is written against a Backend which supplies the thread, mutex,
+    condition_variable and atomic types. ali::ThreadPool uses the std ones;
+    Threads/Deterministic plugs in instrumented types instead, so the very
+    same pool code can run under a deterministic, replayable scheduler
+    (dsched::ThreadPool). std::future is not instrumented, so in that mode
+    wait for work through parallel_for() rather than submit().get().
+*/
+
+namespace ali {
+
+struct StdBackend
+{
+    using thread = std::thread;
+    using mutex = std::mutex;
+    using condition_variable = std::condition_variable;
+    template <class T> using atomic = std::atomic<T>;
+};
+
+template <class Backend>
+class BasicThreadPool
+{
+    using Thread = typename Backend::thread;
+    using Mutex = typename Backend::mutex;
+    using ConditionVariable = typename Backend::condition_variable;
+    template <class T> using Atomic = typename Backend::template atomic<T>;
+
+public:
+    explicit BasicThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+            workers_.emplace_back([this] { workerLoop(); });
+    }
+
+    ~BasicThreadPool()
+    {
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_)
+            w.join();
+    }
+
+    BasicThreadPool(const BasicThreadPool&) = delete;
+    BasicThreadPool& operator=(const BasicThreadPool&) = delete;
+
+    static BasicThreadPool& instance()
+    {
+        static BasicThreadPool pool;
+        return pool;
+    }
+
+    std::size_t size() const { return workers_.size(); }
+
+    template <class F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        enqueue([task] { (*task)(); });
+        return result;
+    }
+
+    template <class F>
+    void parallel_for(std::size_t tasks, const F& fn)
+    {
+        if (tasks == 0)
+            return;
+
+        if (tasks == 1 || workers_.empty()) {
+            for (std::size_t i = 0; i < tasks; ++i)
+                fn(i);
+            return;
+        }
+
+        struct Shared
+        {
+            Atomic<std::size_t>     next{0};
+            Atomic<std::size_t>     done{0};
+            Mutex                   mutex;
+            ConditionVariable       cv;
+            std::exception_ptr      error;
+        };
+        auto shared = std::make_shared<Shared>();
+
+        // Helpers that start after everything is done find no index left and
+        // never touch fn, which may be gone by then.
+        auto work = [shared, &fn, tasks] {
+            std::size_t i;
+            while ((i = shared->next.fetch_add(1, std::memory_order_relaxed)) < tasks) {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::lock_guard<Mutex> lock(shared->mutex);
+                    if (!shared->error) shared->error = std::current_exception();
+                }
+                if (shared->done.fetch_add(1, std::memory_order_acq_rel) + 1 == tasks) {
+                    std::lock_guard<Mutex> lock(shared->mutex);
+                    shared->cv.notify_all();
+                }
+            }
+        };
+
+        const std::size_t helpers = std::min(tasks - 1, workers_.size());
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            for (std::size_t h = 0; h < helpers; ++h)
+                queue_.emplace_back(work);
+        }
+        cv_.notify_all();
+
+        work();
+
+        std::unique_lock<Mutex> lock(shared->mutex);
+        shared->cv.wait(lock, [&] { return shared->done.load(std::memory_order_acquire) == tasks; });
+        if (shared->error)
+            std::rethrow_exception(shared->error);
+    }
+
+private:
+    void enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            queue_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    void workerLoop()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<Mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (stop_ && queue_.empty())
+                    return;
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<Thread>                 workers_;
+    std::deque<std::function<void()>>   queue_;
+    Mutex                               mutex_;
+    ConditionVariable                   cv_;
+    bool                                stop_ = false;
+};
+
+using ThreadPool = BasicThreadPool<StdBackend>;
+
+} // namespace ali
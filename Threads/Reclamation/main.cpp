@@ -0,0 +1,230 @@
+/*
+
+    -----------------------
+    Reclamation stress test
+    -----------------------
+    Hammers the Treiber stack and the Michael-Scott queue from many threads,
+    once with each reclamation domain, and checks that:
+
+    -   no value is lost or duplicated (sums of pushed and popped values match)
+    -   the queue keeps FIFO order per producer
+    -   every allocated node is eventually freed
+    -   a reader that stalls inside a guard does not make memory grow without bound
+    -   a thread that touched many short-lived domains does not slow down
+        (it drops its entries of destroyed domains)
+
+    Best run under ThreadSanitizer, see Readme.txt.
+
+    Usage:
+        ./main [threads] [operations-per-thread]
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ms_queue.hpp"
+#include "reclamation.hpp"
+#include "treiber_stack.hpp"
+#include "../../Testing/self_check.hpp"
+
+using ali::check::report;
+
+static void printStats(const ali::ReclamationStats& s)
+{
+    std::cout << "  allocated: " << s.allocated
+              << "  retired: " << s.retired
+              << "  freed: " << s.freed
+              << "  peak pending/thread: " << s.peakPending << "\n";
+}
+
+template <typename Domain>
+void stressStack(const char* name, int threads, int ops)
+{
+    std::cout << "\nTreiberStack<" << name << ">\n";
+
+    Domain domain;
+    std::uint64_t pushedSum = 0;
+    std::atomic<std::uint64_t> poppedSum{0};
+    {
+        ali::TreiberStack<std::uint64_t, Domain> stack(domain);
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::uint64_t local = 0;
+                for (int i = 0; i < ops; ++i) {
+                    stack.push(std::uint64_t(t) * ops + i);
+                    if (auto v = stack.pop()) local += *v;
+                }
+                poppedSum.fetch_add(local);
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        while (auto v = stack.pop()) poppedSum += *v;
+
+        for (int t = 0; t < threads; ++t)
+            for (int i = 0; i < ops; ++i)
+                pushedSum += std::uint64_t(t) * ops + i;
+
+        domain.collect();
+        printStats(domain.stats());
+        report(pushedSum == poppedSum.load(), "every pushed value popped exactly once");
+        report(domain.stats().pending() == 0, "all retired nodes freed after quiescence");
+    }
+}
+
+template <typename Domain>
+void stressQueue(const char* name, int threads, int ops)
+{
+    std::cout << "\nMSQueue<" << name << ">\n";
+
+    Domain domain;
+    const int producers = std::max(1, threads / 2);
+    const int consumers = std::max(1, threads - producers);
+
+    ali::MSQueue<std::uint64_t, Domain> queue(domain);
+    std::atomic<std::uint64_t> poppedSum{0};
+    std::atomic<std::uint64_t> poppedCount{0};
+    std::atomic<bool> ordered{true};
+
+    std::vector<std::thread> workers;
+    for (int p = 0; p < producers; ++p) {
+        workers.emplace_back([&, p] {
+            // value = producer id in the top bits, sequence number in the low bits
+            for (int i = 0; i < ops; ++i)
+                queue.push((std::uint64_t(p) << 32) | std::uint64_t(i));
+        });
+    }
+
+    const std::uint64_t total = std::uint64_t(producers) * ops;
+    for (int c = 0; c < consumers; ++c) {
+        workers.emplace_back([&] {
+            std::vector<std::int64_t> lastSeen(producers, -1);
+            while (poppedCount.load() < total) {
+                auto v = queue.pop();
+                if (!v) { std::this_thread::yield(); continue; }
+
+                const auto producer = *v >> 32;
+                const auto seq = std::int64_t(*v & 0xffffffffu);
+                if (seq <= lastSeen[producer]) ordered = false;
+                lastSeen[producer] = seq;
+
+                poppedSum.fetch_add(*v);
+                poppedCount.fetch_add(1);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    std::uint64_t pushedSum = 0;
+    for (int p = 0; p < producers; ++p)
+        for (int i = 0; i < ops; ++i)
+            pushedSum += (std::uint64_t(p) << 32) | std::uint64_t(i);
+
+    domain.collect();
+    printStats(domain.stats());
+    report(pushedSum == poppedSum.load(), "every enqueued value dequeued exactly once");
+    report(ordered.load(), "FIFO order preserved per producer");
+    report(queue.empty(), "queue drained");
+}
+
+// One thread enters a guard, reads the top of the stack and then goes to sleep.
+// Meanwhile the others keep pushing and popping. The pending retire lists
+// must stay bounded instead of growing with the number of operations.
+template <typename Domain>
+void stalledReader(const char* name, int threads, int ops)
+{
+    std::cout << "\nStalled reader <" << name << ">\n";
+
+    Domain domain;
+    ali::TreiberStack<std::uint64_t, Domain> stack(domain);
+    for (int i = 0; i < 64; ++i) stack.push(i);
+
+    std::atomic<bool> stalled{false};
+    std::atomic<bool> done{false};
+
+    std::thread reader([&] {
+        typename Domain::Guard guard(domain);
+        stack.empty();
+        stalled = true;
+        while (!done.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    while (!stalled.load()) std::this_thread::yield();
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < ops; ++i) {
+                stack.push(i);
+                stack.pop();
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    const auto s = domain.stats();
+    done = true;
+    reader.join();
+
+    printStats(s);
+    // with unbounded EBR every one of the (threads-1)*ops pops would still be pending
+    const std::uint64_t bound = 4 * (Domain::kScanThreshold + 64 * std::uint64_t(threads));
+    report(s.peakPending <= bound, "pending nodes stay bounded (<= " + std::to_string(bound) + ")");
+    report(s.freed > 0, "reclamation kept making progress");
+}
+
+// One thread enters a guard in 50000 domains, each destroyed before the next
+// is made. Finding the thread's record in a new domain must not get slower
+// with the number of dead domains the thread has seen.
+template <typename Domain>
+void shortLivedDomains(const char* name)
+{
+    std::cout << "\nShort-lived domains <" << name << ">\n";
+
+    constexpr int kDomains = 50000, kSample = 5000;
+    double firstNanos = 0, lastNanos = 0;
+    for (int i = 0; i < kDomains; ++i) {
+        Domain domain;
+        const auto t0 = std::chrono::steady_clock::now();
+        { typename Domain::Guard guard(domain); }
+        const auto t1 = std::chrono::steady_clock::now();
+        const double nanos = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        if (i < kSample)
+            firstNanos += nanos;
+        else if (i >= kDomains - kSample)
+            lastNanos += nanos;
+    }
+    std::cout << "  first guard in the first domains: " << firstNanos / kSample
+              << " ns, in the last: " << lastNanos / kSample << " ns\n";
+    report(lastNanos < 2 * firstNanos, "no slowdown after 50000 destroyed domains");
+}
+
+int main(int argc, char* argv[])
+{
+    const int threads = argc > 1 ? std::atoi(argv[1]) : std::max(4u, std::thread::hardware_concurrency());
+    const int ops     = argc > 2 ? std::atoi(argv[2]) : 100000;
+
+    std::cout << "threads: " << threads << "  ops/thread: " << ops << "\n";
+
+    stressStack<ali::EpochDomain>("EpochDomain", threads, ops);
+    stressStack<ali::HazardDomain>("HazardDomain", threads, ops);
+
+    stressQueue<ali::EpochDomain>("EpochDomain", threads, ops);
+    stressQueue<ali::HazardDomain>("HazardDomain", threads, ops);
+
+    stalledReader<ali::EpochDomain>("EpochDomain", threads, ops);
+    stalledReader<ali::HazardDomain>("HazardDomain", threads, ops);
+
+    shortLivedDomains<ali::EpochDomain>("EpochDomain");
+    shortLivedDomains<ali::HazardDomain>("HazardDomain");
+
+    return ali::check::finish();
+}
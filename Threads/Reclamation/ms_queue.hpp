@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+#include "reclamation.hpp"
+
+/*
+    -----------------------
+    Michael-Scott Queue
+    -----------------------
+    A lock-free FIFO (Michael & Scott, PODC 1996).
+    The list always starts with a "dummy" node: head points at the dummy,
+    the first real value lives in head->next.
+
+        enqueue:  link the new node after tail, then swing tail forward.
+        dequeue:  read the value of head->next, then swing head forward;
+                  the old dummy is retired and head->next becomes the new dummy.
+
+    Any thread that finds tail lagging behind (tail->next != nullptr) helps
+    by swinging tail forward, that makes the queue lock-free.
+
+    dequeue() needs two protected pointers at once (head and head->next),
+    which is why the domains hand out two slots per guard.
+
+    The value is copied out *before* the CAS on head: after the CAS another
+    dequeuer may already retire the node. Hence T must be copyable.
+*/
+
+namespace ali {
+
+template <typename T, typename Domain>
+class MSQueue
+{
+    struct Node : Reclaimable
+    {
+        Node() = default;
+        template <class... Args>
+        explicit Node(std::in_place_t, Args&&... args) : value(std::in_place, std::forward<Args>(args)...) {}
+
+        std::optional<T>    value;      // empty for the initial dummy
+        std::atomic<Node*>  next{nullptr};
+    };
+
+public:
+    explicit MSQueue(Domain& domain) : domain_(domain)
+    {
+        Node* dummy = domain_.template create<Node>();
+        head_.store(dummy, std::memory_order_relaxed);
+        tail_.store(dummy, std::memory_order_relaxed);
+    }
+
+    // Not safe against concurrent use, all other threads must be done.
+    ~MSQueue()
+    {
+        Node* n = head_.load(std::memory_order_acquire);
+        while (n) {
+            Node* next = n->next.load(std::memory_order_relaxed);
+            n->deleter(n);
+            n = next;
+        }
+    }
+
+    MSQueue(const MSQueue&) = delete;
+    MSQueue& operator=(const MSQueue&) = delete;
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value)      { emplace(std::move(value)); }
+
+    template <class... Args>
+    void emplace(Args&&... args)
+    {
+        Node* node = domain_.template create<Node>(std::in_place, std::forward<Args>(args)...);
+
+        typename Domain::Guard guard(domain_);
+        while (true) {
+            Node* tail = guard.protect(tail_, 0);
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (tail != tail_.load(std::memory_order_acquire))
+                continue;
+
+            if (next != nullptr) {
+                // tail is lagging behind, help the other enqueuer
+                tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                                        std::memory_order_relaxed);
+                continue;
+            }
+
+            if (tail->next.compare_exchange_weak(next, node, std::memory_order_release,
+                                                             std::memory_order_relaxed)) {
+                tail_.compare_exchange_strong(tail, node, std::memory_order_release,
+                                                          std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    std::optional<T> pop()
+    {
+        typename Domain::Guard guard(domain_);
+        while (true) {
+            Node* head = guard.protect(head_, 0);
+            Node* tail = tail_.load(std::memory_order_acquire);
+            Node* next = guard.protect(head->next, 1);
+            if (head != head_.load(std::memory_order_acquire))
+                continue;
+
+            if (next == nullptr)
+                return std::nullopt;
+
+            if (head == tail) {
+                tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                                        std::memory_order_relaxed);
+                continue;
+            }
+
+            std::optional<T> result = next->value;
+            if (head_.compare_exchange_strong(head, next, std::memory_order_acq_rel,
+                                                          std::memory_order_relaxed)) {
+                guard.clear();
+                domain_.retire(head);
+                return result;
+            }
+        }
+    }
+
+    bool empty() const
+    {
+        typename Domain::Guard guard(domain_);
+        Node* head = guard.protect(head_, 0);
+        return head->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    Domain&             domain_;
+    std::atomic<Node*>  head_;
+    std::atomic<Node*>  tail_;
+};
+
+} // namespace ali
@@ -0,0 +1,632 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/*
+    -----------------------
+    Safe Memory Reclamation
+    -----------------------
+    A lock-free container unlinks a node with a single CAS, but it cannot
+    "delete" that node right away: another thread may have loaded the same
+    pointer a moment earlier and still be reading through it.
+
+    A reclamation domain answers the question "when is it safe to free?".
+    Both domains below share the same API:
+
+        Domain domain;
+        T* node = domain.create<T>(args...);            // allocate a managed node
+        {
+            Domain::Guard guard(domain);                // enter a read-side section
+            T* p = guard.protect(atomicPtr, slot);      // load & protect a pointer
+            ...                                         // p can be dereferenced safely
+            domain.retire(p);                           // unlinked: free it "later"
+        }
+
+    Every thread keeps its own retire list. The list is scanned in batches
+    (every kScanThreshold retires), so the cost of a scan is amortised over
+    many frees.
+
+    1. EpochDomain (interval based epochs):
+       Classic EBR only lets the global epoch advance when every reader has
+       caught up. A single stalled reader therefore blocks *all* frees and the
+       retire lists grow without bound.
+       Here every reader reserves an interval [lower, upper] of epochs instead
+       and every node remembers the epoch it was born and retired in. A node
+       can be freed as soon as its lifetime [birth, retire] does not overlap
+       any reservation. A stalled reader only pins the nodes that were alive
+       while it was running, so memory stays bounded.
+       (Wen et al. "Interval-Based Memory Reclamation", PPoPP 2018)
+
+    2. HazardDomain (hazard pointers):
+       Every reader publishes the exact pointers it is about to dereference.
+       A retired node is freed once no hazard slot points at it. At most
+       (kScanThreshold + hazards of all threads) nodes per thread are pending.
+       (Michael, "Hazard Pointers", IEEE TPDS 2004)
+
+    Nodes must derive from ali::Reclaimable, which holds the intrusive
+    retire-list link and the epochs used by the EpochDomain.
+
+    A domain must outlive every container that uses it. Threads can come and
+    go freely: a thread that exits hands its retire list over to the domain,
+    and the next scan of any other thread adopts it.
+*/
+
+namespace ali {
+
+// Base class of every node managed by a reclamation domain.
+struct Reclaimable
+{
+    Reclaimable*    retiredNext = nullptr;
+    std::uint64_t   birthEpoch = 0;
+    std::uint64_t   retireEpoch = 0;
+    void          (*deleter)(Reclaimable*) = nullptr;
+};
+
+struct ReclamationStats
+{
+    std::uint64_t allocated = 0;
+    std::uint64_t retired = 0;
+    std::uint64_t freed = 0;
+    std::uint64_t peakPending = 0;  // longest retire list held by any single thread
+
+    std::uint64_t pending() const { return retired - freed; }
+};
+
+namespace detail {
+
+// Per-thread state of one thread inside one domain.
+struct RecordBase
+{
+    std::atomic<bool>           inUse{false};
+    RecordBase*                 nextRecord = nullptr;
+
+    // retire list, only touched by the owning thread
+    Reclaimable*                retired = nullptr;
+    std::size_t                 retiredCount = 0;
+    std::size_t                 peakRetired = 0;
+    std::uint64_t               opCounter = 0;
+
+    std::atomic<std::uint64_t>  allocated{0};
+    std::atomic<std::uint64_t>  retiredTotal{0};
+    std::atomic<std::uint64_t>  freed{0};
+    std::atomic<std::uint64_t>  peak{0};
+};
+
+class DomainBase;
+
+inline std::mutex& registryMutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+inline std::unordered_set<std::uint64_t>& liveDomains()
+{
+    static std::unordered_set<std::uint64_t> uids;
+    return uids;
+}
+
+// Maps every domain this thread has touched to the thread's record in it.
+// Entries of destroyed domains are dropped on the next miss; on thread exit
+// the records of all still-alive domains are released.
+class ThreadRecords
+{
+    struct Entry
+    {
+        std::uint64_t   uid;
+        DomainBase*     domain;
+        RecordBase*     record;
+    };
+    std::vector<Entry> entries_;
+
+public:
+    ThreadRecords() { registryMutex(); liveDomains(); }   // make sure they outlive us
+    ~ThreadRecords();
+
+    RecordBase* find(std::uint64_t uid) const
+    {
+        for (const auto& e : entries_)
+            if (e.uid == uid) return e.record;
+        return nullptr;
+    }
+
+    void add(std::uint64_t uid, DomainBase* domain, RecordBase* record)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                      [](const Entry& e) { return liveDomains().count(e.uid) == 0; }),
+                       entries_.end());
+        entries_.push_back({uid, domain, record});
+    }
+};
+
+class DomainBase
+{
+public:
+    DomainBase() : uid_(nextUid())
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        liveDomains().insert(uid_);
+    }
+
+    virtual ~DomainBase() = default;
+
+    DomainBase(const DomainBase&) = delete;
+    DomainBase& operator=(const DomainBase&) = delete;
+
+    // called with registryMutex() held, from the exiting thread
+    virtual void releaseRecord(RecordBase* record) = 0;
+
+protected:
+    template <class Record>
+    Record* record()
+    {
+        static thread_local ThreadRecords tls;
+
+        if (auto* r = tls.find(uid_))
+            return static_cast<Record*>(r);
+
+        Record* r = claimRecord<Record>();
+        tls.add(uid_, this, r);
+        return r;
+    }
+
+    // Must be the first thing a derived destructor does: after this no thread
+    // exit will touch the domain any more.
+    void unregister()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        liveDomains().erase(uid_);
+    }
+
+    void orphan(RecordBase* record)
+    {
+        if (record->retired == nullptr) return;
+
+        std::lock_guard<std::mutex> lock(orphanMutex_);
+        Reclaimable* tail = record->retired;
+        while (tail->retiredNext) tail = tail->retiredNext;
+        tail->retiredNext = orphans_;
+        orphans_ = record->retired;
+        orphanCount_.fetch_add(record->retiredCount, std::memory_order_release);
+        record->retired = nullptr;
+        record->retiredCount = 0;
+    }
+
+    void adoptOrphans(RecordBase* record)
+    {
+        if (orphanCount_.load(std::memory_order_acquire) == 0) return;
+
+        std::unique_lock<std::mutex> lock(orphanMutex_, std::try_to_lock);
+        if (!lock.owns_lock()) return;
+
+        while (orphans_) {
+            Reclaimable* n = orphans_;
+            orphans_ = n->retiredNext;
+            n->retiredNext = record->retired;
+            record->retired = n;
+            ++record->retiredCount;
+        }
+        orphanCount_.store(0, std::memory_order_release);
+    }
+
+    static void push(RecordBase* record, Reclaimable* node)
+    {
+        node->retiredNext = record->retired;
+        record->retired = node;
+        ++record->retiredCount;
+        record->retiredTotal.store(record->retiredTotal.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+        if (record->retiredCount > record->peakRetired) {
+            record->peakRetired = record->retiredCount;
+            record->peak.store(record->peakRetired, std::memory_order_relaxed);
+        }
+    }
+
+    // Frees every node on the record's retire list for which canFree(node) holds.
+    template <class Pred>
+    static void sweep(RecordBase* record, Pred canFree)
+    {
+        Reclaimable*    keep = nullptr;
+        std::size_t     kept = 0;
+        std::uint64_t   freed = 0;
+
+        Reclaimable* n = record->retired;
+        while (n) {
+            Reclaimable* next = n->retiredNext;
+            if (canFree(n)) {
+                n->deleter(n);
+                ++freed;
+            } else {
+                n->retiredNext = keep;
+                keep = n;
+                ++kept;
+            }
+            n = next;
+        }
+        record->retired = keep;
+        record->retiredCount = kept;
+        record->freed.store(record->freed.load(std::memory_order_relaxed) + freed,
+                            std::memory_order_relaxed);
+    }
+
+    static void freeAll(Reclaimable* n)
+    {
+        while (n) {
+            Reclaimable* next = n->retiredNext;
+            n->deleter(n);
+            n = next;
+        }
+    }
+
+    // Frees everything; only valid once no other thread uses the domain.
+    template <class Record>
+    void destroyRecords()
+    {
+        RecordBase* r = records_.load(std::memory_order_acquire);
+        while (r) {
+            RecordBase* next = r->nextRecord;
+            freeAll(r->retired);
+            delete static_cast<Record*>(r);
+            r = next;
+        }
+        freeAll(orphans_);
+    }
+
+    template <class Fn>
+    void forEachRecord(Fn fn) const
+    {
+        for (RecordBase* r = records_.load(std::memory_order_acquire); r; r = r->nextRecord)
+            fn(r);
+    }
+
+    std::size_t recordCount() const { return recordCount_.load(std::memory_order_relaxed); }
+
+    ReclamationStats collectStats() const
+    {
+        ReclamationStats s;
+        forEachRecord([&](RecordBase* r) {
+            s.allocated += r->allocated.load(std::memory_order_relaxed);
+            s.retired   += r->retiredTotal.load(std::memory_order_relaxed);
+            s.freed     += r->freed.load(std::memory_order_relaxed);
+            s.peakPending = std::max<std::uint64_t>(s.peakPending, r->peak.load(std::memory_order_relaxed));
+        });
+        return s;
+    }
+
+private:
+    static std::uint64_t nextUid()
+    {
+        static std::atomic<std::uint64_t> uid{0};
+        return uid.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    template <class Record>
+    Record* claimRecord()
+    {
+        // reuse the record of a thread that has exited
+        for (RecordBase* r = records_.load(std::memory_order_acquire); r; r = r->nextRecord) {
+            bool expected = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                return static_cast<Record*>(r);
+        }
+
+        auto* r = new Record();
+        r->inUse.store(true, std::memory_order_relaxed);
+        RecordBase* head = records_.load(std::memory_order_relaxed);
+        do {
+            r->nextRecord = head;
+        } while (!records_.compare_exchange_weak(head, r, std::memory_order_release,
+                                                          std::memory_order_relaxed));
+        recordCount_.fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+
+    const std::uint64_t         uid_;
+    std::atomic<RecordBase*>    records_{nullptr};
+    std::atomic<std::size_t>    recordCount_{0};
+
+    std::mutex                  orphanMutex_;
+    Reclaimable*                orphans_ = nullptr;
+    std::atomic<std::size_t>    orphanCount_{0};
+};
+
+inline ThreadRecords::~ThreadRecords()
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const auto& e : entries_)
+        if (liveDomains().count(e.uid))
+            e.domain->releaseRecord(e.record);
+}
+
+} // namespace detail
+
+//-----------------------------------------------------
+// EpochDomain:  interval-based epoch reclamation
+//-----------------------------------------------------
+class EpochDomain : public detail::DomainBase
+{
+    static constexpr std::uint64_t kInactive = std::numeric_limits<std::uint64_t>::max();
+
+    struct Record : detail::RecordBase
+    {
+        std::atomic<std::uint64_t>  lower{kInactive};
+        std::atomic<std::uint64_t>  upper{kInactive};
+        unsigned                    nesting = 0;
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> reservations;  // scan buffer
+    };
+
+public:
+    static constexpr std::size_t kScanThreshold = 128;   // retires between two scans
+    static constexpr std::size_t kEpochFrequency = 64;   // allocations between epoch bumps
+    static constexpr std::size_t kSlotsPerGuard = 2;     // accepted for API parity, unused
+
+    class Guard
+    {
+    public:
+        explicit Guard(EpochDomain& domain) : domain_(domain), record_(domain.record<Record>())
+        {
+            if (record_->nesting++ == 0) {
+                const std::uint64_t e = domain_.epoch_.load(std::memory_order_acquire);
+                record_->lower.store(e, std::memory_order_seq_cst);
+                record_->upper.store(e, std::memory_order_seq_cst);
+            }
+        }
+
+        ~Guard()
+        {
+            if (--record_->nesting == 0) {
+                record_->lower.store(kInactive, std::memory_order_release);
+                record_->upper.store(kInactive, std::memory_order_release);
+            }
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        // Loads src and extends the reservation until it covers the epoch
+        // in which the pointer was read.
+        template <class T>
+        T* protect(const std::atomic<T*>& src, std::size_t slot = 0)
+        {
+            assert(slot < kSlotsPerGuard); (void)slot;
+            std::uint64_t prev = record_->upper.load(std::memory_order_relaxed);
+            while (true) {
+                T* p = src.load(std::memory_order_acquire);
+                const std::uint64_t e = domain_.epoch_.load(std::memory_order_acquire);
+                if (e == prev) return p;
+                record_->upper.store(e, std::memory_order_seq_cst);
+                prev = e;
+            }
+        }
+
+        void clear() {}
+
+    private:
+        EpochDomain&    domain_;
+        Record*         record_;
+    };
+
+    EpochDomain() = default;
+
+    ~EpochDomain() override
+    {
+        unregister();
+        destroyRecords<Record>();
+    }
+
+    template <class T, class... Args>
+    T* create(Args&&... args)
+    {
+        static_assert(std::is_base_of<Reclaimable, T>::value, "T must derive from ali::Reclaimable");
+        Record* r = record<Record>();
+        if (++r->opCounter % kEpochFrequency == 0)
+            epoch_.fetch_add(1, std::memory_order_acq_rel);
+        r->allocated.store(r->allocated.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        T* node = new T(std::forward<Args>(args)...);
+        node->deleter = [](Reclaimable* n) { delete static_cast<T*>(n); };
+        node->birthEpoch = epoch_.load(std::memory_order_acquire);
+        return node;
+    }
+
+    void retire(Reclaimable* node)
+    {
+        Record* r = record<Record>();
+        node->retireEpoch = epoch_.load(std::memory_order_acquire);
+        push(r, node);
+        if (r->retiredCount >= kScanThreshold)
+            scan(r);
+    }
+
+    // Forces a scan of the calling thread's retire list.
+    void collect() { scan(record<Record>()); }
+
+    ReclamationStats stats() const { return collectStats(); }
+
+    std::uint64_t epoch() const { return epoch_.load(std::memory_order_relaxed); }
+
+    void releaseRecord(detail::RecordBase* base) override
+    {
+        auto* r = static_cast<Record*>(base);
+        r->lower.store(kInactive, std::memory_order_release);
+        r->upper.store(kInactive, std::memory_order_release);
+        r->nesting = 0;
+        scan(r);
+        orphan(r);
+        r->inUse.store(false, std::memory_order_release);
+    }
+
+private:
+    void scan(Record* r)
+    {
+        epoch_.fetch_add(1, std::memory_order_acq_rel);
+        adoptOrphans(r);
+
+        auto& reservations = r->reservations;
+        reservations.clear();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        forEachRecord([&](detail::RecordBase* base) {
+            auto* other = static_cast<Record*>(base);
+            const std::uint64_t lo = other->lower.load(std::memory_order_seq_cst);
+            const std::uint64_t hi = other->upper.load(std::memory_order_seq_cst);
+            if (lo != kInactive)
+                reservations.emplace_back(lo, hi);
+        });
+
+        sweep(r, [&](Reclaimable* n) {
+            for (const auto& res : reservations)
+                if (n->birthEpoch <= res.second && n->retireEpoch >= res.first)
+                    return false;
+            return true;
+        });
+    }
+
+    std::atomic<std::uint64_t> epoch_{1};
+};
+
+//-----------------------------------------------------
+// HazardDomain:  hazard pointers
+//-----------------------------------------------------
+class HazardDomain : public detail::DomainBase
+{
+public:
+    static constexpr std::size_t kScanThreshold = 128;
+    static constexpr std::size_t kSlotsPerGuard = 2;
+    static constexpr std::size_t kSlotsPerThread = 8;    // i.e. up to 4 nested guards
+
+private:
+    struct Record : detail::RecordBase
+    {
+        std::array<std::atomic<const void*>, kSlotsPerThread>   hazards{};
+        std::size_t                                             usedSlots = 0;
+        std::vector<const void*>                                snapshot;   // scan buffer
+    };
+
+public:
+    class Guard
+    {
+    public:
+        explicit Guard(HazardDomain& domain) : record_(domain.record<Record>())
+        {
+            assert(record_->usedSlots + kSlotsPerGuard <= kSlotsPerThread && "guards nested too deep");
+            base_ = record_->usedSlots;
+            record_->usedSlots += kSlotsPerGuard;
+        }
+
+        ~Guard()
+        {
+            clear();
+            record_->usedSlots -= kSlotsPerGuard;
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        // Publishes the loaded pointer in a hazard slot and re-validates it.
+        template <class T>
+        T* protect(const std::atomic<T*>& src, std::size_t slot = 0)
+        {
+            static_assert(std::is_base_of<Reclaimable, T>::value, "T must derive from ali::Reclaimable");
+            assert(slot < kSlotsPerGuard);
+            auto& hazard = record_->hazards[base_ + slot];
+            T* p = src.load(std::memory_order_relaxed);
+            while (true) {
+                // hazards hold the Reclaimable* address, that is what retire() sees
+                hazard.store(static_cast<const Reclaimable*>(p), std::memory_order_seq_cst);
+                T* again = src.load(std::memory_order_seq_cst);
+                if (again == p) return p;
+                p = again;
+            }
+        }
+
+        void clear()
+        {
+            for (std::size_t i = 0; i < kSlotsPerGuard; ++i)
+                record_->hazards[base_ + i].store(nullptr, std::memory_order_release);
+        }
+
+    private:
+        Record*         record_;
+        std::size_t     base_;
+    };
+
+    HazardDomain() = default;
+
+    ~HazardDomain() override
+    {
+        unregister();
+        destroyRecords<Record>();
+    }
+
+    template <class T, class... Args>
+    T* create(Args&&... args)
+    {
+        static_assert(std::is_base_of<Reclaimable, T>::value, "T must derive from ali::Reclaimable");
+        Record* r = record<Record>();
+        r->allocated.store(r->allocated.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        T* node = new T(std::forward<Args>(args)...);
+        node->deleter = [](Reclaimable* n) { delete static_cast<T*>(n); };
+        return node;
+    }
+
+    void retire(Reclaimable* node)
+    {
+        Record* r = record<Record>();
+        push(r, node);
+        // scan less often when there are many threads, so that every scan frees
+        // at least half of the list (amortised O(1) per retire)
+        const std::size_t threshold = std::max(kScanThreshold, 2 * kSlotsPerThread * recordCount());
+        if (r->retiredCount >= threshold)
+            scan(r);
+    }
+
+    void collect() { scan(record<Record>()); }
+
+    ReclamationStats stats() const { return collectStats(); }
+
+    void releaseRecord(detail::RecordBase* base) override
+    {
+        auto* r = static_cast<Record*>(base);
+        for (auto& h : r->hazards) h.store(nullptr, std::memory_order_release);
+        r->usedSlots = 0;
+        scan(r);
+        orphan(r);
+        r->inUse.store(false, std::memory_order_release);
+    }
+
+private:
+    void scan(Record* r)
+    {
+        adoptOrphans(r);
+
+        auto& snapshot = r->snapshot;
+        snapshot.clear();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        forEachRecord([&](detail::RecordBase* base) {
+            for (auto& h : static_cast<Record*>(base)->hazards)
+                if (const void* p = h.load(std::memory_order_seq_cst))
+                    snapshot.push_back(p);
+        });
+        std::sort(snapshot.begin(), snapshot.end());
+
+        sweep(r, [&](Reclaimable* n) {
+            return !std::binary_search(snapshot.begin(), snapshot.end(), static_cast<const void*>(n));
+        });
+    }
+};
+
+} // namespace ali
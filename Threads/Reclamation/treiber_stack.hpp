@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+#include "reclamation.hpp"
+
+/*
+    -----------------------
+    Treiber Stack
+    -----------------------
+    The simplest lock-free container: a singly linked list whose head is
+    swung with compare_exchange.
+
+        push:   node->next = head;              CAS(head, node->next, node)
+        pop:    h = head;   next = h->next;     CAS(head, h, next)
+
+    The hard part is pop(): between reading "h" and reading "h->next" another
+    thread may pop and delete h. The Domain (EpochDomain or HazardDomain)
+    guarantees that h stays allocated while we hold a guard on it.
+    Since a protected node is never reused either, this also rules out
+    the ABA problem.
+*/
+
+namespace ali {
+
+template <typename T, typename Domain>
+class TreiberStack
+{
+    struct Node : Reclaimable
+    {
+        template <class... Args>
+        explicit Node(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+        T       value;
+        Node*   next = nullptr;     // immutable once the node is published
+    };
+
+public:
+    explicit TreiberStack(Domain& domain) : domain_(domain) {}
+
+    // Not safe against concurrent use, all other threads must be done.
+    ~TreiberStack()
+    {
+        Node* n = head_.load(std::memory_order_acquire);
+        while (n) {
+            Node* next = n->next;
+            n->deleter(n);
+            n = next;
+        }
+    }
+
+    TreiberStack(const TreiberStack&) = delete;
+    TreiberStack& operator=(const TreiberStack&) = delete;
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value)      { emplace(std::move(value)); }
+
+    template <class... Args>
+    void emplace(Args&&... args)
+    {
+        Node* node = domain_.template create<Node>(std::forward<Args>(args)...);
+        node->next = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                                              std::memory_order_relaxed))
+            ;
+    }
+
+    std::optional<T> pop()
+    {
+        typename Domain::Guard guard(domain_);
+        while (true) {
+            Node* head = guard.protect(head_);
+            if (head == nullptr)
+                return std::nullopt;
+
+            if (head_.compare_exchange_strong(head, head->next, std::memory_order_acquire,
+                                                                std::memory_order_relaxed)) {
+                // we own the node now, nobody else reads its value
+                std::optional<T> result(std::move(head->value));
+                guard.clear();
+                domain_.retire(head);
+                return result;
+            }
+        }
+    }
+
+    bool empty() const { return head_.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    Domain&             domain_;
+    std::atomic<Node*>  head_{nullptr};
+};
+
+} // namespace ali